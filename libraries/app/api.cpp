@@ -28,11 +28,16 @@
 
 #include "database_api_helper.hxx"
 
+#include <graphene/account_history/account_history_plugin.hpp>
+#include <graphene/account_history/history_store.hpp>
+
 #include <fc/crypto/base64.hpp>
+#include <fc/io/raw.hpp>
 #include <fc/rpc/api_connection.hpp>
 #include <fc/thread/future.hpp>
 
 template class fc::api<graphene::app::block_api>;
+template class fc::api<graphene::app::binary_api>;
 template class fc::api<graphene::app::network_broadcast_api>;
 template class fc::api<graphene::app::network_node_api>;
 template class fc::api<graphene::app::history_api>;
@@ -129,6 +134,35 @@ namespace graphene { namespace app {
        return res;
     }
 
+    // binary_api
+    binary_api::binary_api(application& app) : _app(app) { /* Nothing to do */ }
+
+    vector<char> binary_api::get_blocks(uint32_t block_num_from, uint32_t block_num_to)const
+    {
+       return fc::raw::pack( block_api( *_app.chain_database() ).get_blocks( block_num_from, block_num_to ) );
+    }
+
+    vector<char> binary_api::get_objects(const vector<object_id_type>& ids)const
+    {
+       const auto& db = *_app.chain_database();
+       vector<optional<vector<char>>> result;
+       result.reserve( ids.size() );
+       for( const object_id_type& id : ids )
+       {
+          const object* obj = db.find_object( id );
+          result.push_back( obj != nullptr ? obj->pack() : optional<vector<char>>() );
+       }
+       return fc::raw::pack( result );
+    }
+
+    vector<char> binary_api::get_account_history( const std::string& account_name_or_id,
+                                                  operation_history_id_type stop,
+                                                  uint32_t limit,
+                                                  operation_history_id_type start )const
+    {
+       return fc::raw::pack( history_api( _app ).get_account_history( account_name_or_id, stop, limit, start ) );
+    }
+
     network_broadcast_api::network_broadcast_api(application& a):_app(a)
     {
        _applied_block_connection = _app.chain_database()->applied_block.connect(
@@ -240,6 +274,16 @@ namespace graphene { namespace app {
        return _app.p2p_node()->set_advanced_node_parameters(params);
     }
 
+    graphene::chain::evaluator_profile network_node_api::get_evaluator_profile( const optional<bool>& reset ) const
+    {
+       auto* profiler = _app.chain_database()->get_evaluator_profiler();
+       FC_ASSERT( profiler != nullptr, "Evaluator profiling is not enabled" );
+       auto result = profiler->get_profile();
+       if( reset.valid() && *reset )
+          profiler->reset();
+       return result;
+    }
+
     fc::api<network_broadcast_api> login_api::network_broadcast()
     {
        bool is_allowed = ( _allowed_apis.find("network_broadcast_api") != _allowed_apis.end() );
@@ -262,6 +306,17 @@ namespace graphene { namespace app {
        return *_block_api;
     }
 
+    fc::api<binary_api> login_api::binary()
+    {
+       bool is_allowed = ( _allowed_apis.find("binary_api") != _allowed_apis.end() );
+       FC_ASSERT( is_allowed, "Access denied" );
+       if( !_binary_api )
+       {
+          _binary_api = std::make_shared< binary_api >( std::ref( _app ) );
+       }
+       return *_binary_api;
+    }
+
     fc::api<network_node_api> login_api::network_node()
     {
        bool is_allowed = ( _allowed_apis.find("network_node_api") != _allowed_apis.end() );
@@ -280,7 +335,8 @@ namespace graphene { namespace app {
        if( !_database_api )
        {
           _database_api = std::make_shared< database_api >( std::ref( *_app.chain_database() ),
-                                                            &( _app.get_options() ) );
+                                                            &( _app.get_options() ),
+                                                            _app.get_subscription_hub() );
        }
        return *_database_api;
     }
@@ -371,6 +427,13 @@ namespace graphene { namespace app {
     { // Nothing else to do
     }
 
+    std::shared_ptr<const account_history::history_store> history_api::get_history_store()const
+    {
+       if( !_app.is_plugin_enabled( "account_history" ) )
+          return nullptr;
+       return _app.get_plugin<account_history::account_history_plugin>( "account_history" )->get_history_store();
+    }
+
     vector<order_history_object> history_api::get_fill_order_history( const std::string& asset_a,
                                                                       const std::string& asset_b,
                                                                       uint32_t limit )const
@@ -448,6 +511,22 @@ namespace graphene { namespace app {
           result.emplace_back( itr->operation_id(db) );
           ++itr;
        }
+       // Older history of the account may have been moved to disk
+       const auto store = get_history_store();
+       if( store && result.size() < limit && ( itr == by_op_idx.end() || itr->account != account ) )
+       {
+          const auto& stats = account(db).statistics(db);
+          const uint64_t seq = store->find_sequence( account, stats.removed_ops,
+                [start]( const operation_history_object& op ) { return op.id.instance() <= start.instance.value; } );
+          store->for_each( account, seq, 1, [&result,stop,limit]( uint64_t, const operation_history_object& op ) {
+             // Note: when stop is 0, the object with ID 0 is included
+             if( op.id.instance() <= stop.instance.value && stop.instance.value != 0 )
+                return false;
+             result.push_back( op );
+             return result.size() < limit;
+          });
+          return result;
+       }
        // Deal with a special case : include the object with ID 0 when it fits
        if( 0 == stop.instance.value && result.size() < limit && itr != by_op_idx.end() )
        {
@@ -482,19 +561,35 @@ namespace graphene { namespace app {
 
        fc::time_point_sec start = ostart.valid() ? *ostart : fc::time_point_sec::maximum();
 
+       const auto store = get_history_store();
        const auto& op_hist_idx = db.get_index_type<operation_history_index>().indices().get<by_time>();
        auto op_hist_itr = op_hist_idx.lower_bound( start );
-       if( op_hist_itr == op_hist_idx.end() )
+       if( op_hist_itr == op_hist_idx.end() && !store )
           return result;
 
-       const auto& acc_hist_idx = db.get_index_type<account_history_index>().indices().get<by_op>();
-       auto itr = acc_hist_idx.lower_bound( boost::make_tuple( account, op_hist_itr->get_id() ) );
-       auto itr_end = acc_hist_idx.upper_bound( account );
+       if( op_hist_itr != op_hist_idx.end() )
+       {
+          const auto& acc_hist_idx = db.get_index_type<account_history_index>().indices().get<by_op>();
+          auto itr = acc_hist_idx.lower_bound( boost::make_tuple( account, op_hist_itr->get_id() ) );
+          auto itr_end = acc_hist_idx.upper_bound( account );
 
-       while( itr != itr_end && result.size() < limit )
+          while( itr != itr_end && result.size() < limit )
+          {
+             result.emplace_back( itr->operation_id(db) );
+             ++itr;
+          }
+       }
+
+       // Older history of the account may have been moved to disk
+       if( store && result.size() < limit )
        {
-          result.emplace_back( itr->operation_id(db) );
-          ++itr;
+          const auto& stats = account(db).statistics(db);
+          const uint64_t seq = store->find_sequence( account, stats.removed_ops,
+                [start]( const operation_history_object& op ) { return op.block_time <= start; } );
+          store->for_each( account, seq, 1, [&result,limit]( uint64_t, const operation_history_object& op ) {
+             result.push_back( op );
+             return result.size() < limit;
+          });
        }
 
        return result;
@@ -538,6 +633,20 @@ namespace graphene { namespace app {
              node = nullptr;
           else node = &node->next(db);
        }
+       // Older history of the account may have been moved to disk
+       const auto store = get_history_store();
+       if( store && !node && result.size() < limit )
+       {
+          store->for_each( account, stats.removed_ops, 1,
+                [&result,operation_type,start,stop,limit]( uint64_t, const operation_history_object& op ) {
+             // Note: when stop is 0, the object with ID 0 is included
+             if( op.id.instance() <= stop.instance.value && stop.instance.value != 0 )
+                return false;
+             if( op.id.instance() <= start.instance.value && op.op.which() == operation_type )
+                result.push_back( op );
+             return result.size() < limit;
+          });
+       }
        if( stop.instance.value == 0 && result.size() < limit ) {
           const auto* head = db.find(account_history_id_type());
           if (head != nullptr && head->account == account && head->operation_id(db).op.which() == operation_type)
@@ -587,6 +696,17 @@ namespace graphene { namespace app {
           }
           while ( itr != itr_stop && result.size() < limit );
        }
+
+       // Older history of the account may have been moved to disk
+       const auto store = get_history_store();
+       const uint64_t disk_start = std::min( start, stats.removed_ops );
+       if( store && disk_start >= stop && result.size() < limit )
+       {
+          store->for_each( account, disk_start, stop, [&result,limit]( uint64_t, const operation_history_object& op ) {
+             result.push_back( op );
+             return result.size() < limit;
+          });
+       }
        return result;
     }
 
@@ -670,30 +790,14 @@ namespace graphene { namespace app {
        FC_ASSERT( market_hist_plugin, "Market history plugin is not enabled" );
        FC_ASSERT(_app.chain_database());
 
-       const auto& db = *_app.chain_database();
        database_api_helper db_api_helper( _app );
        asset_id_type a = db_api_helper.get_asset_from_string( asset_a )->get_id();
        asset_id_type b = db_api_helper.get_asset_from_string( asset_b )->get_id();
-       vector<bucket_object> result;
        const auto configured_limit = _app.get_options().api_limit_get_market_history;
-       result.reserve( configured_limit );
 
        if( a > b ) std::swap(a,b);
 
-       const auto& bidx = db.get_index_type<bucket_index>();
-       const auto& by_key_idx = bidx.indices().get<by_key>();
-
-       auto itr = by_key_idx.lower_bound( bucket_key( a, b, bucket_seconds, start ) );
-       while( itr != by_key_idx.end() && itr->key.open <= end && result.size() < configured_limit )
-       {
-          if( !(itr->key.base == a && itr->key.quote == b && itr->key.seconds == bucket_seconds) )
-          {
-            return result;
-          }
-          result.push_back(*itr);
-          ++itr;
-       }
-       return result;
+       return market_hist_plugin->get_market_history( a, b, bucket_seconds, start, end, configured_limit );
     } FC_CAPTURE_AND_RETHROW( (asset_a)(asset_b)(bucket_seconds)(start)(end) ) }
 
     static uint32_t validate_get_lp_history_params( const application& _app, const optional<uint32_t>& olimit )
@@ -885,7 +989,16 @@ namespace graphene { namespace app {
     asset_api::asset_api(graphene::app::application& app)
     : _app(app),
       _db( *app.chain_database() )
-    { // Nothing else to do
+    {
+       try
+       {
+          _asset_holders_count_index = &_db.get_index_type< primary_index< account_balance_index > >()
+                                    .get_secondary_index<graphene::api_helper_indexes::asset_holders_count_index>();
+       }
+       catch( const fc::assert_exception& )
+       {
+          _asset_holders_count_index = nullptr;
+       }
     }
 
     vector<asset_api::account_asset_balance> asset_api::get_asset_holders( const std::string& asset_symbol_or_id,
@@ -927,21 +1040,26 @@ namespace graphene { namespace app {
 
        return result;
     }
-    // get number of asset holders.
-    int64_t asset_api::get_asset_holders_count( const std::string& asset_symbol_or_id ) const {
+    int64_t asset_api::get_holders_count( const asset_id_type& asset_id ) const {
+       if( _asset_holders_count_index )
+          return _asset_holders_count_index->get_balance_count( asset_id ) - 1;
+
        const auto& bal_idx = _db.get_index_type< account_balance_index >().indices().get< by_asset_balance >();
-       database_api_helper db_api_helper( _app );
-       asset_id_type asset_id = db_api_helper.get_asset_from_string( asset_symbol_or_id )->get_id();
        auto range = bal_idx.equal_range( boost::make_tuple( asset_id ) );
 
        int64_t count = boost::distance(range) - 1;
 
        return count;
     }
+    // get number of asset holders.
+    int64_t asset_api::get_asset_holders_count( const std::string& asset_symbol_or_id ) const {
+       database_api_helper db_api_helper( _app );
+       asset_id_type asset_id = db_api_helper.get_asset_from_string( asset_symbol_or_id )->get_id();
+       return get_holders_count( asset_id );
+    }
     // function to get vector of system assets with holders count.
     vector<asset_api::asset_holders> asset_api::get_all_asset_holders() const {
        vector<asset_holders> result;
-       vector<asset_id_type> total_assets;
        for( const asset_object& asset_obj : _db.get_index_type<asset_index>().indices() )
        {
           const auto& dasset_obj = asset_obj.dynamic_asset_data_id(_db);
@@ -949,10 +1067,7 @@ namespace graphene { namespace app {
           asset_id_type asset_id;
           asset_id = dasset_obj.id;
 
-          const auto& bal_idx = _db.get_index_type< account_balance_index >().indices().get< by_asset_balance >();
-          auto range = bal_idx.equal_range( boost::make_tuple( asset_id ) );
-
-          int64_t count = boost::distance(range) - 1;
+          int64_t count = get_holders_count( asset_id );
 
           asset_holders ah;
           ah.asset_id       = asset_id;
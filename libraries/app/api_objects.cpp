@@ -51,6 +51,30 @@ order_book::order_book( const string& _base, const string& _quote )
    // Do nothing else
 }
 
+order_book_level::order_book_level( const graphene::protocol::price& sell_price, share_type for_sale,
+                                    share_type to_receive, uint32_t count,
+                                    const asset_object& _base, const asset_object& _quote )
+: price( price_to_string( sell_price, _base, _quote ) ),
+  order_count( count )
+{
+   if( sell_price.base.asset_id == _base.id )
+   {
+      quote = _quote.amount_to_string( to_receive );
+      base = _base.amount_to_string( for_sale );
+   }
+   else
+   {
+      quote = _quote.amount_to_string( for_sale );
+      base = _base.amount_to_string( to_receive );
+   }
+}
+
+order_book_depth::order_book_depth( const string& _base, const string& _quote )
+: base( _base ), quote( _quote )
+{
+   // Do nothing else
+}
+
 market_ticker::market_ticker(const market_ticker_object& mto,
                              const fc::time_point_sec& now,
                              const asset_object& asset_base,
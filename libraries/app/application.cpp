@@ -111,6 +111,7 @@ namespace detail {
 }}
 
 #include "application_impl.hxx"
+#include "subscription_hub.hxx"
 
 namespace graphene { namespace app { namespace detail {
 
@@ -280,6 +281,10 @@ void application_impl::initialize(const fc::path& data_dir, shared_ptr<boost::pr
 
    if ( _options->count("enable-subscribe-to-all") > 0 )
       _app_options.enable_subscribe_to_all = _options->at( "enable-subscribe-to-all" ).as<bool>();
+   if( _options->count("subscription-queue-size") > 0 )
+      _app_options.subscription_queue_size = _options->at("subscription-queue-size").as<uint32_t>();
+   if( _options->count("subscription-threads") > 0 )
+      _app_options.subscription_threads = _options->at("subscription-threads").as<uint16_t>();
 
    set_api_limit();
 
@@ -554,6 +559,25 @@ void application_impl::open_chain_database() const
       _chain_db->enable_standby_votes_tracking( _options->at("enable-standby-votes-tracking").as<bool>() );
    }
 
+   {
+      uint32_t replay_window = 0;
+      uint32_t replay_decode_threads = 0;
+      if( _options->count("replay-precompute-window") > 0 )
+         replay_window = _options->at("replay-precompute-window").as<uint32_t>();
+      if( _options->count("replay-decode-threads") > 0 )
+         replay_decode_threads = _options->at("replay-decode-threads").as<uint32_t>();
+      _chain_db->set_replay_pipeline( replay_window, replay_decode_threads );
+   }
+
+   if( _options->count("object-database-flush-interval") > 0 )
+      _chain_db->set_flush_interval( _options->at("object-database-flush-interval").as<uint32_t>() );
+
+   if( _options->count("signature-cache-size") > 0 )
+      _chain_db->set_signature_cache_size( _options->at("signature-cache-size").as<uint32_t>() );
+
+   if( _options->count("enable-evaluator-profiling") > 0 )
+      _chain_db->enable_evaluator_profiling( _options->at("enable-evaluator-profiling").as<bool>() );
+
    if( _options->count("replay-blockchain") > 0 || _options->count("revalidate-blockchain") > 0 )
       _chain_db->wipe( _data_dir / "blockchain", false );
 
@@ -602,6 +626,9 @@ void application_impl::startup()
 
    open_chain_database();
 
+   _subscription_hub = std::make_shared<subscription_hub>( *_chain_db, _app_options.subscription_queue_size,
+                                                           _app_options.subscription_threads );
+
    startup_plugins();
 
    if( enable_p2p_network && _active_plugins.find( "delayed_node" ) == _active_plugins.end() )
@@ -730,6 +757,16 @@ bool application_impl::handle_block(const graphene::net::block_message& blk_msg,
    }
 } FC_CAPTURE_AND_RETHROW( (blk_msg)(sync_mode) ) return false; }
 
+fc::future<void> application_impl::prepare_sync_block(const graphene::net::block_message& blk_msg)
+{
+   // same as in handle_block, so that nothing is computed twice
+   const uint32_t skip = (_is_block_producer || _force_validate) ?
+                            database::skip_nothing : database::skip_transaction_signatures;
+   return fc::do_parallel( [this,&blk_msg,skip] () {
+      _chain_db->precompute_serial( blk_msg.block, skip );
+   } );
+}
+
 void application_impl::handle_transaction(const graphene::net::trx_message& transaction_message)
 { try {
    static fc::time_point last_call;
@@ -824,13 +861,20 @@ message application_impl::get_item(const item_id& id)
   // ilog("Request for item ${id}", ("id", id));
    if( id.item_type == graphene::net::block_message_type )
    {
-      auto opt_block = _chain_db->fetch_block_by_id(id.item_hash);
+      auto opt_block = _chain_db->fetch_packed_block_by_id(id.item_hash);
       if( !opt_block )
          elog("Couldn't find block ${id} -- corresponding ID in our chain is ${id2}",
               ("id", id.item_hash)("id2", _chain_db->get_block_id_for_num(block_header::num_from_id(id.item_hash))));
       FC_ASSERT( opt_block.valid() );
-      // ilog("Serving up block #${num}", ("num", opt_block->block_num()));
-      return block_message(std::move(*opt_block));
+      // ilog("Serving up block #${num}", ("num", block_header::num_from_id(id.item_hash)));
+      // Same as message( block_message( block ) ), but reuses the packed block instead of unpacking and packing it
+      message result;
+      result.msg_type = graphene::net::block_message_type;
+      result.data = std::move(*opt_block);
+      const auto packed_id = fc::raw::pack( block_id_type( id.item_hash ) );
+      result.data.insert( result.data.end(), packed_id.begin(), packed_id.end() );
+      result.size = (uint32_t)result.data.size();
+      return result;
    }
    return trx_message( _chain_db->get_recent_transaction( id.item_hash ) );
 } FC_CAPTURE_AND_RETHROW( (id) ) }
@@ -1098,6 +1142,9 @@ void application_impl::shutdown()
    else
       ilog( "P2P network is disabled" );
 
+   // Database API sessions which are still open keep the hub until they are closed
+   _subscription_hub.reset();
+
    if( _chain_db )
    {
       ilog( "Closing chain database" );
@@ -1223,9 +1270,32 @@ void application::set_program_options(boost::program_options::options_descriptio
           "Number of IO threads, default to 0 for auto-configuration")
          ("enable-subscribe-to-all", bpo::value<bool>()->implicit_value(true),
           "Whether allow API clients to subscribe to universal object creation and removal events")
+         ("subscription-queue-size",
+          bpo::value<uint32_t>()->default_value(default_opts.subscription_queue_size),
+          "Maximum number of pending notifications per API client, more notifications are dropped "
+          "and the client is told to resync")
+         ("subscription-threads",
+          bpo::value<uint16_t>()->default_value(default_opts.subscription_threads),
+          "Number of threads filtering and sending notifications to API clients")
          ("enable-standby-votes-tracking", bpo::value<bool>()->implicit_value(true),
           "Whether to enable tracking of votes of standby witnesses and committee members. "
           "Set it to true to provide accurate data to API clients, set to false for slightly better performance.")
+         ("replay-precompute-window", bpo::value<uint32_t>()->default_value(0),
+          "Number of blocks to read and precompute ahead of the block being applied during replay, "
+          "default to 0 for auto-configuration")
+         ("replay-decode-threads", bpo::value<uint32_t>()->default_value(0),
+          "Number of dedicated threads reading and precomputing blocks during replay, "
+          "default to 0 for the number of IO threads")
+         ("object-database-flush-interval", bpo::value<uint32_t>()->default_value(0),
+          "Number of blocks after which the objects changed since the last save are written to disk, so that a "
+          "crashed node only replays the blocks since then, default to 0 to only save them on shutdown")
+         ("signature-cache-size",
+          bpo::value<uint32_t>()->default_value(graphene::protocol::signature_key_cache::default_capacity),
+          "Number of public keys recovered from transaction signatures to keep, so that signatures of transactions "
+          "are not checked again when the transactions are included in a block, 0 to disable")
+         ("enable-evaluator-profiling", bpo::value<bool>()->implicit_value(true),
+          "Whether to collect the time spent in evaluators per operation type and in the expensive phases of block "
+          "processing. The profile is logged at every maintenance interval and can be queried via network_node_api")
          ("api-limit-get-account-history-operations",
           bpo::value<uint32_t>()->default_value(default_opts.api_limit_get_account_history_operations),
           "For history_api::get_account_history_operations to set max limit value")
@@ -1441,6 +1511,11 @@ const application_options& application::get_options() const
    return my->_app_options;
 }
 
+std::shared_ptr<subscription_hub> application::get_subscription_hub() const
+{
+   return my->_subscription_hub;
+}
+
 const string& application::get_node_info() const
 {
    return my->_node_info;
@@ -65,6 +65,14 @@ class application_impl : public net::node_delegate, public std::enable_shared_fr
       bool handle_block(const graphene::net::block_message& blk_msg, bool sync_mode,
                         std::vector<graphene::net::message_hash_type>& contained_transaction_msg_ids) override;
 
+      /**
+       * @brief precomputes what does not depend on the state of the blockchain for a block received while
+       *        syncing, in the thread pool, so that handle_block() finds it done
+       *
+       * Called in the thread of the P2P node, it only launches the work.
+       */
+      fc::future<void> prepare_sync_block(const graphene::net::block_message& blk_msg) override;
+
       void handle_transaction(const graphene::net::trx_message& transaction_message) override;
 
       void handle_message(const graphene::net::message& message_to_process) override;
@@ -215,6 +223,7 @@ class application_impl : public net::node_delegate, public std::enable_shared_fr
       api_access _apiaccess;
 
       std::shared_ptr<graphene::chain::database>            _chain_db;
+      std::shared_ptr<subscription_hub>                     _subscription_hub;
       std::shared_ptr<graphene::net::node>                  _p2p_network;
       std::shared_ptr<fc::http::websocket_server>      _websocket_server;
       std::shared_ptr<fc::http::websocket_tls_server>  _websocket_tls_server;
@@ -49,8 +49,9 @@ namespace graphene { namespace app {
 //                                                                  //
 //////////////////////////////////////////////////////////////////////
 
-database_api::database_api( graphene::chain::database& db, const application_options* app_options )
-: my( std::make_shared<database_api_impl>( db, app_options ) )
+database_api::database_api( graphene::chain::database& db, const application_options* app_options,
+                            std::shared_ptr<subscription_hub> hub )
+: my( std::make_shared<database_api_impl>( db, app_options, std::move(hub) ) )
 { // Nothing else to do
 }
 
@@ -66,29 +67,20 @@ database_api_helper::database_api_helper( const graphene::app::application& app
 { // Nothing else to do
 }
 
-database_api_impl::database_api_impl( graphene::chain::database& db, const application_options* app_options )
-:database_api_helper( db, app_options )
+database_api_impl::database_api_impl( graphene::chain::database& db, const application_options* app_options,
+                                      std::shared_ptr<subscription_hub> hub )
+:database_api_helper( db, app_options ), _subscription_hub( std::move(hub) ),
+ _owner_thread( &fc::thread::current() )
 {
    dlog("creating database api ${x}", ("x",int64_t(this)) );
-   _new_connection = _db.new_objects.connect([this](const vector<object_id_type>& ids,
-                                                    const flat_set<account_id_type>& impacted_accounts) {
-                                on_objects_new(ids, impacted_accounts);
-                                });
-   _change_connection = _db.changed_objects.connect([this](const vector<object_id_type>& ids,
-                                                           const flat_set<account_id_type>& impacted_accounts) {
-                                on_objects_changed(ids, impacted_accounts);
-                                });
-   _removed_connection = _db.removed_objects.connect([this](const vector<object_id_type>& ids,
-                                                            const vector<const object*>& objs,
-                                                            const flat_set<account_id_type>& impacted_accounts) {
-                                on_objects_removed(ids, objs, impacted_accounts);
-                                });
-   _applied_block_connection = _db.applied_block.connect([this](const signed_block&){ on_applied_block(); });
-
-   _pending_trx_connection = _db.on_pending_transaction.connect([this](const signed_transaction& trx ){
-                                if( _pending_trx_callback )
-                                   _pending_trx_callback( fc::variant(trx, GRAPHENE_MAX_NESTED_OBJECTS) );
-                      });
+   if( !_subscription_hub )
+   {
+      const auto& options = _app_options ? *_app_options : application_options::get_default();
+      _subscription_hub = std::make_shared<subscription_hub>( _db, options.subscription_queue_size,
+                                                              options.subscription_threads );
+   }
+   _subscription_hub->add_session( this );
+
    try
    {
       amount_in_collateral_index = &_db.get_index_type< primary_index< call_order_index > >()
@@ -119,11 +111,22 @@ database_api_impl::database_api_impl( graphene::chain::database& db, const appli
       next_object_ids_index = nullptr;
    }
 
+   try
+   {
+      order_book_depth_index = &_db.get_index_type< primary_index< limit_order_index > >()
+                                    .get_secondary_index<graphene::api_helper_indexes::order_book_depth_index>();
+   }
+   catch( const fc::assert_exception& )
+   {
+      order_book_depth_index = nullptr;
+   }
+
 }
 
 database_api_impl::~database_api_impl()
 {
    dlog("freeing database api ${x}", ("x",int64_t(this)) );
+   _subscription_hub->remove_session( this );
 }
 
 //////////////////////////////////////////////////////////////////////
@@ -179,6 +182,7 @@ void database_api_impl::set_subscribe_callback( std::function<void(const variant
 
    cancel_all_subscriptions(false, false);
 
+   std::lock_guard<std::mutex> guard( _subscription_mutex );
    _subscribe_callback = cb;
    _notify_remove_create = notify_remove_create;
 }
@@ -200,6 +204,7 @@ void database_api::set_pending_transaction_callback( std::function<void(const va
 
 void database_api_impl::set_pending_transaction_callback( std::function<void(const variant&)> cb )
 {
+   std::lock_guard<std::mutex> guard( _subscription_mutex );
    _pending_trx_callback = cb;
 }
 
@@ -210,6 +215,7 @@ void database_api::set_block_applied_callback( std::function<void(const variant&
 
 void database_api_impl::set_block_applied_callback( std::function<void(const variant& block_id)> cb )
 {
+   std::lock_guard<std::mutex> guard( _subscription_mutex );
    _block_applied_callback = cb;
 }
 
@@ -220,6 +226,8 @@ void database_api::cancel_all_subscriptions()
 
 void database_api_impl::cancel_all_subscriptions( bool reset_callback, bool reset_market_subscriptions )
 {
+   std::lock_guard<std::mutex> guard( _subscription_mutex );
+
    if ( reset_callback )
       _subscribe_callback = std::function<void(const fc::variant&)>();
 
@@ -540,7 +548,10 @@ std::map<std::string, full_account, std::less<>> database_api_impl::get_full_acc
 
       if( to_subscribe && _subscribed_accounts.size() < _app_options->api_limit_get_full_accounts_subscribe )
       {
-         _subscribed_accounts.insert( account->get_id() );
+         {
+            std::lock_guard<std::mutex> guard( _subscription_mutex );
+            _subscribed_accounts.insert( account->get_id() );
+         }
          subscribe_to_item( account->id );
       }
 
@@ -1371,6 +1382,7 @@ void database_api_impl::subscribe_to_market( std::function<void(const variant&)>
 
    if(asset_a_id > asset_b_id) std::swap(asset_a_id,asset_b_id);
    FC_ASSERT(asset_a_id != asset_b_id);
+   std::lock_guard<std::mutex> guard( _subscription_mutex );
    _market_subscriptions[ std::make_pair(asset_a_id,asset_b_id) ] = callback;
 }
 
@@ -1386,6 +1398,7 @@ void database_api_impl::unsubscribe_from_market(const std::string& a, const std:
 
    if(a > b) std::swap(asset_a_id,asset_b_id);
    FC_ASSERT(asset_a_id != asset_b_id);
+   std::lock_guard<std::mutex> guard( _subscription_mutex );
    _market_subscriptions.erase(std::make_pair(asset_a_id,asset_b_id));
 }
 
@@ -1491,6 +1504,59 @@ order_book database_api_impl::get_order_book( const string& base, const string&
    return result;
 }
 
+order_book_depth database_api::get_order_book_depth( const string& base, const string& quote, uint32_t limit )const
+{
+   return my->get_order_book_depth( base, quote, limit );
+}
+
+order_book_depth database_api_impl::get_order_book_depth( const string& base, const string& quote,
+                                                          uint32_t limit )const
+{
+   FC_ASSERT( _app_options, "Internal error" );
+   const auto configured_limit = _app_options->api_limit_get_order_book;
+   FC_ASSERT( limit <= configured_limit,
+              "limit can not be greater than ${configured_limit}",
+              ("configured_limit", configured_limit) );
+
+   order_book_depth result( base, quote );
+
+   auto assets = lookup_asset_symbols( {base, quote} );
+   FC_ASSERT( assets[0], "Invalid base asset symbol: ${s}", ("s",base) );
+   FC_ASSERT( assets[1], "Invalid quote asset symbol: ${s}", ("s",quote) );
+
+   if( order_book_depth_index )
+   {
+      order_book_depth_index->get_order_book_depth( *assets[0], *assets[1], limit, result );
+      return result;
+   }
+
+   // Orders of the same price are next to each other in the by_price index
+   const auto& limit_price_idx = _db.get_index_type<limit_order_index>().indices().get<by_price>();
+   auto add_levels = [this,&limit_price_idx,&assets,limit]( asset_id_type sell, asset_id_type receive,
+                                                            vector<order_book_level>& levels ) {
+      auto itr = limit_price_idx.lower_bound( price::max( sell, receive ) );
+      auto end = limit_price_idx.upper_bound( price::min( sell, receive ) );
+      while( itr != end && levels.size() < limit )
+      {
+         const price level_price = itr->sell_price;
+         share_type for_sale;
+         share_type to_receive;
+         uint32_t count = 0;
+         for( ; itr != end && itr->sell_price == level_price; ++itr, ++count )
+         {
+            for_sale += itr->for_sale;
+            to_receive += share_type( fc::uint128_t( itr->for_sale.value ) * itr->sell_price.quote.amount.value
+                                                                      / itr->sell_price.base.amount.value );
+         }
+         levels.emplace_back( level_price, for_sale, to_receive, count, *assets[0], *assets[1] );
+      }
+   };
+   add_levels( assets[0]->get_id(), assets[1]->get_id(), result.bids );
+   add_levels( assets[1]->get_id(), assets[0]->get_id(), result.asks );
+
+   return result;
+}
+
 vector<market_ticker> database_api::get_top_markets(uint32_t limit)const
 {
    return my->get_top_markets(limit);
@@ -3162,7 +3228,7 @@ void database_api_impl::broadcast_updates( const vector<variant>& updates )
 {
    if( !updates.empty() && _subscribe_callback ) {
       auto capture_this = shared_from_this();
-      fc::async([capture_this,updates](){
+      _owner_thread->async([capture_this,updates](){
           if(capture_this->_subscribe_callback)
             capture_this->_subscribe_callback( fc::variant(updates) );
       });
@@ -3174,7 +3240,7 @@ void database_api_impl::broadcast_market_updates( const market_queue_type& queue
    if( !queue.empty() )
    {
       auto capture_this = shared_from_this();
-      fc::async([capture_this, this, queue](){
+      _owner_thread->async([capture_this, this, queue](){
           for( const auto& item : queue )
           {
             auto sub = _market_subscriptions.find(item.first);
@@ -3185,65 +3251,49 @@ void database_api_impl::broadcast_market_updates( const market_queue_type& queue
    }
 }
 
-void database_api_impl::on_objects_removed( const vector<object_id_type>& ids,
-                                            const vector<const object*>& objs,
-                                            const flat_set<account_id_type>& impacted_accounts )
+void database_api_impl::on_objects_removed( const object_notification& notification )
 {
-   handle_object_changed(_notify_remove_create, false, ids, impacted_accounts,
-      [objs](object_id_type id) -> const object* {
-         auto it = std::find_if(
-               objs.begin(), objs.end(),
-               [id](const object* o) {return o != nullptr && o->id == id;});
-
-         if (it != objs.end())
-            return *it;
-
-         return nullptr;
-      }
-   );
+   std::lock_guard<std::mutex> guard( _subscription_mutex );
+   handle_object_changed( _notify_remove_create, false, notification );
 }
 
-void database_api_impl::on_objects_new( const vector<object_id_type>& ids,
-                                        const flat_set<account_id_type>& impacted_accounts )
+void database_api_impl::on_objects_new( const object_notification& notification )
 {
-   handle_object_changed(_notify_remove_create, true, ids, impacted_accounts,
-      std::bind(&object_database::find_object, &_db, std::placeholders::_1)
-   );
+   std::lock_guard<std::mutex> guard( _subscription_mutex );
+   handle_object_changed( _notify_remove_create, true, notification );
 }
 
-void database_api_impl::on_objects_changed( const vector<object_id_type>& ids,
-                                            const flat_set<account_id_type>& impacted_accounts )
+void database_api_impl::on_objects_changed( const object_notification& notification )
 {
-   handle_object_changed(false, true, ids, impacted_accounts,
-      std::bind(&object_database::find_object, &_db, std::placeholders::_1)
-   );
+   std::lock_guard<std::mutex> guard( _subscription_mutex );
+   handle_object_changed( false, true, notification );
 }
 
+// The caller should hold _subscription_mutex
 void database_api_impl::handle_object_changed( bool force_notify,
                                                bool full_object,
-                                               const vector<object_id_type>& ids,
-                                               const flat_set<account_id_type>& impacted_accounts,
-                                               std::function<const object*(object_id_type id)> find_object )
+                                               const object_notification& notification )
 {
+   const auto& ids = notification.ids;
    if( _subscribe_callback )
    {
       vector<variant> updates;
 
-      for(auto id : ids)
+      for( size_t i = 0; i < ids.size(); ++i )
       {
-         if( force_notify || is_subscribed_to_item(id) || is_impacted_account(impacted_accounts) )
+         if( force_notify || is_subscribed_to_item(ids[i]) || is_impacted_account(notification.impacted_accounts) )
          {
             if( full_object )
             {
-               auto obj = find_object(id);
+               const fc::variant* obj = notification.full_variant(i);
                if( obj )
                {
-                  updates.emplace_back( obj->to_variant() );
+                  updates.emplace_back( *obj );
                }
             }
             else
             {
-               updates.emplace_back( fc::variant( id, 1 ) );
+               updates.emplace_back( notification.id_variant(i) );
             }
          }
       }
@@ -3256,83 +3306,104 @@ void database_api_impl::handle_object_changed( bool force_notify,
    {
       market_queue_type broadcast_queue;
 
-      for(auto id : ids)
-      {
-         if( id.is<call_order_id_type>() )
-         {
-            enqueue_if_subscribed_to_market<call_order_object>( find_object(id), broadcast_queue, full_object );
-         }
-         else if( id.is<limit_order_id_type>() )
-         {
-            enqueue_if_subscribed_to_market<limit_order_object>( find_object(id), broadcast_queue, full_object );
-         }
-         else if( id.is<force_settlement_id_type>() )
-         {
-            enqueue_if_subscribed_to_market<force_settlement_object>( find_object(id), broadcast_queue,
-                                                                      full_object );
-         }
-      }
+      for( size_t i = 0; i < ids.size(); ++i )
+         enqueue_if_subscribed_to_market( notification, i, broadcast_queue, full_object );
 
       if( !broadcast_queue.empty() )
          broadcast_market_updates(broadcast_queue);
    }
 }
 
-/** note: this method cannot yield because it is called in the middle of
- * apply a block.
- */
-void database_api_impl::on_applied_block()
+void database_api_impl::on_applied_block( const block_notification& notification )
 {
+   std::lock_guard<std::mutex> guard( _subscription_mutex );
+
    if (_block_applied_callback)
    {
       auto capture_this = shared_from_this();
-      block_id_type block_id = _db.head_block_id();
-      fc::async([this,capture_this,block_id](){
-         _block_applied_callback(fc::variant(block_id, 1));
+      fc::variant block_id = notification.block_id();
+      _owner_thread->async([this,capture_this,block_id](){
+         if( _block_applied_callback )
+            _block_applied_callback(block_id);
       });
    }
 
    if( _market_subscriptions.empty() )
       return;
 
-   const auto& ops = _db.get_applied_operations();
-   map< std::pair<asset_id_type,asset_id_type>, vector<pair<operation, operation_result>> > subscribed_markets_ops;
-   for(const optional< operation_history_object >& o_op : ops)
+   // FIXME this may cause fill_order_operation be pushed before order creation
+   std::map< market_type, fc::variant > subscribed_markets_ops;
+   for( const auto& item : _market_subscriptions )
    {
-      if( !o_op.valid() )
-         continue;
-      const operation_history_object& op = *o_op;
-
-      optional< std::pair<asset_id_type,asset_id_type> > market;
-      switch(op.op.which())
-      {
-         /*  This is sent via the object_changed callback
-         case operation::tag<limit_order_create_operation>::value:
-            market = op.op.get<limit_order_create_operation>().get_market();
-            break;
-         */
-         case operation::tag<fill_order_operation>::value:
-            market = op.op.get<fill_order_operation>().get_market();
-            break;
-            /*
-         case operation::tag<limit_order_cancel_operation>::value:
-         */
-         default: break;
-      }
-      if( market.valid() && _market_subscriptions.count(*market) > 0 )
-         // FIXME this may cause fill_order_operation be pushed before order creation
-         subscribed_markets_ops[*market].emplace_back(std::make_pair(op.op, op.result));
+      const fc::variant* fills = notification.market_fills( item.first );
+      if( fills )
+         subscribed_markets_ops[item.first] = *fills;
    }
+   if( subscribed_markets_ops.empty() )
+      return;
    /// we need to ensure the database_api is not deleted for the life of the async operation
    auto capture_this = shared_from_this();
-   fc::async([this,capture_this,subscribed_markets_ops](){
-      for(auto item : subscribed_markets_ops)
+   _owner_thread->async([this,capture_this,subscribed_markets_ops](){
+      for(const auto& item : subscribed_markets_ops)
       {
          auto itr = _market_subscriptions.find(item.first);
          if(itr != _market_subscriptions.end())
-            itr->second(fc::variant(item.second, GRAPHENE_NET_MAX_NESTED_OBJECTS));
+            itr->second( item.second );
       }
    });
 }
 
+void database_api_impl::on_pending_transaction( const pending_transaction_notification& notification )
+{
+   if( !has_pending_transaction_callback() )
+      return;
+   fc::variant trx = notification.transaction();
+   auto capture_this = shared_from_this();
+   _owner_thread->async([this,capture_this,trx](){
+      if( _pending_trx_callback )
+         _pending_trx_callback( trx );
+   });
+}
+
+void database_api_impl::on_resync_required()
+{
+   // Tell every subscriber that some notifications were lost, so that it can query the data again
+   fc::variant resync = fc::mutable_variant_object( "resync_required", true );
+
+   std::lock_guard<std::mutex> guard( _subscription_mutex );
+   if( _subscribe_callback )
+      broadcast_updates( vector<variant>{ resync } );
+   if( !_market_subscriptions.empty() )
+   {
+      market_queue_type queue;
+      for( const auto& item : _market_subscriptions )
+         queue[item.first].push_back( resync );
+      broadcast_market_updates( queue );
+   }
+}
+
+bool database_api_impl::has_object_subscriptions()const
+{
+   std::lock_guard<std::mutex> guard( _subscription_mutex );
+   return _subscribe_callback || !_market_subscriptions.empty();
+}
+
+bool database_api_impl::has_block_subscriptions()const
+{
+   std::lock_guard<std::mutex> guard( _subscription_mutex );
+   return _block_applied_callback || !_market_subscriptions.empty();
+}
+
+bool database_api_impl::has_market_subscriptions()const
+{
+   std::lock_guard<std::mutex> guard( _subscription_mutex );
+   return !_market_subscriptions.empty();
+}
+
+bool database_api_impl::has_pending_transaction_callback()const
+{
+   std::lock_guard<std::mutex> guard( _subscription_mutex );
+   return !!_pending_trx_callback;
+}
+
 } } // graphene::app
@@ -25,6 +25,7 @@
 
 #include <fc/bloom_filter.hpp>
 #include "database_api_helper.hxx"
+#include "subscription_hub.hxx"
 
 #define GET_REQUIRED_FEES_MAX_RECURSION 4
 
@@ -36,7 +37,8 @@ using market_queue_type = std::map< std::pair<graphene::chain::asset_id_type, gr
 class database_api_impl : public std::enable_shared_from_this<database_api_impl>, public database_api_helper
 {
    public:
-      database_api_impl( graphene::chain::database& db, const application_options* app_options );
+      database_api_impl( graphene::chain::database& db, const application_options* app_options,
+                         std::shared_ptr<subscription_hub> hub );
       virtual ~database_api_impl();
 
       // Objects
@@ -129,6 +131,8 @@ class database_api_impl : public std::enable_shared_from_this<database_api_impl>
       market_volume                      get_24_volume( const string& base, const string& quote )const;
       order_book                         get_order_book( const string& base, const string& quote,
                                                          uint32_t limit )const;
+      order_book_depth                   get_order_book_depth( const string& base, const string& quote,
+                                                               uint32_t limit )const;
       vector<market_ticker>              get_top_markets( uint32_t limit )const;
       vector<market_trade>               get_trade_history( const string& base, const string& quote,
                                                             fc::time_point_sec start, fc::time_point_sec stop,
@@ -344,12 +348,14 @@ class database_api_impl : public std::enable_shared_from_this<database_api_impl>
             return;
 
          vector<char> key = get_subscription_key( object_id_type(item) );
+         std::lock_guard<std::mutex> guard( _subscription_mutex );
          if( !_subscribe_filter.contains( key.data(), key.size() ) )
          {
             _subscribe_filter.insert( key.data(), key.size() );
          }
       }
 
+      // The caller should hold _subscription_mutex
       template<typename T>
       bool is_subscribed_to_item( const T& item )const
       {
@@ -360,37 +366,21 @@ class database_api_impl : public std::enable_shared_from_this<database_api_impl>
          return _subscribe_filter.contains( key.data(), key.size() );
       }
 
-      // for full-account subscription
+      // for full-account subscription, the caller should hold _subscription_mutex
       bool is_impacted_account( const flat_set<account_id_type>& accounts );
 
-      // for market subscription
-      template<typename T>
-      const std::pair<asset_id_type,asset_id_type> get_order_market( const T& order )
-      {
-         return order.get_market();
-      }
-
-      // for market subscription
-      const std::pair<asset_id_type,asset_id_type> get_order_market( const force_settlement_object& order )
+      // for market subscription, the caller should hold _subscription_mutex
+      void enqueue_if_subscribed_to_market( const object_notification& notification, size_t i,
+                                            market_queue_type& queue, bool full_object=true )
       {
-         // TODO cache the result to avoid repeatly fetching from db
-         asset_id_type backing_id = order.balance.asset_id( _db ).bitasset_data( _db ).options.short_backing_asset;
-         auto tmp = std::make_pair( order.balance.asset_id, backing_id );
-         if( tmp.first > tmp.second ) std::swap( tmp.first, tmp.second );
-         return tmp;
-      }
-
-      template<typename T>
-      void enqueue_if_subscribed_to_market(const object* obj, market_queue_type& queue, bool full_object=true)
-      {
-         const T* order = dynamic_cast<const T*>(obj);
-         FC_ASSERT( order != nullptr);
-
-         const auto& market = get_order_market( *order );
+         const auto& market = notification.order_market(i);
+         if( !market.valid() )
+            return;
 
-         auto sub = _market_subscriptions.find( market );
+         auto sub = _market_subscriptions.find( *market );
          if( sub != _market_subscriptions.end() ) {
-            queue[market].emplace_back( full_object ? obj->to_variant() : fc::variant(obj->id, 1) );
+            const fc::variant* obj = full_object ? notification.full_variant(i) : nullptr;
+            queue[*market].emplace_back( obj ? *obj : notification.id_variant(i) );
          }
       }
 
@@ -398,16 +388,27 @@ class database_api_impl : public std::enable_shared_from_this<database_api_impl>
       void broadcast_market_updates( const market_queue_type& queue);
       void handle_object_changed( bool force_notify,
                                   bool full_object,
-                                  const vector<object_id_type>& ids,
-                                  const flat_set<account_id_type>& impacted_accounts,
-                                  std::function<const object*(object_id_type id)> find_object );
-
-      /** called every time a block is applied to report the objects that were changed */
-      void on_objects_new(const vector<object_id_type>& ids, const flat_set<account_id_type>& impacted_accounts);
-      void on_objects_changed(const vector<object_id_type>& ids, const flat_set<account_id_type>& impacted_accounts);
-      void on_objects_removed(const vector<object_id_type>& ids, const vector<const object*>& objs,
-                              const flat_set<account_id_type>& impacted_accounts);
-      void on_applied_block();
+                                  const object_notification& notification );
+
+      /** called by the subscription hub in a worker thread to report the objects that were changed */
+      void on_objects_new( const object_notification& notification );
+      void on_objects_changed( const object_notification& notification );
+      void on_objects_removed( const object_notification& notification );
+      void on_applied_block( const block_notification& notification );
+      void on_pending_transaction( const pending_transaction_notification& notification );
+      /** called by the subscription hub in a worker thread when notifications were dropped for this session */
+      void on_resync_required();
+
+      /// Used by the subscription hub to decide which sessions to notify
+      /// @{
+      bool has_object_subscriptions()const;
+      bool has_block_subscriptions()const;
+      bool has_market_subscriptions()const;
+      bool has_pending_transaction_callback()const;
+      /// @}
+
+      /// @return the thread which created this session, where callbacks are called
+      fc::thread* get_owner_thread()const { return _owner_thread; }
 
       ////////////////////////////////////////////////
       // Member variables
@@ -423,17 +424,17 @@ class database_api_impl : public std::enable_shared_from_this<database_api_impl>
       std::function<void(const fc::variant&)> _pending_trx_callback;
       std::function<void(const fc::variant&)> _block_applied_callback;
 
-      boost::signals2::scoped_connection _new_connection;
-      boost::signals2::scoped_connection _change_connection;
-      boost::signals2::scoped_connection _removed_connection;
-      boost::signals2::scoped_connection _applied_block_connection;
-      boost::signals2::scoped_connection _pending_trx_connection;
+      std::shared_ptr<subscription_hub> _subscription_hub;
+      fc::thread* _owner_thread;
+      /// Guards the subscription data which is read by the workers of the subscription hub
+      mutable std::mutex _subscription_mutex;
 
       map< pair<asset_id_type,asset_id_type>, std::function<void(const variant&)> > _market_subscriptions;
 
       const graphene::api_helper_indexes::amount_in_collateral_index* amount_in_collateral_index;
       const graphene::api_helper_indexes::asset_in_liquidity_pools_index* asset_in_liquidity_pools_index;
       const graphene::api_helper_indexes::next_object_ids_index* next_object_ids_index;
+      const graphene::api_helper_indexes::order_book_depth_index* order_book_depth_index;
 };
 
 } } // graphene::app
@@ -49,6 +49,10 @@
 #include <string>
 #include <vector>
 
+namespace graphene { namespace account_history {
+   class history_store;
+} }
+
 namespace graphene { namespace app {
    using namespace graphene::chain;
    using namespace graphene::market_history;
@@ -300,6 +304,9 @@ namespace graphene { namespace app {
                const optional<int64_t>& operation_type = optional<int64_t>() )const;
 
       private:
+           /// @return the store of account history moved to disk, or null if not enabled
+           std::shared_ptr<const account_history::history_store> get_history_store()const;
+
            application& _app;
    };
 
@@ -323,6 +330,49 @@ namespace graphene { namespace app {
       const graphene::chain::database& _db;
    };
 
+   /**
+    * @brief The binary_api class returns data in the binary format of @a fc::raw instead of as JSON objects
+    *
+    * The results are packed straight from the objects, which is much cheaper than converting large objects to
+    * JSON, and smaller to transfer.  Clients unpack them with the same reflection.
+    */
+   class binary_api
+   {
+   public:
+      explicit binary_api(application& app);
+
+      /**
+       * @brief Get signed blocks
+       * @param block_num_from The lowest block number
+       * @param block_num_to The highest block number
+       * @return The packed @a vector<optional<signed_block>> of blocks from block_num_from till block_num_to
+       */
+      vector<char> get_blocks(uint32_t block_num_from, uint32_t block_num_to)const;
+
+      /**
+       * @brief Get the objects corresponding to the provided IDs
+       * @param ids IDs of the objects to retrieve
+       * @return The packed @a vector<optional<vector<char>>> of the objects, each of them packed, or null if the
+       *         object was not found.  The type of each object is given by its ID.
+       */
+      vector<char> get_objects(const vector<object_id_type>& ids)const;
+
+      /**
+       * @brief Get the history of operations related to the specified account,
+       *        with the same parameters as @ref history_api::get_account_history
+       * @return The packed @a vector<operation_history_object> of operations, ordered from most recent to oldest
+       */
+      vector<char> get_account_history(
+         const std::string& account_name_or_id,
+         operation_history_id_type stop = operation_history_id_type(),
+         uint32_t limit = application_options::get_default().api_limit_get_account_history,
+         operation_history_id_type start = operation_history_id_type()
+      )const;
+
+   private:
+      application& _app;
+   };
+
 
    /**
     * @brief The network_broadcast_api class allows broadcasting of transactions.
@@ -429,6 +479,13 @@ namespace graphene { namespace app {
           */
          std::vector<net::potential_peer_record> get_potential_peers() const;
 
+         /**
+          * @brief Get the time spent in evaluators per operation type and in the expensive phases of block processing
+          * @param reset Whether to clear the collected data after retrieving it, false by default
+          * @note Profiling needs to be enabled with the @a enable-evaluator-profiling node option
+          */
+         graphene::chain::evaluator_profile get_evaluator_profile( const optional<bool>& reset = optional<bool>() ) const;
+
       private:
          application& _app;
    };
@@ -587,8 +644,12 @@ namespace graphene { namespace app {
          vector<asset_holders> get_all_asset_holders() const;
 
       private:
+         /// @return the number of holders of an asset, found with the helper index if it is available
+         int64_t get_holders_count( const asset_id_type& asset_id ) const;
+
          graphene::app::application& _app;
          graphene::chain::database& _db;
+         const graphene::api_helper_indexes::asset_holders_count_index* _asset_holders_count_index;
    };
 
    /**
@@ -701,6 +762,7 @@ namespace graphene { namespace app {
 } } // graphene::app
 
 extern template class fc::api<graphene::app::block_api>;
+extern template class fc::api<graphene::app::binary_api>;
 extern template class fc::api<graphene::app::network_broadcast_api>;
 extern template class fc::api<graphene::app::network_node_api>;
 extern template class fc::api<graphene::app::history_api>;
@@ -757,6 +819,8 @@ namespace graphene { namespace app {
 
          /// @brief Retrieve the network block API set
          fc::api<block_api> block();
+         /// @brief Retrieve the binary API set
+         fc::api<binary_api> binary();
          /// @brief Retrieve the network broadcast API set
          fc::api<network_broadcast_api> network_broadcast();
          /// @brief Retrieve the database API set
@@ -789,6 +853,7 @@ namespace graphene { namespace app {
          flat_set< string > _allowed_apis;
 
          optional< fc::api<block_api> >                          _block_api;
+         optional< fc::api<binary_api> >                         _binary_api;
          optional< fc::api<database_api> >                       _database_api;
          optional< fc::api<network_broadcast_api> >              _network_broadcast_api;
          optional< fc::api<network_node_api> >                   _network_node_api;
@@ -839,6 +904,11 @@ FC_API(graphene::app::history_api,
 FC_API(graphene::app::block_api,
        (get_blocks)
      )
+FC_API(graphene::app::binary_api,
+       (get_blocks)
+       (get_objects)
+       (get_account_history)
+     )
 FC_API(graphene::app::network_broadcast_api,
        (broadcast_transaction)
        (broadcast_transaction_with_callback)
@@ -852,6 +922,7 @@ FC_API(graphene::app::network_node_api,
        (get_potential_peers)
        (get_advanced_node_parameters)
        (set_advanced_node_parameters)
+       (get_evaluator_profile)
      )
 FC_API(graphene::app::crypto_api,
        (blind)
@@ -884,6 +955,7 @@ FC_API(graphene::app::login_api,
        (get_config)
        (get_available_api_sets)
        (block)
+       (binary)
        (network_broadcast)
        (database)
        (history)
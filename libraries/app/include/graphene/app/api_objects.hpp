@@ -109,6 +109,37 @@ namespace graphene { namespace app {
      order_book( const string& _base, const string& _quote );
    };
 
+   /// All orders of a market at the same price
+   struct order_book_level
+   {
+      string                     price;
+      string                     quote;
+      string                     base;
+      uint32_t                   order_count = 0;
+
+      order_book_level() = default;
+      /**
+       * @param sell_price the price of the orders
+       * @param for_sale the amount the orders sell in total
+       * @param to_receive the amount the orders receive in total
+       * @param count the number of orders
+       * @param _base the base asset of the market
+       * @param _quote the quote asset of the market
+       */
+      order_book_level( const graphene::protocol::price& sell_price, share_type for_sale, share_type to_receive,
+                        uint32_t count, const asset_object& _base, const asset_object& _quote );
+   };
+
+   struct order_book_depth
+   {
+     string                      base;
+     string                      quote;
+     vector< order_book_level >  bids;
+     vector< order_book_level >  asks;
+     order_book_depth() = default;
+     order_book_depth( const string& _base, const string& _quote );
+   };
+
    struct market_ticker
    {
       time_point_sec             time;
@@ -216,6 +247,8 @@ FC_REFLECT( graphene::app::full_account,
 
 FC_REFLECT( graphene::app::order, (price)(quote)(base)(id)(owner_id)(owner_name)(expiration) )
 FC_REFLECT( graphene::app::order_book, (base)(quote)(bids)(asks) )
+FC_REFLECT( graphene::app::order_book_level, (price)(quote)(base)(order_count) )
+FC_REFLECT( graphene::app::order_book_depth, (base)(quote)(bids)(asks) )
 FC_REFLECT( graphene::app::market_ticker,
             (time)(base)(quote)(latest)(lowest_ask)(lowest_ask_base_size)(lowest_ask_quote_size)
             (highest_bid)(highest_bid_base_size)(highest_bid_quote_size)(percent_change)(base_volume)(quote_volume)
@@ -34,11 +34,14 @@ namespace graphene { namespace app {
    using std::string;
 
    class abstract_plugin;
+   class subscription_hub;
 
    class application_options
    {
       public:
          bool enable_subscribe_to_all = false;
+         uint32_t subscription_queue_size = 1000;
+         uint16_t subscription_threads = 2;
 
          bool has_api_helper_indexes_plugin = false;
          bool has_market_history_plugin = false;
@@ -151,6 +154,10 @@ namespace graphene { namespace app {
 
          const application_options& get_options() const;
 
+         /// @return the hub dispatching notifications of the chain database to the database API sessions,
+         ///         created at startup
+         std::shared_ptr<subscription_hub> get_subscription_hub() const;
+
          void enable_plugin( const string& name ) const;
 
          bool is_plugin_enabled(const string& name) const;
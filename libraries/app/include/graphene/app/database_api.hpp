@@ -59,6 +59,7 @@ using std::vector;
 using std::map;
 
 class database_api_impl;
+class subscription_hub;
 
 /**
  * @brief The database_api class implements the RPC API for the chain database.
@@ -70,7 +71,14 @@ class database_api_impl;
 class database_api
 {
    public:
-      database_api(graphene::chain::database& db, const application_options* app_options = nullptr );
+      /**
+       * @param db the database to access
+       * @param app_options the options of the application, the defaults are used if null
+       * @param hub dispatches the notifications of @p db to the subscriptions, usually the one of the application.
+       *            If null, a hub only for this instance is created with the settings of @p app_options.
+       */
+      database_api( graphene::chain::database& db, const application_options* app_options = nullptr,
+                    std::shared_ptr<subscription_hub> hub = nullptr );
       ~database_api();
 
       /////////////
@@ -106,6 +114,10 @@ class database_api
        *        on server startup.
        *
        * Note: auto-subscription is enabled by default and can be disabled with @ref set_auto_subscription API.
+       *
+       * Note: if the client is too slow to keep up with the notifications, some of them will be dropped, after
+       *       that the callback will be passed an object `{"resync_required":true}`, and the client should
+       *       query the data it is interested in again.
        */
       void set_subscribe_callback( std::function<void(const variant&)> cb, bool notify_remove_create );
       /**
@@ -598,6 +610,9 @@ class database_api
        *
        * Callback will be passed a variant containing a vector<pair<operation, operation_result>>. The vector will
        * contain, in order, the operations which changed the market, and their results.
+       *
+       * If the client is too slow to keep up with the notifications, some of them will be dropped, after that
+       * the callback will be passed a vector containing an object `{"resync_required":true}`.
        */
       void subscribe_to_market(std::function<void(const variant&)> callback,
                                const std::string& a, const std::string& b);
@@ -636,6 +651,20 @@ class database_api
       order_book get_order_book( const string& base, const string& quote,
             uint32_t limit = application_options::get_default().api_limit_get_order_book )const;
 
+      /**
+       * @brief Returns the order book for the market base:quote with the orders of the same price summed up
+       * @param base symbol name or ID of the base asset
+       * @param quote symbol name or ID of the quote asset
+       * @param limit number of price levels to retrieve, for bids and asks each, capped at the configured value
+       *              of @a api_limit_get_order_book
+       * @return Price levels of the market, from the best price to the worst
+       *
+       * @note If the api_helper_indexes plugin is enabled, the levels are kept up to date by it, otherwise all
+       *       orders of the returned levels are read.
+       */
+      order_book_depth get_order_book_depth( const string& base, const string& quote,
+            uint32_t limit = application_options::get_default().api_limit_get_order_book )const;
+
       /**
        * @brief Returns vector of tickers sorted by reverse base_volume
        * @note this API is experimental and subject to change in next releases
@@ -1523,6 +1552,7 @@ FC_API(graphene::app::database_api,
 
    // Markets / feeds
    (get_order_book)
+   (get_order_book_depth)
    (get_limit_orders)
    (get_limit_orders_by_account)
    (get_account_limit_orders)
@@ -0,0 +1,394 @@
+/*
+ * Copyright (c) 2026 Contributors.
+ *
+ * The MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <graphene/app/database_api.hpp>
+
+#include "database_api_impl.hxx"
+
+#include <graphene/net/config.hpp>
+
+#include <boost/lockfree/spsc_queue.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <unordered_map>
+
+namespace graphene { namespace app {
+
+namespace {
+
+template<typename T>
+market_type get_order_market( const T& order, const graphene::chain::database& )
+{
+   return order.get_market();
+}
+
+market_type get_order_market( const force_settlement_object& order, const graphene::chain::database& db )
+{
+   // TODO cache the result to avoid repeatly fetching from db
+   asset_id_type backing_id = order.balance.asset_id( db ).bitasset_data( db ).options.short_backing_asset;
+   auto tmp = std::make_pair( order.balance.asset_id, backing_id );
+   if( tmp.first > tmp.second ) std::swap( tmp.first, tmp.second );
+   return tmp;
+}
+
+template<typename T>
+market_type get_order_market( const object* obj, const graphene::chain::database& db )
+{
+   const T* order = dynamic_cast<const T*>( obj );
+   FC_ASSERT( order != nullptr );
+   return get_order_market( *order, db );
+}
+
+} // namespace
+
+object_notification::object_notification( change_kind kind_in,
+                                          const vector<object_id_type>& ids_in,
+                                          const flat_set<account_id_type>& impacted_accounts_in,
+                                          const graphene::chain::database& db,
+                                          const find_function& find_object )
+: kind( kind_in ), ids( ids_in ), impacted_accounts( impacted_accounts_in ),
+  _order_markets( ids_in.size() ), _full_variants( ids_in.size() )
+{
+   _objects.reserve( ids.size() );
+   for( const auto& id : ids )
+   {
+      const object* obj = find_object( id );
+      // Sessions only send IDs of removed objects, no need to copy them
+      _objects.emplace_back( ( obj != nullptr && kind != change_kind::removed ) ? obj->clone() : nullptr );
+      if( obj == nullptr )
+         continue;
+
+      if( id.is<call_order_id_type>() )
+         _order_markets[ _objects.size() - 1 ] = get_order_market<call_order_object>( obj, db );
+      else if( id.is<limit_order_id_type>() )
+         _order_markets[ _objects.size() - 1 ] = get_order_market<limit_order_object>( obj, db );
+      else if( id.is<force_settlement_id_type>() )
+         _order_markets[ _objects.size() - 1 ] = get_order_market<force_settlement_object>( obj, db );
+   }
+}
+
+const fc::variant* object_notification::full_variant( size_t i )const
+{
+   if( !_objects[i] )
+      return nullptr;
+   std::lock_guard<std::mutex> guard( _variants_mutex );
+   if( !_full_variants[i].valid() )
+      _full_variants[i] = _objects[i]->to_variant();
+   return &(*_full_variants[i]);
+}
+
+fc::variant object_notification::id_variant( size_t i )const
+{
+   return fc::variant( ids[i], 1 );
+}
+
+void object_notification::deliver( database_api_impl& session )const
+{
+   switch( kind )
+   {
+      case change_kind::created:
+         session.on_objects_new( *this );
+         break;
+      case change_kind::changed:
+         session.on_objects_changed( *this );
+         break;
+      case change_kind::removed:
+         session.on_objects_removed( *this );
+         break;
+   }
+}
+
+block_notification::block_notification( const graphene::chain::database& db, bool with_market_fills )
+: _block_id( db.head_block_id(), 1 )
+{
+   if( !with_market_fills )
+      return;
+   for( const optional< operation_history_object >& o_op : db.get_applied_operations() )
+   {
+      if( !o_op.valid() )
+         continue;
+      const operation_history_object& op = *o_op;
+      if( op.op.which() == operation::tag<fill_order_operation>::value )
+         _fills[ op.op.get<fill_order_operation>().get_market() ].emplace_back( op.op, op.result );
+   }
+}
+
+const fc::variant* block_notification::market_fills( const market_type& market )const
+{
+   auto itr = _fills.find( market );
+   if( itr == _fills.end() )
+      return nullptr;
+   std::lock_guard<std::mutex> guard( _variants_mutex );
+   auto vitr = _fill_variants.find( market );
+   if( vitr == _fill_variants.end() )
+      vitr = _fill_variants.emplace( market, fc::variant( itr->second, GRAPHENE_NET_MAX_NESTED_OBJECTS ) ).first;
+   return &vitr->second;
+}
+
+void block_notification::deliver( database_api_impl& session )const
+{
+   session.on_applied_block( *this );
+}
+
+pending_transaction_notification::pending_transaction_notification( const signed_transaction& trx )
+: _trx( trx )
+{ // Nothing else to do
+}
+
+const fc::variant& pending_transaction_notification::transaction()const
+{
+   std::lock_guard<std::mutex> guard( _variant_mutex );
+   if( !_trx_variant.valid() )
+      _trx_variant = fc::variant( _trx, GRAPHENE_MAX_NESTED_OBJECTS );
+   return *_trx_variant;
+}
+
+void pending_transaction_notification::deliver( database_api_impl& session )const
+{
+   session.on_pending_transaction( *this );
+}
+
+/// The queue of one session, written by the thread emitting the database signals and read by one worker
+struct subscription_hub::session_queue
+{
+   session_queue( database_api_impl* s, fc::thread* w, uint32_t capacity )
+   : session( s ), worker( w ), events( capacity )
+   { // Nothing else to do
+   }
+
+   database_api_impl* const session;
+   fc::thread* const        worker;
+
+   /// An empty pointer in the queue tells the session that notifications were dropped before it
+   boost::lockfree::spsc_queue< std::shared_ptr<const subscription_event> > events;
+   std::atomic<bool>        draining { false };
+
+   /// Whether notifications were dropped and the session is not told yet, only accessed by the writer
+   bool                     overflowed = false;
+};
+
+subscription_hub::subscription_hub( graphene::chain::database& db, uint32_t queue_size, uint16_t num_threads )
+: _db( db ), _queue_size( std::max<uint32_t>( queue_size, 1 ) )
+{
+   num_threads = std::max<uint16_t>( num_threads, 1 );
+   _threads.reserve( num_threads );
+   for( uint16_t i = 0; i < num_threads; ++i )
+      _threads.push_back( std::make_unique<fc::thread>( "subscriptions_" + fc::to_string(i) ) );
+
+   _new_connection = _db.new_objects.connect([this](const vector<object_id_type>& ids,
+                                                    const flat_set<account_id_type>& impacted_accounts) {
+                                on_objects_new(ids, impacted_accounts);
+                                });
+   _change_connection = _db.changed_objects.connect([this](const vector<object_id_type>& ids,
+                                                           const flat_set<account_id_type>& impacted_accounts) {
+                                on_objects_changed(ids, impacted_accounts);
+                                });
+   _removed_connection = _db.removed_objects.connect([this](const vector<object_id_type>& ids,
+                                                            const vector<const object*>& objs,
+                                                            const flat_set<account_id_type>& impacted_accounts) {
+                                on_objects_removed(ids, objs, impacted_accounts);
+                                });
+   _applied_block_connection = _db.applied_block.connect([this](const signed_block&){ on_applied_block(); });
+
+   _pending_trx_connection = _db.on_pending_transaction.connect([this](const signed_transaction& trx ){
+                                on_pending_transaction( trx );
+                                });
+}
+
+subscription_hub::~subscription_hub()
+{
+   // Sessions keep the hub alive, so no worker has anything left to do
+   for( auto& thread : _threads )
+      thread->quit();
+}
+
+void subscription_hub::add_session( database_api_impl* session )
+{
+   std::lock_guard<std::mutex> guard( _sessions_mutex );
+   fc::thread* worker = _threads[ _next_thread ].get();
+   _next_thread = ( _next_thread + 1 ) % _threads.size();
+   _sessions.push_back( std::make_shared<session_queue>( session, worker, _queue_size ) );
+}
+
+void subscription_hub::remove_session( database_api_impl* session )
+{
+   std::lock_guard<std::mutex> guard( _sessions_mutex );
+   _sessions.erase( std::remove_if( _sessions.begin(), _sessions.end(),
+                                    [session]( const std::shared_ptr<session_queue>& queue ) {
+                                       return queue->session == session;
+                                    } ),
+                    _sessions.end() );
+}
+
+bool subscription_hub::any_session( session_filter filter )
+{
+   std::lock_guard<std::mutex> guard( _sessions_mutex );
+   return std::any_of( _sessions.begin(), _sessions.end(), [filter]( const std::shared_ptr<session_queue>& queue ) {
+      return ( queue->session->*filter )();
+   });
+}
+
+void subscription_hub::enqueue( const std::shared_ptr<const subscription_event>& event, session_filter filter )
+{
+   std::lock_guard<std::mutex> guard( _sessions_mutex );
+   for( const auto& queue : _sessions )
+   {
+      if( !( queue->session->*filter )() )
+         continue;
+      if( queue->overflowed )
+      {
+         if( !queue->events.push( std::shared_ptr<const subscription_event>() ) )
+            continue;
+         queue->overflowed = false;
+      }
+      if( !queue->events.push( event ) )
+      {
+         wlog( "Subscription queue of database API ${x} is full, dropping notifications", ("x",int64_t(queue->session)) );
+         queue->overflowed = true;
+      }
+      schedule( queue );
+   }
+}
+
+void subscription_hub::schedule( const std::shared_ptr<session_queue>& queue )
+{
+   if( queue->draining.exchange( true ) )
+      return;
+
+   std::weak_ptr<database_api_impl> weak_session;
+   try
+   {
+      weak_session = queue->session->shared_from_this();
+   }
+   catch( const std::bad_weak_ptr& )
+   {
+      // The session is being destroyed and is waiting to be removed
+      return;
+   }
+   // The task must not hold the session, it could be the last reference when the task is done
+   queue->worker->async( [queue, weak_session]() { drain( queue, weak_session ); }, "subscription fan-out" );
+}
+
+void subscription_hub::drain( const std::shared_ptr<session_queue>& queue,
+                              const std::weak_ptr<database_api_impl>& weak_session )
+{
+   std::shared_ptr<database_api_impl> session = weak_session.lock();
+   if( !session )
+   {
+      // The session was closed after it was scheduled and is waiting to be removed
+      queue->draining.store( false );
+      return;
+   }
+   while( true )
+   {
+      std::shared_ptr<const subscription_event> event;
+      while( queue->events.pop( event ) )
+      {
+         try
+         {
+            if( event )
+               event->deliver( *session );
+            else
+               session->on_resync_required();
+         }
+         catch( const fc::exception& e )
+         {
+            wlog( "Failed to notify database API ${x}: ${e}", ("x",int64_t(session.get()))("e",e.to_detail_string()) );
+         }
+      }
+      queue->draining.store( false );
+      // Check again in case the writer pushed something after the last pop but saw the flag still set
+      if( queue->events.read_available() == 0 || queue->draining.exchange( true ) )
+         break;
+   }
+   // The session must not be destroyed in a worker thread, which the hub joins in its destructor,
+   // so hand the reference over to the thread that owns the session
+   fc::thread* owner = session->get_owner_thread();
+   owner->async( [released = std::move(session)]() {}, "release database API" );
+}
+
+void subscription_hub::on_objects_new( const vector<object_id_type>& ids,
+                                       const flat_set<account_id_type>& impacted_accounts )
+{
+   if( !any_session( &database_api_impl::has_object_subscriptions ) )
+      return;
+   enqueue( std::make_shared<object_notification>( object_notification::change_kind::created,
+                                                   ids, impacted_accounts, _db,
+                                                   [this]( object_id_type id ) { return _db.find_object( id ); } ),
+            &database_api_impl::has_object_subscriptions );
+}
+
+void subscription_hub::on_objects_changed( const vector<object_id_type>& ids,
+                                           const flat_set<account_id_type>& impacted_accounts )
+{
+   if( !any_session( &database_api_impl::has_object_subscriptions ) )
+      return;
+   enqueue( std::make_shared<object_notification>( object_notification::change_kind::changed,
+                                                   ids, impacted_accounts, _db,
+                                                   [this]( object_id_type id ) { return _db.find_object( id ); } ),
+            &database_api_impl::has_object_subscriptions );
+}
+
+void subscription_hub::on_objects_removed( const vector<object_id_type>& ids,
+                                           const vector<const object*>& objs,
+                                           const flat_set<account_id_type>& impacted_accounts )
+{
+   if( !any_session( &database_api_impl::has_object_subscriptions ) )
+      return;
+   // Removed objects are no longer in the database, they are only available during this call
+   std::unordered_map< object_id_type, const object* > removed;
+   removed.reserve( objs.size() );
+   for( const object* obj : objs )
+   {
+      if( obj != nullptr )
+         removed.emplace( obj->id, obj );
+   }
+   enqueue( std::make_shared<object_notification>( object_notification::change_kind::removed,
+                                                   ids, impacted_accounts, _db,
+                                                   [&removed]( object_id_type id ) -> const object* {
+                                                      auto itr = removed.find( id );
+                                                      return itr == removed.end() ? nullptr : itr->second;
+                                                   } ),
+            &database_api_impl::has_object_subscriptions );
+}
+
+void subscription_hub::on_applied_block()
+{
+   if( !any_session( &database_api_impl::has_block_subscriptions ) )
+      return;
+   bool with_market_fills = any_session( &database_api_impl::has_market_subscriptions );
+   enqueue( std::make_shared<block_notification>( _db, with_market_fills ),
+            &database_api_impl::has_block_subscriptions );
+}
+
+void subscription_hub::on_pending_transaction( const signed_transaction& trx )
+{
+   if( !any_session( &database_api_impl::has_pending_transaction_callback ) )
+      return;
+   enqueue( std::make_shared<pending_transaction_notification>( trx ),
+            &database_api_impl::has_pending_transaction_callback );
+}
+
+} } // graphene::app
@@ -0,0 +1,191 @@
+/*
+ * Copyright (c) 2026 Contributors.
+ *
+ * The MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#pragma once
+
+#include <graphene/app/database_api.hpp>
+
+#include <boost/signals2/connection.hpp>
+
+#include <fc/thread/thread.hpp>
+
+#include <map>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace graphene { namespace app {
+
+class database_api_impl;
+
+using market_type = std::pair<graphene::chain::asset_id_type, graphene::chain::asset_id_type>;
+
+/**
+ * A notification of the database queued for the sessions.
+ * It holds copies of all the data it needs, so it can be delivered after the database has moved on.
+ * Conversions to variants are done by the first worker which needs them and are shared by all sessions.
+ */
+class subscription_event
+{
+   public:
+      virtual ~subscription_event() = default;
+
+      /// Filters the notification for the given session and sends it out, called in a worker thread
+      virtual void deliver( database_api_impl& session )const = 0;
+};
+
+/**
+ * Objects reported by one notification of the database.
+ */
+class object_notification : public subscription_event
+{
+   public:
+      enum class change_kind { created, changed, removed };
+
+      using find_function = std::function<const graphene::db::object*(graphene::db::object_id_type)>;
+
+      object_notification( change_kind kind,
+                           const vector<object_id_type>& ids,
+                           const flat_set<graphene::chain::account_id_type>& impacted_accounts,
+                           const graphene::chain::database& db,
+                           const find_function& find_object );
+
+      const change_kind                                kind;
+      const vector<object_id_type>                     ids;
+      const flat_set<graphene::chain::account_id_type> impacted_accounts;
+
+      /// @return the object with the given index in @ref ids as a variant, or nullptr if it is not found
+      const fc::variant*                  full_variant( size_t i )const;
+      /// @return the ID with the given index in @ref ids as a variant
+      fc::variant                         id_variant( size_t i )const;
+      /// @return the market of the order with the given index in @ref ids, or an invalid optional if it is not an order
+      const fc::optional<market_type>&    order_market( size_t i )const { return _order_markets[i]; }
+
+      void deliver( database_api_impl& session )const override;
+
+   private:
+      vector<std::unique_ptr<graphene::db::object>>   _objects;
+      vector<fc::optional<market_type>>               _order_markets;
+
+      mutable std::mutex                              _variants_mutex;
+      mutable vector<fc::optional<fc::variant>>       _full_variants;
+};
+
+/**
+ * Data of an applied block needed by the sessions.
+ */
+class block_notification : public subscription_event
+{
+   public:
+      block_notification( const graphene::chain::database& db, bool with_market_fills );
+
+      const fc::variant& block_id()const { return _block_id; }
+      /// @return the fill operations of the block in the given market as a variant, or nullptr if there is none
+      const fc::variant* market_fills( const market_type& market )const;
+
+      void deliver( database_api_impl& session )const override;
+
+   private:
+      fc::variant                                     _block_id;
+      std::map< market_type, vector<pair<graphene::chain::operation, graphene::chain::operation_result>> >
+                                                      _fills;
+
+      mutable std::mutex                              _variants_mutex;
+      mutable std::map< market_type, fc::variant >    _fill_variants;
+};
+
+/**
+ * A transaction pushed to the pending state of the database.
+ */
+class pending_transaction_notification : public subscription_event
+{
+   public:
+      explicit pending_transaction_notification( const graphene::chain::signed_transaction& trx );
+
+      const fc::variant& transaction()const;
+
+      void deliver( database_api_impl& session )const override;
+
+   private:
+      graphene::chain::signed_transaction             _trx;
+
+      mutable std::mutex                              _variant_mutex;
+      mutable fc::optional<fc::variant>               _trx_variant;
+};
+
+/**
+ * Connects to the notification signals of a database once and dispatches the notifications to all
+ * database API sessions.
+ *
+ * The signal handlers only copy what the sessions may need and push it to a bounded queue per session.
+ * Filtering and broadcasting are done by a pool of worker threads, so that sessions do not slow down
+ * the application of blocks. When the queue of a slow session is full, notifications for it are dropped,
+ * and it is told to resync once it has caught up.
+ *
+ * The hub is owned by the application and shared with the sessions it serves. Workers only hold sessions
+ * weakly while they are queued, so that neither a session nor the hub is destroyed in a worker thread.
+ */
+class subscription_hub
+{
+   public:
+      subscription_hub( graphene::chain::database& db, uint32_t queue_size, uint16_t num_threads );
+      ~subscription_hub();
+
+      void add_session( database_api_impl* session );
+      void remove_session( database_api_impl* session );
+
+   private:
+      struct session_queue;
+      using session_filter = bool (database_api_impl::*)()const;
+
+      bool any_session( session_filter filter );
+      void enqueue( const std::shared_ptr<const subscription_event>& event, session_filter filter );
+      static void schedule( const std::shared_ptr<session_queue>& queue );
+      static void drain( const std::shared_ptr<session_queue>& queue,
+                         const std::weak_ptr<database_api_impl>& weak_session );
+
+      void on_objects_new( const vector<object_id_type>& ids,
+                           const flat_set<graphene::chain::account_id_type>& impacted_accounts );
+      void on_objects_changed( const vector<object_id_type>& ids,
+                               const flat_set<graphene::chain::account_id_type>& impacted_accounts );
+      void on_objects_removed( const vector<object_id_type>& ids, const vector<const graphene::db::object*>& objs,
+                               const flat_set<graphene::chain::account_id_type>& impacted_accounts );
+      void on_applied_block();
+      void on_pending_transaction( const graphene::chain::signed_transaction& trx );
+
+      graphene::chain::database&                        _db;
+      const uint32_t                                    _queue_size;
+      std::vector< std::unique_ptr<fc::thread> >        _threads;
+      size_t                                            _next_thread = 0;
+
+      std::mutex                                        _sessions_mutex;
+      std::vector< std::shared_ptr<session_queue> >     _sessions;
+
+      boost::signals2::scoped_connection                _new_connection;
+      boost::signals2::scoped_connection                _change_connection;
+      boost::signals2::scoped_connection                _removed_connection;
+      boost::signals2::scoped_connection                _applied_block_connection;
+      boost::signals2::scoped_connection                _pending_trx_connection;
+};
+
+} } // graphene::app
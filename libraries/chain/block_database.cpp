@@ -25,6 +25,9 @@
 #include <graphene/protocol/fee_schedule.hpp>
 #include <fc/io/raw.hpp>
 #include <boost/endian/buffers.hpp>
+#include <boost/thread/locks.hpp>
+
+#include <cstring>
 
 namespace graphene { namespace chain {
 
@@ -43,23 +46,50 @@ FC_REFLECT( graphene::chain::index_entry, (block_pos)(block_size)(block_id) );
 
 namespace graphene { namespace chain {
 
+namespace {
+   /// Address space mapped beyond the end of the files, so that appending blocks rarely requires a remap
+   constexpr uint64_t index_mapping_reserve  = 32 * 1024 * 1024;
+   constexpr uint64_t blocks_mapping_reserve = 1024 * 1024 * 1024;
+
+   size_t mapping_capacity( uint64_t file_size, uint64_t reserve )
+   {
+      return static_cast<size_t>( ( file_size / reserve + 1 ) * reserve );
+   }
+}
+
+using read_lock  = boost::shared_lock<boost::shared_mutex>;
+using write_lock = boost::unique_lock<boost::shared_mutex>;
+
+block_database::mapped_file::mapped_file( const fc::path& filename, size_t capacity )
+   : mapping( filename.generic_string().c_str(), fc::read_only ),
+     region( mapping, fc::read_only, 0, capacity )
+{
+}
+
 void block_database::open( const fc::path& dbdir )
 { try {
+   write_lock lock( _mutex );
    fc::create_directories(dbdir);
    _block_num_to_pos.exceptions(std::ios_base::failbit | std::ios_base::badbit);
    _blocks.exceptions(std::ios_base::failbit | std::ios_base::badbit);
 
    _index_filename = dbdir / "index";
+   _blocks_filename = dbdir / "blocks";
    if( !fc::exists( _index_filename ) )
    {
      _block_num_to_pos.open( _index_filename.generic_string().c_str(), std::fstream::binary | std::fstream::in | std::fstream::out | std::fstream::trunc);
-     _blocks.open( (dbdir/"blocks").generic_string().c_str(), std::fstream::binary | std::fstream::in | std::fstream::out | std::fstream::trunc);
+     _blocks.open( _blocks_filename.generic_string().c_str(), std::fstream::binary | std::fstream::in | std::fstream::out | std::fstream::trunc);
    }
    else
    {
      _block_num_to_pos.open( _index_filename.generic_string().c_str(), std::fstream::binary | std::fstream::in | std::fstream::out );
-     _blocks.open( (dbdir/"blocks").generic_string().c_str(), std::fstream::binary | std::fstream::in | std::fstream::out );
+     _blocks.open( _blocks_filename.generic_string().c_str(), std::fstream::binary | std::fstream::in | std::fstream::out );
    }
+
+   _index_size = fc::file_size( _index_filename );
+   _blocks_size = fc::file_size( _blocks_filename );
+   _blocks_read_position = 0;
+   update_mappings();
 } FC_CAPTURE_AND_RETHROW( (dbdir) ) }
 
 bool block_database::is_open()const
@@ -69,16 +99,60 @@ bool block_database::is_open()const
 
 void block_database::close()
 {
+  write_lock lock( _mutex );
+  _index_map.reset();
+  _blocks_map.reset();
   _blocks.close();
   _block_num_to_pos.close();
+  _index_size = 0;
+  _blocks_size = 0;
 }
 
 void block_database::flush()
 {
+  write_lock lock( _mutex );
   _blocks.flush();
   _block_num_to_pos.flush();
 }
 
+void block_database::update_mappings()
+{
+   if( !_index_map || _index_map->region.get_size() < _index_size )
+   {
+      _index_map.reset();
+      _index_map = std::make_unique<mapped_file>( _index_filename,
+                                                  mapping_capacity( _index_size, index_mapping_reserve ) );
+   }
+   if( !_blocks_map || _blocks_map->region.get_size() < _blocks_size )
+   {
+      _blocks_map.reset();
+      _blocks_map = std::make_unique<mapped_file>( _blocks_filename,
+                                                   mapping_capacity( _blocks_size, blocks_mapping_reserve ) );
+   }
+}
+
+bool block_database::read_index_entry( uint32_t block_num, index_entry& e )const
+{
+   const uint64_t index_pos = sizeof(e) * uint64_t(block_num);
+   if( !_index_map || _index_size < index_pos + sizeof(e) )
+      return false;
+   std::memcpy( (char*)&e, _index_map->data() + index_pos, sizeof(e) );
+   return true;
+}
+
+signed_block block_database::read_block( const index_entry& e )const
+{
+   const uint64_t block_pos = e.block_pos.value();
+   const uint64_t block_size = e.block_size.value();
+   FC_ASSERT( _blocks_map && block_pos + block_size <= _blocks_size,
+              "Block position out of range in block_database (maybe corrupt on disk?)" );
+   fc::datastream<const char*> ds( _blocks_map->data() + block_pos, block_size );
+   signed_block result;
+   fc::raw::unpack( ds, result );
+   _blocks_read_position = block_pos + block_size;
+   return result;
+}
+
 void block_database::store( const block_id_type& _id, const signed_block& b )
 {
    block_id_type id = _id;
@@ -87,33 +161,46 @@ void block_database::store( const block_id_type& _id, const signed_block& b )
       id = b.id();
       elog( "id argument of block_database::store() was not initialized for block ${id}", ("id", id) );
    }
-   _block_num_to_pos.seekp( sizeof( index_entry ) * int64_t(block_header::num_from_id(id)) );
+   store_packed( id, fc::raw::pack( b ) );
+}
+
+void block_database::store_packed( const block_id_type& id, const vector<char>& packed_block )
+{
+   FC_ASSERT( id != block_id_type(), "Can not store a packed block without its id" );
+
+   write_lock lock( _mutex );
+   const uint64_t index_pos = sizeof( index_entry ) * uint64_t(block_header::num_from_id(id));
    index_entry e;
-   _blocks.seekp( 0, _blocks.end );
-   auto vec = fc::raw::pack( b );
-   e.block_pos  = _blocks.tellp();
-   e.block_size = vec.size();
+   e.block_pos  = _blocks_size;
+   e.block_size = packed_block.size();
    e.block_id   = id;
-   _blocks.write( vec.data(), vec.size() );
+   // Both streams are flushed right away so that the data is visible through the mappings
+   _blocks.seekp( _blocks_size );
+   _blocks.write( packed_block.data(), packed_block.size() );
+   _blocks.flush();
+   _block_num_to_pos.seekp( index_pos );
    _block_num_to_pos.write( (char*)&e, sizeof(e) );
+   _block_num_to_pos.flush();
+
+   _blocks_size += packed_block.size();
+   _index_size = std::max<uint64_t>( _index_size, index_pos + sizeof(e) );
+   update_mappings();
 }
 
 void block_database::remove( const block_id_type& id )
 { try {
+   write_lock lock( _mutex );
+   const uint32_t block_num = block_header::num_from_id(id);
    index_entry e;
-   int64_t index_pos = sizeof(e) * int64_t(block_header::num_from_id(id));
-   _block_num_to_pos.seekg( 0, _block_num_to_pos.end );
-   if ( _block_num_to_pos.tellg() <= index_pos )
+   if( !read_index_entry( block_num, e ) )
       FC_THROW_EXCEPTION(fc::key_not_found_exception, "Block ${id} not contained in block database", ("id", id));
 
-   _block_num_to_pos.seekg( index_pos );
-   _block_num_to_pos.read( (char*)&e, sizeof(e) );
-
    if( e.block_id == id )
    {
       e.block_size = 0;
-      _block_num_to_pos.seekp( sizeof(e) * int64_t(block_header::num_from_id(id)) );
+      _block_num_to_pos.seekp( sizeof(e) * int64_t(block_num) );
       _block_num_to_pos.write( (char*)&e, sizeof(e) );
+      _block_num_to_pos.flush();
    }
 } FC_CAPTURE_AND_RETHROW( (id) ) }
 
@@ -122,13 +209,10 @@ bool block_database::contains( const block_id_type& id )const
    if( id == block_id_type() )
       return false;
 
+   read_lock lock( _mutex );
    index_entry e;
-   int64_t index_pos = sizeof(e) * int64_t(block_header::num_from_id(id));
-   _block_num_to_pos.seekg( 0, _block_num_to_pos.end );
-   if ( _block_num_to_pos.tellg() < int64_t(index_pos + sizeof(e)) )
+   if( !read_index_entry( block_header::num_from_id(id), e ) )
       return false;
-   _block_num_to_pos.seekg( index_pos );
-   _block_num_to_pos.read( (char*)&e, sizeof(e) );
 
    return e.block_id == id && e.block_size.value() > 0;
 }
@@ -136,15 +220,11 @@ bool block_database::contains( const block_id_type& id )const
 block_id_type block_database::fetch_block_id( uint32_t block_num )const
 {
    assert( block_num != 0 );
+   read_lock lock( _mutex );
    index_entry e;
-   int64_t index_pos = sizeof(e) * int64_t(block_num);
-   _block_num_to_pos.seekg( 0, _block_num_to_pos.end );
-   if ( _block_num_to_pos.tellg() <= index_pos )
+   if( !read_index_entry( block_num, e ) )
       FC_THROW_EXCEPTION(fc::key_not_found_exception, "Block number ${block_num} not contained in block database", ("block_num", block_num));
 
-   _block_num_to_pos.seekg( index_pos );
-   _block_num_to_pos.read( (char*)&e, sizeof(e) );
-
    FC_ASSERT( e.block_id != block_id_type(), "Empty block_id in block_database (maybe corrupt on disk?)" );
    return e.block_id;
 }
@@ -153,22 +233,14 @@ optional<signed_block> block_database::fetch_optional( const block_id_type& id )
 {
    try
    {
+      read_lock lock( _mutex );
       index_entry e;
-      int64_t index_pos = sizeof(e) * int64_t(block_header::num_from_id(id));
-      _block_num_to_pos.seekg( 0, _block_num_to_pos.end );
-      if ( _block_num_to_pos.tellg() <= index_pos )
+      if( !read_index_entry( block_header::num_from_id(id), e ) )
          return {};
 
-      _block_num_to_pos.seekg( index_pos );
-      _block_num_to_pos.read( (char*)&e, sizeof(e) );
-
       if( e.block_id != id ) return optional<signed_block>();
 
-      vector<char> data( e.block_size.value() );
-      _blocks.seekg( e.block_pos.value() );
-      if (e.block_size.value())
-         _blocks.read( data.data(), e.block_size.value() );
-      auto result = fc::raw::unpack<signed_block>(data);
+      auto result = read_block( e );
       FC_ASSERT( result.id() == e.block_id );
       return result;
    }
@@ -185,19 +257,12 @@ optional<signed_block> block_database::fetch_by_number( uint32_t block_num )cons
 {
    try
    {
+      read_lock lock( _mutex );
       index_entry e;
-      int64_t index_pos = sizeof(e) * int64_t(block_num);
-      _block_num_to_pos.seekg( 0, _block_num_to_pos.end );
-      if ( _block_num_to_pos.tellg() <= index_pos )
+      if( !read_index_entry( block_num, e ) )
          return {};
 
-      _block_num_to_pos.seekg( index_pos, _block_num_to_pos.beg );
-      _block_num_to_pos.read( (char*)&e, sizeof(e) );
-
-      vector<char> data( e.block_size.value() );
-      _blocks.seekg( e.block_pos.value() );
-      _blocks.read( data.data(), e.block_size.value() );
-      auto result = fc::raw::unpack<signed_block>(data);
+      auto result = read_block( e );
       FC_ASSERT( result.id() == e.block_id );
       return result;
    }
@@ -210,38 +275,39 @@ optional<signed_block> block_database::fetch_by_number( uint32_t block_num )cons
    return optional<signed_block>();
 }
 
+optional<vector<char>> block_database::fetch_packed( const block_id_type& id )const
+{
+   read_lock lock( _mutex );
+   index_entry e;
+   if( !read_index_entry( block_header::num_from_id(id), e ) || e.block_id != id || e.block_size.value() == 0 )
+      return {};
+
+   const uint64_t block_pos = e.block_pos.value();
+   const uint64_t block_size = e.block_size.value();
+   if( !_blocks_map || block_pos + block_size > _blocks_size )
+      return {};
+   const char* begin = _blocks_map->data() + block_pos;
+   return vector<char>( begin, begin + block_size );
+}
+
 optional<index_entry> block_database::last_index_entry()const {
    try
    {
+      // May truncate the index file, so readers are locked out
+      write_lock lock( _mutex );
       index_entry e;
 
-      _block_num_to_pos.seekg( 0, _block_num_to_pos.end );
-      std::streampos pos = _block_num_to_pos.tellg();
-      if( pos < long(sizeof(index_entry)) )
-         return optional<index_entry>();
-
-      pos -= pos % sizeof(index_entry);
-
-      _blocks.seekg( 0, _block_num_to_pos.end );
-      const std::streampos blocks_size = _blocks.tellg();
+      uint64_t pos = _index_size - _index_size % sizeof(index_entry);
       while( pos > 0 )
       {
          pos -= sizeof(index_entry);
-         _block_num_to_pos.seekg( pos );
-         _block_num_to_pos.read( (char*)&e, sizeof(e) );
-         if( _block_num_to_pos.gcount() == sizeof(e) && e.block_size.value() > 0
-                && int64_t(e.block_pos.value() + e.block_size.value()) <= blocks_size )
+         if( read_index_entry( uint32_t( pos / sizeof(index_entry) ), e ) && e.block_size.value() > 0
+                && e.block_pos.value() + e.block_size.value() <= _blocks_size )
             try
             {
-               vector<char> data( e.block_size.value() );
-               _blocks.seekg( e.block_pos.value() );
-               _blocks.read( data.data(), e.block_size.value() );
-               if( _blocks.gcount() == long(e.block_size.value()) )
-               {
-                  const signed_block block = fc::raw::unpack<signed_block>(data);
-                  if( block.id() == e.block_id )
-                     return e;
-               }
+               const signed_block block = read_block( e );
+               if( block.id() == e.block_id )
+                  return e;
             }
             catch (const fc::exception&)
             {
@@ -250,6 +316,7 @@ optional<index_entry> block_database::last_index_entry()const {
             {
             }
          fc::resize_file( _index_filename, pos );
+         _index_size = pos;
       }
    }
    catch (const fc::exception&)
@@ -277,13 +344,13 @@ optional<block_id_type> block_database::last_id()const
 
 size_t block_database::blocks_current_position()const
 {
-   return (size_t)_blocks.tellg();
+   return (size_t)_blocks_read_position.load();
 }
 
 size_t block_database::total_block_size()const
 {
-   _blocks.seekg( 0, _blocks.end );
-   return (size_t)_blocks.tellg();
+   read_lock lock( _mutex );
+   return (size_t)_blocks_size;
 }
 
 } }
@@ -80,6 +80,7 @@ object_id_type custom_authority_create_evaluator::do_apply(const custom_authorit
       std::for_each(op.restrictions.begin(), op.restrictions.end(), [&obj](const restriction& r) mutable {
          obj.restrictions.insert(std::make_pair(obj.restriction_counter++, r));
       });
+      obj.try_update_predicate_cache();
    }).id;
 } FC_CAPTURE_AND_RETHROW((op)) }
 
@@ -163,8 +164,8 @@ void_result custom_authority_update_evaluator::do_apply(const custom_authority_u
          obj.restrictions.insert(std::make_pair(obj.restriction_counter++, r));
       });
 
-      // Clear the predicate cache
-      obj.clear_predicate_cache();
+      // Regenerate the predicate cache
+      obj.try_update_predicate_cache();
    });
 
    return void_result();
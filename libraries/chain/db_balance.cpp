@@ -36,11 +36,19 @@ asset database::get_balance(account_id_type owner, asset_id_type asset_id) const
 {
    auto& index = get_index_type< primary_index< account_balance_index > >().get_secondary_index<balances_by_account_index>();
    auto abo = index.get_account_balance( owner, asset_id );
+   track_balance_read( abo );
    if( !abo )
       return asset(0, asset_id);
    return abo->get_balance();
 }
 
+void database::track_balance_read( const account_balance_object* abo )const
+{
+   // A missing balance may be created by anyone, so the lookup depends on all balances
+   track_read( abo != nullptr ? object_id_type( abo->id )
+                              : pending_transaction_effects::any_of_type( account_balance_id_type() ) );
+}
+
 asset database::get_balance(const account_object& owner, const asset_object& asset_obj) const
 {
    return get_balance(owner.get_id(), asset_obj.get_id());
@@ -58,6 +66,7 @@ void database::adjust_balance(account_id_type account, asset delta )
 
    auto& index = get_index_type< primary_index< account_balance_index > >().get_secondary_index<balances_by_account_index>();
    auto abo = index.get_account_balance( account, delta.asset_id );
+   track_balance_read( abo );
    if( !abo )
    {
       FC_ASSERT( delta.amount > 0, "Insufficient Balance: ${a}'s balance of ${b} is less than required ${r}",
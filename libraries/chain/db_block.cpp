@@ -43,6 +43,11 @@
 #include <fc/io/raw.hpp>
 #include <fc/thread/parallel.hpp>
 
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+
 namespace graphene { namespace chain {
 
 bool database::is_known_block( const block_id_type& id )const
@@ -73,6 +78,14 @@ optional<signed_block> database::fetch_block_by_id( const block_id_type& id )con
    return b->data;
 }
 
+optional<vector<char>> database::fetch_packed_block_by_id( const block_id_type& id )const
+{
+   auto b = _fork_db.fetch_block( id );
+   if( !b )
+      return _block_id_to_block.fetch_packed(id);
+   return fc::raw::pack( b->data );
+}
+
 optional<signed_block> database::fetch_block_by_number( uint32_t num )const
 {
    auto results = _fork_db.fetch_block_by_number(num);
@@ -116,21 +129,40 @@ std::vector<block_id_type> database::get_block_ids_on_fork(block_id_type head_of
  */
 bool database::push_block(const signed_block& new_block, uint32_t skip)
 {
-//   idump((new_block.block_num())(new_block.id())(new_block.timestamp)(new_block.previous));
+   return push_block( std::make_shared<const signed_block>( new_block ), skip );
+}
+
+bool database::push_block(const block_ptr& new_block, uint32_t skip)
+{
+//   idump((new_block->block_num())(new_block->id())(new_block->timestamp)(new_block->previous));
    bool result;
    detail::with_skip_flags( *this, skip, [&]()
    {
-      detail::without_pending_transactions( *this, std::move(_pending_tx),
+      detail::without_pending_transactions( *this, std::move(_pending_tx), std::move(_pending_tx_effects),
       [&]()
       {
          result = _push_block(new_block);
+         // Pending transactions are not applied at this point
+         flush_incremental_if_due();
       });
    });
    return result;
 }
 
-bool database::_push_block(const signed_block& new_block)
+void database::flush_incremental_if_due()
+{
+   // Only the state which can not be undone anymore is written, otherwise it might not be on the chain
+   // the node switches to after a restart
+   const uint32_t flushed_block_num = last_non_undoable_block_num();
+   if( 0 == _flush_interval || flushed_block_num < _last_flush_block_num + _flush_interval )
+      return;
+   flush_incremental( true );
+   _last_flush_block_num = flushed_block_num;
+}
+
+bool database::_push_block(const block_ptr& new_block_ptr)
 { try {
+   const signed_block& new_block = *new_block_ptr;
    uint32_t skip = get_node_properties().skip_flags;
 
    const auto now = fc::time_point::now().sec_since_epoch();
@@ -143,7 +175,7 @@ bool database::_push_block(const signed_block& new_block)
          verify_signing_witness( new_block, *prev_block );
    }
 
-   const shared_ptr<fork_item> new_head = _fork_db.push_block(new_block);
+   const shared_ptr<fork_item> new_head = _fork_db.push_block(new_block_ptr);
    //If the head block from the longest chain does not build off of the current head, we need to switch forks.
    if( new_head->data.previous != head_block_id() )
    {
@@ -216,7 +248,10 @@ bool database::_push_block(const signed_block& new_block)
       apply_block(new_block, skip);
       if( new_block.timestamp.sec_since_epoch() > now - 86400 )
          update_witnesses( *new_head );
-      _block_id_to_block.store(new_block.id(), new_block);
+      // new_head may be another block than the one pushed, see fork_database::push_block
+      const shared_ptr<fork_item> new_item = _fork_db.fetch_block( new_block.id() );
+      FC_ASSERT( new_item, "The new block is not in the fork database" );
+      _block_id_to_block.store( new_item->id, new_item->data );
       session.commit();
    } catch ( const fc::exception& e ) {
       elog("Failed to push new block:\n${e}", ("e", e.to_detail_string()));
@@ -225,7 +260,7 @@ bool database::_push_block(const signed_block& new_block)
    }
 
    return false;
-} FC_CAPTURE_AND_RETHROW( (new_block) ) }
+} FC_CAPTURE_AND_RETHROW( (*new_block_ptr) ) }
 
 void database::verify_signing_witness( const signed_block& new_block, const fork_item& fork_entry )const
 {
@@ -277,6 +312,84 @@ processed_transaction database::push_transaction( const precomputable_transactio
    return result;
 } FC_CAPTURE_AND_RETHROW( (trx) ) }
 
+namespace {
+
+/// Whether the effects of a transaction are recorded so that it can be reapplied, see pending_transactions_restorer
+bool is_reapplicable( const precomputable_transaction& trx )
+{
+   return std::all_of( trx.operations.begin(), trx.operations.end(), []( const operation& op ) {
+      return op.is_type<transfer_operation>() || op.is_type<limit_order_create_operation>()
+             || op.is_type<limit_order_cancel_operation>();
+   });
+}
+
+struct read_tracking_guard
+{
+   read_tracking_guard( db::object_database& odb, std::vector<object_id_type>* reads ) : _db( odb )
+   {
+      _db.track_reads( reads );
+   }
+   ~read_tracking_guard()
+   {
+      _db.track_reads( nullptr );
+   }
+   db::object_database& _db;
+};
+
+/// Whether a hardfork time lies in [ @p from, @p to ], so that evaluators may behave differently at @p to than
+/// at @p from.  Both ends are included since hardforks are checked with both > and >=.
+bool crosses_hardfork_time( const fc::time_point_sec from, const fc::time_point_sec to )
+{
+   // Generated from the files in hardfork.d
+   static const fc::time_point_sec hardfork_times[] = { GRAPHENE_HARDFORK_TIMES };
+   return std::any_of( std::begin(hardfork_times), std::end(hardfork_times),
+                       [from, to]( const fc::time_point_sec t ) { return from <= t && t <= to; } );
+}
+
+void record_effects( const database& db, const precomputable_transaction& trx, const graphene::db::undo_state& state,
+                     database::pending_transaction_effects& effects )
+{
+   using effects_type = database::pending_transaction_effects;
+   // A new limit order is matched against the orders found through the indexes, and market fees may be paid
+   // into vesting balances found by owner and asset
+   for( const auto& op : trx.operations )
+   {
+      if( op.is_type<limit_order_create_operation>() )
+      {
+         effects.reads.push_back( effects_type::any_of_type( limit_order_id_type() ) );
+         effects.reads.push_back( effects_type::any_of_type( call_order_id_type() ) );
+         effects.reads.push_back( effects_type::any_of_type( force_settlement_id_type() ) );
+         effects.reads.push_back( effects_type::any_of_type( vesting_balance_id_type() ) );
+         break;
+      }
+   }
+   std::sort( effects.reads.begin(), effects.reads.end() );
+   effects.reads.erase( std::unique( effects.reads.begin(), effects.reads.end() ), effects.reads.end() );
+
+   for( const auto& item : state.removed )
+      effects.removed.push_back( item.first );
+   for( const auto& item : state.new_ids )
+   {
+      // Recreated by _reapply_pending_transaction if needed
+      if( !item.first.is<transaction_history_id_type>() )
+         effects.created.push_back( item.first );
+   }
+   std::sort( effects.removed.begin(), effects.removed.end() );
+   std::sort( effects.created.begin(), effects.created.end() );
+
+   effects.written.reserve( state.old_values.size() + effects.created.size() );
+   for( const auto& item : state.old_values )
+      effects.written.emplace_back( db.get_object( item.first ).clone() );
+   for( const auto& id : effects.created )
+      effects.written.emplace_back( db.get_object( id ).clone() );
+   std::sort( effects.written.begin(), effects.written.end(),
+              []( const std::shared_ptr<const object>& a, const std::shared_ptr<const object>& b ) {
+                 return a->id < b->id;
+              });
+}
+
+} // anonymous namespace
+
 processed_transaction database::_push_transaction( const precomputable_transaction& trx )
 {
    // If this is the first transaction pushed after applying a block, start a new undo session.
@@ -290,8 +403,22 @@ processed_transaction database::_push_transaction( const precomputable_transacti
    // apply the changes.
 
    auto temp_session = _undo_db.start_undo_session();
-   auto processed_trx = _apply_transaction( trx );
+   std::shared_ptr<pending_transaction_effects> effects;
+   if( _undo_db.enabled() && is_reapplicable( trx ) )
+      effects = std::make_shared<pending_transaction_effects>();
+   processed_transaction processed_trx;
+   {
+      read_tracking_guard guard( *this, effects ? &effects->reads : nullptr );
+      processed_trx = _apply_transaction( trx );
+   }
+   if( effects )
+   {
+      effects->head_time = head_block_time();
+      record_effects( *this, trx, _undo_db.head(), *effects );
+   }
    _pending_tx.push_back(processed_trx);
+   _pending_tx_effects.push_back( std::move(effects) );
+   _pending_tx_skip_flags |= get_node_properties().skip_flags;
 
    // notify_changed_objects();
    // The transaction applied successfully. Merge its changes into the pending block session.
@@ -302,6 +429,120 @@ processed_transaction database::_push_transaction( const precomputable_transacti
    return processed_trx;
 }
 
+bool database::_get_head_block_changes( const block_id_type& previous_head,
+                                        std::unordered_set<object_id_type>& changed )const
+{
+   if( head_block_id() == previous_head )
+      return true;
+   if( !_undo_db.enabled() || _undo_db.size() == 0 )
+      return false;
+   const auto head = _fork_db.fetch_block( head_block_id() );
+   if( !head || head->data.previous != previous_head )
+      return false;
+
+   const auto& state = _undo_db.head();
+   changed.reserve( state.old_values.size() + state.new_ids.size() + state.removed.size() );
+   for( const auto& item : state.old_values )
+      changed.insert( item.first );
+   for( const auto& item : state.new_ids )
+      changed.insert( item.first );
+   for( const auto& item : state.removed )
+      changed.insert( item.first );
+
+   // Transactions use these through cached pointers, so changes to them are not covered by tracked reads
+   if( changed.count( global_property_id_type() ) > 0 || changed.count( asset_id_type() ) > 0
+         || changed.count( asset_dynamic_data_id_type() ) > 0 )
+      return false;
+   // Viable custom authorities are found through an index, so any change to them may matter
+   for( const auto& id : changed )
+   {
+      if( id.is<custom_authority_id_type>() )
+         return false;
+   }
+   // The head block time is checked separately
+   changed.erase( dynamic_global_property_id_type() );
+
+   flat_set<object_id_type> types;
+   for( const auto& id : changed )
+      types.insert( pending_transaction_effects::any_of_type( id ) );
+   changed.insert( types.begin(), types.end() );
+   return true;
+}
+
+bool database::_reapply_pending_transaction( const processed_transaction& trx,
+                                             const std::shared_ptr<const pending_transaction_effects>& effects,
+                                             const std::unordered_set<object_id_type>& changed )
+{
+   const auto is_changed = [&changed]( const object_id_type& id ) { return changed.count( id ) > 0; };
+   if( std::any_of( effects->reads.begin(), effects->reads.end(), is_changed )
+         || std::any_of( effects->removed.begin(), effects->removed.end(), is_changed )
+         || std::any_of( effects->created.begin(), effects->created.end(), is_changed ) )
+      return false;
+   for( const auto& obj : effects->written )
+   {
+      if( is_changed( obj->id ) )
+         return false;
+   }
+
+   // The checks of _apply_transaction and the evaluators which depend on the head block time
+   const fc::time_point_sec now = head_block_time();
+   if( now > trx.expiration || crosses_hardfork_time( effects->head_time, now ) )
+      return false;
+   for( const auto& op : trx.operations )
+   {
+      if( op.is_type<limit_order_create_operation>() && op.get<limit_order_create_operation>().expiration < now )
+         return false;
+   }
+
+   // Created objects need to get the same IDs again
+   for( size_t i = 0; i < effects->created.size(); ++i )
+   {
+      const object_id_type& id = effects->created[i];
+      const bool first_of_type = ( i == 0 || effects->created[i-1].space_type() != id.space_type() );
+      if( first_of_type && get_index( id ).get_next_id() != id )
+         return false;
+      if( !first_of_type && effects->created[i-1].instance() + 1 != id.instance() )
+         return false;
+   }
+
+   if( !_pending_tx_session.valid() )
+      _pending_tx_session = _undo_db.start_undo_session();
+
+   auto temp_session = _undo_db.start_undo_session();
+   try
+   {
+      for( const auto& id : effects->removed )
+         remove( get_object( id ) );
+      for( const auto& obj : effects->written )
+      {
+         std::unique_ptr<object> copy = obj->clone();
+         if( std::binary_search( effects->created.begin(), effects->created.end(), obj->id ) )
+            get_mutable_index( obj->id ).create( [&copy]( object& o ) { o.move_from( *copy ); } );
+         else
+            modify( get_object( obj->id ), [&copy]( object& o ) { o.move_from( *copy ); } );
+      }
+      if( 0 == ( get_node_properties().skip_flags & skip_transaction_dupe_check ) )
+      {
+         create<transaction_history_object>([&trx](transaction_history_object& transaction) {
+            transaction.trx_id = trx.id();
+            transaction.trx = trx;
+         });
+      }
+   }
+   catch( const fc::exception& e )
+   {
+      wlog( "Failed to reapply pending transaction ${id}: ${e}", ("id", trx.id())("e", e.to_detail_string()) );
+      return false;
+   }
+   temp_session.merge();
+
+   _pending_tx.push_back( trx );
+   _pending_tx_effects.push_back( effects );
+
+   notify_on_pending_transaction( trx );
+   return true;
+}
+
 processed_transaction database::validate_transaction( const signed_transaction& trx )
 {
    auto session = _undo_db.start_undo_session();
@@ -376,8 +617,18 @@ signed_block database::generate_block(
    const fc::ecc::private_key& block_signing_private_key,
    uint32_t skip /* = 0 */
    )
+{
+   return *generate_shared_block( when, witness_id, block_signing_private_key, skip );
+}
+
+block_ptr database::generate_shared_block(
+   fc::time_point_sec when,
+   witness_id_type witness_id,
+   const fc::ecc::private_key& block_signing_private_key,
+   uint32_t skip /* = 0 */
+   )
 { try {
-   signed_block result;
+   block_ptr result;
    detail::with_skip_flags( *this, skip, [&]()
    {
       result = _generate_block( when, witness_id, block_signing_private_key );
@@ -385,7 +636,7 @@ signed_block database::generate_block(
    return result;
 } FC_CAPTURE_AND_RETHROW() }
 
-signed_block database::_generate_block(
+block_ptr database::_generate_block(
    fc::time_point_sec when,
    witness_id_type witness_id,
    const fc::ecc::private_key& block_signing_private_key
@@ -398,29 +649,9 @@ signed_block database::_generate_block(
    witness_id_type scheduled_witness = get_scheduled_witness( slot_num );
    FC_ASSERT( scheduled_witness == witness_id );
 
-   //
-   // The following code throws away existing pending_tx_session and
-   // rebuilds it by re-applying pending transactions.
-   //
-   // This rebuild is necessary because pending transactions' validity
-   // and semantics may have changed since they were received, because
-   // time-based semantics are evaluated based on the current block
-   // time.  These changes can only be reflected in the database when
-   // the value of the "when" variable is known, which means we need to
-   // re-apply pending transactions in this method.
-   //
-
-   // pop pending state (reset to head block state)
-   _pending_tx_session.reset();
-
    // Check witness signing key
    if( 0 == (skip & skip_witness_signature) )
    {
-      // Note: if this check failed (which won't happen in normal situations),
-      // we would have temporarily broken the invariant that
-      // _pending_tx_session is the result of applying _pending_tx.
-      // In this case, when the node received a new block,
-      // the push_block() call will re-create the _pending_tx_session.
       FC_ASSERT( witness_id(*this).signing_key == block_signing_private_key.get_public_key() );
    }
 
@@ -434,32 +665,59 @@ signed_block database::_generate_block(
 
    signed_block pending_block;
 
-   _pending_tx_session = _undo_db.start_undo_session();
-
-   uint64_t postponed_tx_count = 0;
-   for( const processed_transaction& tx : _pending_tx )
+   //
+   // The pending state is kept up to date as transactions arrive, it is the result of applying the pending
+   // transactions in order on top of the head block.  Unless some of them do not fit into the block, were
+   // checked less strictly than required now, or were reapplied from their recorded effects instead of being
+   // evaluated on top of the current head block, the block consists of exactly these transactions, and they
+   // do not need to be applied again before the block is pushed.
+   //
+   bool reuse_pending_state = ( _pending_tx.empty() || _pending_tx_session.valid() )
+                              && 0 == ( _pending_tx_skip_flags & ~skip ) && !_pending_tx_reapplied;
+   if( reuse_pending_state )
    {
-      size_t new_total_size = total_block_size + fc::raw::pack_size( tx );
-
-      // postpone transaction if it would make block too big
-      if( new_total_size > maximum_block_size )
+      pending_block.transactions.reserve( _pending_tx.size() );
+      for( const processed_transaction& tx : _pending_tx )
       {
-         postponed_tx_count++;
-         continue;
-      }
-
-      try
-      {
-         auto temp_session = _undo_db.start_undo_session();
-         processed_transaction ptx = _apply_transaction( tx );
+         processed_transaction ptx( tx );
          // Clear results to save disk space and network bandwidth.
          // This may break client applications which rely on the results.
          ptx.operation_results.clear();
+         total_block_size += fc::raw::pack_size( ptx );
+         if( total_block_size > maximum_block_size )
+         {
+            reuse_pending_state = false;
+            break;
+         }
+         pending_block.transactions.push_back( std::move(ptx) );
+      }
+   }
+
+   if( !reuse_pending_state )
+   {
+      //
+      // The following code throws away existing pending_tx_session and
+      // rebuilds it by re-applying pending transactions.
+      //
+      // This rebuild is necessary because pending transactions' validity
+      // and semantics may have changed since they were received, because
+      // time-based semantics are evaluated based on the current block
+      // time.  These changes can only be reflected in the database when
+      // the value of the "when" variable is known, which means we need to
+      // re-apply pending transactions in this method.
+      //
+      pending_block.transactions.clear();
+      total_block_size = max_block_header_size;
+
+      // pop pending state (reset to head block state)
+      _pending_tx_session.reset();
+      _pending_tx_session = _undo_db.start_undo_session();
+
+      uint64_t postponed_tx_count = 0;
+      for( const processed_transaction& tx : _pending_tx )
+      {
+         size_t new_total_size = total_block_size + fc::raw::pack_size( tx );
 
-         // We have to recompute pack_size(ptx) because it may be different
-         // than pack_size(tx) (i.e. if one or more results increased
-         // their size)
-         new_total_size = total_block_size + fc::raw::pack_size( ptx );
          // postpone transaction if it would make block too big
          if( new_total_size > maximum_block_size )
          {
@@ -467,22 +725,42 @@ signed_block database::_generate_block(
             continue;
          }
 
-         temp_session.merge();
-
-         total_block_size = new_total_size;
-         pending_block.transactions.push_back( ptx );
+         try
+         {
+            auto temp_session = _undo_db.start_undo_session();
+            processed_transaction ptx = _apply_transaction( tx );
+            // Clear results to save disk space and network bandwidth.
+            // This may break client applications which rely on the results.
+            ptx.operation_results.clear();
+
+            // We have to recompute pack_size(ptx) because it may be different
+            // than pack_size(tx) (i.e. if one or more results increased
+            // their size)
+            new_total_size = total_block_size + fc::raw::pack_size( ptx );
+            // postpone transaction if it would make block too big
+            if( new_total_size > maximum_block_size )
+            {
+               postponed_tx_count++;
+               continue;
+            }
+
+            temp_session.merge();
+
+            total_block_size = new_total_size;
+            pending_block.transactions.push_back( ptx );
+         }
+         catch ( const fc::exception& e )
+         {
+            // Do nothing, transaction will not be re-applied
+            wlog( "Transaction was not processed while generating block due to ${e}", ("e", e) );
+            wlog( "The transaction was ${t}", ("t", tx) );
+         }
       }
-      catch ( const fc::exception& e )
+      if( postponed_tx_count > 0 )
       {
-         // Do nothing, transaction will not be re-applied
-         wlog( "Transaction was not processed while generating block due to ${e}", ("e", e) );
-         wlog( "The transaction was ${t}", ("t", tx) );
+         wlog( "Postponed ${n} transactions due to block size limit", ("n", postponed_tx_count) );
       }
    }
-   if( postponed_tx_count > 0 )
-   {
-      wlog( "Postponed ${n} transactions due to block size limit", ("n", postponed_tx_count) );
-   }
 
    _pending_tx_session.reset();
 
@@ -500,9 +778,10 @@ signed_block database::_generate_block(
    if( 0 == (skip & skip_witness_signature) )
       pending_block.sign( block_signing_private_key );
 
-   push_block( pending_block, skip | skip_transaction_signatures ); // skip authority check when pushing self-generated blocks
+   const auto new_block = std::make_shared<const signed_block>( std::move(pending_block) );
+   push_block( new_block, skip | skip_transaction_signatures ); // skip authority check when pushing self-generated blocks
 
-   return pending_block;
+   return new_block;
 } FC_CAPTURE_AND_RETHROW( (witness_id) ) }
 
 /**
@@ -529,6 +808,9 @@ void database::clear_pending()
 { try {
    assert( (_pending_tx.size() == 0) || _pending_tx_session.valid() );
    _pending_tx.clear();
+   _pending_tx_effects.clear();
+   _pending_tx_skip_flags = 0;
+   _pending_tx_reapplied = false;
    _pending_tx_session.reset();
 } FC_CAPTURE_AND_RETHROW() }
 
@@ -612,6 +894,11 @@ void database::_apply_block( const signed_block& next_block )
 
    _issue_453_affected_assets.clear();
 
+   vector<authority_precheck> prechecks;
+   if( 0 == (skip & skip_transaction_signatures) )
+      prechecks = precheck_authorities( next_block );
+   bool custom_authorities_changed = false;
+
    signed_block processed_block( next_block ); // make a copy
    for( auto& trx : processed_block.transactions )
    {
@@ -621,8 +908,22 @@ void database::_apply_block( const signed_block& next_block )
        * for transactions when validating broadcast transactions or
        * when building a block.
        */
-      trx.operation_results = apply_transaction( trx, skip ).operation_results;
+      uint32_t trx_skip = skip;
+      if( _current_trx_in_block < prechecks.size()
+            && is_precheck_valid( prechecks[_current_trx_in_block], custom_authorities_changed ) )
+         trx_skip |= skip_transaction_signatures;
+      trx.operation_results = apply_transaction( trx, trx_skip ).operation_results;
       ++_current_trx_in_block;
+
+      if( !custom_authorities_changed && !prechecks.empty() )
+         custom_authorities_changed = std::any_of( trx.operations.begin(), trx.operations.end(),
+               []( const operation& op ) {
+                  // Approving a proposal may execute custom authority operations
+                  return op.is_type<custom_authority_create_operation>()
+                      || op.is_type<custom_authority_update_operation>()
+                      || op.is_type<custom_authority_delete_operation>()
+                      || op.is_type<proposal_update_operation>();
+               });
    }
 
    _current_op_in_trx    = 0;
@@ -637,7 +938,12 @@ void database::_apply_block( const signed_block& next_block )
 
    // Are we at the maintenance interval?
    if( maint_needed )
+   {
       perform_chain_maintenance( next_block );
+      // Dump the profile once per maintenance interval
+      if( const evaluator_profiler* profiler = get_evaluator_profiler() )
+         profiler->log_profile();
+   }
 
    create_block_summary(next_block);
    clear_expired_transactions();
@@ -829,6 +1135,96 @@ bool database::before_last_checkpoint()const
 static const uint32_t skip_expensive = database::skip_transaction_signatures | database::skip_witness_signature
                                        | database::skip_merkle_check | database::skip_transaction_dupe_check;
 
+vector<database::authority_precheck> database::precheck_authorities( const signed_block& block )const
+{
+   vector<authority_precheck> results;
+   const size_t count = block.transactions.size();
+   const size_t threads = std::min<size_t>( fc::asio::default_io_service_scope::get_num_threads(), count );
+   if( threads < 2 || !_undo_db.enabled() || _undo_db.size() == 0 )
+      return results;
+   // Changes made by the block are found in the undo state, so it must not contain anything else
+   const auto& changes = _undo_db.head();
+   if( !changes.old_values.empty() || !changes.new_ids.empty() || !changes.removed.empty() )
+      return results;
+
+   results.resize( count );
+
+   // Transactions are picked one at a time by the pool threads and by this thread, which blocks without yielding
+   // to other tasks until all of them are verified, so that nothing can change the state in the meantime.
+   // Tasks which start late find nothing left to do.
+   struct job_state
+   {
+      std::atomic<size_t>     next{0};
+      std::atomic<size_t>     done{0};
+      std::mutex              mutex;
+      std::condition_variable finished;
+   };
+   auto job = std::make_shared<job_state>();
+   auto work = [this,job,&block,&results,count]() {
+      for( size_t i = job->next.fetch_add( 1 ); i < count; i = job->next.fetch_add( 1 ) )
+      {
+         precheck_authority( block.transactions[i], results[i] );
+         if( job->done.fetch_add( 1 ) + 1 == count )
+         {
+            std::lock_guard<std::mutex> lock( job->mutex );
+            job->finished.notify_all();
+         }
+      }
+   };
+   for( size_t i = 1; i < threads; ++i )
+      fc::do_parallel( work );
+   work();
+
+   std::unique_lock<std::mutex> lock( job->mutex );
+   job->finished.wait( lock, [&job,count]() { return job->done.load() == count; } );
+   return results;
+}
+
+void database::precheck_authority( const signed_transaction& trx, authority_precheck& result )const
+{
+   // Custom authorities whose predicates are not cached are left to the serial check, which caches them
+   bool predicates_cached = true;
+   try
+   {
+      bool allow_non_immediate_owner = ( head_block_time() >= HARDFORK_CORE_584_TIME );
+      auto get_active = [this,&result]( account_id_type id ) {
+         result.accounts.insert( id );
+         return &id(*this).active;
+      };
+      auto get_owner  = [this,&result]( account_id_type id ) {
+         result.accounts.insert( id );
+         return &id(*this).owner;
+      };
+      auto get_custom = [this,&result,&predicates_cached]( account_id_type id, const operation& op,
+                                                           rejected_predicate_map* rejects ) {
+         result.uses_custom_authorities = true;
+         if( !are_custom_authority_predicates_cached( id, op ) )
+         {
+            predicates_cached = false;
+            return vector<authority>();
+         }
+         return get_viable_custom_authorities( id, op, rejects );
+      };
+
+      trx.verify_authority( get_chain_id(), get_active, get_owner, get_custom, allow_non_immediate_owner,
+                            MUST_IGNORE_CUSTOM_OP_REQD_AUTHS(head_block_time()),
+                            get_global_properties().parameters.max_authority_depth );
+      result.passed = predicates_cached;
+   }
+   catch( ... )
+   { // verified again when the transaction is applied, to fail with the right error
+   }
+}
+
+bool database::is_precheck_valid( const authority_precheck& check, bool custom_authorities_changed )const
+{
+   if( !check.passed || ( check.uses_custom_authorities && custom_authorities_changed ) )
+      return false;
+   const auto& changes = _undo_db.head();
+   return std::none_of( check.accounts.begin(), check.accounts.end(),
+                        [&changes]( const account_id_type& id ) { return changes.old_values.count( id ) > 0; } );
+}
+
 template<typename Trx>
 void database::_precompute_parallel( const Trx* trx, const size_t count, const uint32_t skip )const
 {
@@ -840,7 +1236,7 @@ void database::_precompute_parallel( const Trx* trx, const size_t count, const u
       if( 0 == (skip&skip_transaction_dupe_check) )
          trx->id();
       if( 0 == (skip&skip_transaction_signatures) )
-         trx->get_signature_keys( get_chain_id() );
+         trx->get_signature_keys( get_chain_id(), _signature_key_cache );
    }
 }
 
@@ -881,6 +1277,17 @@ fc::future<void> database::precompute_parallel( const signed_block& block, const
    return *first;
 } FC_LOG_AND_RETHROW() }
 
+void database::precompute_serial( const signed_block& block, const uint32_t skip )const
+{
+   if( !block.transactions.empty() )
+      _precompute_parallel( &block.transactions[0], block.transactions.size(), skip );
+   if( 0 == (skip&skip_witness_signature) )
+      block.signee();
+   if( 0 == (skip&skip_merkle_check) )
+      block.calculate_merkle_root();
+   block.id();
+}
+
 fc::future<void> database::precompute_parallel( const precomputable_transaction& trx )const
 {
    return fc::do_parallel([this,&trx] () {
@@ -127,6 +127,23 @@ vector<authority> database::get_viable_custom_authorities(
    return results;
 }
 
+bool database::are_custom_authority_predicates_cached( account_id_type account, const operation& op ) const
+{
+   const auto& index = get_index_type<custom_authority_index>().indices().get<by_account_custom>();
+   auto range = index.equal_range(boost::make_tuple(account, unsigned_int(op.which()), true));
+   return std::all_of(range.first, range.second,
+                      [](const custom_authority_object& auth) { return auth.is_predicate_cached(); });
+}
+
+void database::cache_custom_authority_predicates() const
+{
+   for( const auto& auth : get_index_type<custom_authority_index>().indices() )
+   {
+      if( auth.enabled && !auth.is_predicate_cached() )
+         auth.try_update_predicate_cache();
+   }
+}
+
 uint32_t database::last_non_undoable_block_num() const
 {
    //see https://github.com/bitshares/bitshares-core/issues/377
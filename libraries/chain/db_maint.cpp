@@ -22,6 +22,8 @@
  * THE SOFTWARE.
  */
 
+#include <fc/asio.hpp>
+#include <fc/thread/parallel.hpp>
 #include <fc/uint128.hpp>
 
 #include <graphene/protocol/market.hpp>
@@ -75,7 +77,7 @@ vector<std::reference_wrapper<const typename Index::object_type>> database::sort
 }
 
 template<class Type>
-void database::perform_account_maintenance(Type tally_helper)
+void database::perform_account_maintenance(Type& tally_helper)
 {
    const auto& bal_idx = get_index_type< account_balance_index >().indices().get< by_maintenance_flag >();
    if( bal_idx.begin() != bal_idx.end() )
@@ -100,6 +102,37 @@ void database::perform_account_maintenance(Type tally_helper)
    const auto& stats_idx = get_index_type< account_stats_index >().indices().get< by_maintenance_seq >();
    auto stats_itr = stats_idx.lower_bound( true );
 
+   // After core-2262, cashback no longer counts as voting stake, and nothing else changed by process_fees()
+   // affects the tally, so votes of all accounts can be tallied in parallel before processing the fees.
+   // Accounts which start to need maintenance in process_fees() only get a cashback vesting balance,
+   // which is not voting stake, so they can be skipped.
+   if( tally_helper.hf2262_passed )
+   {
+      vector< std::pair<const account_object*, const account_statistics_object*> > voting_accounts;
+      vector< std::pair<const account_object*, const account_statistics_object*> > accounts;
+      for( ; stats_itr != stats_idx.end(); ++stats_itr )
+      {
+         accounts.emplace_back( &stats_itr->owner( *this ), &(*stats_itr) );
+         if( stats_itr->has_some_core_voting() )
+            voting_accounts.push_back( accounts.back() );
+      }
+
+      const auto voting_powers = tally_helper.tally_all( voting_accounts );
+
+      // Save voting power and process fees in the same order as the serial loop below
+      size_t next_voting_account = 0;
+      for( const auto& account : accounts )
+      {
+         if( next_voting_account < voting_accounts.size()
+               && voting_accounts[next_voting_account].second == account.second )
+            tally_helper.apply( voting_powers[next_voting_account++] );
+
+         if( account.second->has_pending_fees() )
+            account.second->process_fees( *account.first, *this );
+      }
+      return;
+   }
+
    while( stats_itr != stats_idx.end() )
    {
       const account_statistics_object& acc_stat = *stats_itr;
@@ -1245,6 +1278,8 @@ namespace detail {
 
 void database::perform_chain_maintenance( const signed_block& next_block )
 {
+   evaluator_profiler::scoped_timer timer( get_evaluator_profiler(), evaluator_profiler::perform_chain_maintenance );
+
    const auto& gpo = get_global_properties();
    const auto& dgpo = get_dynamic_global_properties();
    auto last_vote_tally_time = head_block_time();
@@ -1270,17 +1305,48 @@ void database::perform_chain_maintenance( const signed_block& next_block )
       optional<detail::vote_recalc_times> worker_recalc_times;
       optional<detail::vote_recalc_times> delegator_recalc_times;
 
+      /// Votes counted so far, each thread counts into its own buffers when tallying in parallel
+      struct tally_buffers {
+         vector<uint64_t>        votes;
+         vector<uint64_t>        witness_counts;
+         vector<uint64_t>        committee_counts;
+         std::array<uint64_t,2>  total_voting_stake {{ 0, 0 }};
+
+         void merge( const tally_buffers& other )
+         {
+            for( size_t i = 0; i < votes.size(); ++i )
+               votes[i] += other.votes[i];
+            for( size_t i = 0; i < witness_counts.size(); ++i )
+               witness_counts[i] += other.witness_counts[i];
+            for( size_t i = 0; i < committee_counts.size(); ++i )
+               committee_counts[i] += other.committee_counts[i];
+            for( size_t i = 0; i < total_voting_stake.size(); ++i )
+               total_voting_stake[i] += other.total_voting_stake[i];
+         }
+      };
+
+      /// Voting power of an account to be saved in its statistics object
+      struct voting_power {
+         const account_statistics_object* stats = nullptr; ///< nullptr if nothing to save
+         uint64_t vp_all = 0;
+         uint64_t vp_active = 0;
+         uint64_t vp_committee = 0;
+         uint64_t vp_witness = 0;
+         uint64_t vp_worker = 0;
+      };
+
+      tally_buffers buffers;
+
+      /// Minimum number of accounts tallied by one thread, to avoid spending more time on scheduling than on work
+      const size_t min_accounts_per_thread = 1000;
+
       explicit vote_tally_helper( database& db )
          : d(db), props( d.get_global_properties() ), dprops( d.get_dynamic_global_properties() ),
            now( d.head_block_time() ), hf2103_passed( HARDFORK_CORE_2103_PASSED( now ) ),
            hf2262_passed( HARDFORK_CORE_2262_PASSED( now ) ),
            pob_activated( dprops.total_pob > 0 || dprops.total_inactive > 0 )
       {
-         d._vote_tally_buffer.resize( props.next_available_vote_id, 0 );
-         d._witness_count_histogram_buffer.resize( (props.parameters.maximum_witness_count / two) + 1, 0 );
-         d._committee_count_histogram_buffer.resize( (props.parameters.maximum_committee_count / two) + 1, 0 );
-         d._total_voting_stake[vid_committee] = 0;
-         d._total_voting_stake[vid_witness] = 0;
+         buffers = make_buffers();
          if( hf2103_passed )
          {
             witness_recalc_times   = detail::vote_recalc_options::witness().get_vote_recalc_times( now );
@@ -1290,11 +1356,105 @@ void database::perform_chain_maintenance( const signed_block& next_block )
          }
       }
 
+      tally_buffers make_buffers()const
+      {
+         tally_buffers result;
+         result.votes.resize( props.next_available_vote_id, 0 );
+         result.witness_counts.resize( (props.parameters.maximum_witness_count / two) + 1, 0 );
+         result.committee_counts.resize( (props.parameters.maximum_committee_count / two) + 1, 0 );
+         return result;
+      }
+
       void operator()( const account_object& stake_account, const account_statistics_object& stats )
       {
+         apply( tally( stake_account, stats, buffers ) );
+      }
+
+      /**
+       * Tally a list of accounts in parallel without changing the database
+       * @return voting power of the accounts, in the same order
+       */
+      vector<voting_power> tally_all( const vector< std::pair<const account_object*,
+                                                              const account_statistics_object*> >& accounts )
+      {
+         vector<voting_power> result( accounts.size() );
+
+         const size_t threads = fc::asio::default_io_service_scope::get_num_threads();
+         const size_t chunk_size = std::max( min_accounts_per_thread, ( accounts.size() + threads - 1 ) / threads );
+         if( accounts.size() <= chunk_size )
+         {
+            for( size_t i = 0; i < accounts.size(); ++i )
+               result[i] = tally( *accounts[i].first, *accounts[i].second, buffers );
+            return result;
+         }
+
+         const size_t chunks = ( accounts.size() + chunk_size - 1 ) / chunk_size;
+         vector<tally_buffers> chunk_buffers( chunks, make_buffers() );
+         std::vector<fc::future<void>> workers;
+         workers.reserve( chunks );
+         for( size_t c = 0; c < chunks; ++c )
+         {
+            workers.push_back( fc::do_parallel( [this,&accounts,&result,&chunk_buffers,c,chunk_size] () {
+               const size_t end = std::min( accounts.size(), ( c + 1 ) * chunk_size );
+               for( size_t i = c * chunk_size; i < end; ++i )
+                  result[i] = tally( *accounts[i].first, *accounts[i].second, chunk_buffers[c] );
+            }) );
+         }
+         for( auto& worker : workers )
+            worker.wait();
+
+         // Additions of unsigned integers are associative and commutative, so the sums are identical to
+         // the ones of a serial tally
+         for( const auto& b : chunk_buffers )
+            buffers.merge( b );
+
+         return result;
+      }
+
+      /// Save the voting power of an account
+      void apply( const voting_power& vp )
+      {
+         if( vp.stats == nullptr )
+            return;
+         d.modify( *vp.stats, [&vp,this]( account_statistics_object& update_stats ) {
+            if (update_stats.vote_tally_time != now)
+            {
+               update_stats.vp_all = vp.vp_all;
+               update_stats.vp_active = vp.vp_active;
+               update_stats.vp_committee = vp.vp_committee;
+               update_stats.vp_witness = vp.vp_witness;
+               update_stats.vp_worker = vp.vp_worker;
+               update_stats.vote_tally_time = now;
+            }
+            else
+            {
+               update_stats.vp_all += vp.vp_all;
+               update_stats.vp_active += vp.vp_active;
+               update_stats.vp_committee += vp.vp_committee;
+               update_stats.vp_witness += vp.vp_witness;
+               update_stats.vp_worker += vp.vp_worker;
+            }
+         });
+      }
+
+      /// Move the counted votes to the database
+      void finish()
+      {
+         d._vote_tally_buffer = std::move( buffers.votes );
+         d._witness_count_histogram_buffer = std::move( buffers.witness_counts );
+         d._committee_count_histogram_buffer = std::move( buffers.committee_counts );
+         d._total_voting_stake = buffers.total_voting_stake;
+      }
+
+      /// Count the votes of an account into @p out without changing the database
+      voting_power tally( const account_object& stake_account, const account_statistics_object& stats,
+                          tally_buffers& out )const
+      {
+         voting_power result;
+
          // PoB activation
          if( pob_activated && stats.total_core_pob == 0 && stats.total_core_inactive == 0 )
-            return;
+            return result;
 
          if( props.parameters.count_non_member_votes || stake_account.is_member( now ) )
          {
@@ -1368,7 +1528,7 @@ void database::perform_chain_maintenance( const signed_block& next_block )
 
             // Shortcut
             if( 0 == voting_stake[vid_worker] )
-               return;
+               return result;
 
             const auto& opinion_account_stats = ( directly_voting ? stats : opinion_account.statistics( d ) );
 
@@ -1409,34 +1569,20 @@ void database::perform_chain_maintenance( const signed_block& next_block )
             }
 
             // update voting power
-            d.modify( opinion_account_stats, [vp_all,vp_active,vp_committee,vp_witness,vp_worker,this]
-                                             ( account_statistics_object& update_stats ) {
-               if (update_stats.vote_tally_time != now)
-               {
-                  update_stats.vp_all = vp_all;
-                  update_stats.vp_active = vp_active;
-                  update_stats.vp_committee = vp_committee;
-                  update_stats.vp_witness = vp_witness;
-                  update_stats.vp_worker = vp_worker;
-                  update_stats.vote_tally_time = now;
-               }
-               else
-               {
-                  update_stats.vp_all += vp_all;
-                  update_stats.vp_active += vp_active;
-                  update_stats.vp_committee += vp_committee;
-                  update_stats.vp_witness += vp_witness;
-                  update_stats.vp_worker += vp_worker;
-               }
-            });
+            result.stats = &opinion_account_stats;
+            result.vp_all = vp_all;
+            result.vp_active = vp_active;
+            result.vp_committee = vp_committee;
+            result.vp_witness = vp_witness;
+            result.vp_worker = vp_worker;
 
             for( vote_id_type id : opinion_account.options.votes )
             {
                uint32_t offset = id.instance();
                uint32_t type = std::min( id.type(), vote_id_type::vote_type::worker ); // cap the data
                // if they somehow managed to specify an illegal offset, ignore it.
-               if( offset < d._vote_tally_buffer.size() )
-                  d._vote_tally_buffer[offset] += voting_stake[type];
+               if( offset < out.votes.size() )
+                  out.votes[offset] += voting_stake[type];
             }
 
             // votes for a number greater than maximum_witness_count are skipped here
@@ -1444,25 +1590,27 @@ void database::perform_chain_maintenance( const signed_block& next_block )
                   && opinion_account.options.num_witness <= props.parameters.maximum_witness_count )
             {
                uint16_t offset = opinion_account.options.num_witness / two;
-               d._witness_count_histogram_buffer[offset] += voting_stake[vid_witness];
+               out.witness_counts[offset] += voting_stake[vid_witness];
             }
             // votes for a number greater than maximum_committee_count are skipped here
             if( num_committee_voting_stake > 0
                   && opinion_account.options.num_committee <= props.parameters.maximum_committee_count )
             {
                uint16_t offset = opinion_account.options.num_committee / two;
-               d._committee_count_histogram_buffer[offset] += num_committee_voting_stake;
+               out.committee_counts[offset] += num_committee_voting_stake;
             }
 
-            d._total_voting_stake[vid_committee] += num_committee_voting_stake;
-            d._total_voting_stake[vid_witness] += voting_stake[vid_witness];
+            out.total_voting_stake[vid_committee] += num_committee_voting_stake;
+            out.total_voting_stake[vid_witness] += voting_stake[vid_witness];
          }
+         return result;
       }
    };
 
    vote_tally_helper tally_helper(*this);
 
    perform_account_maintenance( tally_helper );
+   tally_helper.finish();
 
    struct clear_canary {
       explicit clear_canary(vector<uint64_t>& target): target(target){}
@@ -31,16 +31,91 @@
 
 #include <graphene/protocol/fee_schedule.hpp>
 
+#include <fc/asio.hpp>
 #include <fc/io/fstream.hpp>
+#include <fc/thread/thread.hpp>
 
+#include <atomic>
+#include <deque>
 #include <fstream>
 #include <functional>
 #include <iostream>
-#include <queue>
 #include <tuple>
 
 namespace graphene { namespace chain {
 
+namespace {
+
+/**
+ * Reads, unpacks and precomputes blocks on dedicated threads ahead of the block being applied during replay.
+ * Blocks are assigned to the threads round-robin and are handed out in the order they were pushed.
+ */
+class replay_decoder
+{
+   public:
+      struct decoded_block
+      {
+         fc::optional< signed_block > block;
+         size_t                       position = 0; ///< approximate position in the block log after reading
+      };
+      using decode_function = std::function< decoded_block( uint32_t ) >;
+
+      replay_decoder( uint32_t num_threads, decode_function decode ) : _decode( std::move(decode) )
+      {
+         _threads.reserve( num_threads );
+         for( uint32_t t = 0; t < num_threads; ++t )
+            _threads.push_back( std::make_unique<fc::thread>( "replay_decode_" + fc::to_string(t) ) );
+      }
+
+      ~replay_decoder()
+      {
+         // Decode tasks refer to the state of the caller, make sure none of them is still running
+         for( auto& item : _queue )
+         {
+            try { item.wait(); } catch( ... ) {}
+         }
+         for( auto& thread : _threads )
+            thread->quit();
+      }
+
+      size_t size()const  { return _queue.size(); }
+      bool   empty()const { return _queue.empty(); }
+
+      void push( uint32_t block_num )
+      {
+         const decode_function& decode = _decode;
+         _queue.push_back( _threads[ _next_thread ]->async( [&decode,block_num]() { return decode( block_num ); },
+                                                             "replay_decode" ) );
+         _next_thread = ( _next_thread + 1 ) % _threads.size();
+      }
+
+      /// Waits until the oldest block in the queue is decoded
+      const decoded_block& front()const { return _queue.front().wait(); }
+      void pop() { _queue.pop_front(); }
+
+   private:
+      decode_function                             _decode;
+      std::vector< std::unique_ptr<fc::thread> >  _threads;
+      size_t                                      _next_thread = 0;
+      std::deque< fc::future< decoded_block > >   _queue;
+};
+
+void log_replay_throughput( uint32_t blocks, int64_t apply_time, int64_t wait_time, int64_t decode_time,
+                            uint32_t decode_threads )
+{
+   const auto per_second = []( uint32_t count, int64_t microseconds ) {
+      return microseconds > 0 ? uint64_t( count * 1000000.0 / microseconds ) : uint64_t(0);
+   };
+   ilog( "   replay pipeline: apply ${a} blocks/s, decode ${d} blocks/s with ${t} threads, "
+         "apply stage waited ${w} ms for decoding",
+         ("a", per_second( blocks, apply_time ))
+         ("d", per_second( blocks, decode_time / std::max( 1u, decode_threads ) ))
+         ("t", decode_threads)
+         ("w", wait_time / 1000) );
+}
+
+} // anonymous namespace
+
 database::database()
 {
    initialize_indexes();
@@ -80,85 +155,125 @@ void database::reindex( fc::path data_dir )
 
    size_t total_block_size = _block_id_to_block.total_block_size();
    const auto& gpo = get_global_properties();
-   std::queue< std::tuple< size_t, signed_block, fc::future< void > > > blocks;
+   const fc::time_point_sec dupe_check_start = last_block->timestamp - gpo.parameters.maximum_time_until_expiration;
+
+   uint32_t decode_threads = _replay_decode_threads;
+   if( decode_threads == 0 )
+      decode_threads = std::max( 1u, uint32_t(fc::asio::default_io_service_scope::get_num_threads()) );
+   uint32_t window = _replay_window;
+   if( window == 0 )
+      window = std::max( 20u, 4 * decode_threads );
+   ilog( "Replay pipeline: ${t} decode threads, ${w} blocks ahead", ("t",decode_threads)("w",window) );
+
+   // Stage 1+2: blocks are read, unpacked and precomputed by the decode threads.
+   // The block log is thread safe, and the precomputation only depends on the block itself.
+   std::atomic<int64_t> decode_time { 0 };
+   const uint32_t decode_skip = skip;
+   replay_decoder decoder( decode_threads,
+                           [this,&decode_time,dupe_check_start,decode_skip]( uint32_t block_num ) {
+      const auto decode_start = fc::time_point::now();
+      replay_decoder::decoded_block result;
+      result.block = _block_id_to_block.fetch_by_number( block_num );
+      // Only approximate when several threads are reading, good enough for progress reporting
+      result.position = _block_id_to_block.blocks_current_position();
+      if( result.block.valid() )
+      {
+         uint32_t block_skip = decode_skip;
+         if( result.block->timestamp >= dupe_check_start )
+            block_skip &= (uint32_t)(~skip_transaction_dupe_check);
+         precompute_serial( *result.block, block_skip );
+      }
+      decode_time += ( fc::time_point::now() - decode_start ).count();
+      return result;
+   } );
+
+   // Stage 3: blocks are applied in order on this thread
+   int64_t apply_time = 0;
+   int64_t wait_time = 0;
    uint32_t next_block_num = head_block_num() + 1;
    uint32_t i = next_block_num;
-   while( next_block_num <= last_block_num || !blocks.empty() )
+   const uint32_t first_block_num = i;
+   while( next_block_num <= last_block_num || !decoder.empty() )
    {
-      if( next_block_num <= last_block_num && blocks.size() < 20 )
+      if( next_block_num <= last_block_num && decoder.size() < window )
       {
-         const size_t processed_block_size = _block_id_to_block.blocks_current_position();
-         fc::optional< signed_block > block = _block_id_to_block.fetch_by_number( next_block_num );
+         decoder.push( next_block_num );
          ++next_block_num;
-         if( block.valid() )
-         {
-            if( block->timestamp >= (last_block->timestamp - gpo.parameters.maximum_time_until_expiration) )
-               skip &= (uint32_t)(~skip_transaction_dupe_check);
-            blocks.emplace( processed_block_size, std::move(*block), fc::future<void>() );
-            std::get<2>(blocks.back()) = precompute_parallel( std::get<1>(blocks.back()), skip );
-         }
-         else
+         continue;
+      }
+
+      const auto wait_start = fc::time_point::now();
+      const replay_decoder::decoded_block& decoded = decoder.front();
+      const auto apply_start = fc::time_point::now();
+      wait_time += ( apply_start - wait_start ).count();
+
+      if( !decoded.block.valid() )
+      {
+         wlog( "Reindexing terminated due to gap:  Block ${i} does not exist!", ("i", i) );
+         uint32_t dropped_count = 0;
+         while( true )
          {
-            wlog( "Reindexing terminated due to gap:  Block ${i} does not exist!", ("i", i) );
-            uint32_t dropped_count = 0;
-            while( true )
-            {
-               fc::optional< block_id_type > last_id = _block_id_to_block.last_id();
-               // this can trigger if we attempt to e.g. read a file that has block #2 but no block #1
-               // OR
-               // we've caught up to the gap
-               if( !last_id.valid() || block_header::num_from_id( *last_id ) <= i )
-                  break;
-               _block_id_to_block.remove( *last_id );
-               ++dropped_count;
-            }
-            wlog( "Dropped ${n} blocks from after the gap", ("n", dropped_count) );
-            next_block_num = last_block_num + 1; // don't load more blocks
+            fc::optional< block_id_type > last_id = _block_id_to_block.last_id();
+            // this can trigger if we attempt to e.g. read a file that has block #2 but no block #1
+            // OR
+            // we've caught up to the gap
+            if( !last_id.valid() || block_header::num_from_id( *last_id ) <= i )
+               break;
+            _block_id_to_block.remove( *last_id );
+            ++dropped_count;
          }
+         wlog( "Dropped ${n} blocks from after the gap", ("n", dropped_count) );
+         break;
+      }
+
+      const signed_block& block = *decoded.block;
+      if( block.timestamp >= dupe_check_start )
+         skip &= (uint32_t)(~skip_transaction_dupe_check);
+
+      if( i % 10000 == 0 )
+      {
+         std::stringstream bysize;
+         std::stringstream bynum;
+         size_t current_pos = decoded.position;
+         if( current_pos > total_block_size )
+            total_block_size = current_pos;
+         bysize << std::fixed << std::setprecision(5) << (100 * double(current_pos) / total_block_size);
+         bynum << std::fixed << std::setprecision(5) << (100 * double(i) / last_block_num);
+         ilog(
+            "   [by size: ${size}%   ${processed} of ${total}]   [by num: ${num}%   ${i} of ${last}]",
+            ("size", bysize.str())
+            ("processed", current_pos)
+            ("total", total_block_size)
+            ("num", bynum.str())
+            ("i", i)
+            ("last", last_block_num)
+         );
+         log_replay_throughput( i - first_block_num, apply_time, wait_time, decode_time.load(), decode_threads );
+      }
+      if( i == undo_point )
+      {
+         ilog( "Writing object database to disk at block ${i}, please DO NOT kill the program", ("i", i) );
+         flush_incremental();
+         _last_flush_block_num = head_block_num();
+         ilog( "Done writing object database to disk" );
+      }
+      if( i < undo_point )
+      {
+         apply_block( block, skip );
+         flush_incremental_if_due();
       }
       else
       {
-         std::get<2>(blocks.front()).wait();
-         const signed_block& block = std::get<1>(blocks.front());
-
-         if( i % 10000 == 0 )
-         {
-            std::stringstream bysize;
-            std::stringstream bynum;
-            size_t current_pos = std::get<0>(blocks.front());
-            if( current_pos > total_block_size )
-               total_block_size = current_pos;
-            bysize << std::fixed << std::setprecision(5) << (100 * double(current_pos) / total_block_size);
-            bynum << std::fixed << std::setprecision(5) << (100 * double(i) / last_block_num);
-            ilog(
-               "   [by size: ${size}%   ${processed} of ${total}]   [by num: ${num}%   ${i} of ${last}]",
-               ("size", bysize.str())
-               ("processed", current_pos)
-               ("total", total_block_size)
-               ("num", bynum.str())
-               ("i", i)
-               ("last", last_block_num)
-            );
-         }
-         if( i == undo_point )
-         {
-            ilog( "Writing object database to disk at block ${i}, please DO NOT kill the program", ("i", i) );
-            flush();
-            ilog( "Done writing object database to disk" );
-         }
-         if( i < undo_point )
-            apply_block( block, skip );
-         else
-         {
-            _undo_db.enable();
-            push_block( block, skip );
-         }
-         blocks.pop();
-         ++i;
+         _undo_db.enable();
+         push_block( block, skip );
       }
+      decoder.pop();
+      apply_time += ( fc::time_point::now() - apply_start ).count();
+      ++i;
    }
    _undo_db.enable();
    auto end = fc::time_point::now();
+   log_replay_throughput( i - first_block_num, apply_time, wait_time, decode_time.load(), decode_threads );
    ilog( "Done reindexing, elapsed time: ${t} sec", ("t",double((end-start).count())/1000000.0 ) );
 } FC_CAPTURE_AND_RETHROW( (data_dir) ) }
 
@@ -214,6 +329,7 @@ void database::open(
          _p_witness_schedule_obj = &get( witness_schedule_id_type() );
       }
 
+      _last_flush_block_num = head_block_num();
       fc::optional<block_id_type> last_block = _block_id_to_block.last_id();
       if( last_block.valid() )
       {
@@ -222,6 +338,8 @@ void database::open(
                     ("last_block->id", last_block)("head_block_id",head_block_num()) );
          reindex( data_dir );
       }
+      // Otherwise custom authorities could not be checked in parallel until they are used once
+      cache_custom_authority_predicates();
       _opened = true;
    }
    FC_CAPTURE_LOG_AND_RETHROW( (data_dir) )
@@ -262,7 +380,7 @@ void database::close(bool rewinding)
    clear_pending();
 
    ilog( "Writing object database to disk at block ${i}, please DO NOT kill the program", ("i", head_block_num()) );
-   object_database::flush();
+   object_database::flush_incremental();
    ilog( "Done writing object database to disk" );
 
    object_database::close();
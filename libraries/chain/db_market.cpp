@@ -1746,6 +1746,8 @@ bool database::check_call_orders( const asset_object& mia, bool enable_black_swa
                                   const asset_bitasset_data_object* bitasset_ptr,
                                   bool mute_exceptions, bool skip_matching_settle_orders )
 { try {
+    evaluator_profiler::scoped_timer timer( get_evaluator_profiler(), evaluator_profiler::check_call_orders );
+
     const auto& dyn_prop = get_dynamic_global_properties();
     auto maint_time = dyn_prop.next_maintenance_time;
     if( for_new_limit_order )
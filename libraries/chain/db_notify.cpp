@@ -592,8 +592,8 @@ void database::notify_changed_objects()
         flat_set<account_id_type> new_accounts_impacted;
         for( const auto& item : head_undo.new_ids )
         {
-          new_ids.push_back(item);
-          auto* obj = find_object(item);
+          new_ids.push_back(item.first);
+          auto* obj = find_object(item.first);
           if(obj != nullptr)
             get_relevant_accounts(obj, new_accounts_impacted,
                                   MUST_IGNORE_CUSTOM_OP_REQD_AUTHS(chain_time));
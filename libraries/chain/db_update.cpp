@@ -265,6 +265,8 @@ void database::update_bitasset_current_feed( const asset_bitasset_data_object& b
 
 void database::clear_expired_orders()
 { try {
+         evaluator_profiler::scoped_timer timer( get_evaluator_profiler(), evaluator_profiler::clear_expired_orders );
+
          //Cancel expired limit orders
          auto head_time = head_block_time();
          auto maint_time = get_dynamic_global_properties().next_maintenance_time;
@@ -475,6 +477,8 @@ void database::clear_expired_force_settlements()
 
 void database::update_expired_feeds()
 {
+   evaluator_profiler::scoped_timer timer( get_evaluator_profiler(), evaluator_profiler::update_expired_feeds );
+
    const auto head_time = head_block_time();
    bool after_hardfork_615 = ( head_time >= HARDFORK_615_TIME );
    bool after_core_hardfork_2582 = HARDFORK_CORE_2582_PASSED( head_time ); // Price feed issues
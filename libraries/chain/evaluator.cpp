@@ -42,12 +42,31 @@ database& generic_evaluator::db()const { return trx_state->db(); }
    { try {
       trx_state   = &eval_state;
       //check_required_authorities(op);
+      evaluator_profiler* profiler = db().get_evaluator_profiler();
+      if( profiler )
+         return profiled_evaluate( *profiler, op, apply );
+
       auto result = evaluate( op );
 
       if( apply ) result = this->apply( op );
       return result;
    } FC_CAPTURE_AND_RETHROW() }
 
+   operation_result generic_evaluator::profiled_evaluate( evaluator_profiler& profiler, const operation& op, bool apply )
+   {
+      auto start = evaluator_profiler::clock::now();
+      auto result = evaluate( op );
+      auto evaluated = evaluator_profiler::clock::now();
+      profiler.record_evaluate( op.which(), evaluated - start );
+
+      if( apply )
+      {
+         result = this->apply( op );
+         profiler.record_apply( op.which(), evaluator_profiler::clock::now() - evaluated );
+      }
+      return result;
+   }
+
    void generic_evaluator::prepare_fee(account_id_type account_id, asset fee)
    {
       const database& d = db();
@@ -0,0 +1,155 @@
+/*
+ * Copyright (c) 2026 Contributors.
+ *
+ * The MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#include <graphene/chain/evaluator_profiler.hpp>
+
+#include <fc/log/logger.hpp>
+
+namespace graphene { namespace chain {
+
+constexpr size_t latency_histogram::bucket_count;
+
+size_t latency_histogram::bucket_of( uint64_t ns )
+{
+   uint64_t us = ns / 1000;
+   size_t bucket = 0;
+   while( us > 0 && bucket + 1 < bucket_count )
+   {
+      us >>= 1;
+      ++bucket;
+   }
+   return bucket;
+}
+
+evaluator_profiler::counters::counters()
+{
+   for( auto& bucket : buckets )
+      bucket.store( 0, std::memory_order_relaxed );
+}
+
+void evaluator_profiler::counters::add( clock::duration elapsed )
+{
+   const auto ns = static_cast<uint64_t>(
+         std::max<int64_t>( 0, std::chrono::duration_cast<std::chrono::nanoseconds>( elapsed ).count() ) );
+   count.fetch_add( 1, std::memory_order_relaxed );
+   total_ns.fetch_add( ns, std::memory_order_relaxed );
+   buckets[ latency_histogram::bucket_of( ns ) ].fetch_add( 1, std::memory_order_relaxed );
+   uint64_t old_max = max_ns.load( std::memory_order_relaxed );
+   while( ns > old_max && !max_ns.compare_exchange_weak( old_max, ns, std::memory_order_relaxed ) )
+      ;
+}
+
+latency_histogram evaluator_profiler::counters::snapshot()const
+{
+   latency_histogram result;
+   result.count = count.load( std::memory_order_relaxed );
+   result.total_ns = total_ns.load( std::memory_order_relaxed );
+   result.max_ns = max_ns.load( std::memory_order_relaxed );
+   result.buckets.reserve( buckets.size() );
+   for( const auto& bucket : buckets )
+      result.buckets.push_back( bucket.load( std::memory_order_relaxed ) );
+   return result;
+}
+
+void evaluator_profiler::counters::reset()
+{
+   count.store( 0, std::memory_order_relaxed );
+   total_ns.store( 0, std::memory_order_relaxed );
+   max_ns.store( 0, std::memory_order_relaxed );
+   for( auto& bucket : buckets )
+      bucket.store( 0, std::memory_order_relaxed );
+}
+
+evaluator_profiler::evaluator_profiler()
+   : _evaluate( new counters[ operation::count() ] ), _apply( new counters[ operation::count() ] )
+{}
+
+const char* evaluator_profiler::phase_name( block_phase phase )
+{
+   switch( phase )
+   {
+   case clear_expired_orders:      return "clear_expired_orders";
+   case update_expired_feeds:      return "update_expired_feeds";
+   case perform_chain_maintenance: return "perform_chain_maintenance";
+   case check_call_orders:         return "check_call_orders";
+   default:                        return "unknown";
+   }
+}
+
+static string operation_name( int64_t op_type )
+{
+   string name = fc::typelist::runtime::dispatch( operation::list(), op_type, []( auto t ) -> string {
+      return fc::get_typename<typename decltype(t)::type>::name();
+   });
+   auto pos = name.rfind( "::" );
+   return ( pos == string::npos ) ? name : name.substr( pos + 2 );
+}
+
+evaluator_profile evaluator_profiler::get_profile()const
+{
+   evaluator_profile result;
+   for( int64_t op_type = 0; op_type < operation::count(); ++op_type )
+   {
+      if( _evaluate[op_type].count.load( std::memory_order_relaxed ) == 0 )
+         continue;
+      result.operations.push_back( { operation_name( op_type ),
+                                     _evaluate[op_type].snapshot(), _apply[op_type].snapshot() } );
+   }
+   for( size_t phase = 0; phase < block_phase_count; ++phase )
+   {
+      if( _phases[phase].count.load( std::memory_order_relaxed ) == 0 )
+         continue;
+      result.phases.push_back( { phase_name( static_cast<block_phase>( phase ) ), _phases[phase].snapshot() } );
+   }
+   return result;
+}
+
+void evaluator_profiler::log_profile()const
+{
+   const auto average_us = []( const latency_histogram& h ) {
+      return h.count == 0 ? 0 : h.total_ns / h.count / 1000;
+   };
+   const evaluator_profile profile = get_profile();
+   for( const auto& op : profile.operations )
+      ilog( "Evaluator profile ${op}: evaluated ${ne}x avg ${ae}us max ${me}us, applied ${na}x avg ${aa}us max ${ma}us",
+            ("op", op.operation)
+            ("ne", op.evaluate.count)("ae", average_us( op.evaluate ))("me", op.evaluate.max_ns / 1000)
+            ("na", op.apply.count)("aa", average_us( op.apply ))("ma", op.apply.max_ns / 1000) );
+   for( const auto& phase : profile.phases )
+      ilog( "Block phase profile ${p}: run ${n}x avg ${a}us max ${m}us total ${t}ms",
+            ("p", phase.phase)("n", phase.duration.count)("a", average_us( phase.duration ))
+            ("m", phase.duration.max_ns / 1000)("t", phase.duration.total_ns / 1000000) );
+}
+
+void evaluator_profiler::reset()
+{
+   for( int64_t op_type = 0; op_type < operation::count(); ++op_type )
+   {
+      _evaluate[op_type].reset();
+      _apply[op_type].reset();
+   }
+   for( auto& phase : _phases )
+      phase.reset();
+}
+
+} } // graphene::chain
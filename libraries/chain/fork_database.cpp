@@ -44,7 +44,7 @@ void fork_database::pop_block()
 
 void     fork_database::start_block(signed_block b)
 {
-   auto item = std::make_shared<fork_item>(std::move(b));
+   auto item = std::make_shared<fork_item>( std::make_shared<const signed_block>( std::move(b) ) );
    _index.insert(item);
    _head = item;
 }
@@ -54,6 +54,11 @@ void     fork_database::start_block(signed_block b)
  *
  */
 shared_ptr<fork_item>  fork_database::push_block(const signed_block& b)
+{
+   return push_block( std::make_shared<const signed_block>( b ) );
+}
+
+shared_ptr<fork_item>  fork_database::push_block(const block_ptr& b)
 {
    auto item = std::make_shared<fork_item>(b);
    try {
@@ -61,7 +66,7 @@ shared_ptr<fork_item>  fork_database::push_block(const signed_block& b)
    }
    catch ( const unlinkable_block_exception& e )
    {
-      wlog( "Pushing block to fork database that failed to link: ${id}, ${num}", ("id",b.id())("num",b.block_num()) );
+      wlog( "Pushing block to fork database that failed to link: ${id}, ${num}", ("id",item->id)("num",item->num) );
       wlog( "Head: ${num}, ${id}", ("num",_head->data.block_num())("id",_head->data.id()) );
       throw;
    }
@@ -22,16 +22,33 @@
  * THE SOFTWARE.
  */
 #pragma once
+#include <atomic>
 #include <fstream>
+#include <memory>
 #include <graphene/protocol/block.hpp>
 
 #include <fc/filesystem.hpp>
+#include <fc/interprocess/file_mapping.hpp>
+
+#include <boost/thread/shared_mutex.hpp>
 
 namespace graphene { namespace chain {
    struct index_entry;
    using namespace graphene::protocol;
 
-   class block_database 
+   /**
+    *  @brief Append-only on-disk log of irreversible blocks
+    *
+    *  The log consists of two files: @c blocks holds the packed blocks back to back, and @c index is a flat
+    *  array of @ref index_entry indexed by block number.  Both files are read through read-only memory
+    *  mappings, so lookups do not need any system call and may be performed concurrently from multiple
+    *  threads.  Writes are done through regular file handles on the calling thread and are serialized
+    *  against readers.
+    *
+    *  The mappings are created larger than the files so that appending blocks only occasionally requires a
+    *  remap.  Only the part of a mapping that lies within the current file size is ever accessed.
+    */
+   class block_database
    {
       public:
          void open( const fc::path& dbdir );
@@ -40,20 +57,53 @@ namespace graphene { namespace chain {
          void close();
 
          void store( const block_id_type& id, const signed_block& b );
+         /// Stores a block which has already been serialized with fc::raw::pack()
+         void store_packed( const block_id_type& id, const vector<char>& packed_block );
          void remove( const block_id_type& id );
 
          bool                   contains( const block_id_type& id )const;
          block_id_type          fetch_block_id( uint32_t block_num )const;
          optional<signed_block> fetch_optional( const block_id_type& id )const;
          optional<signed_block> fetch_by_number( uint32_t block_num )const;
+         /// Returns the block as it is stored on disk, i.e. serialized with fc::raw::pack()
+         optional<vector<char>> fetch_packed( const block_id_type& id )const;
          optional<signed_block> last()const;
          optional<block_id_type> last_id()const;
          size_t                 blocks_current_position()const;
          size_t                 total_block_size()const;
       private:
+         /// A read-only mapping of a file which may be larger than the file itself
+         struct mapped_file
+         {
+            mapped_file( const fc::path& filename, size_t capacity );
+            fc::file_mapping  mapping;
+            fc::mapped_region region;
+            const char*       data()const { return static_cast<const char*>( region.get_address() ); }
+         };
+
          optional<index_entry> last_index_entry()const;
+         /// Reads the index entry of the given block number, requires a lock to be held by the caller
+         bool read_index_entry( uint32_t block_num, index_entry& e )const;
+         /// Unpacks the block referenced by the index entry, requires a lock to be held by the caller
+         signed_block read_block( const index_entry& e )const;
+         /// Makes sure the mappings cover the current file sizes, requires the exclusive lock
+         void update_mappings();
+
          fc::path _index_filename;
-         mutable std::fstream _blocks;
-         mutable std::fstream _block_num_to_pos;
+         fc::path _blocks_filename;
+         std::fstream _blocks;
+         std::fstream _block_num_to_pos;
+
+         /// Current sizes of the files, the mappings must not be accessed beyond these
+         mutable uint64_t _index_size = 0;
+         uint64_t _blocks_size = 0;
+         /// End position of the most recently read block, used for progress reporting during replay
+         mutable std::atomic<uint64_t> _blocks_read_position { 0 };
+
+         std::unique_ptr<mapped_file> _index_map;
+         std::unique_ptr<mapped_file> _blocks_map;
+
+         /// Readers hold it shared, writers and remapping hold it exclusively
+         mutable boost::shared_mutex _mutex;
    };
 } }
@@ -39,9 +39,9 @@ namespace graphene { namespace chain {
    class custom_authority_object : public abstract_object<custom_authority_object,
                                              protocol_ids, custom_authority_object_type>
    {
-      /// Unreflected field to store a cache of the predicate function
+      /// Unreflected field to store a cache of the predicate function, shared by copies of the object
       /// Note that this cache can be modified when the object is const!
-      mutable optional<restriction_predicate_function> predicate_cache;
+      mutable std::shared_ptr<const restriction_predicate_function> predicate_cache;
 
    public:
       account_id_type account;
@@ -64,16 +64,28 @@ namespace graphene { namespace chain {
          return rs;
       }
       /// Get predicate, from cache if possible, and update cache if not (modifies const object!)
-      restriction_predicate_function get_predicate() const {
-         if (!predicate_cache.valid())
+      const restriction_predicate_function& get_predicate() const {
+         if (!predicate_cache)
             update_predicate_cache();
 
          return *predicate_cache;
       }
       /// Regenerate predicate function and update predicate cache
       void update_predicate_cache() const {
-         predicate_cache = get_restriction_predicate(get_restrictions(), operation_type);
+         predicate_cache = std::make_shared<const restriction_predicate_function>(
+                              get_restriction_predicate(get_restrictions(), operation_type));
       }
+      /// Regenerate predicate function and update predicate cache, or clear the cache if it can not be generated,
+      /// so that the error is reported by get_predicate() when the custom authority is used
+      void try_update_predicate_cache() const {
+         try {
+            update_predicate_cache();
+         } catch (const fc::exception&) {
+            predicate_cache.reset();
+         }
+      }
+      /// Check whether the predicate function is cached, so that get_predicate() does not modify the object
+      bool is_predicate_cached() const { return predicate_cache != nullptr; }
       /// Clear the cache of the predicate function
       void clear_predicate_cache() { predicate_cache.reset(); }
    };
@@ -24,6 +24,7 @@
 #pragma once
 
 #include <graphene/protocol/fee_schedule.hpp>
+#include <graphene/protocol/signature_key_cache.hpp>
 
 #include <graphene/chain/global_property_object.hpp>
 #include <graphene/chain/node_property_object.hpp>
@@ -33,6 +34,7 @@
 #include <graphene/chain/block_database.hpp>
 #include <graphene/chain/genesis_state.hpp>
 #include <graphene/chain/evaluator.hpp>
+#include <graphene/chain/evaluator_profiler.hpp>
 
 #include <graphene/db/object_database.hpp>
 #include <graphene/db/object.hpp>
@@ -42,10 +44,13 @@
 #include <fc/log/logger.hpp>
 
 #include <map>
+#include <unordered_set>
 
 namespace graphene { namespace protocol { struct predicate_result; } }
 
 namespace graphene { namespace chain {
+   namespace detail { struct pending_transactions_restorer; }
+
    using graphene::db::abstract_object;
    using graphene::db::object;
    class op_evaluator;
@@ -207,6 +212,9 @@ namespace graphene { namespace chain {
          vector<authority> get_viable_custom_authorities(
                  account_id_type account, const operation& op,
                  rejected_predicate_map* rejected_authorities = nullptr )const;
+         /// Builds the predicates of all enabled custom authorities which are not cached, e.g. after a restart,
+         /// since the predicates are not persisted
+         void cache_custom_authority_predicates()const;
 
          uint32_t last_non_undoable_block_num() const;
 
@@ -262,6 +270,10 @@ namespace graphene { namespace chain {
           * @param delta Asset ID and amount to adjust balance by
           */
          void adjust_balance(account_id_type account, asset delta);
+      private:
+         /// Tracks the lookup of a balance by account and asset as a read for the pending transaction effects
+         void track_balance_read( const account_balance_object* abo )const;
+      public:
 
          void deposit_market_fee_vesting_balance(const account_id_type &account_id, const asset &delta);
          /**
@@ -546,6 +558,8 @@ namespace graphene { namespace chain {
          block_id_type              get_block_id_for_num( uint32_t block_num )const;
          optional<signed_block>     fetch_block_by_id( const block_id_type& id )const;
          optional<signed_block>     fetch_block_by_number( uint32_t num )const;
+         /// @return the block serialized with fc::raw::pack(), read as is from the block log if it is stored there
+         optional<vector<char>>     fetch_packed_block_by_id( const block_id_type& id )const;
          const signed_transaction&  get_recent_transaction( const transaction_id_type& trx_id )const;
          std::vector<block_id_type> get_block_ids_on_fork(block_id_type head_of_fork) const;
 
@@ -554,12 +568,66 @@ namespace graphene { namespace chain {
          bool before_last_checkpoint()const;
 
          bool push_block( const signed_block& b, uint32_t skip = skip_nothing );
+         /// Pushes a block which is kept by reference in the fork database instead of being copied
+         bool push_block( const block_ptr& b, uint32_t skip = skip_nothing );
          processed_transaction push_transaction( const precomputable_transaction& trx, uint32_t skip = skip_nothing );
       private:
-         bool _push_block( const signed_block& b );
+         bool _push_block( const block_ptr& b );
+         /// Writes the changes up to the last non-undoable block since the object database was last saved, if
+         /// @ref _flush_interval blocks have become non-undoable since then
+         void flush_incremental_if_due();
       public:
          // It is public because it is used in pending_transactions_restorer in db_with.hpp
          processed_transaction _push_transaction( const precomputable_transaction& trx );
+
+         /**
+          * What a pending transaction read and wrote, so that its result can be kept when a new block does not
+          * change anything it depends on.  Only recorded for transactions which may be reapplied this way,
+          * see pending_transactions_restorer in db_with.hpp.
+          */
+         struct pending_transaction_effects
+         {
+            /// Stands for all objects of the space and type of @p id, for dependencies on whole indexes
+            static object_id_type any_of_type( const object_id_type& id )
+            {
+               return object_id_type( id.space(), id.type(), object_id_type::max_instance );
+            }
+
+            /// Sorted IDs of the objects the transaction looked up by ID, and @ref any_of_type of the
+            /// indexes it searched
+            std::vector<object_id_type>                  reads;
+            /// Sorted IDs of the objects the transaction removed
+            std::vector<object_id_type>                  removed;
+            /// Sorted IDs of the objects the transaction created
+            std::vector<object_id_type>                  created;
+            /// The modified and created objects as left by the transaction, sorted by ID
+            std::vector<std::shared_ptr<const object>>   written;
+            /// The head block time when the transaction was evaluated
+            fc::time_point_sec                           head_time;
+         };
+
+      private:
+         friend struct detail::pending_transactions_restorer;
+
+         /**
+          * Collects the objects changed by the head block, when it was applied on top of @p previous_head or
+          * no block was applied at all
+          * @return false if pending transactions must be evaluated again, e.g. after a fork switch or at a
+          *         maintenance interval
+          */
+         bool _get_head_block_changes( const block_id_type& previous_head,
+                                       std::unordered_set<object_id_type>& changed )const;
+
+         /**
+          * Applies the recorded effects of a pending transaction again instead of evaluating it, if none of
+          * the objects it depends on were changed
+          * @return false if the transaction must be evaluated again
+          */
+         bool _reapply_pending_transaction( const processed_transaction& trx,
+                                            const std::shared_ptr<const pending_transaction_effects>& effects,
+                                            const std::unordered_set<object_id_type>& changed );
+
+      public:
          ///@throws fc::exception if the proposed transaction fails to apply.
          processed_transaction push_proposal( const proposal_object& proposal );
 
@@ -569,8 +637,15 @@ namespace graphene { namespace chain {
             const fc::ecc::private_key& block_signing_private_key,
             uint32_t skip
             );
+         /// Same as @ref generate_block, but returns the block shared with the fork database instead of a copy
+         block_ptr generate_shared_block(
+            const fc::time_point_sec when,
+            witness_id_type witness_id,
+            const fc::ecc::private_key& block_signing_private_key,
+            uint32_t skip
+            );
       private:
-         signed_block _generate_block(
+         block_ptr _generate_block(
             const fc::time_point_sec when,
             witness_id_type witness_id,
             const fc::ecc::private_key& block_signing_private_key
@@ -668,6 +743,11 @@ namespace graphene { namespace chain {
          template<typename Trx>
          void _precompute_parallel( const Trx* trx, const size_t count, const uint32_t skip )const;
 
+         /** Does the same as @ref precompute_parallel, but entirely in the calling thread.
+          *  Used during replay where whole blocks are precomputed in parallel.
+          */
+         void precompute_serial( const signed_block& block, const uint32_t skip )const;
+
       protected:
          // Mark pop_undo() as protected -- we do not want outside calling pop_undo(),
          // it should call pop_block() instead
@@ -691,6 +771,27 @@ namespace graphene { namespace chain {
          void                  _apply_block( const signed_block& next_block );
          processed_transaction _apply_transaction( const signed_transaction& trx );
 
+         /// Result of verifying the authorities of a transaction of a block against the state before the block
+         struct authority_precheck
+         {
+            bool                      passed = false;
+            /// Whether custom authorities were looked up
+            bool                      uses_custom_authorities = false;
+            /// Accounts whose authorities were looked up
+            flat_set<account_id_type> accounts;
+         };
+         /**
+          * Verifies the authorities of the transactions of a block in parallel, against the current state.
+          * @return the results by transaction, or an empty vector if the block is not worth verifying in advance,
+          *         or changes made by the block could not be tracked
+          */
+         vector<authority_precheck> precheck_authorities( const signed_block& block )const;
+         void precheck_authority( const signed_transaction& trx, authority_precheck& result )const;
+         /// @return whether nothing a successful precheck depends on was changed since the block began to be applied
+         bool is_precheck_valid( const authority_precheck& check, bool custom_authorities_changed )const;
+         /// @return whether the predicates of the custom authorities which may authorize @p op are all cached
+         bool are_custom_authority_predicates_cached( account_id_type account, const operation& op )const;
+
          ///Steps involved in applying a new block
          ///@{
 
@@ -746,11 +847,17 @@ namespace graphene { namespace chain {
          void process_bitassets();
 
          template<class Type>
-         void perform_account_maintenance( Type tally_helper );
+         void perform_account_maintenance( Type& tally_helper );
          ///@}
          ///@}
 
          vector< processed_transaction >        _pending_tx;
+         /// Effects of the transactions in @ref _pending_tx, in the same order, null if not recorded
+         vector< std::shared_ptr<const pending_transaction_effects> > _pending_tx_effects;
+         /// Skip flags any of the transactions in @ref _pending_tx was applied with
+         uint32_t                               _pending_tx_skip_flags = 0;
+         /// Whether any of the transactions in @ref _pending_tx was reapplied from its recorded effects
+         bool                                   _pending_tx_reapplied = false;
          fork_database                          _fork_db;
 
          /**
@@ -794,6 +901,22 @@ namespace graphene { namespace chain {
          /// Set it to true to provide accurate data to API clients, set to false to have better performance.
          bool                              _track_standby_votes = true;
 
+         /// Number of blocks to be read and precomputed ahead of the block being applied during replay,
+         /// 0 for auto-configuration
+         uint32_t                          _replay_window = 0;
+         /// Number of dedicated threads reading and precomputing blocks during replay, 0 for auto-configuration
+         uint32_t                          _replay_decode_threads = 0;
+
+         /// Number of blocks after which the changed objects are written to disk, so that little has to be replayed
+         /// after a crash, 0 to only write them on shutdown
+         uint32_t                          _flush_interval = 0;
+         /// Number of the last block included in the state last written to disk
+         uint32_t                          _last_flush_block_num = 0;
+
+         /// Public keys recovered from signatures of pushed transactions, to be reused when the transactions
+         /// come again in a block.  Filled and read by the precompute methods, possibly in parallel.
+         mutable signature_key_cache       _signature_key_cache;
+
          /**
           * Whether database is successfully opened or not.
           *
@@ -818,9 +941,37 @@ namespace graphene { namespace chain {
          const chain_property_object*           _p_chain_property_obj      = nullptr;
          const witness_schedule_object*         _p_witness_schedule_obj    = nullptr;
          ///@}
+
+         /// Collects evaluator and block phase timings when profiling is enabled.  It is never destroyed before the
+         /// database, since API callers may still use it after profiling has been disabled.
+         const std::unique_ptr<evaluator_profiler> _evaluator_profiler = std::make_unique<evaluator_profiler>();
+         std::atomic<bool> _evaluator_profiling_enabled{ false };
       public:
          /// Enable or disable tracking of votes of standby witnesses and committee members
          inline void enable_standby_votes_tracking(bool enable)  { _track_standby_votes = enable; }
+         /// Configure the replay pipeline, 0 for auto-configuration
+         inline void set_replay_pipeline( uint32_t window, uint32_t decode_threads )
+         {
+            _replay_window = window;
+            _replay_decode_threads = decode_threads;
+         }
+         /// Set the number of blocks after which the changed objects are written to disk, 0 to disable
+         inline void set_flush_interval( uint32_t blocks ) { _flush_interval = blocks; }
+         /// Set the maximum number of cached public keys recovered from signatures, 0 to disable the cache
+         inline void set_signature_cache_size( size_t size ) { _signature_key_cache.set_capacity( size ); }
+         /// Enable or disable collecting the time spent in evaluators and in the expensive phases of block processing
+         /// Disabling resets the collected timings
+         inline void enable_evaluator_profiling( bool enable )
+         {
+            if( _evaluator_profiling_enabled.exchange( enable ) && !enable )
+               _evaluator_profiler->reset();
+         }
+         /// @return the evaluator profiler, or a null pointer if profiling is disabled.  The profiler stays valid
+         ///         for the lifetime of the database.
+         inline evaluator_profiler* get_evaluator_profiler()const
+         {
+            return _evaluator_profiling_enabled ? _evaluator_profiler.get() : nullptr;
+         }
    };
 
 } }
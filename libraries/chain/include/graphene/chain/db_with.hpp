@@ -63,19 +63,34 @@ struct skip_flags_restorer
  * Class used to help the without_pending_transactions
  * implementation.
  *
+ * Pending transactions whose recorded effects do not depend on anything
+ * the new block changed are reapplied from their effects instead of being
+ * evaluated again.  This requires all earlier pending transactions to be
+ * either reapplied too, or to have their effects recorded, so that what
+ * they changed by being evaluated again or dropped is known.
+ *
  * TODO:  Change the name of this class to better reflect the fact
  * that it restores popped transactions as well as pending transactions.
  */
 struct pending_transactions_restorer
 {
-   pending_transactions_restorer( database& db, std::vector<processed_transaction>&& pending_transactions )
-      : _db(db), _pending_transactions( std::move(pending_transactions) )
+   using effects_ptr = std::shared_ptr<const database::pending_transaction_effects>;
+
+   pending_transactions_restorer( database& db, std::vector<processed_transaction>&& pending_transactions,
+                                  std::vector<effects_ptr>&& pending_effects )
+      : _db(db), _pending_transactions( std::move(pending_transactions) ),
+        _pending_effects( std::move(pending_effects) ), _head_block_id( db.head_block_id() ),
+        _pending_skip_flags( db._pending_tx_skip_flags )
    {
       _db.clear_pending();
    }
 
    ~pending_transactions_restorer()
    {
+      std::unordered_set<object_id_type> changed;
+      bool may_reapply = _db._popped_tx.empty() && _db._get_head_block_changes( _head_block_id, changed );
+      bool reapplied = false;
+
       for( const auto& tx : _db._popped_tx )
       {
          try {
@@ -86,22 +101,60 @@ struct pending_transactions_restorer
          }
       }
       _db._popped_tx.clear();
-      for( const processed_transaction& tx : _pending_transactions )
+      for( size_t i = 0; i < _pending_transactions.size(); ++i )
       {
+         const processed_transaction& tx = _pending_transactions[i];
+         const effects_ptr effects = ( i < _pending_effects.size() ) ? _pending_effects[i] : effects_ptr();
          try
          {
             if( !_db.is_known_transaction( tx.id() ) ) {
+               if( may_reapply && effects && _db._reapply_pending_transaction( tx, effects, changed ) )
+               {
+                  reapplied = true;
+                  continue;
+               }
+               // Later transactions may depend on what this one did before, or does now
+               mark_changed( effects, changed, may_reapply );
                _db._push_transaction( tx );
+               mark_changed( _db._pending_tx_effects.back(), changed, may_reapply );
             }
          }
          catch( const fc::exception& )
          { // ignore invalid transactions
          }
       }
+      // Reapplied transactions were checked with the skip flags they were pushed with
+      if( reapplied )
+      {
+         _db._pending_tx_skip_flags |= _pending_skip_flags;
+         _db._pending_tx_reapplied = true;
+      }
+   }
+
+   static void mark_changed( const effects_ptr& effects, std::unordered_set<object_id_type>& changed,
+                             bool& may_reapply )
+   {
+      if( !effects )
+         may_reapply = false;
+      if( !may_reapply )
+         return;
+      const auto mark = [&changed]( const object_id_type& id ) {
+         changed.insert( id );
+         changed.insert( database::pending_transaction_effects::any_of_type( id ) );
+      };
+      for( const auto& id : effects->removed )
+         mark( id );
+      for( const auto& id : effects->created )
+         mark( id );
+      for( const auto& obj : effects->written )
+         mark( obj->id );
    }
 
    database& _db;
    std::vector< processed_transaction > _pending_transactions;
+   std::vector< effects_ptr > _pending_effects;
+   block_id_type _head_block_id;
+   uint32_t _pending_skip_flags;
 };
 
 /**
@@ -132,9 +185,10 @@ template< typename Lambda >
 void without_pending_transactions(
    database& db,
    std::vector<processed_transaction>&& pending_transactions,
+   std::vector<pending_transactions_restorer::effects_ptr>&& pending_effects,
    Lambda callback )
 {
-    pending_transactions_restorer restorer( db, std::move(pending_transactions) );
+    pending_transactions_restorer restorer( db, std::move(pending_transactions), std::move(pending_effects) );
     callback();
     return;
 }
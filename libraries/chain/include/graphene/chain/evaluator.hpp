@@ -29,6 +29,7 @@
 namespace graphene { namespace chain {
 
    class database;
+   class evaluator_profiler;
    class generic_evaluator;
    class transaction_evaluation_state;
    class account_object;
@@ -52,6 +53,9 @@ namespace graphene { namespace chain {
       virtual operation_result evaluate(const operation& op) = 0;
       virtual operation_result apply(const operation& op) = 0;
 
+      /// Same as evaluate() followed by apply() if @p apply is true, recording the time each of them takes
+      operation_result profiled_evaluate( evaluator_profiler& profiler, const operation& op, bool apply );
+
       /**
        * Routes the fee to where it needs to go.  The default implementation
        * routes the fee to the account_statistics_object of the fee_paying_account.
@@ -0,0 +1,150 @@
+/*
+ * Copyright (c) 2026 Contributors.
+ *
+ * The MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#pragma once
+#include <graphene/protocol/operations.hpp>
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <memory>
+
+namespace graphene { namespace chain {
+
+   /// A snapshot of the latencies recorded for one profiled code path
+   struct latency_histogram
+   {
+      /// Bucket 0 counts durations below 1 microsecond, bucket i durations of [2^(i-1), 2^i) microseconds,
+      /// the last bucket everything longer
+      static constexpr size_t bucket_count = 24;
+
+      uint64_t              count = 0;
+      uint64_t              total_ns = 0;
+      uint64_t              max_ns = 0;
+      std::vector<uint64_t> buckets;
+
+      static size_t bucket_of( uint64_t ns );
+   };
+
+   struct operation_profile
+   {
+      string            operation;
+      latency_histogram evaluate;
+      latency_histogram apply;
+   };
+
+   struct block_phase_profile
+   {
+      string            phase;
+      latency_histogram duration;
+   };
+
+   struct evaluator_profile
+   {
+      /// Operation types which were evaluated at least once
+      vector<operation_profile>   operations;
+      /// Block processing phases which were run at least once
+      vector<block_phase_profile> phases;
+   };
+
+   /**
+    * Collects the time spent in evaluators per operation type, and in the expensive phases of block processing.
+    *
+    * Recording is lock-free, so that a snapshot can be taken from an API thread while blocks are being applied.
+    * Counters of one path may be slightly out of step with each other in such a snapshot.
+    */
+   class evaluator_profiler
+   {
+   public:
+      enum block_phase
+      {
+         clear_expired_orders,
+         update_expired_feeds,
+         perform_chain_maintenance,
+         check_call_orders,
+         block_phase_count
+      };
+
+      using clock = std::chrono::steady_clock;
+
+      /// Times the enclosing scope, does nothing if constructed with a null profiler
+      class scoped_timer
+      {
+      public:
+         scoped_timer( evaluator_profiler* profiler, block_phase phase )
+            : _profiler( profiler ), _phase( phase )
+         {
+            if( _profiler )
+               _start = clock::now();
+         }
+         ~scoped_timer()
+         {
+            if( _profiler )
+               _profiler->record_phase( _phase, clock::now() - _start );
+         }
+         scoped_timer( const scoped_timer& ) = delete;
+         scoped_timer& operator=( const scoped_timer& ) = delete;
+      private:
+         evaluator_profiler* _profiler;
+         block_phase         _phase;
+         clock::time_point   _start;
+      };
+
+      evaluator_profiler();
+
+      void record_evaluate( int64_t op_type, clock::duration elapsed ) { _evaluate[op_type].add( elapsed ); }
+      void record_apply( int64_t op_type, clock::duration elapsed ) { _apply[op_type].add( elapsed ); }
+      void record_phase( block_phase phase, clock::duration elapsed ) { _phases[phase].add( elapsed ); }
+
+      evaluator_profile get_profile()const;
+      /// Writes the non-empty counters to the log
+      void log_profile()const;
+      void reset();
+
+      static const char* phase_name( block_phase phase );
+
+   private:
+      struct counters
+      {
+         std::atomic<uint64_t> count{0};
+         std::atomic<uint64_t> total_ns{0};
+         std::atomic<uint64_t> max_ns{0};
+         std::array<std::atomic<uint64_t>, latency_histogram::bucket_count> buckets;
+
+         counters();
+         void add( clock::duration elapsed );
+         latency_histogram snapshot()const;
+         void reset();
+      };
+
+      std::unique_ptr<counters[]> _evaluate;
+      std::unique_ptr<counters[]> _apply;
+      std::array<counters, block_phase_count> _phases;
+   };
+
+} } // graphene::chain
+
+FC_REFLECT( graphene::chain::latency_histogram, (count)(total_ns)(max_ns)(buckets) )
+FC_REFLECT( graphene::chain::operation_profile, (operation)(evaluate)(apply) )
+FC_REFLECT( graphene::chain::block_phase_profile, (phase)(duration) )
+FC_REFLECT( graphene::chain::evaluator_profile, (operations)(phases) )
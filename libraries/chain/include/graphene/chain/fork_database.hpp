@@ -37,22 +37,39 @@ namespace graphene { namespace chain {
    using boost::multi_index_container;
    using namespace boost::multi_index;
 
+   /// An immutable block which is shared by reference between whoever pushed it and the fork database
+   typedef shared_ptr<const signed_block> block_ptr;
+
    struct fork_item
    {
-      fork_item( signed_block d )
-      :num(d.block_num()),id(d.id()),data( std::move(d) ){}
+      /// @throws fc::exception if @p b is null
+      explicit fork_item( block_ptr b )
+      :num(non_null(b)->block_num()),id(b->id()),block( std::move(b) ),data( *block ){}
+
+      // data refers into block, so a copy would have to rebind it
+      fork_item( const fork_item& ) = delete;
+      fork_item& operator=( const fork_item& ) = delete;
 
       block_id_type previous_id()const { return data.previous; }
 
       weak_ptr< fork_item > prev;
       uint32_t              num;    // initialized in ctor
       block_id_type         id;
-      signed_block          data;
+      /// Co-owned by the item and never reset, which keeps @ref data valid for the lifetime of the item
+      const block_ptr       block;
+      const signed_block&   data;   ///< the same as *block
 
       // contains witness block signing keys scheduled *after* the block has been applied
       shared_ptr< vector< pair< witness_id_type, public_key_type > > > scheduled_witnesses;
       uint64_t                                                         next_block_aslot = 0;
       fc::time_point_sec                                               next_block_time;
+
+   private:
+      static const block_ptr& non_null( const block_ptr& b )
+      {
+         FC_ASSERT( b, "A fork item needs a block" );
+         return b;
+      }
    };
    typedef shared_ptr<fork_item> item_ptr;
 
@@ -88,6 +105,7 @@ namespace graphene { namespace chain {
           *  @return the new head block ( the longest fork )
           */
          shared_ptr<fork_item>            push_block(const signed_block& b);
+         shared_ptr<fork_item>            push_block(const block_ptr& b);
          shared_ptr<fork_item>            head()const { return _head; }
          void                             pop_block();
 
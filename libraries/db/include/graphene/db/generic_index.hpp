@@ -55,6 +55,20 @@ namespace graphene { namespace db {
             return *insert_result.first;
          }
 
+         /**
+          *  Inserts an object read from disk.  Objects are saved in the order of the first index, usually by ID,
+          *  so the end of it is a good hint for the insert position.
+          *  A failed hinted insert returns the conflicting element, so the size tells whether it was inserted.
+          */
+         const object& insert_loaded( ObjectType&& obj )
+         {
+            const auto old_size = _indices.size();
+            auto itr = _indices.emplace_hint( _indices.end(), std::move( obj ) );
+            FC_ASSERT( _indices.size() != old_size,
+                       "Could not insert object, most likely a uniqueness constraint was violated" );
+            return *itr;
+         }
+
          const object&  create(const std::function<void(object&)>& constructor )override
          {
             ObjectType item;
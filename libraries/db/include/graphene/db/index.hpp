@@ -28,9 +28,12 @@
 #include <fc/io/raw.hpp>
 #include <fc/io/json.hpp>
 #include <fc/crypto/sha256.hpp>
+#include <fc/optional.hpp>
 
 #include <fstream>
 #include <stack>
+#include <unordered_map>
+#include <unordered_set>
 
 namespace graphene { namespace db {
    class object_database;
@@ -51,6 +54,18 @@ namespace graphene { namespace db {
          virtual void on_modify( const object& obj ){}
    };
 
+   /**
+    * @brief Values an index had in an older state, for the objects and the next ID changed since
+    *
+    * Used to save an older state of an index than the current one, see @ref index::save.
+    */
+   struct index_state_overrides
+   {
+      /// Objects changed since, with their older value or nullptr if they did not exist then
+      std::unordered_map<object_id_type, const object*> objects;
+      fc::optional<object_id_type>                      next_id;
+   };
+
    /**
     *  @class index
     *  @brief abstract base class for accessing objects indexed in various ways.
@@ -96,7 +111,27 @@ namespace graphene { namespace db {
           *  Opens the index loading objects from a file
           */
          virtual void open( const fc::path& db ) = 0;
-         virtual void save( const fc::path& db ) = 0;
+         /**
+          *  Saves all objects.  With @p older_state, the state it describes is saved instead of the current one,
+          *  and the objects in it are still considered changed afterwards.
+          */
+         virtual void save( const fc::path& db, const index_state_overrides& older_state = {} ) = 0;
+
+         /**
+          *  Saves the objects changed since the index was last opened or saved to a delta file, which is
+          *  to be applied on top of the previously saved state by @ref open_delta.  @p older_state is used
+          *  like in @ref save.
+          *  @return false if nothing changed, in which case no file is written
+          */
+         virtual bool save_delta( const fc::path& delta, const index_state_overrides& older_state = {} ) = 0;
+         /** Applies a delta file written by @ref save_delta on top of the loaded objects */
+         virtual void open_delta( const fc::path& delta ) = 0;
+         /**
+          *  Merges a file written by @ref save and delta files into a new file in the format of @ref save.
+          *  Objects in the index are not accessed, so this may run in parallel with changes to the index.
+          */
+         virtual void compact( const fc::path& base, const std::vector<fc::path>& deltas,
+                               const fc::path& out )const = 0;
 
 
 
@@ -357,27 +392,31 @@ namespace graphene { namespace db {
             fc::raw::unpack(ds, open_ver);
             FC_ASSERT( open_ver == get_object_version(),
                        "Incompatible Version, the serialization of objects in this index has changed" );
-            std::vector<char> tmp;
             while( ds.remaining() > 0 )
-            {
-               fc::raw::unpack( ds, tmp );
-               load( tmp );
-            }
+               load_record( ds );
+            clear_dirty();
          }
 
-         void save( const fc::path& db ) override
+         void save( const fc::path& db, const index_state_overrides& older_state = {} ) override
          {
             std::ofstream out( db.generic_string(),
                                std::ofstream::binary | std::ofstream::out | std::ofstream::trunc );
             FC_ASSERT( out );
             auto ver  = get_object_version();
-            fc::raw::pack( out, _next_id );
+            fc::raw::pack( out, older_state.next_id.valid() ? *older_state.next_id : _next_id );
             fc::raw::pack( out, ver );
-            this->inspect_all_objects( [&out]( const object& o ) {
-                auto vec = fc::raw::pack( static_cast<const object_type&>(o) );
-                auto packed_vec = fc::raw::pack( vec );
-                out.write( packed_vec.data(), packed_vec.size() );
+            std::vector<char> buffer;
+            this->inspect_all_objects( [&out,&buffer,&older_state]( const object& o ) {
+               if( older_state.objects.count( o.id ) == 0 )
+                  save_record( out, o, buffer );
             });
+            for( const auto& item : older_state.objects )
+            {
+               if( item.second != nullptr )
+                  save_record( out, *item.second, buffer );
+            }
+            FC_ASSERT( out.good(), "Failed to write ${f}", ("f",db) );
+            clear_dirty( older_state );
          }
 
          const object&  load( const std::vector<char>& data )override
@@ -385,9 +424,173 @@ namespace graphene { namespace db {
             const auto& result = DerivedIndex::insert( fc::raw::unpack<object_type>( data ) );
             for( const auto& item : _sindex )
                item->object_inserted( result );
+            ++_object_count;
             return result;
          }
 
+         /**
+          *  A delta file starts with the next ID, the object version and a flag indicating whether the delta
+          *  replaces all objects in the index.  It is followed by records of object ID, a flag indicating whether
+          *  the object exists, and the packed object if it does.
+          */
+         bool save_delta( const fc::path& delta, const index_state_overrides& older_state = {} ) override
+         {
+            if( !_all_dirty && _dirty.empty() && older_state.objects.empty() && !older_state.next_id.valid() )
+               return false;
+            std::ofstream out( delta.generic_string(),
+                               std::ofstream::binary | std::ofstream::out | std::ofstream::trunc );
+            FC_ASSERT( out );
+            auto ver  = get_object_version();
+            fc::raw::pack( out, older_state.next_id.valid() ? *older_state.next_id : _next_id );
+            fc::raw::pack( out, ver );
+            fc::raw::pack( out, _all_dirty );
+            std::vector<char> buffer;
+            const auto write_record = [&out,&buffer]( const object_id_type& id, const object* o ) {
+               fc::raw::pack( out, id );
+               fc::raw::pack( out, o != nullptr );
+               if( o != nullptr )
+                  save_record( out, *o, buffer );
+            };
+            if( _all_dirty )
+            {
+               this->inspect_all_objects( [&write_record,&older_state]( const object& o ) {
+                  if( older_state.objects.count( o.id ) == 0 )
+                     write_record( o.id, &o );
+               });
+            }
+            else
+            {
+               for( const auto& id : _dirty )
+               {
+                  if( older_state.objects.count( id ) == 0 )
+                     write_record( id, find( id ) );
+               }
+            }
+            // Objects which did not exist need no record when the delta replaces all objects
+            for( const auto& item : older_state.objects )
+            {
+               if( !_all_dirty || item.second != nullptr )
+                  write_record( item.first, item.second );
+            }
+            FC_ASSERT( out.good(), "Failed to write ${f}", ("f",delta) );
+            clear_dirty( older_state );
+            return true;
+         }
+
+         void open_delta( const fc::path& delta )override
+         {
+            if( !fc::exists( delta ) ) return;
+            fc::file_mapping fm( delta.generic_string().c_str(), fc::read_only );
+            fc::mapped_region mr( fm, fc::read_only, 0, fc::file_size(delta) );
+            fc::datastream<const char*> ds( (const char*)mr.get_address(), mr.get_size() );
+            fc::sha256 open_ver;
+            bool full = false;
+
+            fc::raw::unpack(ds, _next_id);
+            fc::raw::unpack(ds, open_ver);
+            FC_ASSERT( open_ver == get_object_version(),
+                       "Incompatible Version, the serialization of objects in this index has changed" );
+            fc::raw::unpack(ds, full);
+            if( full )
+            {
+               std::vector<const object*> all;
+               this->inspect_all_objects( [&all]( const object& o ) { all.push_back( &o ); } );
+               for( const object* o : all )
+                  unload( *o );
+            }
+            object_id_type id;
+            bool exists = false;
+            while( ds.remaining() > 0 )
+            {
+               fc::raw::unpack( ds, id );
+               fc::raw::unpack( ds, exists );
+               const object* current = find( id );
+               if( current != nullptr )
+                  unload( *current );
+               if( exists )
+                  load_record( ds );
+            }
+            clear_dirty();
+         }
+
+         void compact( const fc::path& base, const std::vector<fc::path>& deltas, const fc::path& out_file )const override
+         {
+            const auto ver = get_object_version();
+            // Taken from the files, the index may be changed by another thread meanwhile
+            object_id_type next_id( object_type::space_id, object_type::type_id, 0 );
+            bool found = false;
+            // The most recent delta which replaces all objects becomes the base
+            fc::path base_file = base;
+            bool base_is_delta = false;
+            size_t first_delta = 0;
+            for( size_t i = 0; i < deltas.size(); ++i )
+            {
+               if( !fc::exists( deltas[i] ) ) continue;
+               std::ifstream in( deltas[i].generic_string(), std::ifstream::binary );
+               fc::sha256 delta_ver;
+               bool full = false;
+               fc::raw::unpack( in, next_id );
+               fc::raw::unpack( in, delta_ver );
+               FC_ASSERT( delta_ver == ver, "Incompatible Version in ${f}", ("f",deltas[i]) );
+               fc::raw::unpack( in, full );
+               found = true;
+               if( full )
+               {
+                  base_file = deltas[i];
+                  base_is_delta = true;
+                  first_delta = i + 1;
+               }
+            }
+
+            // Changes on top of the base are small enough to be kept in memory
+            // The flag indicates whether the object exists
+            std::unordered_map< object_id_type, std::pair< bool, std::vector<char> > > changes;
+            for( size_t i = first_delta; i < deltas.size(); ++i )
+            {
+               if( !fc::exists( deltas[i] ) ) continue;
+               for_each_record( deltas[i], true, [&changes]( const object_id_type& id, std::vector<char>* data ) {
+                  if( data != nullptr )
+                     changes[id] = std::make_pair( true, std::move( *data ) );
+                  else
+                     changes[id] = std::make_pair( false, std::vector<char>() );
+               });
+            }
+
+            if( !fc::exists( base_file ) && !found )
+               return;
+
+            std::ofstream out( out_file.generic_string(),
+                               std::ofstream::binary | std::ofstream::out | std::ofstream::trunc );
+            FC_ASSERT( out );
+            if( !found )
+            {
+               std::ifstream in( base_file.generic_string(), std::ifstream::binary );
+               fc::raw::unpack( in, next_id );
+            }
+            fc::raw::pack( out, next_id );
+            fc::raw::pack( out, ver );
+            const auto write_object = [&out]( const std::vector<char>& data ) {
+               auto packed_vec = fc::raw::pack( data );
+               out.write( packed_vec.data(), packed_vec.size() );
+            };
+            if( fc::exists( base_file ) )
+               for_each_record( base_file, base_is_delta,
+                                [&changes,&write_object]( const object_id_type& id, std::vector<char>* data ) {
+                  auto itr = changes.find( id );
+                  if( itr == changes.end() )
+                     write_object( *data );
+                  else
+                  {
+                     if( itr->second.first )
+                        write_object( itr->second.second );
+                     changes.erase( itr );
+                  }
+               });
+            for( const auto& change : changes )
+               if( change.second.first )
+                  write_object( change.second.second );
+            FC_ASSERT( out.good(), "Failed to write ${f}", ("f",out_file) );
+         }
 
          const object&  create(const std::function<void(object&)>& constructor )override
          {
@@ -395,6 +598,8 @@ namespace graphene { namespace db {
             for( const auto& item : _sindex )
                item->object_inserted( result );
             on_add( result );
+            ++_object_count;
+            mark_dirty( result.id );
             return result;
          }
 
@@ -404,6 +609,8 @@ namespace graphene { namespace db {
             for( const auto& item : _sindex )
                item->object_inserted( result );
             on_add( result );
+            ++_object_count;
+            mark_dirty( result.id );
             return result;
          }
 
@@ -412,6 +619,8 @@ namespace graphene { namespace db {
             for( const auto& item : _sindex )
                item->object_removed( obj );
             on_remove(obj);
+            mark_dirty( obj.id );
+            --_object_count;
             DerivedIndex::remove(obj);
          }
 
@@ -424,6 +633,7 @@ namespace graphene { namespace db {
             for( const auto& item : _sindex )
                item->object_modified( obj );
             on_modify( obj );
+            mark_dirty( obj.id );
          }
 
          void add_observer( const std::shared_ptr<index_observer>& o ) override
@@ -450,8 +660,124 @@ namespace graphene { namespace db {
          }
 
       private:
+         /**
+          *  Objects are saved as records of their packed size followed by the packed object.
+          *  The buffer is reused to avoid an allocation per object.
+          */
+         static void save_record( std::ostream& out, const object& o, std::vector<char>& buffer )
+         {
+            const auto& obj = static_cast<const object_type&>( o );
+            const size_t size = fc::raw::pack_size( obj );
+            buffer.resize( size );
+            fc::datastream<char*> ds( buffer.data(), size );
+            fc::raw::pack( ds, obj );
+            fc::raw::pack( out, fc::unsigned_int( static_cast<uint32_t>( size ) ) );
+            out.write( buffer.data(), size );
+         }
+
+         /** Unpacks a record written by save_record directly from the stream and inserts the object */
+         const object& load_record( fc::datastream<const char*>& ds )
+         {
+            fc::unsigned_int size;
+            fc::raw::unpack( ds, size );
+            FC_ASSERT( ds.remaining() >= size.value, "Truncated object record" );
+            fc::datastream<const char*> record( ds.pos(), size.value );
+            object_type obj;
+            fc::raw::unpack( record, obj );
+            ds.skip( size.value );
+            const auto& result = DerivedIndex::insert_loaded( std::move( obj ) );
+            for( const auto& item : _sindex )
+               item->object_inserted( result );
+            ++_object_count;
+            return result;
+         }
+
+         /** Removes an object while loading, without undo tracking and notifications */
+         void unload( const object& obj )
+         {
+            for( const auto& item : _sindex )
+               item->object_removed( obj );
+            --_object_count;
+            DerivedIndex::remove( obj );
+         }
+
+         void mark_dirty( const object_id_type& id )
+         {
+            if( _all_dirty )
+               return;
+            _dirty.insert( id );
+            // When a large part of the index changed, saving all objects is cheaper than tracking them
+            if( _dirty.size() > _object_count / 2 + 1024 )
+            {
+               _all_dirty = true;
+               _dirty.clear();
+            }
+         }
+
+         void clear_dirty()
+         {
+            _all_dirty = false;
+            _dirty.clear();
+         }
+
+         /** Clears the changes after saving, except for those made since the saved older state */
+         void clear_dirty( const index_state_overrides& older_state )
+         {
+            clear_dirty();
+            for( const auto& item : older_state.objects )
+               mark_dirty( item.first );
+            // Also makes the next save write the current next ID, if no object is changed until then
+            if( older_state.next_id.valid() )
+               mark_dirty( *older_state.next_id );
+         }
+
+         /** Calls f with the ID and the packed data of every object in a file written by save or save_delta,
+          *  data is nullptr for removed objects */
+         template<typename F>
+         static void for_each_record( const fc::path& file, bool is_delta, F&& f )
+         {
+            fc::file_mapping fm( file.generic_string().c_str(), fc::read_only );
+            fc::mapped_region mr( fm, fc::read_only, 0, fc::file_size(file) );
+            fc::datastream<const char*> ds( (const char*)mr.get_address(), mr.get_size() );
+            object_id_type next_id;
+            fc::sha256 ver;
+            fc::raw::unpack( ds, next_id );
+            fc::raw::unpack( ds, ver );
+            if( is_delta )
+            {
+               bool full = false;
+               fc::raw::unpack( ds, full );
+            }
+            object_id_type id;
+            bool exists = true;
+            std::vector<char> tmp;
+            while( ds.remaining() > 0 )
+            {
+               if( is_delta )
+               {
+                  fc::raw::unpack( ds, id );
+                  fc::raw::unpack( ds, exists );
+               }
+               if( exists )
+               {
+                  fc::raw::unpack( ds, tmp );
+                  if( !is_delta )
+                     id = fc::raw::unpack<object_type>( tmp ).id;
+                  f( id, &tmp );
+               }
+               else
+                  f( id, nullptr );
+            }
+         }
+
          object_id_type                                 _next_id;
          const direct_index< object_type, DirectBits >* _direct_by_id = nullptr;
+
+         /// Objects changed since the index was last opened or saved
+         std::unordered_set<object_id_type>             _dirty;
+         /// Set when too many objects changed to track them individually
+         bool                                           _all_dirty = false;
+         size_t                                         _object_count = 0;
    };
 
 } } // graphene::db
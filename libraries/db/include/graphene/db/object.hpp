@@ -27,6 +27,8 @@
 #include <fc/io/raw.hpp>
 #include <fc/crypto/city.hpp>
 
+#include <new>
+
 #define MAX_NESTING (200)
 
 namespace graphene { namespace db {
@@ -71,6 +73,9 @@ namespace graphene { namespace db {
          /// these methods are implemented for derived classes by inheriting base_abstract_object<DerivedClass>
          /// @{
          virtual std::unique_ptr<object> clone()const = 0;
+         /// Copy-construct the object in the given memory, which must hold at least @ref object_size bytes
+         virtual object*                 clone_into( void* buffer )const = 0;
+         virtual size_t                  object_size()const = 0;
          virtual void                    move_from( object& obj ) = 0;
          virtual fc::variant             to_variant()const  = 0;
          virtual std::vector<char>       pack()const = 0;
@@ -93,6 +98,11 @@ namespace graphene { namespace db {
          {
             return std::make_unique<DerivedClass>( *static_cast<const DerivedClass*>(this) );
          }
+         object* clone_into( void* buffer )const override
+         {
+            return new( buffer ) DerivedClass( *static_cast<const DerivedClass*>(this) );
+         }
+         size_t object_size()const override { return sizeof(DerivedClass); }
 
          void    move_from( object& obj ) override
          {
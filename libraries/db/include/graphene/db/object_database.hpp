@@ -40,7 +40,7 @@ namespace graphene { namespace db {
    {
       public:
          object_database();
-         virtual ~object_database() = default;
+         virtual ~object_database();
 
          static constexpr uint8_t _index_size = 255;
 
@@ -55,7 +55,18 @@ namespace graphene { namespace db {
          /**
           * Saves the complete state of the object_database to disk, this could take a while
           */
-         void flush();
+         void flush() { flush( {} ); }
+         /**
+          * Saves only the objects changed since the object_database was last opened or saved to a new delta
+          * segment on disk.  Falls back to a full @ref flush if there is no complete state on disk to build upon.
+          * When there are too many delta segments, they are merged into a new snapshot in the background.
+          *
+          * If @p exclude_undo_history is true, the state before the oldest undo state is saved, so that nothing
+          * is written which may still be undone.
+          */
+         void flush_incremental( bool exclude_undo_history = false );
+         /// Sets the number of delta segments after which they are merged in the background
+         void set_max_delta_segments( uint32_t max_segments ) { _max_delta_segments = max_segments; }
          void wipe(const fc::path& data_dir); // remove from disk
          void close();
 
@@ -88,6 +99,18 @@ namespace graphene { namespace db {
          const object& get_object( const object_id_type& id )const;
          const object* find_object( const object_id_type& id )const;
 
+         /**
+          * While set, the IDs of all objects looked up by ID, including those not found, are appended to
+          * @p reads.  Lookups through the indexes directly are not tracked.  Pass nullptr to stop tracking.
+          */
+         void track_reads( std::vector<object_id_type>* reads ) { _tracked_reads = reads; }
+         /// Tracks a read of @p id like a lookup by ID, for lookups through the indexes
+         void track_read( const object_id_type& id )const
+         {
+            if( _tracked_reads != nullptr )
+               _tracked_reads->push_back( id );
+         }
+
          /// These methods are mutators of the object_database.
          /// You must use these methods to make changes to the object_database,
          /// in order to maintain proper undo history.
@@ -188,8 +211,27 @@ namespace graphene { namespace db {
          void save_undo_add( const object& obj );
          void save_undo_remove( const object& obj );
 
+         /// Saves the complete state, with the values in @p older_state instead of the current ones where given
+         void flush( const std::unordered_map<object_id_type, index_state_overrides>& older_state );
+         /// Merges the current snapshot with all delta segments in the background
+         void start_compaction();
+         /// Waits for a running compaction, if any, and takes over its result
+         void finish_compaction();
+
          fc::path                                                  _data_dir;
          std::vector< std::vector< std::unique_ptr<index> > >      _index;
+
+         /// Whether the state on disk equals the state in memory apart from changes tracked by the indexes
+         bool                                                      _persisted_state_valid = false;
+         /// The delta segment the current snapshot includes, 0 for a full flush
+         uint32_t                                                  _snapshot_segment = 0;
+         /// The number of the last delta segment written
+         uint32_t                                                  _last_delta_segment = 0;
+         uint32_t                                                  _max_delta_segments = 16;
+         fc::future<void>                                          _compaction;
+         uint32_t                                                  _compaction_segment = 0;
+         /// See @ref track_reads
+         std::vector<object_id_type>*                              _tracked_reads = nullptr;
    };
 
 } } // graphene::db
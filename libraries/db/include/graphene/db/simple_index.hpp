@@ -69,6 +69,12 @@ namespace graphene { namespace db {
             return *_objects[instance];
          }
 
+         /** Inserts an object read from disk */
+         const object& insert_loaded( T&& obj )
+         {
+            return insert( std::move( obj ) );
+         }
+
          virtual void remove( const object& obj ) override
          {
             assert( nullptr != dynamic_cast<const T*>(&obj) );
@@ -0,0 +1,247 @@
+/*
+ * Copyright (c) 2026 Contributors.
+ *
+ * The MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#pragma once
+
+#include <graphene/db/object.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace graphene { namespace db {
+
+   /**
+    * @brief A bump allocator for the objects saved by one undo state.
+    *
+    * Memory is only released when the arena is destroyed, all at once. Objects allocated here must be
+    * destroyed, but not deleted, with @ref undo_arena::destroyer, which is what @ref undo_object_ptr does.
+    */
+   class undo_arena
+   {
+      public:
+         undo_arena() = default;
+         undo_arena( const undo_arena& ) = delete;
+         undo_arena( undo_arena&& ) = default;
+         undo_arena& operator=( const undo_arena& ) = delete;
+         undo_arena& operator=( undo_arena&& ) = default;
+
+         /// Destroys an object allocated in an arena without releasing its memory
+         struct destroyer
+         {
+            void operator()( object* obj )const { obj->~object(); }
+         };
+
+         /// Copy an object into the arena
+         std::unique_ptr<object, destroyer> clone( const object& obj )
+         {
+            return std::unique_ptr<object, destroyer>( obj.clone_into( allocate( obj.object_size() ) ) );
+         }
+
+         /// Take over all memory of another arena, used when merging undo states
+         void merge( undo_arena&& other );
+
+         /// @return bytes allocated from the system
+         size_t reserved()const { return _reserved; }
+         /// @return bytes handed out to objects
+         size_t used()const { return _used; }
+
+      private:
+         void* allocate( size_t size )
+         {
+            size = ( size + alignof(std::max_align_t) - 1 ) & ~( alignof(std::max_align_t) - 1 );
+            if( _chunks.empty() || _position + size > _chunks.back().size )
+               add_chunk( size );
+            void* result = _chunks.back().data() + _position;
+            _position += size;
+            _used += size;
+            return result;
+         }
+
+         void add_chunk( size_t min_size );
+
+         struct chunk
+         {
+            std::unique_ptr<std::max_align_t[]> storage;
+            size_t                              size;
+            char* data()const { return reinterpret_cast<char*>( storage.get() ); }
+         };
+
+         static constexpr size_t min_chunk_size = 4 * 1024;
+         static constexpr size_t max_chunk_size = 1024 * 1024;
+
+         std::vector<chunk> _chunks;
+         size_t             _position = 0; ///< position in the last chunk
+         size_t             _used = 0;
+         size_t             _reserved = 0;
+   };
+
+   using undo_object_ptr = std::unique_ptr<object, undo_arena::destroyer>;
+
+   /**
+    * @brief A map from object IDs to values, with open addressing and entries kept in insertion order.
+    *
+    * Erased entries stay in place and are skipped when iterating, they are revived if the same ID is inserted
+    * again. Memory is only released when the map is cleared or destroyed, which fits the short life of
+    * undo states.
+    */
+   template<typename Value>
+   class undo_id_map
+   {
+      public:
+         struct entry
+         {
+            object_id_type first;
+            Value          second;
+         };
+
+         template<typename Entry, typename Iterator>
+         class basic_iterator
+         {
+            public:
+               basic_iterator( Iterator itr, Iterator end ) : _itr( itr ), _end( end ) { skip_erased(); }
+
+               Entry& operator*()const  { return _itr->item; }
+               Entry* operator->()const { return &_itr->item; }
+               basic_iterator& operator++() { ++_itr; skip_erased(); return *this; }
+               bool operator==( const basic_iterator& other )const { return _itr == other._itr; }
+               bool operator!=( const basic_iterator& other )const { return _itr != other._itr; }
+
+            private:
+               void skip_erased() { while( _itr != _end && !_itr->alive ) ++_itr; }
+
+               Iterator _itr;
+               Iterator _end;
+         };
+
+      private:
+         struct slot_entry
+         {
+            entry item;
+            bool  alive;
+         };
+
+      public:
+         using iterator = basic_iterator< entry, typename std::vector<slot_entry>::iterator >;
+         using const_iterator = basic_iterator< const entry, typename std::vector<slot_entry>::const_iterator >;
+
+         iterator       begin()       { return iterator( _entries.begin(), _entries.end() ); }
+         iterator       end()         { return iterator( _entries.end(), _entries.end() ); }
+         const_iterator begin()const  { return const_iterator( _entries.begin(), _entries.end() ); }
+         const_iterator end()const    { return const_iterator( _entries.end(), _entries.end() ); }
+
+         size_t size()const  { return _size; }
+         bool   empty()const { return _size == 0; }
+
+         Value* find( object_id_type id )
+         {
+            if( _slots.empty() )
+               return nullptr;
+            uint32_t index = _slots[ find_slot( id ) ];
+            if( index == 0 || !_entries[index - 1].alive )
+               return nullptr;
+            return &_entries[index - 1].item.second;
+         }
+
+         const Value* find( object_id_type id )const
+         {
+            return const_cast<undo_id_map*>( this )->find( id );
+         }
+
+         size_t count( object_id_type id )const { return find( id ) != nullptr ? 1 : 0; }
+
+         /// @return the value of the ID, inserted with a default value if not found
+         Value& operator[]( object_id_type id )
+         {
+            if( ( _entries.size() + 1 ) * 2 > _slots.size() )
+               rehash();
+            uint32_t& index = _slots[ find_slot( id ) ];
+            if( index == 0 )
+            {
+               _entries.push_back( slot_entry{ entry{ id, Value() }, true } );
+               index = static_cast<uint32_t>( _entries.size() );
+               ++_size;
+            }
+            else if( !_entries[index - 1].alive )
+            {
+               _entries[index - 1].item.second = Value();
+               _entries[index - 1].alive = true;
+               ++_size;
+            }
+            return _entries[index - 1].item.second;
+         }
+
+         bool erase( object_id_type id )
+         {
+            if( _slots.empty() )
+               return false;
+            uint32_t index = _slots[ find_slot( id ) ];
+            if( index == 0 || !_entries[index - 1].alive )
+               return false;
+            _entries[index - 1].alive = false;
+            _entries[index - 1].item.second = Value();
+            --_size;
+            return true;
+         }
+
+         /// @return bytes used by the map itself, not counting memory owned by the values
+         size_t memory_usage()const
+         {
+            return _entries.capacity() * sizeof(slot_entry) + _slots.capacity() * sizeof(uint32_t);
+         }
+
+      private:
+         size_t find_slot( object_id_type id )const
+         {
+            const size_t mask = _slots.size() - 1;
+            // Fibonacci hashing, IDs of different types often have the same instance number in their low bits
+            size_t slot = static_cast<size_t>( ( id.number * UINT64_C(0x9E3779B97F4A7C15) ) >> _shift );
+            while( _slots[slot] != 0 && _entries[ _slots[slot] - 1 ].item.first != id )
+               slot = ( slot + 1 ) & mask;
+            return slot;
+         }
+
+         void rehash()
+         {
+            if( _slots.empty() )
+            {
+               _slots.assign( 16, 0 );
+               _shift = 64 - 4;
+            }
+            else
+            {
+               _slots.assign( _slots.size() * 2, 0 );
+               --_shift;
+            }
+            for( size_t i = 0; i < _entries.size(); ++i )
+               _slots[ find_slot( _entries[i].item.first ) ] = static_cast<uint32_t>( i + 1 );
+         }
+
+         std::vector<slot_entry> _entries;
+         std::vector<uint32_t>   _slots;  ///< indexes of entries plus one, 0 for empty slots
+         uint8_t                 _shift = 64;
+         size_t                  _size = 0;
+   };
+
+} } // graphene::db
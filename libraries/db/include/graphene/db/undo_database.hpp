@@ -23,6 +23,8 @@
  */
 #pragma once
 #include <graphene/db/object.hpp>
+#include <graphene/db/index.hpp>
+#include <graphene/db/undo_arena.hpp>
 #include <deque>
 #include <fc/exception/exception.hpp>
 
@@ -30,12 +32,33 @@ namespace graphene { namespace db {
 
    class object_database;
 
+   /**
+    * Memory used by an undo state
+    */
+   struct undo_memory_stats
+   {
+      size_t   arena_reserved = 0; ///< bytes allocated for saved objects
+      size_t   arena_used = 0;     ///< bytes used by saved objects
+      size_t   index_bytes = 0;    ///< bytes used by the ID maps
+      size_t   old_values = 0;     ///< number of modified objects
+      size_t   new_ids = 0;        ///< number of created objects
+      size_t   removed = 0;        ///< number of removed objects
+   };
+
+   /**
+    * Changes done in one undo session. Saved objects live in the arena of the state and are released
+    * all at once with the state.
+    */
    struct undo_state
    {
-      std::unordered_map<object_id_type, std::unique_ptr<object> > old_values;
-      std::unordered_map<object_id_type, object_id_type>           old_index_next_ids;
-      std::unordered_set<object_id_type>                           new_ids;
-      std::unordered_map<object_id_type, std::unique_ptr<object> > removed;
+      // Note: the arena must be declared before the maps, so that objects are destroyed before their memory
+      undo_arena                                   arena;
+      undo_id_map<undo_object_ptr>                 old_values;
+      undo_id_map<object_id_type>                  old_index_next_ids;
+      undo_id_map<bool>                            new_ids; ///< only the keys are used
+      undo_id_map<undo_object_ptr>                 removed;
+
+      undo_memory_stats get_memory_stats()const;
    };
 
 
@@ -124,6 +147,15 @@ namespace graphene { namespace db {
 
          const undo_state& head()const;
 
+         /**
+          * @return the objects and next IDs changed by the undo states as they were before the oldest one,
+          * keyed by the ID of their index like undo_state::old_index_next_ids
+          */
+         std::unordered_map<object_id_type, index_state_overrides> get_base_state()const;
+
+         /// @return memory used by each undo state, from the oldest to the newest
+         std::vector<undo_memory_stats> get_memory_stats()const;
+
       private:
          void undo();
          void merge();
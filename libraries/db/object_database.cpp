@@ -27,8 +27,44 @@
 #include <fc/container/flat.hpp>
 #include <fc/thread/parallel.hpp>
 
+#include <algorithm>
+
 namespace graphene { namespace db {
 
+namespace {
+   const std::string delta_prefix = "delta-";
+   const std::string snapshot_prefix = "compacted-";
+
+   /// @return the directory of the snapshot which includes the given delta segment
+   fc::path snapshot_dir( const fc::path& target_dir, uint32_t segment )
+   {
+      return segment == 0 ? target_dir : target_dir / ( snapshot_prefix + fc::to_string(segment) );
+   }
+
+   fc::path delta_dir( const fc::path& target_dir, uint32_t segment )
+   {
+      return target_dir / ( delta_prefix + fc::to_string(segment) );
+   }
+
+   /// @return the numbers of all directories in dir named prefix followed by a number
+   std::vector<uint32_t> find_segments( const fc::path& dir, const std::string& prefix )
+   {
+      std::vector<uint32_t> result;
+      if( !fc::exists( dir ) )
+         return result;
+      for( fc::directory_iterator itr( dir ); itr != fc::directory_iterator(); ++itr )
+      {
+         const std::string name = (*itr).filename().string();
+         if( name.size() <= prefix.size() || name.compare( 0, prefix.size(), prefix ) != 0
+               || name.find_first_not_of( "0123456789", prefix.size() ) != std::string::npos )
+            continue;
+         result.push_back( static_cast<uint32_t>( std::stoul( name.substr( prefix.size() ) ) ) );
+      }
+      std::sort( result.begin(), result.end() );
+      return result;
+   }
+}
+
 object_database::object_database()
 :_undo_db(*this)
 {
@@ -36,16 +72,27 @@ object_database::object_database()
    _undo_db.enable();
 }
 
+object_database::~object_database()
+{
+   // A running compaction accesses the indexes
+   finish_compaction();
+}
+
 void object_database::close()
 {
+   finish_compaction();
 }
 
 const object* object_database::find_object( const object_id_type& id )const
 {
+   if( _tracked_reads != nullptr )
+      _tracked_reads->push_back( id );
    return get_index(id.space(),id.type()).find( id );
 }
 const object& object_database::get_object( const object_id_type& id )const
 {
+   if( _tracked_reads != nullptr )
+      _tracked_reads->push_back( id );
    return get_index(id.space(),id.type()).get( id );
 }
 
@@ -78,8 +125,9 @@ index& object_database::get_mutable_index(uint8_t space_id, uint8_t type_id)
    return *idx;
 }
 
-void object_database::flush()
+void object_database::flush( const std::unordered_map<object_id_type, index_state_overrides>& older_state )
 {
+   finish_compaction();
    const auto tmp_dir = _data_dir / "object_database.tmp";
    const auto old_dir = _data_dir / "object_database.old";
    const auto target_dir = _data_dir / "object_database";
@@ -91,11 +139,15 @@ void object_database::flush()
    constexpr size_t max_tasks = 200;
    tasks.reserve(max_tasks);
 
-   auto push_task = [this,&tasks,&tmp_dir]( size_t space, size_t type ) {
-      if( _index[space][type] )
-         tasks.push_back( fc::do_parallel( [this,space,type,&tmp_dir] () {
-            _index[space][type]->save( tmp_dir / fc::to_string(space) / fc::to_string(type) );
-         } ) );
+   const index_state_overrides unchanged;
+   auto push_task = [this,&tasks,&tmp_dir,&older_state,&unchanged]( size_t space, size_t type ) {
+      if( !_index[space][type] )
+         return;
+      const auto itr = older_state.find( object_id_type( uint8_t(space), uint8_t(type), 0 ) );
+      const auto& overrides = ( itr != older_state.end() ? itr->second : unchanged );
+      tasks.push_back( fc::do_parallel( [this,space,type,&tmp_dir,&overrides] () {
+         _index[space][type]->save( tmp_dir / fc::to_string(space) / fc::to_string(type), overrides );
+      } ) );
    };
 
    const auto spaces = _index.size();
@@ -117,6 +169,120 @@ void object_database::flush()
    }
    fc::rename( tmp_dir, target_dir );
    fc::remove_all( old_dir );
+
+   _persisted_state_valid = true;
+   _snapshot_segment = 0;
+   _last_delta_segment = 0;
+}
+
+void object_database::flush_incremental( bool exclude_undo_history )
+{
+   const auto target_dir = _data_dir / "object_database";
+   if( _compaction.valid() && _compaction.ready() )
+      finish_compaction();
+   std::unordered_map<object_id_type, index_state_overrides> older_state;
+   if( exclude_undo_history )
+      older_state = _undo_db.get_base_state();
+   if( !_persisted_state_valid || !fc::exists( target_dir ) )
+   {
+      flush( older_state );
+      return;
+   }
+
+   const auto tmp_dir = target_dir / "delta.tmp";
+   if( fc::exists( tmp_dir ) )
+      fc::remove_all( tmp_dir );
+   std::vector<fc::future<void>> tasks;
+   tasks.reserve(200);
+
+   const index_state_overrides unchanged;
+   const auto spaces = _index.size();
+   for( size_t space = 0; space < spaces; ++space )
+   {
+      fc::create_directories( tmp_dir / fc::to_string(space) );
+      const auto types = _index[space].size();
+      for( size_t type = 0; type  <  types; ++type )
+      {
+         if( !_index[space][type] )
+            continue;
+         const auto itr = older_state.find( object_id_type( uint8_t(space), uint8_t(type), 0 ) );
+         const auto& overrides = ( itr != older_state.end() ? itr->second : unchanged );
+         tasks.push_back( fc::do_parallel( [this,space,type,&tmp_dir,&overrides] () {
+            _index[space][type]->save_delta( tmp_dir / fc::to_string(space) / fc::to_string(type), overrides );
+         } ) );
+      }
+   }
+   for( auto& task : tasks )
+      task.wait();
+   // The delta segment only becomes visible once complete
+   fc::rename( tmp_dir, delta_dir( target_dir, ++_last_delta_segment ) );
+
+   if( _last_delta_segment - _snapshot_segment >= _max_delta_segments && !_compaction.valid() )
+      start_compaction();
+}
+
+void object_database::start_compaction()
+{
+   const auto target_dir = _data_dir / "object_database";
+   const uint32_t from_segment = _snapshot_segment;
+   const uint32_t to_segment = _last_delta_segment;
+   ilog( "Merging object database delta segments ${f} to ${t} in the background",
+         ("f", from_segment + 1)("t", to_segment) );
+   _compaction_segment = to_segment;
+   // Only files on disk are accessed, the indexes themselves may be changed in the meantime
+   _compaction = fc::do_parallel( [this,target_dir,from_segment,to_segment] () {
+      const auto base_dir = snapshot_dir( target_dir, from_segment );
+      const auto tmp_dir = target_dir / "compacted.tmp";
+      if( fc::exists( tmp_dir ) )
+         fc::remove_all( tmp_dir );
+      const auto spaces = _index.size();
+      for( size_t space = 0; space < spaces; ++space )
+      {
+         const auto space_name = fc::to_string(space);
+         fc::create_directories( tmp_dir / space_name );
+         const auto types = _index[space].size();
+         for( size_t type = 0; type  <  types; ++type )
+         {
+            if( !_index[space][type] )
+               continue;
+            const auto type_name = fc::to_string(type);
+            std::vector<fc::path> deltas;
+            for( uint32_t segment = from_segment + 1; segment <= to_segment; ++segment )
+               deltas.push_back( delta_dir( target_dir, segment ) / space_name / type_name );
+            _index[space][type]->compact( base_dir / space_name / type_name, deltas,
+                                          tmp_dir / space_name / type_name );
+         }
+      }
+      fc::rename( tmp_dir, snapshot_dir( target_dir, to_segment ) );
+
+      // Clean up what is included in the new snapshot
+      for( uint32_t segment = from_segment + 1; segment <= to_segment; ++segment )
+         fc::remove_all( delta_dir( target_dir, segment ) );
+      if( from_segment > 0 )
+         fc::remove_all( base_dir );
+      else
+      {
+         for( size_t space = 0; space < spaces; ++space )
+            fc::remove_all( base_dir / fc::to_string(space) );
+      }
+   } );
+}
+
+void object_database::finish_compaction()
+{
+   if( !_compaction.valid() )
+      return;
+   auto compaction = _compaction;
+   _compaction = fc::future<void>();
+   try {
+      compaction.wait();
+      ilog( "Done merging object database delta segments up to ${t}", ("t", _compaction_segment) );
+   } catch( const fc::exception& e ) {
+      wlog( "Merging object database delta segments failed: ${e}", ("e", e.to_detail_string()) );
+   }
+   // The snapshot is complete once it has been renamed into place, even if cleaning up failed afterwards
+   if( fc::exists( snapshot_dir( _data_dir / "object_database", _compaction_segment ) ) )
+      _snapshot_segment = _compaction_segment;
 }
 
 void object_database::wipe(const fc::path& data_dir)
@@ -124,28 +290,48 @@ void object_database::wipe(const fc::path& data_dir)
    close();
    ilog("Wiping object database...");
    fc::remove_all(data_dir / "object_database");
+   _persisted_state_valid = false;
    ilog("Done wiping object database.");
 }
 
 void object_database::open(const fc::path& data_dir)
 { try {
    _data_dir = data_dir;
-   if( fc::exists( _data_dir / "object_database" / "lock" ) )
+   const auto target_dir = _data_dir / "object_database";
+   if( fc::exists( target_dir / "lock" ) )
    {
        wlog("Ignoring locked object_database");
        return;
    }
+
+   // Start from the most recent complete snapshot and apply the delta segments written after it
+   const auto snapshots = find_segments( target_dir, snapshot_prefix );
+   _snapshot_segment = snapshots.empty() ? 0 : snapshots.back();
+   _last_delta_segment = _snapshot_segment;
+   std::vector<fc::path> deltas;
+   for( const uint32_t segment : find_segments( target_dir, delta_prefix ) )
+   {
+      if( segment <= _snapshot_segment )
+         continue;
+      deltas.push_back( delta_dir( target_dir, segment ) );
+      _last_delta_segment = segment;
+   }
+   const auto base_dir = snapshot_dir( target_dir, _snapshot_segment );
+
    std::vector<fc::future<void>> tasks;
    tasks.reserve(200);
 
-   auto push_task = [this,&tasks]( size_t space, size_t type ) {
+   auto push_task = [this,&tasks,&base_dir,&deltas]( size_t space, size_t type ) {
       if( _index[space][type] )
-         tasks.push_back( fc::do_parallel( [this,space,type] () {
-            _index[space][type]->open( _data_dir / "object_database" / fc::to_string(space) / fc::to_string(type) );
+         tasks.push_back( fc::do_parallel( [this,space,type,&base_dir,&deltas] () {
+            const auto file = fc::path( fc::to_string(space) ) / fc::to_string(type);
+            _index[space][type]->open( base_dir / file );
+            for( const auto& delta : deltas )
+               _index[space][type]->open_delta( delta / file );
          } ) );
    };
 
-   ilog("Opening object database from ${d} ...", ("d", data_dir));
+   ilog("Opening object database from ${d} with ${n} delta segments ...", ("d", data_dir)("n", deltas.size()));
    const auto spaces = _index.size();
    for( size_t space = 0; space < spaces; ++space )
    {
@@ -155,6 +341,7 @@ void object_database::open(const fc::path& data_dir)
    }
    for( auto& task : tasks )
       task.wait();
+   _persisted_state_valid = fc::exists( target_dir );
    ilog( "Done opening object database." );
 
 } FC_CAPTURE_AND_RETHROW( (data_dir) ) }
@@ -25,8 +25,56 @@
 #include <graphene/db/undo_database.hpp>
 #include <fc/reflect/variant.hpp>
 
+#include <algorithm>
+#include <iterator>
+
 namespace graphene { namespace db {
 
+constexpr size_t undo_arena::min_chunk_size;
+constexpr size_t undo_arena::max_chunk_size;
+
+void undo_arena::add_chunk( size_t min_size )
+{
+   // Grow chunks with the arena, so that small states stay small and big states need few allocations
+   size_t size = std::min( max_chunk_size, std::max( min_chunk_size, _reserved ) );
+   size = std::max( size, min_size );
+   const size_t units = ( size + sizeof(std::max_align_t) - 1 ) / sizeof(std::max_align_t);
+   _chunks.push_back( chunk{ std::unique_ptr<std::max_align_t[]>( new std::max_align_t[units] ),
+                             units * sizeof(std::max_align_t) } );
+   _reserved += _chunks.back().size;
+   _position = 0;
+}
+
+void undo_arena::merge( undo_arena&& other )
+{
+   if( other._chunks.empty() )
+      return;
+   // Keep the last chunk of this arena at the end, since it is where the next allocation goes
+   _chunks.insert( _chunks.empty() ? _chunks.end() : _chunks.end() - 1,
+                   std::make_move_iterator( other._chunks.begin() ), std::make_move_iterator( other._chunks.end() ) );
+   if( _chunks.size() == other._chunks.size() )
+      _position = other._position;
+   _used += other._used;
+   _reserved += other._reserved;
+   other._chunks.clear();
+   other._position = 0;
+   other._used = 0;
+   other._reserved = 0;
+}
+
+undo_memory_stats undo_state::get_memory_stats()const
+{
+   undo_memory_stats result;
+   result.arena_reserved = arena.reserved();
+   result.arena_used = arena.used();
+   result.index_bytes = old_values.memory_usage() + old_index_next_ids.memory_usage()
+                      + new_ids.memory_usage() + removed.memory_usage();
+   result.old_values = old_values.size();
+   result.new_ids = new_ids.size();
+   result.removed = removed.size();
+   return result;
+}
+
 void undo_database::enable()  { _disabled = false; }
 void undo_database::disable() { _disabled = true; }
 
@@ -65,10 +113,9 @@ void undo_database::on_create( const object& obj )
       _stack.emplace_back();
    auto& state = _stack.back();
    auto index_id = object_id_type( obj.id.space(), obj.id.type(), 0 );
-   auto itr = state.old_index_next_ids.find( index_id );
-   if( itr == state.old_index_next_ids.end() )
+   if( state.old_index_next_ids.find( index_id ) == nullptr )
       state.old_index_next_ids[index_id] = obj.id;
-   state.new_ids.insert(obj.id);
+   state.new_ids[obj.id] = true;
 }
 void undo_database::on_modify( const object& obj )
 {
@@ -77,11 +124,11 @@ void undo_database::on_modify( const object& obj )
    if( _stack.empty() )
       _stack.emplace_back();
    auto& state = _stack.back();
-   if( state.new_ids.find(obj.id) != state.new_ids.end() )
+   if( state.new_ids.find(obj.id) != nullptr )
+      return;
+   if( state.old_values.find(obj.id) != nullptr )
       return;
-   auto itr =  state.old_values.find(obj.id);
-   if( itr != state.old_values.end() ) return;
-   state.old_values[obj.id] = obj.clone();
+   state.old_values[obj.id] = state.arena.clone( obj );
 }
 void undo_database::on_remove( const object& obj )
 {
@@ -90,19 +137,17 @@ void undo_database::on_remove( const object& obj )
    if( _stack.empty() )
       _stack.emplace_back();
    undo_state& state = _stack.back();
-   if( state.new_ids.count(obj.id) > 0 )
-   {
-      state.new_ids.erase(obj.id);
+   if( state.new_ids.erase(obj.id) )
       return;
-   }
-   if( state.old_values.count(obj.id) > 0 )
+   undo_object_ptr* old_value = state.old_values.find(obj.id);
+   if( old_value != nullptr )
    {
-      state.removed[obj.id] = std::move(state.old_values[obj.id]);
+      state.removed[obj.id] = std::move(*old_value);
       state.old_values.erase(obj.id);
       return;
    }
    if( state.removed.count(obj.id) > 0 ) return;
-   state.removed[obj.id] = obj.clone();
+   state.removed[obj.id] = state.arena.clone( obj );
 }
 
 void undo_database::undo()
@@ -117,9 +162,9 @@ void undo_database::undo()
       _db.modify( _db.get_object( item.second->id ), [&]( object& obj ){ obj.move_from( *item.second ); } );
    }
 
-   for( auto ritr = state.new_ids.begin(); ritr != state.new_ids.end(); ++ritr  )
+   for( const auto& item : state.new_ids )
    {
-      _db.remove( _db.get_object(*ritr) );
+      _db.remove( _db.get_object(item.first) );
    }
 
    for( auto& item : state.old_index_next_ids )
@@ -193,30 +238,30 @@ void undo_database::merge()
    // *+upd
    for( auto& obj : state.old_values )
    {
-      if( prev_state.new_ids.find(obj.second->id) != prev_state.new_ids.end() )
+      if( prev_state.new_ids.find(obj.second->id) != nullptr )
       {
          // new+upd -> new, type A
          continue;
       }
-      if( prev_state.old_values.find(obj.second->id) != prev_state.old_values.end() )
+      if( prev_state.old_values.find(obj.second->id) != nullptr )
       {
          // upd(was=X) + upd(was=Y) -> upd(was=X), type A
          continue;
       }
       // del+upd -> N/A
-      assert( prev_state.removed.find(obj.second->id) == prev_state.removed.end() );
+      assert( prev_state.removed.find(obj.second->id) == nullptr );
       // nop+upd(was=Y) -> upd(was=Y), type B
       prev_state.old_values[obj.second->id] = std::move(obj.second);
    }
 
    // *+new, but we assume the N/A cases don't happen, leaving type B nop+new -> new
-   for( auto id : state.new_ids )
-      prev_state.new_ids.insert(id);
+   for( const auto& item : state.new_ids )
+      prev_state.new_ids[item.first] = true;
 
    // old_index_next_ids can only be updated, iterate over *+upd cases
    for( auto& item : state.old_index_next_ids )
    {
-      if( prev_state.old_index_next_ids.find( item.first ) == prev_state.old_index_next_ids.end() )
+      if( prev_state.old_index_next_ids.find( item.first ) == nullptr )
       {
          // nop+upd(was=Y) -> upd(was=Y), type B
          prev_state.old_index_next_ids[item.first] = item.second;
@@ -233,25 +278,28 @@ void undo_database::merge()
    // *+del
    for( auto& obj : state.removed )
    {
-      if( prev_state.new_ids.find(obj.second->id) != prev_state.new_ids.end() )
+      if( prev_state.new_ids.erase(obj.second->id) )
       {
          // new + del -> nop (type C)
-         prev_state.new_ids.erase(obj.second->id);
          continue;
       }
-      auto it = prev_state.old_values.find(obj.second->id);
-      if( it != prev_state.old_values.end() )
+      undo_object_ptr* it = prev_state.old_values.find(obj.second->id);
+      if( it != nullptr )
       {
          // upd(was=X) + del(was=Y) -> del(was=X)
-         prev_state.removed[obj.second->id] = std::move(it->second);
+         prev_state.removed[obj.second->id] = std::move(*it);
          prev_state.old_values.erase(obj.second->id);
          continue;
       }
       // del + del -> N/A
-      assert( prev_state.removed.find( obj.second->id ) == prev_state.removed.end() );
+      assert( prev_state.removed.find( obj.second->id ) == nullptr );
       // nop + del(was=Y) -> del(was=Y)
       prev_state.removed[obj.second->id] = std::move(obj.second);
    }
+
+   // Objects moved to prev_state live in the arena of state
+   prev_state.arena.merge( std::move(state.arena) );
+
    _stack.pop_back();
    --_active_sessions;
 }
@@ -275,9 +323,9 @@ void undo_database::pop_commit()
          _db.modify( _db.get_object( item.second->id ), [&]( object& obj ){ obj.move_from( *item.second ); } );
       }
 
-      for( auto ritr = state.new_ids.begin(); ritr != state.new_ids.end(); ++ritr  )
+      for( const auto& item : state.new_ids )
       {
-         _db.remove( _db.get_object(*ritr) );
+         _db.remove( _db.get_object(item.first) );
       }
 
       for( auto& item : state.old_index_next_ids )
@@ -304,4 +352,38 @@ const undo_state& undo_database::head()const
    return _stack.back();
 }
 
+std::unordered_map<object_id_type, index_state_overrides> undo_database::get_base_state()const
+{
+   std::unordered_map<object_id_type, index_state_overrides> result;
+   const auto index_of = [&result]( object_id_type id ) -> index_state_overrides& {
+      return result[ object_id_type( id.space(), id.type(), 0 ) ];
+   };
+   // An object is in at most one map of a state, and the oldest state mentioning it has its base value
+   for( const auto& state : _stack )
+   {
+      for( const auto& item : state.old_values )
+         index_of( item.first ).objects.emplace( item.first, item.second.get() );
+      for( const auto& item : state.removed )
+         index_of( item.first ).objects.emplace( item.first, item.second.get() );
+      for( const auto& item : state.new_ids )
+         index_of( item.first ).objects.emplace( item.first, nullptr );
+      for( const auto& item : state.old_index_next_ids )
+      {
+         auto& next_id = index_of( item.first ).next_id;
+         if( !next_id.valid() )
+            next_id = item.second;
+      }
+   }
+   return result;
+}
+
+std::vector<undo_memory_stats> undo_database::get_memory_stats()const
+{
+   std::vector<undo_memory_stats> result;
+   result.reserve( _stack.size() );
+   for( const auto& state : _stack )
+      result.push_back( state.get_memory_stats() );
+   return result;
+}
+
 } } // graphene::db
@@ -86,6 +86,13 @@
 
 #define GRAPHENE_NET_MAX_BLOCKS_PER_PEER_DURING_SYNCING      200
 
+/**
+ * During syncing, how many batches of up to GRAPHENE_NET_MAX_BLOCKS_PER_PEER_DURING_SYNCING
+ * blocks we will have requested from a peer at a time.  Requesting the next batch before the
+ * previous one has arrived keeps the connection busy instead of waiting a round trip per batch.
+ */
+#define GRAPHENE_NET_MAX_SYNC_REQUESTS_PER_PEER              4
+
 /**
  * During normal operation, how many items will be fetched from each
  * peer at a time.  This will only come into play when the network
@@ -43,6 +43,7 @@ namespace graphene { namespace net {
   using graphene::protocol::block_id_type;
   using graphene::protocol::transaction_id_type;
   using graphene::protocol::signed_block;
+  using graphene::protocol::signed_block_header;
 
   typedef fc::ecc::public_key_data node_id_t;
   typedef fc::ripemd160 item_hash_t;
@@ -85,6 +86,9 @@ namespace graphene { namespace net {
     check_firewall_reply_message_type            = 5015,
     get_current_connections_request_message_type = 5016,
     get_current_connections_reply_message_type   = 5017,
+    compact_block_message_type                   = 5018,
+    fetch_block_transactions_message_type        = 5019,
+    block_transactions_message_type              = 5020,
     core_message_type_last                       = 5099
   };
 
@@ -114,6 +118,66 @@ namespace graphene { namespace net {
 
    };
 
+  /**
+   * Sent instead of a block_message in reply to a fetch_items_message when the peer supports it.  It carries
+   * the IDs of the transactions in the block instead of the transactions themselves, so that the receiver can
+   * rebuild the block from the transactions it already has, and ask for the rest with a
+   * fetch_block_transactions_message.
+   */
+  struct compact_block_message
+  {
+    static const core_message_type_enum type;
+
+    signed_block_header                 header;
+    block_id_type                       block_id;
+    /// hash of the block_message this stands for, i.e. the item that was requested
+    item_hash_t                         block_message_hash;
+    std::vector<transaction_id_type>    transaction_ids;
+
+    compact_block_message() {}
+    compact_block_message(const signed_block& blk, const item_hash_t& block_message_hash) :
+      header(blk),
+      block_id(blk.id()),
+      block_message_hash(block_message_hash)
+    {
+      transaction_ids.reserve(blk.transactions.size());
+      for (const auto& trx : blk.transactions)
+        transaction_ids.push_back(trx.id());
+    }
+  };
+
+  struct fetch_block_transactions_message
+  {
+    static const core_message_type_enum type;
+
+    item_hash_t             block_message_hash;
+    /// indexes of the transactions in the block
+    std::vector<uint32_t>   transaction_indexes;
+
+    fetch_block_transactions_message() {}
+    fetch_block_transactions_message(const item_hash_t& block_message_hash,
+                                     const std::vector<uint32_t>& transaction_indexes) :
+      block_message_hash(block_message_hash),
+      transaction_indexes(transaction_indexes)
+    {}
+  };
+
+  struct block_transactions_message
+  {
+    static const core_message_type_enum type;
+
+    item_hash_t                       block_message_hash;
+    /// the transactions in the order of the indexes they were requested with
+    std::vector<signed_transaction>   transactions;
+
+    block_transactions_message() {}
+    block_transactions_message(const item_hash_t& block_message_hash,
+                               std::vector<signed_transaction>&& transactions) :
+      block_message_hash(block_message_hash),
+      transactions(std::move(transactions))
+    {}
+  };
+
   struct item_ids_inventory_message
   {
     static const core_message_type_enum type;
@@ -422,6 +486,9 @@ FC_REFLECT_ENUM( graphene::net::core_message_type_enum,
                  (check_firewall_reply_message_type)
                  (get_current_connections_request_message_type)
                  (get_current_connections_reply_message_type)
+                 (compact_block_message_type)
+                 (fetch_block_transactions_message_type)
+                 (block_transactions_message_type)
                  (core_message_type_last) )
 FC_REFLECT_ENUM(graphene::net::rejection_reason_code, (unspecified)
                                                  (different_chain)
@@ -443,6 +510,9 @@ FC_REFLECT_ENUM(graphene::net::firewall_check_result, (unable_to_check)
 
 FC_REFLECT_TYPENAME( graphene::net::trx_message )
 FC_REFLECT_TYPENAME( graphene::net::block_message )
+FC_REFLECT_TYPENAME( graphene::net::compact_block_message )
+FC_REFLECT_TYPENAME( graphene::net::fetch_block_transactions_message )
+FC_REFLECT_TYPENAME( graphene::net::block_transactions_message )
 FC_REFLECT_TYPENAME( graphene::net::item_id )
 FC_REFLECT_TYPENAME( graphene::net::item_ids_inventory_message )
 FC_REFLECT_TYPENAME( graphene::net::blockchain_item_ids_inventory_message )
@@ -466,6 +536,9 @@ FC_REFLECT_TYPENAME( graphene::net::get_current_connections_reply_message )
 
 GRAPHENE_DECLARE_EXTERNAL_SERIALIZATION( graphene::net::trx_message )
 GRAPHENE_DECLARE_EXTERNAL_SERIALIZATION( graphene::net::block_message )
+GRAPHENE_DECLARE_EXTERNAL_SERIALIZATION( graphene::net::compact_block_message )
+GRAPHENE_DECLARE_EXTERNAL_SERIALIZATION( graphene::net::fetch_block_transactions_message )
+GRAPHENE_DECLARE_EXTERNAL_SERIALIZATION( graphene::net::block_transactions_message )
 GRAPHENE_DECLARE_EXTERNAL_SERIALIZATION( graphene::net::item_id )
 GRAPHENE_DECLARE_EXTERNAL_SERIALIZATION( graphene::net::item_ids_inventory_message )
 GRAPHENE_DECLARE_EXTERNAL_SERIALIZATION( graphene::net::blockchain_item_ids_inventory_message )
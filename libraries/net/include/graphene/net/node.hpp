@@ -29,6 +29,8 @@
 
 #include <graphene/protocol/types.hpp>
 
+#include <fc/thread/future.hpp>
+
 namespace graphene { namespace net {
 
   using fc::variant_object;
@@ -77,6 +79,19 @@ namespace graphene { namespace net {
          virtual bool handle_block( const graphene::net::block_message& blk_msg, bool sync_mode,
                                     std::vector<message_hash_type>& contained_transaction_msg_ids ) = 0;
 
+         /**
+          *  @brief Called when a block fetched through the sync process comes in, which is usually a while
+          *         before it is passed to handle_block() because earlier blocks are still being fetched or applied
+          *
+          *  Allows the delegate to start work on the block which does not depend on the state of the
+          *  blockchain, e.g. checking signatures.  The block is neither modified nor destroyed by the node
+          *  until the returned future is ready.
+          *
+          *  Unlike the other methods, this is called in the thread of the node.  It must not block, but only
+          *  launch the work and return its future.
+          */
+         virtual fc::future<void> prepare_sync_block( const graphene::net::block_message& blk_msg ) = 0;
+
          /**
           *  @brief Called when a new transaction comes in from the network
           *
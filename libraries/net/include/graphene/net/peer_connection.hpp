@@ -37,6 +37,7 @@
 #include <boost/multi_index/tag.hpp>
 #include <boost/multi_index/hashed_index.hpp>
 
+#include <map>
 #include <queue>
 #include <boost/container/deque.hpp>
 #include <fc/thread/future.hpp>
@@ -261,6 +262,19 @@ namespace graphene { namespace net
       /// Items we've requested from this peer during normal operation.
       /// Fetch from another peer if this peer disconnects
       item_to_time_map_type items_requested_from_peer;
+
+      /// Whether the peer can receive a compact_block_message instead of a block_message
+      bool supports_compact_blocks = false;
+      /// A block received from this peer as a compact_block_message, waiting for the transactions we
+      /// did not have
+      struct partial_compact_block
+      {
+        signed_block          block;
+        /// Indexes in block.transactions of the transactions we requested from the peer
+        std::vector<uint32_t> missing_transaction_indexes;
+      };
+      /// Compact blocks waiting for transactions, by the hash of the block_message they stand for
+      std::map<item_hash_t, partial_compact_block> partial_compact_blocks;
       /// @}
 
       // if they're flooding us with transactions, we set this to avoid fetching for a few seconds to let the
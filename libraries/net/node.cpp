@@ -29,6 +29,7 @@
 #include <forward_list>
 #include <iostream>
 #include <algorithm>
+#include <numeric>
 #include <tuple>
 #include <string>
 #include <boost/tuple/tuple.hpp>
@@ -126,6 +127,19 @@ namespace graphene { namespace net { namespace detail {
       FC_THROW_EXCEPTION(  fc::key_not_found_exception, "Requested message not in cache" );
     }
 
+    fc::optional<message> blockchain_tied_message_cache::find_message_by_contents_hash( uint32_t msg_type,
+             const message_hash_type& hash_of_msg_contents_to_lookup ) const
+    {
+      const auto& contents_hash_index = _message_cache.get<message_contents_hash_index>();
+      auto range = contents_hash_index.equal_range( hash_of_msg_contents_to_lookup );
+      for( auto iter = range.first; iter != range.second; ++iter )
+      {
+        if( iter->message_body.msg_type.value() == msg_type )
+          return iter->message_body;
+      }
+      return fc::optional<message>();
+    }
+
     void node_impl_deleter::operator()(node_impl* impl_to_delete)
     {
 #ifdef P2P_IN_DEDICATED_THREAD
@@ -507,10 +521,7 @@ namespace graphene { namespace net { namespace detail {
     bool node_impl::have_already_received_sync_item( const item_hash_t& item_hash )
     {
       VERIFY_CORRECT_THREAD();
-      return std::find_if(_received_sync_items.begin(), _received_sync_items.end(),
-                          [&item_hash]( const graphene::net::block_message& message ) { return message.block_id == item_hash; } ) != _received_sync_items.end() ||
-             std::find_if(_new_received_sync_items.begin(), _new_received_sync_items.end(),
-                          [&item_hash]( const graphene::net::block_message& message ) { return message.block_id == item_hash; } ) != _new_received_sync_items.end();                          ;
+      return _received_sync_items_by_id.find( item_hash ) != _received_sync_items_by_id.end();
     }
 
     void node_impl::request_sync_item_from_peer( const peer_connection_ptr& peer, const item_hash_t& item_to_request )
@@ -538,6 +549,19 @@ namespace graphene { namespace net { namespace detail {
       peer->send_message(fetch_items_message(graphene::net::block_message_type, items_to_request));
     }
 
+    size_t node_impl::number_of_sync_items_to_request_from_peer( const peer_connection* peer ) const
+    {
+      VERIFY_CORRECT_THREAD();
+      // don't mix sync requests with requests for items during normal operation or for item ids
+      if( !peer->items_requested_from_peer.empty() || peer->item_ids_requested_from_peer )
+        return 0;
+      // request the next batch before the previous ones have arrived, so the peer doesn't wait for us
+      const size_t max_sync_items_requested = _max_sync_blocks_per_peer * std::max<size_t>( 1, _max_sync_requests_per_peer );
+      if( peer->sync_items_requested_from_peer.size() + _max_sync_blocks_per_peer > max_sync_items_requested )
+        return 0;
+      return _max_sync_blocks_per_peer;
+    }
+
     void node_impl::fetch_sync_items_loop()
     {
       VERIFY_CORRECT_THREAD();
@@ -553,16 +577,16 @@ namespace graphene { namespace net { namespace detail {
           {
             std::set<item_hash_t> sync_items_to_request;
 
-            // for each idle peer that we're syncing with
+            // for each peer that we're syncing with and which has room for another batch of requests
             fc::scoped_lock<fc::mutex> lock(_active_connections.get_mutex());
             for( const peer_connection_ptr& peer : _active_connections )
             {
               if( peer->we_need_sync_items_from_peer &&
                   // if we've already scheduled a request for this peer, don't consider scheduling another
-                  sync_item_requests_to_send.find(peer) == sync_item_requests_to_send.end() &&
-                  peer->idle() )
+                  sync_item_requests_to_send.find(peer) == sync_item_requests_to_send.end() )
               {
-                if (!peer->inhibit_fetching_sync_blocks)
+                const size_t number_of_items_to_request = number_of_sync_items_to_request_from_peer( peer.get() );
+                if (number_of_items_to_request > 0 && !peer->inhibit_fetching_sync_blocks)
                 {
                   // loop through the items it has that we don't yet have on our blockchain
                   for( const auto& item_to_potentially_request : peer->ids_of_items_to_get )
@@ -579,7 +603,7 @@ namespace graphene { namespace net { namespace detail {
                       // then schedule a request from this peer
                       sync_item_requests_to_send[peer].push_back(item_to_potentially_request);
                       sync_items_to_request.insert( item_to_potentially_request );
-                      if (sync_item_requests_to_send[peer].size() >= _max_sync_blocks_per_peer)
+                      if (sync_item_requests_to_send[peer].size() >= number_of_items_to_request)
                         break;
                     }
                   }
@@ -591,6 +615,9 @@ namespace graphene { namespace net { namespace detail {
           // make all the requests we scheduled in the loop above
           for( auto sync_item_request : sync_item_requests_to_send )
             request_sync_items_from_peer( sync_item_request.first, sync_item_request.second );
+          // only one batch per peer is scheduled above, go around again to fill the rest of the pipeline
+          if( !sync_item_requests_to_send.empty() )
+            _sync_items_to_fetch_updated = true;
           sync_item_requests_to_send.clear();
         }
         else
@@ -1439,6 +1466,16 @@ namespace graphene { namespace net { namespace detail {
         break;
       case core_message_type_enum::get_current_connections_reply_message_type:
         break;
+      case core_message_type_enum::compact_block_message_type:
+        on_compact_block_message(originating_peer, received_message.as<compact_block_message>());
+        break;
+      case core_message_type_enum::fetch_block_transactions_message_type:
+        on_fetch_block_transactions_message(originating_peer,
+                                            received_message.as<fetch_block_transactions_message>());
+        break;
+      case core_message_type_enum::block_transactions_message_type:
+        on_block_transactions_message(originating_peer, received_message.as<block_transactions_message>());
+        break;
 
       default:
         // ignore any message in between core_message_type_first and _last that we don't handle above
@@ -1484,6 +1521,8 @@ namespace graphene { namespace net { namespace detail {
       if (!_hard_fork_block_numbers.empty())
         user_data["last_known_fork_block_number"] = _hard_fork_block_numbers.back();
 
+      user_data["compact_blocks"] = true;
+
       return user_data;
     }
     void node_impl::parse_hello_user_data_for_peer(peer_connection* originating_peer, const fc::variant_object& user_data)
@@ -1508,6 +1547,8 @@ namespace graphene { namespace net { namespace detail {
         originating_peer->node_id = user_data["node_id"].as<node_id_t>(1);
       if (user_data.contains("last_known_fork_block_number"))
         originating_peer->last_known_fork_block_number = user_data["last_known_fork_block_number"].as<uint32_t>(1);
+      if (user_data.contains("compact_blocks"))
+        originating_peer->supports_compact_blocks = user_data["compact_blocks"].as_bool();
     }
 
    void node_impl::on_hello_message( peer_connection* originating_peer, const hello_message& hello_message_received )
@@ -2673,9 +2714,27 @@ namespace graphene { namespace net { namespace detail {
           dlog("received item request for item ${id} from peer ${endpoint}, returning the item from my message cache",
                ("endpoint", originating_peer->get_remote_endpoint())
                ("id", requested_message.id()));
-          reply_messages.push_back(requested_message);
           if (fetch_items_message_received.item_type == block_message_type)
+          {
             last_block_message_sent = requested_message;
+            // The peer asked for the block by the hash of the message, as we advertised it, so it can check the
+            // block it rebuilds against its request.  Transactions with results would not be rebuilt exactly.
+            if (originating_peer->supports_compact_blocks)
+            {
+              graphene::net::block_message block = requested_message.as<graphene::net::block_message>();
+              const auto& transactions = block.block.transactions;
+              if (!transactions.empty()
+                  && std::all_of(transactions.begin(), transactions.end(),
+                                 [](const graphene::protocol::processed_transaction& trx) {
+                                    return trx.operation_results.empty();
+                                 }))
+              {
+                reply_messages.push_back(compact_block_message(block.block, item_hash));
+                continue;
+              }
+            }
+          }
+          reply_messages.push_back(requested_message);
           continue;
         }
         catch (fc::key_not_found_exception&)
@@ -2729,6 +2788,8 @@ namespace graphene { namespace net { namespace detail {
       if (regular_item_iter != originating_peer->items_requested_from_peer.end())
       {
         originating_peer->items_requested_from_peer.erase( regular_item_iter );
+        if (requested_item.item_type == block_message_type)
+          originating_peer->partial_compact_blocks.erase( requested_item.item_hash );
         originating_peer->inventory_peer_advertised_to_us.erase( requested_item );
         if (is_item_in_any_peers_inventory(requested_item))
         {
@@ -3178,87 +3239,90 @@ namespace graphene { namespace net { namespace detail {
 
       do
       {
-        std::copy(std::make_move_iterator(_new_received_sync_items.begin()),
-                  std::make_move_iterator(_new_received_sync_items.end()),
-                  std::front_inserter(_received_sync_items));
-        _new_received_sync_items.clear();
+        // splice instead of moving the blocks, which may still be being prepared by the client
+        _received_sync_items.splice(_received_sync_items.begin(), _new_received_sync_items);
         dlog("currently ${count} sync items to consider", ("count", _received_sync_items.size()));
 
         block_processed_this_iteration = false;
-        for (auto received_block_iter = _received_sync_items.begin();
-             received_block_iter != _received_sync_items.end();
-             ++received_block_iter)
-        {
 
-          // find out if this block is the next block on the active chain or one of the forks
-          bool potential_first_block = false;
+        // find out if we have the next block on the active chain or one of the forks
+        item_hash_t next_block_id;
+        bool have_next_block = false;
+        {
+          fc::scoped_lock<fc::mutex> lock(_active_connections.get_mutex());
+          for (const peer_connection_ptr& peer : _active_connections)
+          {
+            if (!peer->ids_of_items_to_get.empty() &&
+                  have_already_received_sync_item(peer->ids_of_items_to_get.front()))
+            {
+              next_block_id = peer->ids_of_items_to_get.front();
+              have_next_block = true;
+              break;
+            }
+          }
+          if (have_next_block)
           {
-            fc::scoped_lock<fc::mutex> lock(_active_connections.get_mutex());
             for (const peer_connection_ptr& peer : _active_connections)
             {
                if (!peer->ids_of_items_to_get.empty() &&
-                     peer->ids_of_items_to_get.front() == received_block_iter->block_id)
+                     peer->ids_of_items_to_get.front() == next_block_id)
                {
-                  potential_first_block = true;
                   peer->ids_of_items_to_get.pop_front();
-                  peer->ids_of_items_being_processed.insert(received_block_iter->block_id);
+                  peer->ids_of_items_being_processed.insert(next_block_id);
                }
             }
           }
+        }
 
-          // if it is, process it, remove it from all sync peers lists
-          if (potential_first_block)
+        // if we have, process it, it has been removed from all sync peers lists
+        if (have_next_block)
+        {
+          // we can get into an interesting situation near the end of synchronization.  We can be in
+          // sync with one peer who is sending us the last block on the chain via a regular inventory
+          // message, while at the same time still be synchronizing with a peer who is sending us the
+          // block through the sync mechanism.  Further, we must request both blocks because
+          // we don't know they're the same (for the peer in normal operation, it has only told us the
+          // message id, for the peer in the sync case we only known the block_id).
+          graphene::net::block_message block_message_to_process = take_received_sync_item(next_block_id);
+          if (std::find(_most_recent_blocks_accepted.begin(), _most_recent_blocks_accepted.end(),
+                        next_block_id) == _most_recent_blocks_accepted.end())
           {
-            // we can get into an interesting situation near the end of synchronization.  We can be in
-            // sync with one peer who is sending us the last block on the chain via a regular inventory
-            // message, while at the same time still be synchronizing with a peer who is sending us the
-            // block through the sync mechanism.  Further, we must request both blocks because
-            // we don't know they're the same (for the peer in normal operation, it has only told us the
-            // message id, for the peer in the sync case we only known the block_id).
-            if (std::find(_most_recent_blocks_accepted.begin(), _most_recent_blocks_accepted.end(),
-                          received_block_iter->block_id) == _most_recent_blocks_accepted.end())
-            {
-              graphene::net::block_message block_message_to_process = *received_block_iter;
-              _received_sync_items.erase(received_block_iter);
-              _handle_message_calls_in_progress.emplace_back(fc::async([this, block_message_to_process](){
-                send_sync_block_to_node_delegate(block_message_to_process);
-              }, "send_sync_block_to_node_delegate"));
-              ++blocks_processed;
-              block_processed_this_iteration = true;
-            }
-            else
+            _handle_message_calls_in_progress.emplace_back(fc::async([this, block_message_to_process](){
+              send_sync_block_to_node_delegate(block_message_to_process);
+            }, "send_sync_block_to_node_delegate"));
+            ++blocks_processed;
+            block_processed_this_iteration = true;
+          }
+          else
+          {
+            dlog("Already received and accepted this block (presumably through normal inventory mechanism), treating it as accepted");
+            std::vector< peer_connection_ptr > peers_needing_next_batch;
+            fc::scoped_lock<fc::mutex> lock(_active_connections.get_mutex());
+            for (const peer_connection_ptr& peer : _active_connections)
             {
-              dlog("Already received and accepted this block (presumably through normal inventory mechanism), treating it as accepted");
-              std::vector< peer_connection_ptr > peers_needing_next_batch;
-              fc::scoped_lock<fc::mutex> lock(_active_connections.get_mutex());
-              for (const peer_connection_ptr& peer : _active_connections)
+              auto items_being_processed_iter = peer->ids_of_items_being_processed.find(next_block_id);
+              if (items_being_processed_iter != peer->ids_of_items_being_processed.end())
               {
-                auto items_being_processed_iter = peer->ids_of_items_being_processed.find(received_block_iter->block_id);
-                if (items_being_processed_iter != peer->ids_of_items_being_processed.end())
+                peer->ids_of_items_being_processed.erase(items_being_processed_iter);
+                dlog("Removed item from ${endpoint}'s list of items being processed, still processing ${len} blocks",
+                     ("endpoint", peer->get_remote_endpoint())("len", peer->ids_of_items_being_processed.size()));
+
+                // if we just processed the last item in our list from this peer, we will want to
+                // send another request to find out if we are now in sync (this is normally handled in
+                // send_sync_block_to_node_delegate)
+                if (peer->ids_of_items_to_get.empty() &&
+                    peer->number_of_unfetched_item_ids == 0 &&
+                    peer->ids_of_items_being_processed.empty())
                 {
-                  peer->ids_of_items_being_processed.erase(items_being_processed_iter);
-                  dlog("Removed item from ${endpoint}'s list of items being processed, still processing ${len} blocks",
-                       ("endpoint", peer->get_remote_endpoint())("len", peer->ids_of_items_being_processed.size()));
-
-                  // if we just processed the last item in our list from this peer, we will want to
-                  // send another request to find out if we are now in sync (this is normally handled in
-                  // send_sync_block_to_node_delegate)
-                  if (peer->ids_of_items_to_get.empty() &&
-                      peer->number_of_unfetched_item_ids == 0 &&
-                      peer->ids_of_items_being_processed.empty())
-                  {
-                    dlog("We received last item in our list for peer ${endpoint}, setup to do a sync check", ("endpoint", peer->get_remote_endpoint()));
-                    peers_needing_next_batch.push_back( peer );
-                  }
+                  dlog("We received last item in our list for peer ${endpoint}, setup to do a sync check", ("endpoint", peer->get_remote_endpoint()));
+                  peers_needing_next_batch.push_back( peer );
                 }
               }
-              for( const peer_connection_ptr& peer : peers_needing_next_batch )
-                fetch_next_batch_of_item_ids_from_peer(peer.get());
             }
-
-            break; // start iterating _received_sync_items from the beginning
-          } // end if potential_first_block
-        } // end for each block in _received_sync_items
+            for( const peer_connection_ptr& peer : peers_needing_next_batch )
+              fetch_next_batch_of_item_ids_from_peer(peer.get());
+          }
+        } // end if have_next_block
 
         if (_handle_message_calls_in_progress.size() >= _max_blocks_to_handle_at_once)
         {
@@ -3278,6 +3342,36 @@ namespace graphene { namespace net { namespace detail {
         trigger_fetch_sync_items_loop();
     }
 
+    graphene::net::block_message node_impl::take_received_sync_item( const item_hash_t& block_id )
+    {
+      VERIFY_CORRECT_THREAD();
+      fc::future<void> prepared = _received_sync_items_by_id.at( block_id ).prepared;
+      if( prepared.valid() && !prepared.ready() )
+      {
+        try
+        {
+          prepared.wait();
+        }
+        catch (const fc::canceled_exception&)
+        {
+          throw;
+        }
+        catch (const fc::exception& e)
+        {
+          // the client will find out again when the block is handled
+          dlog("Failed to prepare sync block ${id}: ${e}", ("id", block_id)("e", e));
+        }
+      }
+
+      // more blocks may have arrived in the meantime, make sure this one is in _received_sync_items
+      _received_sync_items.splice(_received_sync_items.begin(), _new_received_sync_items);
+      auto item_iter = _received_sync_items_by_id.find( block_id );
+      graphene::net::block_message result = std::move( *item_iter->second.block );
+      _received_sync_items.erase( item_iter->second.block );
+      _received_sync_items_by_id.erase( item_iter );
+      return result;
+    }
+
     void node_impl::trigger_process_backlog_of_sync_blocks()
     {
       if (!_node_is_shutting_down &&
@@ -3295,7 +3389,22 @@ namespace graphene { namespace net { namespace detail {
 
       // add it to the front of _received_sync_items, then process _received_sync_items to try to
       // pass as many messages as possible to the client.
-      _new_received_sync_items.push_front( block_message_to_process );
+      if( _received_sync_items_by_id.find( block_message_to_process.block_id ) == _received_sync_items_by_id.end() )
+      {
+        _new_received_sync_items.push_front( block_message_to_process );
+        received_sync_item& item = _received_sync_items_by_id[block_message_to_process.block_id];
+        item.block = _new_received_sync_items.begin();
+        // let the client start working on the block while earlier blocks are still being fetched or applied
+        try
+        {
+          item.prepared = _delegate->prepare_sync_block( *item.block );
+        }
+        catch (const fc::exception& e)
+        {
+          // the client will find out again when the block is handled
+          dlog("Failed to prepare sync block ${id}: ${e}", ("id", block_message_to_process.block_id)("e", e));
+        }
+      }
       trigger_process_backlog_of_sync_blocks();
     }
 
@@ -3496,16 +3605,15 @@ namespace graphene { namespace net { namespace detail {
             originating_peer->last_sync_item_received_time = fc::time_point::now();
             _active_sync_requests.erase(block_message_to_process.block_id);
             process_block_during_syncing(originating_peer, block_message_to_process, message_hash);
-            if (originating_peer->idle())
-            {
-              // we have finished fetching a batch of items, so we either need to grab another batch of items
-              // or we need to get another list of item ids.
-              if (originating_peer->number_of_unfetched_item_ids > 0 &&
-                  originating_peer->ids_of_items_to_get.size() < GRAPHENE_NET_MIN_BLOCK_IDS_TO_PREFETCH)
-                fetch_next_batch_of_item_ids_from_peer(originating_peer);
-              else
-                trigger_fetch_sync_items_loop();
-            }
+            // we either need to grab another batch of items or we need to get another list of item ids.
+            // Item ids are fetched while the rest of the requested items are still arriving.
+            if (originating_peer->number_of_unfetched_item_ids > 0 &&
+                originating_peer->ids_of_items_to_get.size() < GRAPHENE_NET_MIN_BLOCK_IDS_TO_PREFETCH &&
+                !originating_peer->item_ids_requested_from_peer &&
+                originating_peer->items_requested_from_peer.empty())
+              fetch_next_batch_of_item_ids_from_peer(originating_peer);
+            else if (number_of_sync_items_to_request_from_peer(originating_peer) > 0)
+              trigger_fetch_sync_items_loop();
             return;
           }
           catch (const fc::canceled_exception& e)
@@ -3542,6 +3650,184 @@ namespace graphene { namespace net { namespace detail {
       disconnect_from_peer(originating_peer, "You sent me a block that I didn't ask for", true, detailed_error);
     }
 
+    void node_impl::on_compact_block_message(peer_connection* originating_peer,
+                                             const compact_block_message& compact_block_message_received)
+    {
+      VERIFY_CORRECT_THREAD();
+      const item_hash_t& block_message_hash = compact_block_message_received.block_message_hash;
+      // compact blocks are only sent in reply to requests made during normal operation
+      if (originating_peer->items_requested_from_peer.find(item_id(block_message_type, block_message_hash))
+            == originating_peer->items_requested_from_peer.end())
+      {
+        wlog("received a compact block ${block_id} I didn't ask for from peer ${endpoint}, disconnecting from peer",
+             ("endpoint", originating_peer->get_remote_endpoint())
+             ("block_id", compact_block_message_received.block_id));
+        fc::exception detailed_error(FC_LOG_MESSAGE(error, "You sent me a compact block that I didn't ask for, block_id: ${block_id}",
+                                                    ("block_id", compact_block_message_received.block_id)));
+        disconnect_from_peer(originating_peer, "You sent me a compact block that I didn't ask for", true, detailed_error);
+        return;
+      }
+
+      peer_connection::partial_compact_block rebuilt_block;
+      static_cast<signed_block_header&>(rebuilt_block.block) = compact_block_message_received.header;
+      const std::vector<transaction_id_type>& transaction_ids = compact_block_message_received.transaction_ids;
+      rebuilt_block.block.transactions.resize(transaction_ids.size());
+      for (uint32_t i = 0; i < transaction_ids.size(); ++i)
+      {
+        fc::optional<signed_transaction> trx = find_transaction_for_compact_block(transaction_ids[i]);
+        if (trx)
+          rebuilt_block.block.transactions[i] = graphene::protocol::processed_transaction(*trx);
+        else
+          rebuilt_block.missing_transaction_indexes.push_back(i);
+      }
+      dlog("received compact block ${block_id} with ${count} transactions from peer ${endpoint}, missing ${missing}",
+           ("block_id", compact_block_message_received.block_id)
+           ("count", transaction_ids.size())
+           ("missing", rebuilt_block.missing_transaction_indexes.size())
+           ("endpoint", originating_peer->get_remote_endpoint()));
+
+      if (rebuilt_block.missing_transaction_indexes.empty())
+      {
+        process_rebuilt_compact_block(originating_peer, block_message_hash, std::move(rebuilt_block));
+        return;
+      }
+      originating_peer->send_message(fetch_block_transactions_message(block_message_hash,
+                                                                      rebuilt_block.missing_transaction_indexes));
+      originating_peer->partial_compact_blocks[block_message_hash] = std::move(rebuilt_block);
+    }
+
+    void node_impl::on_fetch_block_transactions_message(peer_connection* originating_peer,
+                                  const fetch_block_transactions_message& fetch_block_transactions_message_received)
+    {
+      VERIFY_CORRECT_THREAD();
+      // Gatekeeping code
+      if( originating_peer->their_state != peer_connection::their_connection_state::connection_accepted )
+      {
+         wlog( "Unexpected fetch_block_transactions_message from peer ${peer}, disconnecting",
+               ("peer", originating_peer->get_remote_endpoint()) );
+         disconnect_from_peer( originating_peer, "Received an unexpected fetch_block_transactions_message" );
+         return;
+      }
+
+      const item_hash_t& block_message_hash = fetch_block_transactions_message_received.block_message_hash;
+      graphene::net::block_message requested_block;
+      try
+      {
+        requested_block = _message_cache.get_message(block_message_hash).as<graphene::net::block_message>();
+      }
+      catch (fc::key_not_found_exception&)
+      {
+        dlog("peer ${endpoint} asked for transactions of a block which is no longer in my message cache",
+             ("endpoint", originating_peer->get_remote_endpoint()));
+        originating_peer->send_message(item_not_available_message(item_id(block_message_type, block_message_hash)));
+        return;
+      }
+
+      std::vector<signed_transaction> transactions;
+      transactions.reserve(fetch_block_transactions_message_received.transaction_indexes.size());
+      for (uint32_t index : fetch_block_transactions_message_received.transaction_indexes)
+      {
+        if (index >= requested_block.block.transactions.size())
+        {
+          wlog("peer ${endpoint} asked for transaction ${index} of block ${block_id} which has only ${count}",
+               ("endpoint", originating_peer->get_remote_endpoint())("index", index)
+               ("block_id", requested_block.block_id)("count", requested_block.block.transactions.size()));
+          disconnect_from_peer(originating_peer, "You asked for a transaction which is not in the block");
+          return;
+        }
+        transactions.push_back(requested_block.block.transactions[index]);
+      }
+      originating_peer->send_message(block_transactions_message(block_message_hash, std::move(transactions)));
+    }
+
+    void node_impl::on_block_transactions_message(peer_connection* originating_peer,
+                                                  const block_transactions_message& block_transactions_message_received)
+    {
+      VERIFY_CORRECT_THREAD();
+      const item_hash_t& block_message_hash = block_transactions_message_received.block_message_hash;
+      auto iter = originating_peer->partial_compact_blocks.find(block_message_hash);
+      if (iter == originating_peer->partial_compact_blocks.end())
+      {
+        wlog("received transactions of a block I didn't ask for from peer ${endpoint}, disconnecting from peer",
+             ("endpoint", originating_peer->get_remote_endpoint()));
+        disconnect_from_peer(originating_peer, "You sent me transactions of a block that I didn't ask for");
+        return;
+      }
+      peer_connection::partial_compact_block rebuilt_block = std::move(iter->second);
+      originating_peer->partial_compact_blocks.erase(iter);
+
+      const std::vector<signed_transaction>& transactions = block_transactions_message_received.transactions;
+      if (transactions.size() != rebuilt_block.missing_transaction_indexes.size())
+      {
+        wlog("peer ${endpoint} sent me ${count} transactions of block ${block_id} instead of ${expected}",
+             ("endpoint", originating_peer->get_remote_endpoint())("count", transactions.size())
+             ("block_id", rebuilt_block.block.id())("expected", rebuilt_block.missing_transaction_indexes.size()));
+        disconnect_from_peer(originating_peer, "You sent me a wrong number of block transactions");
+        return;
+      }
+      for (size_t i = 0; i < transactions.size(); ++i)
+        rebuilt_block.block.transactions[rebuilt_block.missing_transaction_indexes[i]]
+              = graphene::protocol::processed_transaction(transactions[i]);
+      process_rebuilt_compact_block(originating_peer, block_message_hash, std::move(rebuilt_block));
+    }
+
+    fc::optional<signed_transaction> node_impl::find_transaction_for_compact_block(const transaction_id_type& trx_id)
+    {
+      VERIFY_CORRECT_THREAD();
+      fc::optional<message> cached_message = _message_cache.find_message_by_contents_hash(trx_message_type, trx_id);
+      if (cached_message)
+        return signed_transaction(cached_message->as<trx_message>().trx);
+      try
+      {
+        message client_message = _delegate->get_item(item_id(trx_message_type, trx_id));
+        if (client_message.msg_type.value() == trx_message_type)
+          return signed_transaction(client_message.as<trx_message>().trx);
+      }
+      catch (const fc::canceled_exception&)
+      {
+        throw;
+      }
+      catch (const fc::exception&)
+      {
+        // the client doesn't know it either
+      }
+      return fc::optional<signed_transaction>();
+    }
+
+    void node_impl::process_rebuilt_compact_block(peer_connection* originating_peer,
+                                                  const item_hash_t& block_message_hash,
+                                                  peer_connection::partial_compact_block&& rebuilt_block)
+    {
+      VERIFY_CORRECT_THREAD();
+      message message_to_process(graphene::net::block_message(rebuilt_block.block));
+      if (message_to_process.id() == block_message_hash)
+      {
+        process_block_message(originating_peer, message_to_process, block_message_hash);
+        return;
+      }
+
+      // A transaction we had differs from the one in the block, e.g. in its signatures, so ask for all of them
+      const uint32_t transaction_count = (uint32_t)rebuilt_block.block.transactions.size();
+      if (rebuilt_block.missing_transaction_indexes.size() < transaction_count)
+      {
+        dlog("compact block ${block_id} from peer ${endpoint} did not match the block message I asked for, "
+             "fetching all of its transactions",
+             ("block_id", rebuilt_block.block.id())("endpoint", originating_peer->get_remote_endpoint()));
+        rebuilt_block.missing_transaction_indexes.resize(transaction_count);
+        std::iota(rebuilt_block.missing_transaction_indexes.begin(), rebuilt_block.missing_transaction_indexes.end(),
+                  0u);
+        originating_peer->send_message(fetch_block_transactions_message(block_message_hash,
+                                                                        rebuilt_block.missing_transaction_indexes));
+        originating_peer->partial_compact_blocks[block_message_hash] = std::move(rebuilt_block);
+        return;
+      }
+
+      wlog("block ${block_id} rebuilt from the compact block sent by peer ${endpoint} does not match the block "
+           "message I asked for, disconnecting from peer",
+           ("block_id", rebuilt_block.block.id())("endpoint", originating_peer->get_remote_endpoint()));
+      disconnect_from_peer(originating_peer, "You sent me a compact block that does not match the block I asked for");
+    }
+
     void node_impl::on_current_time_request_message(peer_connection* originating_peer,
                                                     const current_time_request_message& current_time_request_message_received)
     {
@@ -3779,6 +4065,23 @@ namespace graphene { namespace net { namespace detail {
         wlog( "Exception thrown while terminating Process backlog of sync items task, ignoring" );
       }
 
+      // the client may still be preparing sync blocks we own
+      for( auto& received_item : _received_sync_items_by_id )
+      {
+        try
+        {
+          if( received_item.second.prepared.valid() )
+            received_item.second.prepared.wait();
+        }
+        catch (...)
+        { // errors don't matter anymore
+        }
+      }
+      _received_sync_items_by_id.clear();
+      _new_received_sync_items.clear();
+      _received_sync_items.clear();
+      dlog("Preparation of sync blocks terminated");
+
       size_t handle_message_call_count = 0;
       while( true )
       {
@@ -4920,6 +5223,8 @@ namespace graphene { namespace net { namespace detail {
         _max_sync_blocks_to_prefetch = params["max_sync_blocks_to_prefetch"].as<uint32_t>(1);
       if (params.contains("max_sync_blocks_per_peer"))
         _max_sync_blocks_per_peer = params["max_sync_blocks_per_peer"].as<uint32_t>(1);
+      if (params.contains("max_sync_requests_per_peer"))
+        _max_sync_requests_per_peer = params["max_sync_requests_per_peer"].as<uint32_t>(1);
 
       _desired_number_of_connections = std::min(_desired_number_of_connections, _maximum_number_of_connections);
 
@@ -4940,6 +5245,7 @@ namespace graphene { namespace net { namespace detail {
       result["max_blocks_to_handle_at_once"] = _max_blocks_to_handle_at_once;
       result["max_sync_blocks_to_prefetch"] = _max_sync_blocks_to_prefetch;
       result["max_sync_blocks_per_peer"] = _max_sync_blocks_per_peer;
+      result["max_sync_requests_per_peer"] = _max_sync_requests_per_peer;
       return result;
     }
 
@@ -5343,6 +5649,20 @@ namespace graphene { namespace net { namespace detail {
       INVOKE_AND_COLLECT_STATISTICS(handle_block, block_message, sync_mode, contained_transaction_msg_ids);
     }
 
+    fc::future<void> statistics_gathering_node_delegate_wrapper::prepare_sync_block(
+             const graphene::net::block_message& block_message )
+    {
+      // The delegate only launches the work and returns its future, so it is called in the thread of the node
+      // instead of waiting for the thread of the delegate like the other methods
+      std::shared_ptr<call_statistics_collector> statistics_collector = std::make_shared<call_statistics_collector>(
+                                                     "prepare_sync_block",
+                                                     &_prepare_sync_block_execution_accumulator,
+                                                     &_prepare_sync_block_delay_before_accumulator,
+                                                     &_prepare_sync_block_delay_after_accumulator);
+      call_statistics_collector::actual_execution_measurement_helper helper(statistics_collector);
+      return _node_delegate->prepare_sync_block( block_message );
+    }
+
     void statistics_gathering_node_delegate_wrapper::handle_transaction( const graphene::net::trx_message& transaction_message )
     {
       INVOKE_AND_COLLECT_STATISTICS(handle_transaction, transaction_message);
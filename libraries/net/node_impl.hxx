@@ -231,6 +231,9 @@ public:
    message get_message( const message_hash_type& hash_of_message_to_lookup ) const;
    message_propagation_data get_message_propagation_data(
          const message_hash_type& hash_of_msg_contents_to_lookup ) const;
+   /// Finds a message of the given type by what it contains, e.g. a transaction by its ID
+   fc::optional<message> find_message_by_contents_hash( uint32_t msg_type,
+         const message_hash_type& hash_of_msg_contents_to_lookup ) const;
    size_t size() const { return _message_cache.size(); }
 };
 
@@ -272,6 +275,7 @@ class statistics_gathering_node_delegate_wrapper : public node_delegate
 #define NODE_DELEGATE_METHOD_NAMES (has_item) \
                                (handle_message) \
                                (handle_block) \
+                               (prepare_sync_block) \
                                (handle_transaction) \
                                (get_block_ids) \
                                (get_item) \
@@ -371,6 +375,7 @@ class statistics_gathering_node_delegate_wrapper : public node_delegate
       void handle_message( const message& ) override;
       bool handle_block( const graphene::net::block_message& block_message, bool sync_mode,
                          std::vector<message_hash_type>& contained_transaction_msg_ids ) override;
+      fc::future<void> prepare_sync_block( const graphene::net::block_message& block_message ) override;
       void handle_transaction( const graphene::net::trx_message& transaction_message ) override;
       std::vector<item_hash_t> get_block_ids(const std::vector<item_hash_t>& blockchain_synopsis,
                                              uint32_t& remaining_item_count,
@@ -464,6 +469,17 @@ public:
       /// List of sync blocks we've received, but can't yet process because we are still missing blocks
       /// that come earlier in the chain
       std::list<graphene::net::block_message> _received_sync_items;
+
+      /// A sync block in one of the lists above.  Blocks are moved between the lists by splicing, so that
+      /// they stay in place while the node delegate prepares them
+      struct received_sync_item
+      {
+        std::list<graphene::net::block_message>::iterator block;
+        /// Ready once the node delegate has finished preparing the block
+        fc::future<void> prepared;
+      };
+      /// Sync blocks in _new_received_sync_items and _received_sync_items by block id
+      std::unordered_map<graphene::net::block_id_type, received_sync_item> _received_sync_items_by_id;
       /// @}
 
       fc::future<void> _process_backlog_of_sync_blocks_done;
@@ -624,6 +640,8 @@ public:
       size_t _max_sync_blocks_to_prefetch = MAX_SYNC_BLOCKS_TO_PREFETCH;
       /// Maximum number of blocks per peer during syncing
       size_t _max_sync_blocks_per_peer = GRAPHENE_NET_MAX_BLOCKS_PER_PEER_DURING_SYNCING;
+      /// Maximum number of batches of sync blocks requested from a peer which may be outstanding at the same time
+      size_t _max_sync_requests_per_peer = GRAPHENE_NET_MAX_SYNC_REQUESTS_PER_PEER;
 
       std::list<fc::future<void> > _handle_message_calls_in_progress;
 
@@ -646,6 +664,7 @@ public:
       bool have_already_received_sync_item( const item_hash_t& item_hash );
       void request_sync_item_from_peer( const peer_connection_ptr& peer, const item_hash_t& item_to_request );
       void request_sync_items_from_peer( const peer_connection_ptr& peer, const std::vector<item_hash_t>& items_to_request );
+      size_t number_of_sync_items_to_request_from_peer( const peer_connection* peer ) const;
       void fetch_sync_items_loop();
       void trigger_fetch_sync_items_loop();
 
@@ -718,11 +737,28 @@ public:
       void on_current_time_reply_message( peer_connection* originating_peer,
                                           const current_time_reply_message& current_time_reply_message_received );
 
+      void on_compact_block_message( peer_connection* originating_peer,
+                                     const compact_block_message& compact_block_message_received );
+
+      void on_fetch_block_transactions_message( peer_connection* originating_peer,
+                                                const fetch_block_transactions_message& fetch_block_transactions_message_received );
+
+      void on_block_transactions_message( peer_connection* originating_peer,
+                                          const block_transactions_message& block_transactions_message_received );
+
+      /// Returns the transaction with the given ID if we received it recently or the client knows it
+      fc::optional<signed_transaction> find_transaction_for_compact_block( const transaction_id_type& trx_id );
+      /// Passes a block rebuilt from a compact_block_message on as if it was received as a block_message,
+      /// or asks the peer for all of its transactions if it does not match the requested item
+      void process_rebuilt_compact_block( peer_connection* originating_peer, const item_hash_t& block_message_hash,
+                                          peer_connection::partial_compact_block&& rebuilt_block );
+
       void on_connection_closed(peer_connection* originating_peer) override;
 
       void send_sync_block_to_node_delegate(const graphene::net::block_message& block_message_to_send);
       void process_backlog_of_sync_blocks();
       void trigger_process_backlog_of_sync_blocks();
+      graphene::net::block_message take_received_sync_item( const item_hash_t& block_id );
       void process_block_during_syncing(
                   peer_connection* originating_peer,
                   const graphene::net::block_message& block_message,
@@ -23,6 +23,7 @@
  */
 
 #include <graphene/account_history/account_history_plugin.hpp>
+#include <graphene/account_history/history_store.hpp>
 
 #include <graphene/chain/impacted.hpp>
 
@@ -78,6 +79,11 @@ class account_history_plugin_impl
 
       uint32_t _latest_block_number_to_remove = 0;
 
+      /// Where history removed from memory is saved, if enabled
+      std::shared_ptr<history_store> _history_store;
+      /// Only entries of irreversible blocks are moved to the history store
+      uint32_t _last_irreversible_block_num = 0;
+
       uint64_t get_max_ops_to_keep( const account_id_type& account_id );
 
       /** add one history record, then check and remove the earliest history record(s) */
@@ -106,6 +112,11 @@ void account_history_plugin_impl::update_account_histories( const signed_block&
    _latest_block_number_to_remove = get_biggest_number_to_remove( b.block_num(), _min_blocks_to_keep );
 
    graphene::chain::database& db = database();
+   if( _history_store )
+   {
+      _last_irreversible_block_num = db.get_dynamic_global_properties().last_irreversible_block_num;
+      _latest_block_number_to_remove = std::min( _latest_block_number_to_remove, _last_irreversible_block_num );
+   }
    const vector<optional< operation_history_object > >& hist = db.get_applied_operations();
    bool is_first = true;
    auto skip_oho_id = [&is_first,&db,this]() {
@@ -238,6 +249,9 @@ void account_history_plugin_impl::update_account_histories( const signed_block&
    }
 
    remove_old_histories();
+
+   if( _history_store )
+      _history_store->flush();
 }
 
 void account_history_plugin_impl::add_account_history( const account_id_type& account_id,
@@ -300,7 +314,8 @@ void account_history_plugin_impl::remove_old_histories()
 
 void account_history_plugin_impl::check_and_remove_op_history_obj( const operation_history_object& op )
 {
-   if( _partial_operations )
+   // Operations saved in the history store do not need to stay in memory either
+   if( _partial_operations || _history_store )
    {
       // check for references
       graphene::chain::database& db = database();
@@ -348,6 +363,14 @@ void account_history_plugin_impl::remove_old_histories_by_account( const account
       if( remove_op.block_num > _latest_block_number_to_remove && removed_ops >= number_of_ops_to_remove_by_blks )
          break;
 
+      // save the entry to disk before removing it from memory, which is only safe when it is irreversible
+      if( _history_store )
+      {
+         if( remove_op.block_num > _last_irreversible_block_num )
+            break;
+         _history_store->store( account_id, aho_to_remove.sequence, remove_op );
+      }
+
       // remove the entry
       ++aho_itr;
       db.remove( aho_to_remove );
@@ -449,6 +472,11 @@ void account_history_plugin::plugin_set_program_options(
           "when the min-blocks-to-keep option causes the amount to exceed the limit defined by the "
           "max-ops-per-account option. If this is less than max-ops-per-account, max-ops-per-account will be used. "
           "(default: 1000)")
+         ("history-store-dir", boost::program_options::value<boost::filesystem::path>(),
+          "Save account history which is removed from memory to this directory instead of discarding it, "
+          "and serve it from there in the history API. Only history of irreversible blocks is moved to disk, "
+          "the limits of the other options then define how much history is kept in memory. "
+          "Operations saved to disk are removed from memory as with partial-operations.")
          ;
    cfg.add(cli);
 }
@@ -463,6 +491,12 @@ void account_history_plugin::plugin_initialize(const boost::program_options::var
    database().add_index< primary_index< account_history_index > >();
 
    database().add_index< primary_index< exceeded_account_index > >();
+
+   if( my->_history_store )
+   {
+      ilog( "Opening account history store" );
+      my->_history_store->open();
+   }
 }
 
 void detail::account_history_plugin_impl::init_program_options(const boost::program_options::variables_map& options)
@@ -484,15 +518,32 @@ void detail::account_history_plugin_impl::init_program_options(const boost::prog
    utilities::get_program_option( options, "max-ops-per-acc-by-min-blocks", _max_ops_per_acc_by_min_blocks );
    if( _max_ops_per_acc_by_min_blocks < _max_ops_per_account )
       _max_ops_per_acc_by_min_blocks = _max_ops_per_account;
+
+   if( options.count( "history-store-dir" ) > 0 )
+   {
+      const auto& dir = options.at( "history-store-dir" ).as<boost::filesystem::path>();
+      _history_store = std::make_shared<history_store>( dir );
+   }
 }
 
 void account_history_plugin::plugin_startup()
 {
 }
 
+void account_history_plugin::plugin_shutdown()
+{
+   if( my->_history_store )
+      my->_history_store->close();
+}
+
 flat_set<account_id_type> account_history_plugin::tracked_accounts() const
 {
    return my->_tracked_accounts;
 }
 
+std::shared_ptr<const history_store> account_history_plugin::get_history_store()const
+{
+   return my->_history_store;
+}
+
 } }
@@ -0,0 +1,533 @@
+/*
+ * Copyright (c) 2026 Contributors.
+ *
+ * The MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#include <graphene/account_history/history_store.hpp>
+
+#include <fc/io/fstream.hpp>
+#include <fc/io/raw.hpp>
+#include <fc/log/logger.hpp>
+
+#include <boost/endian/buffers.hpp>
+
+#include <algorithm>
+#include <deque>
+#include <fstream>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+namespace graphene { namespace account_history { namespace detail {
+
+/// An account history entry as stored on disk
+struct account_record
+{
+   boost::endian::little_uint64_buf_t account;   ///< instance of the account ID
+   boost::endian::little_uint64_buf_t sequence;
+   boost::endian::little_uint64_buf_t operation; ///< position of the operation in the segments
+   boost::endian::little_uint64_buf_t previous;  ///< position of the previous record of the account plus one, 0 if none
+};
+
+struct record_checkpoint
+{
+   uint64_t sequence = 0;
+   uint64_t position = 0;
+};
+
+/// In-memory index of the records of one account
+struct account_entries
+{
+   uint64_t                       account = 0;
+   uint64_t                       last_sequence = 0;
+   uint64_t                       last_position = 0;
+   std::vector<record_checkpoint> checkpoints;
+};
+
+/// The in-memory index as saved on close, it covers the first @ref records_size bytes of the records file
+struct saved_index
+{
+   uint64_t                     records_size = 0;
+   std::vector<account_entries> accounts;
+};
+
+} } } // graphene::account_history::detail
+
+FC_REFLECT( graphene::account_history::detail::record_checkpoint, (sequence)(position) )
+FC_REFLECT( graphene::account_history::detail::account_entries,
+            (account)(last_sequence)(last_position)(checkpoints) )
+FC_REFLECT( graphene::account_history::detail::saved_index, (records_size)(accounts) )
+
+namespace graphene { namespace account_history {
+
+namespace detail {
+
+namespace {
+   /// Maximum size of a segment file, operation positions are encoded as segment * segment_size + offset
+   constexpr uint64_t segment_size = 1024 * 1024 * 1024;
+   /// Number of recently written operations remembered, so that an operation shared by several accounts
+   /// is usually written only once
+   constexpr size_t max_recent_operations = 64 * 1024;
+   /// Number of records read at once when rebuilding the index
+   constexpr size_t records_per_batch = 4096;
+}
+
+class history_store_impl
+{
+   public:
+      explicit history_store_impl( const fc::path& dir ) : _dir( dir ) {}
+
+      void open();
+      void write_pending();
+      void close();
+
+      void store( const account_id_type& account, uint64_t sequence, const operation_history_object& op );
+      uint64_t find_sequence( const account_id_type& account, uint64_t max_sequence,
+                              const std::function<bool(const operation_history_object&)>& is_old )const;
+      void for_each( const account_id_type& account, uint64_t start, uint64_t stop,
+                     const std::function<bool(uint64_t, const operation_history_object&)>& visitor )const;
+
+      const account_entries* find_entries( const account_id_type& account )const
+      {
+         auto itr = _accounts.find( account.instance.value );
+         return itr == _accounts.end() ? nullptr : &itr->second;
+      }
+
+      mutable std::mutex _mutex;
+
+   private:
+      fc::path segment_filename( size_t segment )const;
+      void open_segment( size_t segment );
+      void open_records();
+
+      uint64_t write_operation( const operation_history_object& op );
+      operation_history_object read_operation( uint64_t position )const;
+      void read_record( uint64_t position, account_record& rec )const;
+      /// Finds the newest record of the account with a sequence number not above the given one
+      bool seek( const account_entries& entries, uint64_t sequence, account_record& rec )const;
+      void add_record( account_entries& entries, const account_record& rec, uint64_t position );
+
+      void load_index();
+      void save_index();
+      /// Adds the records starting at the given position to the index
+      void scan_records( uint64_t from );
+
+      fc::path                                   _dir;
+      fc::path                                   _records_filename;
+      fc::path                                   _index_filename;
+
+      mutable std::fstream                       _records;
+      /// Records are kept in memory until @ref write_pending, after the operations they point to
+      std::vector<account_record>                _pending_records;
+      uint64_t                                   _written_records_size = 0;
+      uint64_t                                   _records_size = 0;
+
+      mutable std::vector<std::unique_ptr<std::fstream>> _segments;
+      uint64_t                                   _last_segment_size = 0;
+      bool                                       _segments_dirty = false;
+
+      std::unordered_map<uint64_t, account_entries> _accounts;
+
+      std::unordered_map<uint64_t, uint64_t>     _recent_operations; ///< operation instance to position
+      std::deque<uint64_t>                       _recent_operation_order;
+};
+
+fc::path history_store_impl::segment_filename( size_t segment )const
+{
+   std::string number = fc::to_string( uint64_t(segment) );
+   if( number.size() < 6 )
+      number.insert( 0, 6 - number.size(), '0' );
+   return _dir / ( "operations." + number );
+}
+
+void history_store_impl::open_segment( size_t segment )
+{
+   const auto filename = segment_filename( segment );
+   auto mode = std::fstream::binary | std::fstream::in | std::fstream::out;
+   if( !fc::exists( filename ) )
+      mode |= std::fstream::trunc;
+   auto stream = std::make_unique<std::fstream>();
+   stream->exceptions( std::ios_base::failbit | std::ios_base::badbit );
+   stream->open( filename.generic_string().c_str(), mode );
+   _segments.push_back( std::move( stream ) );
+}
+
+void history_store_impl::open_records()
+{
+   auto mode = std::fstream::binary | std::fstream::in | std::fstream::out;
+   if( !fc::exists( _records_filename ) )
+      mode |= std::fstream::trunc;
+   _records.exceptions( std::ios_base::failbit | std::ios_base::badbit );
+   _records.open( _records_filename.generic_string().c_str(), mode );
+}
+
+void history_store_impl::open()
+{ try {
+   fc::create_directories( _dir );
+   _records_filename = _dir / "records";
+   _index_filename = _dir / "index";
+
+   for( size_t segment = 0; segment == 0 || fc::exists( segment_filename( segment ) ); ++segment )
+      open_segment( segment );
+   _last_segment_size = fc::file_size( segment_filename( _segments.size() - 1 ) );
+
+   open_records();
+   // Drop a record which was not completely written
+   _records_size = fc::file_size( _records_filename );
+   _records_size -= _records_size % sizeof(account_record);
+   _written_records_size = _records_size;
+
+   load_index();
+} FC_CAPTURE_AND_RETHROW( (_dir) ) }
+
+void history_store_impl::load_index()
+{
+   saved_index saved;
+   if( fc::exists( _index_filename ) )
+   {
+      try
+      {
+         std::string data;
+         fc::read_file_contents( _index_filename, data );
+         saved = fc::raw::unpack<saved_index>( std::vector<char>( data.begin(), data.end() ) );
+      }
+      catch( const fc::exception& e )
+      {
+         wlog( "Failed to load the account history store index, rebuilding it: ${e}", ("e", e.to_detail_string()) );
+         saved = saved_index();
+      }
+   }
+   // The index is still valid if records were added afterwards, but not if some were dropped
+   if( saved.records_size > _records_size )
+   {
+      wlog( "Account history store index does not match the records, rebuilding it" );
+      saved = saved_index();
+   }
+   _accounts.clear();
+   _accounts.reserve( saved.accounts.size() );
+   for( auto& entries : saved.accounts )
+   {
+      const uint64_t account = entries.account;
+      _accounts[account] = std::move( entries );
+   }
+   if( saved.records_size < _records_size )
+      ilog( "Indexing ${n} account history records", ("n", ( _records_size - saved.records_size ) / sizeof(account_record)) );
+   scan_records( saved.records_size );
+}
+
+void history_store_impl::scan_records( uint64_t from )
+{
+   std::vector<account_record> batch( records_per_batch );
+   uint64_t position = from;
+   while( position < _written_records_size )
+   {
+      const size_t count = static_cast<size_t>( std::min<uint64_t>( records_per_batch,
+                                                   ( _written_records_size - position ) / sizeof(account_record) ) );
+      _records.seekg( position );
+      _records.read( (char*)batch.data(), count * sizeof(account_record) );
+      for( size_t i = 0; i < count; ++i, position += sizeof(account_record) )
+      {
+         const account_record& rec = batch[i];
+         const uint64_t op_position = rec.operation.value();
+         const uint64_t segment = op_position / segment_size;
+         const bool is_last_segment = ( segment + 1 == _segments.size() );
+         if( segment >= _segments.size() || ( is_last_segment && op_position % segment_size >= _last_segment_size ) )
+         {
+            // The operation was lost in an unclean shutdown, drop this and all later records
+            wlog( "Dropping account history records from position ${p}, their operations are missing",
+                  ("p", position) );
+            _records.close();
+            fc::resize_file( _records_filename, position );
+            open_records();
+            _records_size = _written_records_size = position;
+            return;
+         }
+         auto& entries = _accounts[ rec.account.value() ];
+         entries.account = rec.account.value();
+         add_record( entries, rec, position );
+      }
+   }
+}
+
+void history_store_impl::save_index()
+{
+   saved_index saved;
+   saved.records_size = _written_records_size;
+   saved.accounts.reserve( _accounts.size() );
+   for( const auto& item : _accounts )
+      saved.accounts.push_back( item.second );
+   const auto data = fc::raw::pack( saved );
+
+   const auto tmp_filename = _dir / "index.tmp";
+   {
+      std::ofstream out( tmp_filename.generic_string().c_str(),
+                         std::ofstream::binary | std::ofstream::out | std::ofstream::trunc );
+      out.write( data.data(), data.size() );
+   }
+   fc::rename( tmp_filename, _index_filename );
+}
+
+void history_store_impl::write_pending()
+{
+   if( _segments_dirty )
+   {
+      for( auto& segment : _segments )
+         segment->flush();
+      _segments_dirty = false;
+   }
+   if( _pending_records.empty() )
+      return;
+   // Records are written after the operations, so that they never point to missing data
+   _records.seekp( _written_records_size );
+   _records.write( (const char*)_pending_records.data(), _pending_records.size() * sizeof(account_record) );
+   _records.flush();
+   _written_records_size += _pending_records.size() * sizeof(account_record);
+   _pending_records.clear();
+}
+
+void history_store_impl::close()
+{
+   if( !_records.is_open() )
+      return;
+   write_pending();
+   save_index();
+   _records.close();
+   _segments.clear();
+}
+
+void history_store_impl::add_record( account_entries& entries, const account_record& rec, uint64_t position )
+{
+   entries.last_sequence = rec.sequence.value();
+   entries.last_position = position;
+   if( entries.last_sequence % history_store::checkpoint_interval == 0 )
+      entries.checkpoints.push_back( record_checkpoint{ entries.last_sequence, position } );
+}
+
+uint64_t history_store_impl::write_operation( const operation_history_object& op )
+{
+   const uint64_t op_instance = op.id.instance();
+   auto itr = _recent_operations.find( op_instance );
+   if( itr != _recent_operations.end() )
+      return itr->second;
+
+   const auto data = fc::raw::pack( op );
+   const uint64_t size = sizeof(boost::endian::little_uint32_buf_t) + data.size();
+   if( _last_segment_size > 0 && _last_segment_size + size > segment_size )
+   {
+      open_segment( _segments.size() );
+      _last_segment_size = 0;
+   }
+   boost::endian::little_uint32_buf_t data_size;
+   data_size = static_cast<uint32_t>( data.size() );
+   auto& segment = *_segments.back();
+   segment.seekp( _last_segment_size );
+   segment.write( (const char*)&data_size, sizeof(data_size) );
+   segment.write( data.data(), data.size() );
+   _segments_dirty = true;
+
+   const uint64_t position = ( _segments.size() - 1 ) * segment_size + _last_segment_size;
+   _last_segment_size += size;
+
+   _recent_operations[op_instance] = position;
+   _recent_operation_order.push_back( op_instance );
+   if( _recent_operation_order.size() > max_recent_operations )
+   {
+      _recent_operations.erase( _recent_operation_order.front() );
+      _recent_operation_order.pop_front();
+   }
+   return position;
+}
+
+operation_history_object history_store_impl::read_operation( uint64_t position )const
+{
+   const uint64_t segment = position / segment_size;
+   FC_ASSERT( segment < _segments.size(), "Operation position out of range in history store (maybe corrupt on disk?)" );
+   auto& stream = *_segments[segment];
+   boost::endian::little_uint32_buf_t data_size;
+   stream.seekg( position % segment_size );
+   stream.read( (char*)&data_size, sizeof(data_size) );
+   std::vector<char> data( data_size.value() );
+   stream.read( data.data(), data.size() );
+   return fc::raw::unpack<operation_history_object>( data );
+}
+
+void history_store_impl::read_record( uint64_t position, account_record& rec )const
+{
+   if( position >= _written_records_size )
+   {
+      const uint64_t index = ( position - _written_records_size ) / sizeof(account_record);
+      FC_ASSERT( index < _pending_records.size(), "Record position out of range in history store" );
+      rec = _pending_records[index];
+      return;
+   }
+   _records.seekg( position );
+   _records.read( (char*)&rec, sizeof(rec) );
+}
+
+bool history_store_impl::seek( const account_entries& entries, uint64_t sequence, account_record& rec )const
+{
+   if( sequence == 0 || entries.last_sequence == 0 )
+      return false;
+   const auto& checkpoints = entries.checkpoints;
+   auto itr = std::lower_bound( checkpoints.begin(), checkpoints.end(), sequence,
+                                []( const record_checkpoint& c, uint64_t s ) { return c.sequence < s; } );
+   read_record( itr != checkpoints.end() ? itr->position : entries.last_position, rec );
+   while( rec.sequence.value() > sequence )
+   {
+      if( rec.previous.value() == 0 )
+         return false;
+      read_record( rec.previous.value() - 1, rec );
+   }
+   return true;
+}
+
+void history_store_impl::store( const account_id_type& account, uint64_t sequence,
+                                const operation_history_object& op )
+{
+   auto& entries = _accounts[ account.instance.value ];
+   if( sequence <= entries.last_sequence )
+      return;
+   entries.account = account.instance.value;
+
+   account_record rec;
+   rec.account = account.instance.value;
+   rec.sequence = sequence;
+   rec.operation = write_operation( op );
+   rec.previous = ( entries.last_sequence > 0 ) ? ( entries.last_position + 1 ) : 0;
+
+   const uint64_t position = _records_size;
+   _pending_records.push_back( rec );
+   _records_size += sizeof(account_record);
+   add_record( entries, rec, position );
+}
+
+uint64_t history_store_impl::find_sequence( const account_id_type& account, uint64_t max_sequence,
+                              const std::function<bool(const operation_history_object&)>& is_old )const
+{
+   const account_entries* entries = find_entries( account );
+   if( entries == nullptr )
+      return 0;
+
+   // Binary search the checkpoints for the oldest one which is not old, the result is below it
+   const auto& checkpoints = entries->checkpoints;
+   const size_t candidates = std::upper_bound( checkpoints.begin(), checkpoints.end(), max_sequence,
+                                [](  uint64_t s, const record_checkpoint& c ) { return s < c.sequence; } )
+                             - checkpoints.begin();
+   size_t low = 0;
+   size_t high = candidates;
+   account_record rec;
+   while( low < high )
+   {
+      const size_t mid = low + ( high - low ) / 2;
+      read_record( checkpoints[mid].position, rec );
+      if( is_old( read_operation( rec.operation.value() ) ) )
+         low = mid + 1;
+      else
+         high = mid;
+   }
+   const uint64_t upper = ( low < candidates ) ? checkpoints[low].sequence - 1 : max_sequence;
+
+   // At most checkpoint_interval records are left to check
+   if( !seek( *entries, upper, rec ) )
+      return 0;
+   while( !is_old( read_operation( rec.operation.value() ) ) )
+   {
+      if( rec.previous.value() == 0 )
+         return 0;
+      read_record( rec.previous.value() - 1, rec );
+   }
+   return rec.sequence.value();
+}
+
+void history_store_impl::for_each( const account_id_type& account, uint64_t start, uint64_t stop,
+                    const std::function<bool(uint64_t, const operation_history_object&)>& visitor )const
+{
+   const account_entries* entries = find_entries( account );
+   account_record rec;
+   if( entries == nullptr || start < stop || !seek( *entries, start, rec ) )
+      return;
+   while( rec.sequence.value() >= stop )
+   {
+      if( !visitor( rec.sequence.value(), read_operation( rec.operation.value() ) ) )
+         return;
+      if( rec.previous.value() == 0 )
+         return;
+      read_record( rec.previous.value() - 1, rec );
+   }
+}
+
+} // detail
+
+constexpr uint64_t history_store::checkpoint_interval;
+
+history_store::history_store( const fc::path& dir )
+   : my( std::make_unique<detail::history_store_impl>( dir ) )
+{
+}
+
+history_store::~history_store() = default;
+
+void history_store::open()
+{
+   std::lock_guard<std::mutex> lock( my->_mutex );
+   my->open();
+}
+
+void history_store::flush()
+{
+   std::lock_guard<std::mutex> lock( my->_mutex );
+   my->write_pending();
+}
+
+void history_store::close()
+{
+   std::lock_guard<std::mutex> lock( my->_mutex );
+   my->close();
+}
+
+void history_store::store( const account_id_type& account, uint64_t sequence, const operation_history_object& op )
+{
+   std::lock_guard<std::mutex> lock( my->_mutex );
+   my->store( account, sequence, op );
+}
+
+uint64_t history_store::last_sequence( const account_id_type& account )const
+{
+   std::lock_guard<std::mutex> lock( my->_mutex );
+   const auto* entries = my->find_entries( account );
+   return entries == nullptr ? 0 : entries->last_sequence;
+}
+
+uint64_t history_store::find_sequence( const account_id_type& account, uint64_t max_sequence,
+                                       const std::function<bool(const operation_history_object&)>& is_old )const
+{
+   std::lock_guard<std::mutex> lock( my->_mutex );
+   return my->find_sequence( account, max_sequence, is_old );
+}
+
+void history_store::for_each( const account_id_type& account, uint64_t start, uint64_t stop,
+                   const std::function<bool(uint64_t, const operation_history_object&)>& visitor )const
+{
+   std::lock_guard<std::mutex> lock( my->_mutex );
+   my->for_each( account, start, stop, visitor );
+}
+
+} } // graphene::account_history
@@ -84,6 +84,8 @@ namespace detail
     class account_history_plugin_impl;
 }
 
+class history_store;
+
 class account_history_plugin : public graphene::app::plugin
 {
    public:
@@ -96,9 +98,13 @@ class account_history_plugin : public graphene::app::plugin
          boost::program_options::options_description& cfg) override;
       void plugin_initialize(const boost::program_options::variables_map& options) override;
       void plugin_startup() override;
+      void plugin_shutdown() override;
 
       flat_set<account_id_type> tracked_accounts()const;
 
+      /// @return the store of history which was moved from memory to disk, or null if not enabled
+      std::shared_ptr<const history_store> get_history_store()const;
+
    private:
       std::unique_ptr<detail::account_history_plugin_impl> my;
 };
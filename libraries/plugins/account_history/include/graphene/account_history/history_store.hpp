@@ -0,0 +1,97 @@
+/*
+ * Copyright (c) 2026 Contributors.
+ *
+ * The MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#pragma once
+
+#include <graphene/chain/operation_history_object.hpp>
+
+#include <fc/filesystem.hpp>
+
+#include <functional>
+#include <memory>
+
+namespace graphene { namespace account_history {
+   using namespace chain;
+
+   namespace detail
+   {
+      class history_store_impl;
+   }
+
+   /**
+    *  @brief Append-only on-disk store of account history entries which are no longer kept in memory
+    *
+    *  Operations are packed into segment files of limited size, account history entries are fixed-size
+    *  records in a separate file.  Each record points to its operation and to the previous record of the
+    *  same account, so that the history of an account can be walked backwards like the in-memory linked list.
+    *  Only the newest record and every @ref checkpoint_interval -th record of each account are indexed in
+    *  memory, which keeps lookups by sequence number bounded without holding per-operation data in RAM.
+    *
+    *  Entries are identified by account and sequence number and only accepted in ascending order per
+    *  account, so storing an entry again, e.g. after a chain reorganization or a replay, has no effect.
+    *  Callers must therefore only store entries of irreversible blocks.
+    *
+    *  All methods may be called from any thread.
+    */
+   class history_store
+   {
+      public:
+         /// Every this many entries of an account, the position of the entry is kept in memory
+         static constexpr uint64_t checkpoint_interval = 64;
+
+         explicit history_store( const fc::path& dir );
+         ~history_store();
+
+         /// Opens the store, truncating records which were not completely written before an unclean shutdown
+         void open();
+         /// Writes buffered entries to disk
+         void flush();
+         /// Flushes and saves the in-memory index, so that it does not need to be rebuilt when reopening
+         void close();
+
+         /// Adds an entry, ignored if the account already has an entry with this or a higher sequence number
+         void store( const account_id_type& account, uint64_t sequence, const operation_history_object& op );
+
+         /// @return the highest stored sequence number of the account, or 0 if none
+         uint64_t last_sequence( const account_id_type& account )const;
+
+         /**
+          *  @return the highest sequence number of the account which is not above @p max_sequence and whose
+          *          operation satisfies @p is_old, or 0 if none.  @p is_old must hold for all entries older
+          *          than an entry for which it holds, e.g. a comparison of operation IDs or block times.
+          */
+         uint64_t find_sequence( const account_id_type& account, uint64_t max_sequence,
+                                 const std::function<bool(const operation_history_object&)>& is_old )const;
+
+         /**
+          *  Calls @p visitor for the entries of the account from sequence number @p start down to @p stop,
+          *  both inclusive, until it returns false
+          */
+         void for_each( const account_id_type& account, uint64_t start, uint64_t stop,
+                        const std::function<bool(uint64_t, const operation_history_object&)>& visitor )const;
+
+      private:
+         std::unique_ptr<detail::history_store_impl> my;
+   };
+
+} } // graphene::account_history
@@ -23,6 +23,8 @@
  */
 
 #include <graphene/api_helper_indexes/api_helper_indexes.hpp>
+#include <graphene/app/util.hpp>
+#include <graphene/chain/account_object.hpp>
 #include <graphene/chain/liquidity_pool_object.hpp>
 #include <graphene/chain/market_object.hpp>
 #include <graphene/chain/proposal_object.hpp>
@@ -130,6 +132,106 @@ const flat_set<liquidity_pool_id_type>& asset_in_liquidity_pools_index::get_liqu
    return empty_set;
 }
 
+void asset_holders_count_index::object_inserted( const object& objct )
+{ try {
+   const auto& o = static_cast<const account_balance_object&>( objct );
+   ++balance_counts[ o.asset_type ]; // Note: [] operator will create an entry if not found
+} FC_CAPTURE_AND_RETHROW( (objct) ) }
+
+void asset_holders_count_index::object_removed( const object& objct )
+{ try {
+   const auto& o = static_cast<const account_balance_object&>( objct );
+   auto itr = balance_counts.find( o.asset_type );
+   if( itr != balance_counts.end() ) // should always be true
+      --itr->second;
+   // Note: do not erase entries with a zero count from the map in order to avoid read/write race conditions
+} FC_CAPTURE_AND_RETHROW( (objct) ) }
+
+void asset_holders_count_index::about_to_modify( const object& objct )
+{
+   // the asset of a balance object never changes, nothing to do here
+}
+
+void asset_holders_count_index::object_modified( const object& objct )
+{
+   // the asset of a balance object never changes, nothing to do here
+}
+
+int64_t asset_holders_count_index::get_balance_count( const asset_id_type& a )const
+{
+   auto itr = balance_counts.find( a );
+   if( itr != balance_counts.end() )
+      return itr->second;
+   return 0;
+}
+
+static share_type order_receive_amount( const limit_order_object& o )
+{
+   return share_type( fc::uint128_t( o.for_sale.value ) * o.sell_price.quote.amount.value
+                                                        / o.sell_price.base.amount.value );
+}
+
+void order_book_depth_index::object_inserted( const object& objct )
+{ try {
+   const auto& o = static_cast<const limit_order_object&>( objct );
+   boost::unique_lock<boost::shared_mutex> guard( _sides_mutex );
+   auto& side = _sides[ std::make_pair( o.sell_price.base.asset_id, o.sell_price.quote.asset_id ) ];
+   price_level& level = side[ o.sell_price ];
+   level.for_sale += o.for_sale;
+   level.to_receive += order_receive_amount( o );
+   ++level.order_count;
+} FC_CAPTURE_AND_RETHROW( (objct) ) }
+
+void order_book_depth_index::object_removed( const object& objct )
+{ try {
+   const auto& o = static_cast<const limit_order_object&>( objct );
+   boost::unique_lock<boost::shared_mutex> guard( _sides_mutex );
+   auto side_itr = _sides.find( std::make_pair( o.sell_price.base.asset_id, o.sell_price.quote.asset_id ) );
+   if( side_itr == _sides.end() ) // should not happen
+      return;
+   auto level_itr = side_itr->second.find( o.sell_price );
+   if( level_itr == side_itr->second.end() ) // should not happen
+      return;
+   if( level_itr->second.order_count <= 1 )
+   {
+      side_itr->second.erase( level_itr );
+      if( side_itr->second.empty() )
+         _sides.erase( side_itr );
+      return;
+   }
+   level_itr->second.for_sale -= o.for_sale;
+   level_itr->second.to_receive -= order_receive_amount( o );
+   --level_itr->second.order_count;
+} FC_CAPTURE_AND_RETHROW( (objct) ) }
+
+void order_book_depth_index::about_to_modify( const object& objct )
+{ try {
+   object_removed( objct );
+} FC_CAPTURE_AND_RETHROW( (objct) ) }
+
+void order_book_depth_index::object_modified( const object& objct )
+{ try {
+   object_inserted( objct );
+} FC_CAPTURE_AND_RETHROW( (objct) ) }
+
+void order_book_depth_index::get_order_book_depth( const asset_object& base, const asset_object& quote,
+                                                   uint32_t limit, graphene::app::order_book_depth& result )const
+{ try {
+   boost::shared_lock<boost::shared_mutex> guard( _sides_mutex );
+
+   auto add_levels = [this,&base,&quote,limit]( asset_id_type sell, asset_id_type receive,
+                                                vector<graphene::app::order_book_level>& levels ) {
+      auto side_itr = _sides.find( std::make_pair( sell, receive ) );
+      if( side_itr == _sides.end() )
+         return;
+      for( auto itr = side_itr->second.begin(); itr != side_itr->second.end() && levels.size() < limit; ++itr )
+         levels.emplace_back( itr->first, itr->second.for_sale, itr->second.to_receive, itr->second.order_count,
+                              base, quote );
+   };
+   add_levels( base.get_id(), quote.get_id(), result.bids );
+   add_levels( quote.get_id(), base.get_id(), result.asks );
+} FC_CAPTURE_AND_RETHROW( (base.symbol)(quote.symbol)(limit) ) }
+
 namespace detail
 {
 
@@ -201,6 +303,16 @@ void api_helper_indexes::plugin_startup()
    for( const auto& pool : database().get_index_type<liquidity_pool_index>().indices() )
       asset_in_liquidity_pools_idx->object_inserted( pool );
 
+   asset_holders_count_idx = database().add_secondary_index< primary_index<account_balance_index>,
+                                                             asset_holders_count_index >();
+   for( const auto& balance : database().get_index_type<account_balance_index>().indices() )
+      asset_holders_count_idx->object_inserted( balance );
+
+   order_book_depth_idx = database().add_secondary_index< primary_index<limit_order_index>,
+                                                          order_book_depth_index >();
+   for( const auto& order : database().get_index_type<limit_order_index>().indices() )
+      order_book_depth_idx->object_inserted( order );
+
    next_object_ids_idx = database().add_secondary_index< primary_index<simple_index<chain_property_object>>,
                                                         next_object_ids_index >();
    refresh_next_ids();
@@ -23,9 +23,12 @@
  */
 #pragma once
 
+#include <graphene/app/api_objects.hpp>
 #include <graphene/app/plugin.hpp>
 #include <graphene/protocol/types.hpp>
 
+#include <boost/thread/shared_mutex.hpp>
+
 namespace graphene { namespace api_helper_indexes {
 using namespace chain;
 
@@ -71,6 +74,26 @@ class asset_in_liquidity_pools_index: public secondary_index
       flat_map<asset_id_type, flat_set<liquidity_pool_id_type>> asset_in_pools_map;
 };
 
+/**
+ *  @brief This secondary index counts the account balance objects of every asset, so that the number of holders
+ *         of an asset can be found without going through all of its balances.
+ *  @note Entries are never erased from the map in order to avoid read/write race conditions.
+ */
+class asset_holders_count_index : public secondary_index
+{
+   public:
+      void object_inserted( const object& obj ) override;
+      void object_removed( const object& obj ) override;
+      void about_to_modify( const object& before ) override;
+      void object_modified( const object& after ) override;
+
+      /// @return the number of account balance objects of the asset, including those with a zero balance
+      int64_t get_balance_count( const asset_id_type& a )const;
+
+   private:
+      flat_map<asset_id_type, int64_t> balance_counts;
+};
+
 /**
  *  @brief This secondary index tracks the next ID of all object types.
  *  @note This is implemented with \c flat_map considering there aren't too many object types in the system thus
@@ -86,6 +109,50 @@ class next_object_ids_index : public secondary_index
       flat_map< std::pair<uint8_t,uint8_t>, object_id_type > _next_ids;
 };
 
+/**
+ *  @brief This secondary index keeps the order book depth of every market, i.e. the amounts of all orders at the
+ *         same price summed up, sorted by price.
+ *  @note The price levels are updated with every change of an order, so reading the depth is bounded by the
+ *        number of levels returned.  The index is changed by the thread applying blocks while API threads read
+ *        it, so the levels are guarded by a read/write lock.
+ */
+class order_book_depth_index : public secondary_index
+{
+   public:
+      void object_inserted( const object& obj ) override;
+      void object_removed( const object& obj ) override;
+      void about_to_modify( const object& before ) override;
+      void object_modified( const object& after ) override;
+
+      /**
+       * Add the best price levels of a market to an order book depth
+       * @param base the base asset
+       * @param quote the quote asset
+       * @param limit maximum number of levels to add to each side
+       * @param result the order book depth to add the levels to, levels selling @p base are bids
+       */
+      void get_order_book_depth( const asset_object& base, const asset_object& quote, uint32_t limit,
+                                 graphene::app::order_book_depth& result )const;
+
+   private:
+      struct price_level
+      {
+         share_type for_sale;
+         /// Summed up from the orders, as each order is rounded down on its own
+         share_type to_receive;
+         uint32_t   order_count = 0;
+      };
+
+      /// Levels are sorted like the by_price index of limit orders, from the best price to the worst.  Prices of
+      /// the same ratio compare equal, so they share a level.
+      using order_book_side = std::map< price, price_level, std::greater<price> >;
+
+      /// Guards @ref _sides
+      mutable boost::shared_mutex _sides_mutex;
+      /// Price levels grouped by the assets they sell and receive
+      std::map< std::pair<asset_id_type, asset_id_type>, order_book_side > _sides;
+};
+
 namespace detail
 {
     class api_helper_indexes_impl;
@@ -111,7 +178,9 @@ class api_helper_indexes : public graphene::app::plugin
       std::unique_ptr<detail::api_helper_indexes_impl> my;
       amount_in_collateral_index* amount_in_collateral_idx = nullptr;
       asset_in_liquidity_pools_index* asset_in_liquidity_pools_idx = nullptr;
+      asset_holders_count_index* asset_holders_count_idx = nullptr;
       next_object_ids_index* next_object_ids_idx = nullptr;
+      order_book_depth_index* order_book_depth_idx = nullptr;
 
       bool _next_ids_map_initialized = false;
       void refresh_next_ids();
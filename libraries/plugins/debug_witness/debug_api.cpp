@@ -96,7 +96,7 @@ void debug_api_impl::debug_generate_blocks( const std::string& debug_key, uint32
          update("_action", "update")("id", scheduled_witness)("signing_key", debug_public_key);
          db->debug_update( update );
       }
-      db->generate_block( scheduled_time, scheduled_witness, *debug_private_key, graphene::chain::database::skip_nothing );
+      db->generate_shared_block( scheduled_time, scheduled_witness, *debug_private_key, graphene::chain::database::skip_nothing );
    }
 }
 
@@ -30,6 +30,7 @@
 #include <boost/algorithm/string.hpp>
 
 #include <graphene/utilities/boost_program_options.hpp>
+#include <graphene/utilities/es_spool.hpp>
 
 namespace graphene { namespace elasticsearch {
 
@@ -52,6 +53,13 @@ class elasticsearch_plugin_impl
          std::string auth = "";
          uint32_t bulk_replay = 10000;
          uint32_t bulk_sync = 100;
+         uint32_t bulk_connections = 4;
+         uint32_t bulk_queue_size = 16;
+         uint32_t bulk_max_retries = 0;
+
+         std::string spool_dir;
+         uint32_t spool_retain_blocks = 0;
+         uint32_t spool_reexport_from_block = 0;
 
          std::string index_prefix = "bitshares-";
 
@@ -84,6 +92,10 @@ class elasticsearch_plugin_impl
       uint32_t limit_documents = _options.bulk_replay;
 
       std::unique_ptr<graphene::utilities::es_client> es;
+      /// Sends the bulk data in the background, so that applying blocks does not wait for ES
+      std::unique_ptr<graphene::utilities::es_bulk_shipper> shipper;
+      /// Used instead of the shipper if enabled, so that the node does not wait for ES at all
+      std::unique_ptr<graphene::utilities::es_spool> spool;
 
       vector <string> bulk_lines; //  vector of op lines
       size_t approximate_bulk_size = 0;
@@ -105,6 +117,7 @@ class elasticsearch_plugin_impl
       void cleanObjects(const account_history_object& ath, const account_id_type& account_id);
 
       void init_program_options(const boost::program_options::variables_map& options);
+      void shutdown();
 };
 
 static std::string generateIndexName( const fc::time_point_sec& block_date,
@@ -223,23 +236,64 @@ void elasticsearch_plugin_impl::send_bulk( uint32_t block_num )
 {
    ilog( "Sending ${n} lines of bulk data to ElasticSearch at block ${b}, approximate size ${s}",
          ("n",bulk_lines.size())("b",block_num)("s",approximate_bulk_size) );
-   if( !es->send_bulk( bulk_lines ) )
+   try
    {
-      elog( "Error sending ${n} lines of bulk data to ElasticSearch, the first lines are:",
-            ("n",bulk_lines.size()) );
-      const auto log_max = std::min( bulk_lines.size(), size_t(10) );
-      for( size_t i = 0; i < log_max; ++i )
+      if( spool )
+         spool->append( block_num, bulk_lines );
+      else
       {
-         edump( (bulk_lines[i]) );
+         // When in sync, blocks may be popped and their account history ids reused by other documents,
+         // so wait for the data of earlier blocks to be stored first, which usually is the case already
+         if( is_sync )
+            shipper->flush();
+         shipper->enqueue( std::move(bulk_lines) );
       }
+   }
+   catch( const fc::exception& e )
+   {
       FC_THROW_EXCEPTION( graphene::chain::plugin_exception,
-            "Error populating ES database, we are going to keep trying." );
+            "Error populating ES database: ${e}", ("e", e.to_detail_string()) );
    }
    bulk_lines.clear();
    approximate_bulk_size = 0;
    bulk_lines.reserve(limit_documents);
 }
 
+void elasticsearch_plugin_impl::shutdown()
+{
+   if( spool )
+   {
+      try
+      {
+         // What has not been stored in ES yet is sent after the next startup
+         spool->append( database().head_block_num(), bulk_lines );
+      }
+      catch( const fc::exception& e )
+      {
+         elog( "Error appending bulk data to the spool on shutdown: ${e}", ("e", e.to_detail_string()) );
+      }
+      bulk_lines.clear();
+      spool->close();
+      return;
+   }
+   if( !shipper )
+      return;
+   try
+   {
+      if( !bulk_lines.empty() )
+         shipper->enqueue( std::move(bulk_lines) );
+      static const std::chrono::seconds max_wait { 30 };
+      if( !shipper->flush_for( max_wait ) )
+         wlog( "Bulk data has not been sent to ElasticSearch in time, dropping it" );
+   }
+   catch( const fc::exception& e )
+   {
+      elog( "Error sending bulk data to ElasticSearch on shutdown: ${e}", ("e", e.to_detail_string()) );
+   }
+   bulk_lines.clear();
+   shipper->close();
+}
+
 void elasticsearch_plugin_impl::checkState(const fc::time_point_sec& block_time)
 {
    if((fc::time_point::now() - block_time) < fc::seconds(30))
@@ -512,6 +566,20 @@ void elasticsearch_plugin::plugin_set_program_options(
                "Number of bulk documents to index on replay(10000)")
          ("elasticsearch-bulk-sync", boost::program_options::value<uint32_t>(),
                "Number of bulk documents to index on a syncronied chain(100)")
+         ("elasticsearch-bulk-connections", boost::program_options::value<uint32_t>(),
+               "Number of connections used to send bulk documents in parallel(4)")
+         ("elasticsearch-bulk-queue-size", boost::program_options::value<uint32_t>(),
+               "Maximum number of bulk requests waiting to be sent before block processing waits for them(16)")
+         ("elasticsearch-bulk-max-retries", boost::program_options::value<uint32_t>(),
+               "Number of times a failed bulk request is retried before giving up, 0 to keep trying(0)")
+         ("elasticsearch-spool-dir", boost::program_options::value<std::string>(),
+               "Directory of a local spool which keeps bulk documents until they are stored in ES, "
+               "so that the node does not wait for ES. Disabled if empty('')")
+         ("elasticsearch-spool-retain-blocks", boost::program_options::value<uint32_t>(),
+               "Number of blocks whose bulk documents are kept in the spool after being stored in ES, "
+               "for re-exporting(0)")
+         ("elasticsearch-spool-reexport-from-block", boost::program_options::value<uint32_t>(),
+               "Store the bulk documents in the spool in ES again from this block on at startup, 0 to disable(0)")
          ("elasticsearch-index-prefix", boost::program_options::value<std::string>(),
                "Add a prefix to the index(bitshares-)")
          ("elasticsearch-max-mapping-depth", boost::program_options::value<uint16_t>(),
@@ -543,6 +611,28 @@ void detail::elasticsearch_plugin_impl::init_program_options(const boost::progra
    FC_ASSERT( es->check_status(), "ES database is not up in url ${url}", ("url", _options.elasticsearch_url) );
 
    es->check_version_7_or_above( is_es_version_7_or_above );
+
+   if( _options.elasticsearch_mode != mode::only_query )
+   {
+      graphene::utilities::es_bulk_shipper::options shipper_options;
+      shipper_options.connections = _options.bulk_connections;
+      shipper_options.max_queued = _options.bulk_queue_size;
+      shipper_options.max_retries = _options.bulk_max_retries;
+      if( _options.spool_dir.empty() )
+         shipper = std::make_unique<graphene::utilities::es_bulk_shipper>( _options.elasticsearch_url,
+                                                                             _options.auth, shipper_options );
+      else
+      {
+         graphene::utilities::es_spool::options spool_options;
+         spool_options.directory = _options.spool_dir;
+         spool_options.retain_blocks = _options.spool_retain_blocks;
+         spool_options.shipper = shipper_options;
+         spool = std::make_unique<graphene::utilities::es_spool>( _options.elasticsearch_url, _options.auth,
+                                                                  spool_options );
+         if( _options.spool_reexport_from_block > 0 )
+            spool->rewind( _options.spool_reexport_from_block );
+      }
+   }
 }
 
 void detail::elasticsearch_plugin_impl::plugin_options::init(const boost::program_options::variables_map& options)
@@ -551,6 +641,12 @@ void detail::elasticsearch_plugin_impl::plugin_options::init(const boost::progra
    utilities::get_program_option( options, "elasticsearch-basic-auth",   auth );
    utilities::get_program_option( options, "elasticsearch-bulk-replay",  bulk_replay );
    utilities::get_program_option( options, "elasticsearch-bulk-sync",    bulk_sync );
+   utilities::get_program_option( options, "elasticsearch-bulk-connections", bulk_connections );
+   utilities::get_program_option( options, "elasticsearch-bulk-queue-size",  bulk_queue_size );
+   utilities::get_program_option( options, "elasticsearch-bulk-max-retries", bulk_max_retries );
+   utilities::get_program_option( options, "elasticsearch-spool-dir",           spool_dir );
+   utilities::get_program_option( options, "elasticsearch-spool-retain-blocks", spool_retain_blocks );
+   utilities::get_program_option( options, "elasticsearch-spool-reexport-from-block", spool_reexport_from_block );
    utilities::get_program_option( options, "elasticsearch-index-prefix",         index_prefix );
    utilities::get_program_option( options, "elasticsearch-max-mapping-depth",    max_mapping_depth );
    utilities::get_program_option( options, "elasticsearch-start-es-after-block", start_es_after_block );
@@ -594,6 +690,11 @@ void elasticsearch_plugin::plugin_startup()
    // Nothing to do
 }
 
+void elasticsearch_plugin::plugin_shutdown()
+{
+   my->shutdown();
+}
+
 static operation_history_object fromEStoOperation(const variant& source)
 {
    operation_history_object result;
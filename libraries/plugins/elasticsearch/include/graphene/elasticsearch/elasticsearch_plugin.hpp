@@ -65,6 +65,7 @@ class elasticsearch_plugin : public graphene::app::plugin
          boost::program_options::options_description& cfg) override;
       void plugin_initialize(const boost::program_options::variables_map& options) override;
       void plugin_startup() override;
+      void plugin_shutdown() override;
 
       operation_history_object get_operation_by_id(const operation_history_id_type& id) const;
       vector<operation_history_object> get_account_history(
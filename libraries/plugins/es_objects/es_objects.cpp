@@ -32,6 +32,9 @@
 #include <graphene/chain/budget_record_object.hpp>
 
 #include <graphene/utilities/elasticsearch.hpp>
+#include <graphene/utilities/es_spool.hpp>
+
+#include <fc/thread/thread.hpp>
 #include <graphene/utilities/boost_program_options.hpp>
 
 namespace graphene { namespace db {
@@ -90,6 +93,10 @@ class es_objects_plugin_impl
          uint32_t start_es_after_block = 0;
          bool sync_db_on_startup = false;
 
+         std::string spool_dir;
+         uint32_t spool_retain_blocks = 0;
+         uint32_t spool_reexport_from_block = 0;
+
          void init(const boost::program_options::variables_map& options);
       };
 
@@ -126,6 +133,8 @@ class es_objects_plugin_impl
       uint64_t docs_sent_total = 0;
 
       std::unique_ptr<graphene::utilities::es_client> es;
+      /// If enabled, bulk data is sent through it in the background instead of by @ref es
+      std::unique_ptr<graphene::utilities::es_spool> spool;
 
       vector<std::string> bulk_lines;
       size_t approximate_bulk_size = 0;
@@ -182,6 +191,21 @@ void es_objects_plugin_impl::sync_db( bool delete_before_load )
 
    graphene::chain::database &db = _self.database();
 
+   if( spool && !spool->drained() )
+   {
+      // Otherwise older data in the spool could be stored after the indexes have been cleaned
+      ilog( "elasticsearch OBJECTS: waiting for the data in the spool to be stored" );
+      constexpr int64_t spool_drain_timeout = 60; // seconds
+      const fc::time_point deadline = fc::time_point::now() + fc::seconds( spool_drain_timeout );
+      while( !spool->drained() && fc::time_point::now() < deadline )
+         fc::usleep( fc::milliseconds(100) );
+      // The data loaded below is appended after it and overwrites it, only objects which were
+      // removed since then may be left in the indexes
+      if( !spool->drained() )
+         wlog( "elasticsearch OBJECTS: the spool was not drained within ${s} seconds, loading anyway, "
+               "data of removed objects may be left in the indexes", ("s", spool_drain_timeout) );
+   }
+
    block_number = db.head_block_num();
    block_time = db.head_block_time();
 
@@ -356,7 +380,9 @@ void es_objects_plugin_impl::send_bulk_if_ready( bool force )
       next_log_time = fc::time_point::now() + fc::seconds(log_time_threshold);
    }
    // send data to elasticsearch when being forced or bulk is too large
-   if( !es->send_bulk( bulk_lines ) )
+   if( spool )
+      spool->append( block_number, bulk_lines );
+   else if( !es->send_bulk( bulk_lines ) )
    {
       elog( "Error sending ${n} lines of bulk data to ElasticSearch, the first lines are:",
             ("n",bulk_lines.size()) );
@@ -450,6 +476,14 @@ void es_objects_plugin::plugin_set_program_options(
          ("es-objects-keep-only-current", boost::program_options::value<bool>(),
                "Deprecated. Please use the store-updates or no-delete options. "
                "Keep only current state of the objects(true)")
+         ("es-objects-spool-dir", boost::program_options::value<std::string>(),
+               "Directory of a local spool which keeps bulk documents until they are stored in ES, "
+               "so that the node does not wait for ES. Disabled if empty('')")
+         ("es-objects-spool-retain-blocks", boost::program_options::value<uint32_t>(),
+               "Number of blocks whose bulk documents are kept in the spool after being stored in ES, "
+               "for re-exporting(0)")
+         ("es-objects-spool-reexport-from-block", boost::program_options::value<uint32_t>(),
+               "Store the bulk documents in the spool in ES again from this block on at startup, 0 to disable(0)")
          ("es-objects-start-es-after-block", boost::program_options::value<uint32_t>(),
                "Start doing ES job after block(0)")
          ("es-objects-sync-db-on-startup", boost::program_options::value<bool>(),
@@ -467,6 +501,19 @@ void detail::es_objects_plugin_impl::init_program_options(const boost::program_o
    FC_ASSERT( es->check_status(), "ES database is not up in url ${url}", ("url", _options.elasticsearch_url) );
 
    es->check_version_7_or_above( is_es_version_7_or_above );
+
+   if( !_options.spool_dir.empty() )
+   {
+      graphene::utilities::es_spool::options spool_options;
+      spool_options.directory = _options.spool_dir;
+      spool_options.retain_blocks = _options.spool_retain_blocks;
+      // Objects are updated in place, so their documents must be written in order
+      spool_options.shipper.connections = 1;
+      spool = std::make_unique<graphene::utilities::es_spool>( _options.elasticsearch_url, _options.auth,
+                                                               spool_options );
+      if( _options.spool_reexport_from_block > 0 )
+         spool->rewind( _options.spool_reexport_from_block );
+   }
 }
 
 void detail::es_objects_plugin_impl::plugin_options::init(const boost::program_options::variables_map& options)
@@ -494,6 +541,9 @@ void detail::es_objects_plugin_impl::plugin_options::init(const boost::program_o
    utilities::get_program_option( options, "es-objects-max-mapping-depth",    max_mapping_depth );
    utilities::get_program_option( options, "es-objects-start-es-after-block", start_es_after_block );
    utilities::get_program_option( options, "es-objects-sync-db-on-startup",   sync_db_on_startup );
+   utilities::get_program_option( options, "es-objects-spool-dir",            spool_dir );
+   utilities::get_program_option( options, "es-objects-spool-retain-blocks",  spool_retain_blocks );
+   utilities::get_program_option( options, "es-objects-spool-reexport-from-block", spool_reexport_from_block );
 }
 
 void es_objects_plugin::plugin_initialize(const boost::program_options::variables_map& options)
@@ -526,6 +576,8 @@ void es_objects_plugin::plugin_startup()
 void es_objects_plugin::plugin_shutdown()
 {
    my->send_bulk_if_ready(true); // flush
+   if( my->spool )
+      my->spool->close();
 }
 
 } }
@@ -360,6 +360,10 @@ namespace detail
  *  The market history plugin can be configured to track any number of intervals via its configuration.
  *  Once per block it will scan the virtual operations and look for fill_order_operations and then adjust
  *  the appropriate bucket objects for each fill order.
+ *
+ *  Only buckets of sizes which are not a multiple of a smaller tracked size are adjusted for each fill order.
+ *  Every other bucket size is rolled up from the largest smaller tracked size it is a multiple of, when a
+ *  bucket of that size is complete.
  */
 class market_history_plugin : public graphene::app::plugin
 {
@@ -380,6 +384,22 @@ class market_history_plugin : public graphene::app::plugin
       uint32_t                    max_order_his_records_per_market()const;
       uint32_t                    max_order_his_seconds_per_market()const;
 
+      /**
+       * @brief Get OHLCV buckets of a market
+       * @param base ID of the base asset, lower than @p quote
+       * @param quote ID of the quote asset
+       * @param bucket_seconds size of the buckets
+       * @param start the earliest open time of the buckets to return
+       * @param end the latest open time of the buckets to return
+       * @param limit maximum number of buckets to return
+       * @return the buckets ordered by open time, including data of finer buckets which is not rolled up yet,
+       *         a bucket which only consists of such data has a default ID
+       */
+      vector<bucket_object>       get_market_history( asset_id_type base, asset_id_type quote,
+                                                      uint32_t bucket_seconds,
+                                                      fc::time_point_sec start, fc::time_point_sec end,
+                                                      uint32_t limit )const;
+
    private:
       std::unique_ptr<detail::market_history_plugin_impl> my;
 };
@@ -55,6 +55,13 @@ class market_history_plugin_impl
       void update_liquidity_pool_histories( time_point_sec time, const operation_history_object& oho,
                                             const lp_ticker_meta_object*& lp_meta );
 
+      /// Adds trade data to the bucket of the given size which covers the open time of @p data,
+      /// rolling the previous bucket up into coarser sizes if a new bucket is opened
+      void update_bucket( uint32_t seconds, const bucket_object& data, fc::time_point_sec now );
+
+      /// Figures out which bucket sizes are updated by trades directly and which are rolled up
+      void init_bucket_roll_up();
+
       graphene::chain::database& database()
       {
          return _self.database();
@@ -62,20 +69,166 @@ class market_history_plugin_impl
 
       market_history_plugin&     _self;
       flat_set<uint32_t>         _tracked_buckets;
+      /// Bucket sizes which are not a multiple of a smaller tracked size, updated on every trade
+      vector<uint32_t>           _direct_buckets;
+      /// Bucket size => the largest smaller tracked size it is a multiple of, thus rolled up from
+      flat_map<uint32_t, uint32_t> _roll_up_source;
+      /// Bucket size => tracked sizes rolled up from it
+      flat_map<uint32_t, vector<uint32_t>> _roll_up_targets;
       uint32_t                   _maximum_history_per_bucket_size = 1000;
       uint32_t                   _max_order_his_records_per_market = 1000;
       uint32_t                   _max_order_his_seconds_per_market = 259200;
 };
 
 
+/// Initializes the data of a bucket with the data of another bucket, except the key
+static void init_bucket_data( bucket_object& b, const bucket_object& data )
+{
+   b.base_volume = data.base_volume;
+   b.quote_volume = data.quote_volume;
+   b.open_base = data.open_base;
+   b.open_quote = data.open_quote;
+   b.close_base = data.close_base;
+   b.close_quote = data.close_quote;
+   b.high_base = data.high_base;
+   b.high_quote = data.high_quote;
+   b.low_base = data.low_base;
+   b.low_quote = data.low_quote;
+}
+
+/// Merges the data of a later trade or a later finer bucket of the same market into a bucket
+static void merge_bucket_data( bucket_object& b, const bucket_object& data )
+{
+   try {
+      b.base_volume += data.base_volume;
+   } catch( fc::overflow_exception& ) {
+      b.base_volume = std::numeric_limits<int64_t>::max();
+   }
+   try {
+      b.quote_volume += data.quote_volume;
+   } catch( fc::overflow_exception& ) {
+      b.quote_volume = std::numeric_limits<int64_t>::max();
+   }
+   b.close_base = data.close_base;
+   b.close_quote = data.close_quote;
+   if( b.high() < data.high() )
+   {
+      b.high_base = data.high_base;
+      b.high_quote = data.high_quote;
+   }
+   if( b.low() > data.low() )
+   {
+      b.low_base = data.low_base;
+      b.low_quote = data.low_quote;
+   }
+}
+
+void market_history_plugin_impl::update_bucket( uint32_t seconds, const bucket_object& data,
+                                                fc::time_point_sec now )
+{
+   auto& db = database();
+   const auto& by_key_idx = db.get_index_type<bucket_index>().indices().get<by_key>();
+
+   bucket_key key = data.key;
+   key.seconds = seconds;
+   key.open    = fc::time_point_sec() + ( data.key.open.sec_since_epoch() / seconds * seconds );
+
+   auto bucket_itr = by_key_idx.find( key );
+   if( bucket_itr != by_key_idx.end() )
+   { // update existing bucket
+      db.modify( *bucket_itr, [&data]( bucket_object& b ){
+         merge_bucket_data( b, data );
+      });
+      return;
+   }
+
+   // The previous bucket of the market is complete now, roll it up into coarser buckets
+   auto targets_itr = _roll_up_targets.find( seconds );
+   if( targets_itr != _roll_up_targets.end() )
+   {
+      bucket_itr = by_key_idx.lower_bound( key );
+      if( bucket_itr != by_key_idx.begin() )
+      {
+         --bucket_itr;
+         if( bucket_itr->key.base == key.base && bucket_itr->key.quote == key.quote
+               && bucket_itr->key.seconds == seconds )
+         {
+            for( auto target : targets_itr->second )
+               update_bucket( target, *bucket_itr, now );
+         }
+      }
+   }
+
+   const auto max_history = _maximum_history_per_bucket_size;
+   auto bucket_num = now.sec_since_epoch() / seconds;
+   fc::time_point_sec cutoff;
+   if( bucket_num > max_history )
+      cutoff = cutoff + ( seconds * ( bucket_num - max_history ) );
+
+   if( key.open >= cutoff )
+   { // create new bucket
+      db.create<bucket_object>( [&key,&data]( bucket_object& b ){
+         b.key = key;
+         init_bucket_data( b, data );
+      });
+   }
+   else if( targets_itr != _roll_up_targets.end() )
+   {
+      // A bucket rolled up after a long time without trades would be removed right away, before it could be
+      // rolled up itself, so its data goes to the coarser buckets directly
+      for( auto target : targets_itr->second )
+         update_bucket( target, data, now );
+   }
+
+   // remove old buckets
+   key.open = fc::time_point_sec();
+   bucket_itr = by_key_idx.lower_bound( key );
+   while( bucket_itr != by_key_idx.end() &&
+          bucket_itr->key.base == key.base &&
+          bucket_itr->key.quote == key.quote &&
+          bucket_itr->key.seconds == seconds &&
+          bucket_itr->key.open < cutoff )
+   {
+      auto old_bucket_itr = bucket_itr;
+      ++bucket_itr;
+      db.remove( *old_bucket_itr );
+   }
+}
+
+void market_history_plugin_impl::init_bucket_roll_up()
+{
+   _direct_buckets.clear();
+   _roll_up_source.clear();
+   _roll_up_targets.clear();
+   for( auto bucket : _tracked_buckets )
+   {
+      uint32_t source = 0;
+      for( auto smaller : _tracked_buckets )
+      {
+         if( smaller >= bucket )
+            break;
+         if( bucket % smaller == 0 )
+            source = smaller;
+      }
+      if( source == 0 )
+         _direct_buckets.push_back( bucket );
+      else
+      {
+         _roll_up_source[bucket] = source;
+         _roll_up_targets[source].push_back( bucket );
+      }
+   }
+}
+
 struct operation_process_fill_order
 {
-   market_history_plugin&            _plugin;
+   market_history_plugin_impl&       _impl;
    fc::time_point_sec                _now;
    const market_ticker_meta_object*& _meta;
 
-   operation_process_fill_order( market_history_plugin& mhp, fc::time_point_sec n, const market_ticker_meta_object*& meta )
-   :_plugin(mhp),_now(n),_meta(meta) {}
+   operation_process_fill_order( market_history_plugin_impl& mhp, fc::time_point_sec n,
+                                 const market_ticker_meta_object*& meta )
+   :_impl(mhp),_now(n),_meta(meta) {}
 
    typedef void result_type;
 
@@ -86,7 +239,7 @@ struct operation_process_fill_order
    void operator()( const fill_order_operation& o )const
    {
       //ilog( "processing ${o}", ("o",o) );
-      auto& db         = _plugin.database();
+      auto& db         = _impl.database();
       const auto& order_his_idx = db.get_index_type<history_index>().indices();
       const auto& history_idx = order_his_idx.get<by_key>();
       const auto& his_time_idx = order_his_idx.get<by_market_time>();
@@ -126,12 +279,12 @@ struct operation_process_fill_order
       }
 
       // To remove old filled order data
-      const auto max_records = _plugin.max_order_his_records_per_market();
+      const auto max_records = _impl._max_order_his_records_per_market;
       hkey.sequence += max_records;
       itr = history_idx.lower_bound( hkey );
       if( itr != history_idx.end() && itr->key.base == hkey.base && itr->key.quote == hkey.quote )
       {
-         const auto max_seconds = _plugin.max_order_his_seconds_per_market();
+         const auto max_seconds = _impl._max_order_his_seconds_per_market;
          fc::time_point_sec min_time;
          if( min_time + max_seconds < _now )
             min_time = _now - max_seconds;
@@ -206,90 +359,27 @@ struct operation_process_fill_order
       }
 
       // To update buckets data
-      const auto max_history = _plugin.max_history();
-      if( max_history == 0 ) return;
-
-      const auto& buckets = _plugin.tracked_buckets();
-      if( buckets.size() == 0 ) return;
-
-      const auto& bucket_idx = db.get_index_type<bucket_index>();
-      for( auto bucket : buckets )
-      {
-          auto bucket_num = _now.sec_since_epoch() / bucket;
-          fc::time_point_sec cutoff;
-          if( bucket_num > max_history )
-             cutoff = cutoff + ( bucket * ( bucket_num - max_history ) );
-
-          key.seconds = bucket;
-          key.open    = fc::time_point_sec() + ( bucket_num * bucket );
-
-          const auto& by_key_idx = bucket_idx.indices().get<by_key>();
-          auto bucket_itr = by_key_idx.find( key );
-          if( bucket_itr == by_key_idx.end() )
-          { // create new bucket
-            /* const auto& obj = */
-            db.create<bucket_object>( [&]( bucket_object& b ){
-                 b.key = key;
-                 b.base_volume = trade_price.base.amount;
-                 b.quote_volume = trade_price.quote.amount;
-                 b.open_base = fill_price.base.amount;
-                 b.open_quote = fill_price.quote.amount;
-                 b.close_base = fill_price.base.amount;
-                 b.close_quote = fill_price.quote.amount;
-                 b.high_base = b.close_base;
-                 b.high_quote = b.close_quote;
-                 b.low_base = b.close_base;
-                 b.low_quote = b.close_quote;
-            });
-            //wlog( "    creating bucket ${b}", ("b",obj) );
-          }
-          else
-          { // update existing bucket
-             //wlog( "    before updating bucket ${b}", ("b",*bucket_itr) );
-             db.modify( *bucket_itr, [&]( bucket_object& b ){
-                  try {
-                     b.base_volume += trade_price.base.amount;
-                  } catch( fc::overflow_exception& ) {
-                     b.base_volume = std::numeric_limits<int64_t>::max();
-                  }
-                  try {
-                     b.quote_volume += trade_price.quote.amount;
-                  } catch( fc::overflow_exception& ) {
-                     b.quote_volume = std::numeric_limits<int64_t>::max();
-                  }
-                  b.close_base = fill_price.base.amount;
-                  b.close_quote = fill_price.quote.amount;
-                  if( b.high() < fill_price )
-                  {
-                      b.high_base = b.close_base;
-                      b.high_quote = b.close_quote;
-                  }
-                  if( b.low() > fill_price )
-                  {
-                      b.low_base = b.close_base;
-                      b.low_quote = b.close_quote;
-                  }
-             });
-             //wlog( "    after bucket bucket ${b}", ("b",*bucket_itr) );
-          }
-
-          {
-             key.open = fc::time_point_sec();
-             bucket_itr = by_key_idx.lower_bound( key );
-
-             while( bucket_itr != by_key_idx.end() &&
-                    bucket_itr->key.base == key.base &&
-                    bucket_itr->key.quote == key.quote &&
-                    bucket_itr->key.seconds == bucket &&
-                    bucket_itr->key.open < cutoff )
-             {
-              //  elog( "    removing old bucket ${b}", ("b", *bucket_itr) );
-                auto old_bucket_itr = bucket_itr;
-                ++bucket_itr;
-                db.remove( *old_bucket_itr );
-             }
-          }
-      }
+      if( _impl._maximum_history_per_bucket_size == 0 ) return;
+
+      // Only the finest buckets are updated here, coarser ones are rolled up when finer ones are complete
+      if( _impl._direct_buckets.empty() ) return;
+
+      bucket_object fill;
+      fill.key = key;
+      fill.key.open = _now;
+      fill.base_volume = trade_price.base.amount;
+      fill.quote_volume = trade_price.quote.amount;
+      fill.open_base = fill_price.base.amount;
+      fill.open_quote = fill_price.quote.amount;
+      fill.close_base = fill_price.base.amount;
+      fill.close_quote = fill_price.quote.amount;
+      fill.high_base = fill_price.base.amount;
+      fill.high_quote = fill_price.quote.amount;
+      fill.low_base = fill_price.base.amount;
+      fill.low_quote = fill_price.quote.amount;
+
+      for( auto bucket : _impl._direct_buckets )
+         _impl.update_bucket( bucket, fill, _now );
    }
 };
 
@@ -315,7 +405,7 @@ void market_history_plugin_impl::update_market_histories( const signed_block& b
          // process market history
          try
          {
-            o_op->op.visit( operation_process_fill_order( _self, b.timestamp, _meta ) );
+            o_op->op.visit( operation_process_fill_order( *this, b.timestamp, _meta ) );
          } FC_CAPTURE_AND_LOG( (o_op) )
          // process liquidity pool history
          update_liquidity_pool_histories( b.timestamp, *o_op, _lp_meta );
@@ -785,6 +875,7 @@ void market_history_plugin::plugin_initialize(const boost::program_options::vari
       my->_tracked_buckets = fc::json::from_string(buckets).as<flat_set<uint32_t>>(2);
       my->_tracked_buckets.erase( 0 );
    }
+   my->init_bucket_roll_up();
    if( options.count( "history-per-size" ) > 0 )
       my->_maximum_history_per_bucket_size = options["history-per-size"].as<uint32_t>();
    if( options.count( "max-order-his-records-per-market" ) > 0 )
@@ -817,4 +908,52 @@ uint32_t market_history_plugin::max_order_his_seconds_per_market()const
    return my->_max_order_his_seconds_per_market;
 }
 
+vector<bucket_object> market_history_plugin::get_market_history( asset_id_type base, asset_id_type quote,
+                                                                 uint32_t bucket_seconds,
+                                                                 fc::time_point_sec start, fc::time_point_sec end,
+                                                                 uint32_t limit )const
+{
+   vector<bucket_object> result;
+   if( limit == 0 )
+      return result;
+
+   const auto& by_key_idx = database().get_index_type<bucket_index>().indices().get<by_key>();
+
+   auto itr = by_key_idx.lower_bound( bucket_key( base, quote, bucket_seconds, start ) );
+   while( itr != by_key_idx.end() && itr->key.open <= end && result.size() < limit
+          && itr->key.base == base && itr->key.quote == quote && itr->key.seconds == bucket_seconds )
+   {
+      result.push_back( *itr );
+      ++itr;
+   }
+
+   // The latest bucket of every finer size in the roll-up chain is not rolled up yet.
+   // The latest bucket of a size is always later than the latest one of the size it is rolled up into.
+   for( auto src_itr = my->_roll_up_source.find( bucket_seconds ); src_itr != my->_roll_up_source.end();
+        src_itr = my->_roll_up_source.find( src_itr->second ) )
+   {
+      const uint32_t source = src_itr->second;
+      auto latest_itr = by_key_idx.upper_bound( bucket_key( base, quote, source, fc::time_point_sec::maximum() ) );
+      if( latest_itr == by_key_idx.begin() )
+         continue;
+      --latest_itr;
+      if( !( latest_itr->key.base == base && latest_itr->key.quote == quote && latest_itr->key.seconds == source ) )
+         continue;
+
+      const fc::time_point_sec open = fc::time_point_sec()
+                                      + ( latest_itr->key.open.sec_since_epoch() / bucket_seconds * bucket_seconds );
+      if( open < start || open > end )
+         continue;
+      if( !result.empty() && result.back().key.open == open )
+         detail::merge_bucket_data( result.back(), *latest_itr );
+      else if( result.size() < limit && ( result.empty() || result.back().key.open < open ) )
+      {
+         result.emplace_back();
+         result.back().key = bucket_key( base, quote, bucket_seconds, open );
+         detail::init_bucket_data( result.back(), *latest_itr );
+      }
+   }
+   return result;
+}
+
 } }
@@ -375,14 +375,14 @@ block_production_condition::block_production_condition_enum witness_plugin::mayb
    if( p2p_node() == nullptr )
       return block_production_condition::no_network;
 
-   auto block = db.generate_block(
+   auto block = db.generate_shared_block(
       scheduled_time,
       scheduled_witness,
       private_key_itr->second,
       _production_skip_flags
       );
-   capture("n", block.block_num())("t", block.timestamp)("c", now)("x", block.transactions.size());
-   fc::async( [this,block](){ p2p_node()->broadcast(net::block_message(block)); } );
+   capture("n", block->block_num())("t", block->timestamp)("c", now)("x", block->transactions.size());
+   fc::async( [this,block](){ p2p_node()->broadcast(net::block_message(*block)); } );
 
    return block_production_condition::produced;
 }
@@ -34,7 +34,11 @@ result_type get_restriction_pred_list_1(size_t idx, vector<restriction> rs) {
       result_type to_return = [p=restrictions_to_predicate<Op>(std::move(rs), true)] (const operation& op) {
          FC_ASSERT(op.which() == operation::tag<Op>::value,
                    "Supplied operation is incorrect type for restriction predicate");
-         return p(op.get<Op>());
+         auto result = p(op.get<Op>());
+         // The rejection path is created from the innermost restriction outwards, reverse it to be intuitive
+         if (!result)
+            result.reverse_path();
+         return result;
       };
       return to_return;
    });
@@ -30,7 +30,8 @@
 namespace graphene { namespace protocol {
 
 restriction_predicate_function get_restriction_predicate(vector<restriction> rs, operation::tag_type op_type) {
-   auto f = typelist::runtime::dispatch(operation::list(), op_type, [&rs](auto t) -> restriction_predicate_function {
+   // The functions of the sliced lists also reverse the rejection path, so that no extra wrapper layer is needed
+   return typelist::runtime::dispatch(operation::list(), op_type, [&rs](auto t) -> restriction_predicate_function {
       using Op = typename decltype(t)::type;
       if (typelist::contains<operation_list_1::list, Op>())
          return get_restriction_pred_list_1(typelist::index_of<operation_list_1::list, Op>(), std::move(rs));
@@ -63,10 +64,6 @@ restriction_predicate_function get_restriction_predicate(vector<restriction> rs,
                          "LOGIC ERROR: Operation type not handled by custom authorities implementation. "
                          "Please report this error.");
    });
-
-   // Wrap function in a layer that, if the function returns an error, reverses the order of the rejection path. This
-   // is because the order the path is created in, from the top of the call stack to the bottom, is counterintuitive.
-   return [f=std::move(f)](const operation& op) { return f(op).reverse_path(); };
 }
 
 predicate_result& predicate_result::reverse_path() {
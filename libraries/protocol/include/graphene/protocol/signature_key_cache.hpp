@@ -0,0 +1,99 @@
+/*
+ * Copyright (c) 2026 Contributors.
+ *
+ * The MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#pragma once
+#include <graphene/protocol/types.hpp>
+
+#include <array>
+#include <atomic>
+#include <deque>
+#include <mutex>
+#include <unordered_map>
+
+namespace graphene { namespace protocol {
+
+   /**
+    * A bounded cache of public keys recovered from transaction signatures, keyed by the signature and the digest
+    * it signs.  Public key recovery is by far the most expensive part of checking a transaction, and a node
+    * usually checks the same signatures twice: when the transaction arrives alone, and again when it arrives in a
+    * block.
+    *
+    * It is safe to use the cache from multiple threads.  Entries are spread over a fixed number of shards with a
+    * lock each, and the oldest entries of a shard are dropped when it is full.
+    */
+   class signature_key_cache
+   {
+   public:
+      static constexpr size_t default_capacity = 50000;
+
+      explicit signature_key_cache( size_t capacity = default_capacity );
+
+      /**
+       * Returns the public key which produced @p sig over @p digest, recovering it if it is not cached
+       * @throws fc::exception if no key can be recovered from the signature
+       */
+      public_key_type recover( const digest_type& digest, const signature_type& sig );
+
+      /// Sets the maximum number of cached keys, 0 disables the cache
+      void set_capacity( size_t capacity );
+      size_t get_capacity()const { return _capacity_per_shard * shard_count; }
+
+      /// Number of cached keys
+      size_t size()const;
+
+      void clear();
+
+   private:
+      static constexpr size_t shard_count = 16;
+
+      struct cache_key
+      {
+         digest_type    digest;
+         signature_type signature;
+
+         bool operator==( const cache_key& other )const
+         {
+            return digest == other.digest && signature == other.signature;
+         }
+      };
+
+      struct cache_key_hash
+      {
+         size_t operator()( const cache_key& key )const;
+      };
+
+      struct shard
+      {
+         mutable std::mutex                                              mutex;
+         std::unordered_map<cache_key, public_key_type, cache_key_hash>  keys;
+         /// For dropping the oldest entries
+         std::deque<cache_key>                                           insertion_order;
+      };
+
+      shard& get_shard( size_t hash ) { return _shards[ hash % shard_count ]; }
+
+      std::atomic<size_t>                 _capacity_per_shard;
+      std::array<shard, shard_count>      _shards;
+   };
+
+} } // graphene::protocol
@@ -26,6 +26,7 @@
 
 namespace graphene { namespace protocol {
    struct predicate_result;
+   class signature_key_cache;
 
    using rejected_predicate = static_variant<predicate_result, fc::exception>;
    using rejected_predicate_map = map<custom_authority_id_type, rejected_predicate>;
@@ -241,6 +242,10 @@ namespace graphene { namespace protocol {
       virtual void                             validate()const override;
       virtual const flat_set<public_key_type>& get_signature_keys( const chain_id_type& chain_id )const override;
       virtual uint64_t                         get_packed_size()const override;
+
+      /// Does the same as @ref get_signature_keys, but looks the keys up in @p cache and adds recovered ones to it
+      const flat_set<public_key_type>& get_signature_keys( const chain_id_type& chain_id,
+                                                           signature_key_cache& cache )const;
    protected:
       mutable bool _validated = false;
       mutable uint64_t _packed_size = 0;
@@ -0,0 +1,114 @@
+/*
+ * Copyright (c) 2026 Contributors.
+ *
+ * The MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <graphene/protocol/signature_key_cache.hpp>
+
+#include <fc/crypto/city.hpp>
+
+namespace graphene { namespace protocol {
+
+constexpr size_t signature_key_cache::default_capacity;
+constexpr size_t signature_key_cache::shard_count;
+
+size_t signature_key_cache::cache_key_hash::operator()( const cache_key& key )const
+{
+   // The digest is a hash already, but the same digest can come with different signatures
+   return std::hash<fc::sha256>()( key.digest )
+          ^ fc::city_hash_size_t( (const char*)key.signature.data, sizeof(key.signature.data) );
+}
+
+signature_key_cache::signature_key_cache( size_t capacity )
+   : _capacity_per_shard( ( capacity + shard_count - 1 ) / shard_count )
+{
+}
+
+public_key_type signature_key_cache::recover( const digest_type& digest, const signature_type& sig )
+{
+   const size_t capacity = _capacity_per_shard;
+   if( capacity == 0 )
+      return fc::ecc::public_key( sig, digest );
+
+   cache_key key { digest, sig };
+   const size_t hash = cache_key_hash()( key );
+   shard& s = get_shard( hash );
+   {
+      std::lock_guard<std::mutex> guard( s.mutex );
+      auto itr = s.keys.find( key );
+      if( itr != s.keys.end() )
+         return itr->second;
+   }
+
+   // Recover without holding the lock, another thread may do the same meanwhile
+   public_key_type result( fc::ecc::public_key( sig, digest ) );
+
+   std::lock_guard<std::mutex> guard( s.mutex );
+   if( s.keys.emplace( key, result ).second )
+   {
+      s.insertion_order.push_back( key );
+      while( s.insertion_order.size() > capacity )
+      {
+         s.keys.erase( s.insertion_order.front() );
+         s.insertion_order.pop_front();
+      }
+   }
+   return result;
+}
+
+void signature_key_cache::set_capacity( size_t capacity )
+{
+   _capacity_per_shard = ( capacity + shard_count - 1 ) / shard_count;
+   const size_t new_capacity = _capacity_per_shard;
+   for( shard& s : _shards )
+   {
+      std::lock_guard<std::mutex> guard( s.mutex );
+      while( s.insertion_order.size() > new_capacity )
+      {
+         s.keys.erase( s.insertion_order.front() );
+         s.insertion_order.pop_front();
+      }
+   }
+}
+
+size_t signature_key_cache::size()const
+{
+   size_t result = 0;
+   for( const shard& s : _shards )
+   {
+      std::lock_guard<std::mutex> guard( s.mutex );
+      result += s.keys.size();
+   }
+   return result;
+}
+
+void signature_key_cache::clear()
+{
+   for( shard& s : _shards )
+   {
+      std::lock_guard<std::mutex> guard( s.mutex );
+      s.keys.clear();
+      s.insertion_order.clear();
+   }
+}
+
+} } // graphene::protocol
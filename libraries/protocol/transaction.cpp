@@ -28,6 +28,7 @@
 #include <graphene/protocol/fee_schedule.hpp>
 #include <graphene/protocol/pts_address.hpp>
 #include <graphene/protocol/restriction_predicate.hpp>
+#include <graphene/protocol/signature_key_cache.hpp>
 
 #include <fc/io/raw.hpp>
 
@@ -461,6 +462,24 @@ const flat_set<public_key_type>& precomputable_transaction::get_signature_keys(
    return _signees;
 }
 
+const flat_set<public_key_type>& precomputable_transaction::get_signature_keys( const chain_id_type& chain_id,
+                                                                               signature_key_cache& cache )const
+{ try {
+   if( !_signees.empty() )
+      return _signees;
+   auto d = sig_digest( chain_id );
+   flat_set<public_key_type> result;
+   for( const auto&  sig : signatures )
+   {
+      GRAPHENE_ASSERT(
+         result.insert( cache.recover( d, sig ) ).second,
+            tx_duplicate_sig,
+            "Duplicate Signature detected" );
+   }
+   _signees = std::move( result );
+   return _signees;
+} FC_CAPTURE_AND_RETHROW() }
+
 void signed_transaction::verify_authority( const chain_id_type& chain_id,
                                            const std::function<const authority*(account_id_type)>& get_active,
                                            const std::function<const authority*(account_id_type)>& get_owner,
@@ -261,6 +261,176 @@ std::string es_client::query( const std::string& path, const std::string& query
    return response.content;
 }
 
+es_bulk_shipper::es_bulk_shipper( const std::string& base_url, const std::string& auth, const options& opts )
+   : _options( opts )
+{
+   FC_ASSERT( _options.connections > 0, "At least one connection is needed to send bulk data to ES" );
+   FC_ASSERT( _options.max_queued > 0, "At least one payload must be allowed in the queue" );
+
+   // The clients are created here because the first initialization of cURL is not thread safe
+   _clients.reserve( _options.connections );
+   for( uint32_t i = 0; i < _options.connections; ++i )
+      _clients.push_back( std::make_unique<es_client>( base_url, auth ) );
+   _workers.reserve( _options.connections );
+   for( const auto& client : _clients )
+   {
+      const es_client* p_client = client.get();
+      _workers.emplace_back( [this,p_client]() { run_worker( *p_client ); } );
+   }
+}
+
+es_bulk_shipper::~es_bulk_shipper()
+{
+   close();
+}
+
+uint64_t es_bulk_shipper::enqueue( std::vector<std::string>&& bulk_lines )
+{
+   std::unique_lock<std::mutex> lock( _mutex );
+   _state_changed.wait( lock, [this]() {
+      return _closing || !_failure.empty() || _queue.size() + _in_flight < _options.max_queued;
+   } );
+   check_failure();
+   FC_ASSERT( !_closing, "Unable to send bulk data to ES, the shipper is closed" );
+
+   const uint64_t number = ++_last_enqueued;
+   _queue.push_back( payload{ number, std::move(bulk_lines) } );
+   lock.unlock();
+   _work_available.notify_one();
+   return number;
+}
+
+void es_bulk_shipper::flush()
+{
+   std::unique_lock<std::mutex> lock( _mutex );
+   _state_changed.wait( lock, [this]() { return all_done(); } );
+   check_failure();
+   FC_ASSERT( _last_acknowledged == _last_enqueued, "The shipper was closed before all bulk data was sent to ES" );
+}
+
+bool es_bulk_shipper::flush_for( std::chrono::milliseconds timeout )
+{
+   std::unique_lock<std::mutex> lock( _mutex );
+   if( !_state_changed.wait_for( lock, timeout, [this]() { return all_done(); } ) )
+      return false;
+   check_failure();
+   return ( _last_acknowledged == _last_enqueued );
+}
+
+void es_bulk_shipper::close()
+{
+   {
+      std::lock_guard<std::mutex> lock( _mutex );
+      _closing = true;
+   }
+   _work_available.notify_all();
+   _state_changed.notify_all();
+   for( auto& worker : _workers )
+   {
+      if( worker.joinable() )
+         worker.join();
+   }
+}
+
+uint64_t es_bulk_shipper::last_acknowledged()const
+{
+   std::lock_guard<std::mutex> lock( _mutex );
+   return _last_acknowledged;
+}
+
+size_t es_bulk_shipper::pending()const
+{
+   std::lock_guard<std::mutex> lock( _mutex );
+   return _queue.size() + _in_flight;
+}
+
+void es_bulk_shipper::check_failure()const
+{
+   if( !_failure.empty() )
+      FC_THROW( "${failure}", ("failure", _failure) );
+}
+
+void es_bulk_shipper::run_worker( const es_client& client )
+{
+   while( true )
+   {
+      payload next;
+      {
+         std::unique_lock<std::mutex> lock( _mutex );
+         _work_available.wait( lock, [this]() { return _closing || !_queue.empty(); } );
+         if( _closing )
+            return;
+         next = std::move( _queue.front() );
+         _queue.pop_front();
+         ++_in_flight;
+      }
+
+      auto backoff = _options.initial_backoff;
+      bool sent = false;
+      for( uint32_t retries = 0; !sent; ++retries )
+      {
+         try
+         {
+            sent = client.send_bulk( next.lines );
+         }
+         catch( const fc::exception& e )
+         {
+            elog( "Error sending bulk data to ES: ${e}", ("e", e.to_detail_string()) );
+         }
+         catch( const std::exception& e )
+         {
+            elog( "Error sending bulk data to ES: ${e}", ("e", e.what()) );
+         }
+         if( sent )
+            break;
+
+         std::unique_lock<std::mutex> lock( _mutex );
+         if( _options.max_retries > 0 && retries >= _options.max_retries )
+         {
+            elog( "Giving up sending ${n} lines of bulk data to ES, the first line is ${l}",
+                  ("n", next.lines.size())("l", next.lines.empty() ? std::string() : next.lines.front()) );
+            _failure = "Error populating ES database, gave up sending bulk data #" + std::to_string( next.number )
+                       + " after " + std::to_string( retries ) + " retries";
+            --_in_flight;
+            lock.unlock();
+            _state_changed.notify_all();
+            break;
+         }
+         wlog( "Retrying to send bulk data #${n} to ES in ${ms} ms",
+               ("n", next.number)("ms", backoff.count()) );
+         // _state_changed rather than _work_available, so that no notification about new work is lost
+         _state_changed.wait_for( lock, backoff, [this]() { return _closing; } );
+         if( _closing )
+            return;
+         backoff = std::min( backoff * 2, _options.max_backoff );
+      }
+
+      if( sent )
+         acknowledge( next.number );
+   }
+}
+
+void es_bulk_shipper::acknowledge( uint64_t number )
+{
+   {
+      std::lock_guard<std::mutex> lock( _mutex );
+      --_in_flight;
+      if( number != _last_acknowledged + 1 )
+         _acknowledged_out_of_order.insert( number );
+      else
+      {
+         _last_acknowledged = number;
+         auto itr = _acknowledged_out_of_order.begin();
+         while( itr != _acknowledged_out_of_order.end() && *itr == _last_acknowledged + 1 )
+         {
+            _last_acknowledged = *itr;
+            itr = _acknowledged_out_of_order.erase( itr );
+         }
+      }
+   }
+   _state_changed.notify_all();
+}
+
 fc::variant es_data_adaptor::adapt( const fc::variant_object& op, uint16_t max_depth )
 {
    if( 0 == max_depth )
@@ -0,0 +1,530 @@
+/*
+ * Copyright (c) 2026 Contributors.
+ *
+ * The MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#include <graphene/utilities/es_spool.hpp>
+
+#include <boost/algorithm/string/join.hpp>
+#include <boost/endian/buffers.hpp>
+
+#include <fc/exception/exception.hpp>
+#include <fc/log/logger.hpp>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace graphene { namespace utilities {
+
+namespace {
+   const std::string segment_prefix = "segment-";
+   const std::string cursor_filename = "cursor";
+
+   /// Makes sure that what was written to a file, or the entries of a directory, survive a crash
+   void sync_to_disk( const fc::path& p )
+   {
+#ifndef _WIN32
+      const int fd = ::open( p.generic_string().c_str(), O_RDONLY );
+      FC_ASSERT( fd >= 0, "Unable to open ${f}: ${e}", ("f", p)("e", std::strerror(errno)) );
+      const int result = ::fsync( fd );
+      const int error = errno;
+      ::close( fd );
+      FC_ASSERT( 0 == result, "Unable to sync ${f}: ${e}", ("f", p)("e", std::strerror(error)) );
+#endif
+   }
+
+   /// Precedes the bulk lines of a block, which are stored joined by newlines
+   struct record_header
+   {
+      boost::endian::little_uint32_buf_t block_num;
+      boost::endian::little_uint32_buf_t size;
+   };
+   static_assert( sizeof(record_header) == 8, "The spool format depends on the size of record_header" );
+}
+
+es_spool::es_spool( const std::string& base_url, const std::string& auth, const options& opts )
+   : _options( opts )
+{ try {
+   fc::create_directories( _options.directory );
+   open_segments();
+   load_cursor();
+   _read_position = _cursor;
+
+   // Giving up would lose data, and nothing but the drainer waits for it
+   auto shipper_options = _options.shipper;
+   shipper_options.max_retries = 0;
+   _shipper = std::make_unique<es_bulk_shipper>( base_url, auth, shipper_options );
+   _drainer = std::thread( [this]() { run_drainer(); } );
+} FC_CAPTURE_AND_RETHROW( (opts.directory) ) }
+
+es_spool::~es_spool()
+{
+   close();
+}
+
+fc::path es_spool::segment_file( uint32_t number )const
+{
+   return _options.directory / ( segment_prefix + fc::to_string(number) );
+}
+
+void es_spool::open_segments()
+{
+   std::vector<uint32_t> numbers;
+   for( fc::directory_iterator itr( _options.directory ); itr != fc::directory_iterator(); ++itr )
+   {
+      const std::string name = (*itr).filename().string();
+      if( name.size() <= segment_prefix.size() || name.compare( 0, segment_prefix.size(), segment_prefix ) != 0
+            || name.find_first_not_of( "0123456789", segment_prefix.size() ) != std::string::npos )
+         continue;
+      numbers.push_back( static_cast<uint32_t>( std::stoul( name.substr( segment_prefix.size() ) ) ) );
+   }
+   std::sort( numbers.begin(), numbers.end() );
+
+   for( const uint32_t number : numbers )
+   {
+      segment_info segment;
+      segment.number = number;
+      const fc::path filename = segment_file( number );
+      const uint64_t file_size = fc::file_size( filename );
+      {
+         std::ifstream in( filename.generic_string().c_str(), std::ios::binary );
+         record_header header;
+         while( segment.size + sizeof(header) <= file_size )
+         {
+            in.seekg( segment.size );
+            in.read( (char*)&header, sizeof(header) );
+            if( !in || segment.size + sizeof(header) + header.size.value() > file_size )
+               break;
+            if( segment.size == 0 )
+               segment.first_block = header.block_num.value();
+            segment.last_block = header.block_num.value();
+            segment.size += sizeof(header) + header.size.value();
+         }
+      }
+      if( segment.size < file_size )
+      {
+         wlog( "Discarding ${n} bytes of an incomplete record at the end of ${f}",
+               ("n", file_size - segment.size)("f", filename) );
+         fc::resize_file( filename, segment.size );
+      }
+      _segments.push_back( segment );
+   }
+
+   for( auto itr = _segments.rbegin(); itr != _segments.rend(); ++itr )
+   {
+      if( itr->size > 0 )
+      {
+         _last_appended_block = itr->last_block;
+         break;
+      }
+   }
+}
+
+void es_spool::load_cursor()
+{
+   const fc::path filename = _options.directory / cursor_filename;
+   if( fc::exists( filename ) )
+   {
+      std::ifstream in( filename.generic_string().c_str() );
+      in >> _cursor.segment >> _cursor.offset >> _last_acknowledged_block;
+      if( !in )
+      {
+         wlog( "Unable to read ${f}, sending all data in the spool again", ("f", filename) );
+         _cursor = position();
+         _last_acknowledged_block = 0;
+      }
+   }
+
+   // The cursor may point into a segment which has been removed, or beyond data which was lost in a crash
+   const position end = end_position();
+   if( _segments.empty() || _cursor.segment < _segments.front().number )
+      _cursor = position{ _segments.empty() ? 1 : _segments.front().number, 0 };
+   else if( end < _cursor )
+      _cursor = end;
+   else
+   {
+      for( const auto& segment : _segments )
+      {
+         if( segment.number == _cursor.segment )
+            _cursor.offset = std::min( _cursor.offset, segment.size );
+      }
+   }
+}
+
+void es_spool::save_cursor()const
+{
+   const fc::path filename = _options.directory / cursor_filename;
+   const fc::path tmp_filename = _options.directory / ( cursor_filename + ".tmp" );
+   {
+      std::ofstream out( tmp_filename.generic_string().c_str(), std::ios::out | std::ios::trunc );
+      out << _cursor.segment << ' ' << _cursor.offset << ' ' << _last_acknowledged_block << '\n';
+      out.flush();
+      FC_ASSERT( out.good(), "Unable to write ${f}", ("f", tmp_filename) );
+   }
+   // Replaced in one step, so that the cursor is never lost
+   sync_to_disk( tmp_filename );
+   fc::rename( tmp_filename, filename );
+   sync_to_disk( _options.directory );
+}
+
+es_spool::position es_spool::end_position()const
+{
+   if( _segments.empty() )
+      return position{ 1, 0 };
+   return position{ _segments.back().number, _segments.back().size };
+}
+
+es_spool::position es_spool::find_block( uint32_t block_num, uint32_t& found_block )const
+{
+   found_block = 0;
+   for( const auto& segment : _segments )
+   {
+      if( segment.size == 0 || segment.last_block < block_num )
+         continue;
+      std::ifstream in( segment_file( segment.number ).generic_string().c_str(), std::ios::binary );
+      record_header header;
+      uint64_t offset = 0;
+      while( offset < segment.size )
+      {
+         in.seekg( offset );
+         in.read( (char*)&header, sizeof(header) );
+         FC_ASSERT( in.good(), "Unable to read segment ${n} of the ES spool", ("n", segment.number) );
+         if( header.block_num.value() >= block_num )
+         {
+            found_block = header.block_num.value();
+            return position{ segment.number, offset };
+         }
+         offset += sizeof(header) + header.size.value();
+      }
+   }
+   return end_position();
+}
+
+void es_spool::append( uint32_t block_num, const std::vector<std::string>& bulk_lines )
+{ try {
+   if( bulk_lines.empty() )
+      return;
+   const std::string data = boost::algorithm::join( bulk_lines, "\n" );
+   record_header header;
+   header.block_num = block_num;
+   header.size = static_cast<uint32_t>( data.size() );
+
+   std::lock_guard<std::mutex> writer_lock( _writer_mutex );
+   // Only the writer adds segments, so they can be looked at once and written without the lock
+   bool new_segment = false;
+   uint32_t segment_number = 1;
+   {
+      std::lock_guard<std::mutex> lock( _mutex );
+      FC_ASSERT( !_closing, "The ES spool is closed" );
+      new_segment = ( _segments.empty() || _segments.back().size >= _options.segment_size );
+      if( !_segments.empty() )
+         segment_number = _segments.back().number + ( new_segment ? 1 : 0 );
+   }
+
+   if( _writer != nullptr && _writer_segment != segment_number )
+      close_writer();
+   if( _writer == nullptr )
+   {
+      const fc::path filename = segment_file( segment_number );
+      _writer = std::fopen( filename.generic_string().c_str(), "ab" );
+      FC_ASSERT( _writer != nullptr, "Unable to open ${f}: ${e}", ("f", filename)("e", std::strerror(errno)) );
+      _writer_segment = segment_number;
+      if( new_segment )
+         sync_to_disk( _options.directory );
+   }
+   // Flushed right away, so that the drainer can read it
+   FC_ASSERT( std::fwrite( &header, sizeof(header), 1, _writer ) == 1
+              && std::fwrite( data.data(), 1, data.size(), _writer ) == data.size()
+              && std::fflush( _writer ) == 0,
+              "Unable to write segment ${n} of the ES spool: ${e}", ("n", segment_number)("e", std::strerror(errno)) );
+   if( ++_unsynced_records >= _options.sync_interval )
+      sync_writer();
+
+   {
+      std::lock_guard<std::mutex> lock( _mutex );
+      if( new_segment )
+      {
+         segment_info segment;
+         segment.number = segment_number;
+         _segments.push_back( segment );
+      }
+      segment_info& segment = _segments.back();
+      if( segment.size == 0 )
+         segment.first_block = block_num;
+      segment.last_block = block_num;
+      segment.size += sizeof(header) + data.size();
+      _last_appended_block = block_num;
+   }
+   _changed.notify_all();
+} FC_CAPTURE_AND_RETHROW( (block_num) ) }
+
+void es_spool::sync_writer()
+{
+   if( _unsynced_records == 0 )
+      return;
+#ifndef _WIN32
+   FC_ASSERT( 0 == ::fsync( ::fileno( _writer ) ), "Unable to sync segment ${n} of the ES spool: ${e}",
+              ("n", _writer_segment)("e", std::strerror(errno)) );
+#endif
+   _unsynced_records = 0;
+}
+
+void es_spool::close_writer()
+{
+   sync_writer();
+   std::fclose( _writer );
+   _writer = nullptr;
+}
+
+uint32_t es_spool::rewind( uint32_t block_num )
+{
+   uint32_t found_block = 0;
+   {
+      std::lock_guard<std::mutex> lock( _mutex );
+      find_block( block_num, found_block );
+      for( const auto& segment : _segments )
+      {
+         if( segment.size == 0 )
+            continue;
+         if( block_num < segment.first_block )
+            wlog( "The data of the blocks before ${b} is no longer in the ES spool", ("b", segment.first_block) );
+         break;
+      }
+      _rewind_to = block_num;
+   }
+   _changed.notify_all();
+   return found_block;
+}
+
+void es_spool::close()
+{
+   {
+      std::lock_guard<std::mutex> lock( _mutex );
+      _closing = true;
+   }
+   _changed.notify_all();
+   // Unblocks the drainer if it is waiting for the shipper
+   if( _shipper )
+      _shipper->close();
+   if( _drainer.joinable() )
+      _drainer.join();
+
+   std::lock_guard<std::mutex> writer_lock( _writer_mutex );
+   if( _writer != nullptr )
+      close_writer();
+}
+
+uint32_t es_spool::last_acknowledged_block()const
+{
+   std::lock_guard<std::mutex> lock( _mutex );
+   return _last_acknowledged_block;
+}
+
+uint32_t es_spool::last_appended_block()const
+{
+   std::lock_guard<std::mutex> lock( _mutex );
+   return _last_appended_block;
+}
+
+bool es_spool::drained()const
+{
+   std::lock_guard<std::mutex> lock( _mutex );
+   return !( _cursor < end_position() );
+}
+
+void es_spool::run_drainer()
+{
+   try
+   {
+      while( true )
+      {
+         position end;
+         fc::optional<uint32_t> rewind_to;
+         {
+            std::unique_lock<std::mutex> lock( _mutex );
+            // Wakes up from time to time to move the cursor as requests are acknowledged
+            _changed.wait_for( lock, std::chrono::milliseconds( 100 ), [this]() {
+               return _closing || _rewind_to.valid() || _read_position < end_position();
+            } );
+            if( _closing )
+               break;
+            rewind_to = _rewind_to;
+            _rewind_to.reset();
+            end = end_position();
+         }
+         update_cursor();
+
+         if( rewind_to.valid() )
+         {
+            _shipper->flush();
+            update_cursor();
+            std::lock_guard<std::mutex> lock( _mutex );
+            uint32_t found_block = 0;
+            const position found = find_block( *rewind_to, found_block );
+            if( found_block > 0 )
+            {
+               _read_position = found;
+               _cursor = found;
+               _last_acknowledged_block = found_block - 1;
+               save_cursor();
+            }
+            _last_sent_block = 0;
+            ilog( "Sending the data in the ES spool again from block ${b}", ("b", found_block) );
+            continue;
+         }
+
+         if( !( _read_position < end ) )
+            continue;
+         uint32_t first_block = 0;
+         uint32_t last_block = 0;
+         auto records = read_records( end, first_block, last_block );
+         if( records.empty() )
+            continue;
+         // Data of blocks which were popped and applied again must be stored after the original data,
+         // which may still be in flight if several connections are used
+         if( first_block <= _last_sent_block && _options.shipper.connections > 1 )
+            _shipper->flush();
+         const uint64_t number = _shipper->enqueue( std::move(records) );
+         _last_sent_block = last_block;
+         _sent.push_back( sent_request{ number, _read_position, last_block } );
+      }
+   }
+   catch( const fc::exception& e )
+   {
+      std::lock_guard<std::mutex> lock( _mutex );
+      // The shipper throws when it is closed while the drainer waits for it
+      if( !_closing )
+         elog( "Stopped sending the data in the ES spool: ${e}", ("e", e.to_detail_string()) );
+   }
+   catch( const std::exception& e )
+   {
+      elog( "Stopped sending the data in the ES spool: ${e}", ("e", e.what()) );
+   }
+
+   try
+   {
+      update_cursor();
+   }
+   catch( const fc::exception& e )
+   {
+      elog( "Unable to save the cursor of the ES spool: ${e}", ("e", e.to_detail_string()) );
+   }
+}
+
+std::vector<std::string> es_spool::read_records( const position& end, uint32_t& first_block,
+                                                 uint32_t& last_block )
+{
+   std::vector<std::string> result;
+   uint64_t total_size = 0;
+   while( _read_position < end && total_size < es_client::request_size_threshold )
+   {
+      uint64_t segment_end = 0;
+      uint32_t next_segment = _read_position.segment;
+      {
+         std::lock_guard<std::mutex> lock( _mutex );
+         for( const auto& segment : _segments )
+         {
+            if( segment.number == _read_position.segment )
+               segment_end = segment.size;
+            else if( segment.number > _read_position.segment )
+            {
+               next_segment = segment.number;
+               break;
+            }
+         }
+      }
+      if( _read_position.segment == end.segment )
+         segment_end = end.offset;
+      if( _read_position.offset >= segment_end )
+      {
+         if( next_segment == _read_position.segment )
+            break;
+         _read_position = position{ next_segment, 0 };
+         continue;
+      }
+
+      if( !_reader.is_open() || _reader_segment != _read_position.segment )
+      {
+         if( _reader.is_open() )
+            _reader.close();
+         _reader.clear();
+         _reader.open( segment_file( _read_position.segment ).generic_string().c_str(), std::ios::binary );
+         _reader_segment = _read_position.segment;
+      }
+      record_header header;
+      _reader.seekg( _read_position.offset );
+      _reader.read( (char*)&header, sizeof(header) );
+      std::string data( header.size.value(), '\0' );
+      _reader.read( &data[0], data.size() );
+      FC_ASSERT( _reader.good(), "Unable to read segment ${n} of the ES spool at ${o}",
+                 ("n", _read_position.segment)("o", _read_position.offset) );
+
+      const uint32_t block_num = header.block_num.value();
+      // A request ends where blocks were popped, see run_drainer()
+      if( !result.empty() && block_num < last_block )
+         break;
+      if( result.empty() )
+         first_block = block_num;
+      last_block = block_num;
+      total_size += data.size();
+      result.push_back( std::move(data) );
+      _read_position.offset += sizeof(header) + header.size.value();
+   }
+   return result;
+}
+
+void es_spool::update_cursor()
+{
+   const uint64_t acknowledged = _shipper->last_acknowledged();
+   if( _sent.empty() || _sent.front().number > acknowledged )
+      return;
+
+   std::lock_guard<std::mutex> lock( _mutex );
+   while( !_sent.empty() && _sent.front().number <= acknowledged )
+   {
+      _cursor = _sent.front().end;
+      _last_acknowledged_block = _sent.front().last_block;
+      _sent.pop_front();
+   }
+   save_cursor();
+   remove_old_segments();
+}
+
+void es_spool::remove_old_segments()
+{
+   // The segment being written to is always kept
+   while( _segments.size() > 1 && _segments.front().number < _cursor.segment
+          && _segments.front().last_block + _options.retain_blocks <= _last_acknowledged_block )
+   {
+      if( _reader.is_open() && _reader_segment == _segments.front().number )
+         _reader.close();
+      fc::remove_all( segment_file( _segments.front().number ) );
+      _segments.pop_front();
+   }
+}
+
+} } // end namespace graphene::utilities
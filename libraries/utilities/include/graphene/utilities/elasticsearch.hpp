@@ -22,8 +22,15 @@
  * THE SOFTWARE.
  */
 #pragma once
+#include <chrono>
+#include <condition_variable>
 #include <cstddef>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <set>
 #include <string>
+#include <thread>
 #include <vector>
 
 #include <curl/curl.h>
@@ -114,6 +121,88 @@ private:
    curl_wrapper curl;
 };
 
+/**
+ *  @brief Sends bulk requests to ES from a pool of background threads
+ *
+ *  Bulk payloads are queued by @ref enqueue, which only blocks while @ref options::max_queued payloads are
+ *  waiting or being sent.  Every worker thread has its own connection, so up to @ref options::connections
+ *  requests are in flight at a time.  Failed requests are retried with an exponential backoff.
+ *
+ *  Payloads are numbered in the order they were enqueued, starting at 1.  Since they may complete out of
+ *  order, @ref last_acknowledged returns the highest number up to which all payloads have been stored.
+ *
+ *  @note Payloads sent concurrently must not write the same document, because ES may apply them in any order.
+ */
+class es_bulk_shipper
+{
+public:
+   struct options
+   {
+      uint32_t connections = 4;
+      uint32_t max_queued = 16;
+      /// The number of times a payload is retried before the shipper gives up, 0 to keep trying forever
+      uint32_t max_retries = 0;
+      std::chrono::milliseconds initial_backoff { 100 };
+      std::chrono::milliseconds max_backoff { 10000 };
+   };
+
+   es_bulk_shipper( const std::string& base_url, const std::string& auth, const options& opts );
+   ~es_bulk_shipper();
+
+   /**
+    *  Queues a payload to be sent, waiting for room in the queue if needed
+    *  @return the number of the payload
+    *  @throws fc::exception if an earlier payload could not be sent, or if the shipper is closed
+    */
+   uint64_t enqueue( std::vector<std::string>&& bulk_lines );
+   /**
+    *  Waits until every payload enqueued so far has been stored
+    *  @throws fc::exception if a payload could not be sent
+    */
+   void flush();
+   /**
+    *  Like @ref flush, but gives up after the timeout
+    *  @return true if every payload enqueued so far has been stored
+    */
+   bool flush_for( std::chrono::milliseconds timeout );
+   /// Stops the worker threads, payloads which have not been sent yet are dropped
+   void close();
+
+   uint64_t last_acknowledged()const;
+   /// @return the number of payloads which are waiting or being sent
+   size_t   pending()const;
+
+private:
+   struct payload
+   {
+      uint64_t                 number;
+      std::vector<std::string> lines;
+   };
+
+   void run_worker( const es_client& client );
+   void acknowledge( uint64_t number );
+   void check_failure()const;
+   bool all_done()const { return _closing || !_failure.empty() || _last_acknowledged == _last_enqueued; }
+
+   const options _options;
+
+   mutable std::mutex      _mutex;
+   std::condition_variable _work_available;  ///< notified when a payload is queued or on close
+   std::condition_variable _state_changed;   ///< notified when a payload is done or failed, or on close
+
+   std::deque<payload> _queue;
+   size_t              _in_flight = 0;
+   uint64_t            _last_enqueued = 0;
+   uint64_t            _last_acknowledged = 0;
+   /// Payloads which were stored before some lower numbered one
+   std::set<uint64_t>  _acknowledged_out_of_order;
+   std::string         _failure;
+   bool                _closing = false;
+
+   std::vector<std::unique_ptr<es_client>> _clients;
+   std::vector<std::thread>                _workers;
+};
+
 std::vector<std::string> createBulk(const fc::mutable_variant_object& bulk_header, std::string&& data);
 
 struct es_data_adaptor
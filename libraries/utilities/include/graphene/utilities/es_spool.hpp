@@ -0,0 +1,183 @@
+/*
+ * Copyright (c) 2026 Contributors.
+ *
+ * The MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#pragma once
+
+#include <graphene/utilities/elasticsearch.hpp>
+
+#include <fc/filesystem.hpp>
+#include <fc/optional.hpp>
+
+#include <condition_variable>
+#include <cstdio>
+#include <deque>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace graphene { namespace utilities {
+
+/**
+ *  @brief A durable local queue of ES bulk data
+ *
+ *  Bulk lines are appended to segment files in a local directory, together with the number of the block
+ *  they belong to, and sent to ES from a background thread through an @ref es_bulk_shipper.  Appending never
+ *  waits for ES, so an ES outage does not stall the node, the data is sent once ES is reachable again.
+ *  Records are synced to disk every @ref options::sync_interval appends, when a segment is complete and
+ *  when the spool is closed.
+ *
+ *  What has been stored in ES is tracked by a cursor which is persisted in the directory, so that sending
+ *  resumes where it stopped after a restart.  Segments which have been sent are deleted, unless
+ *  @ref options::retain_blocks is set to keep them for re-exporting with @ref rewind.
+ *
+ *  Data is sent in the order it was appended.  If the shipper uses several connections, requests are only
+ *  sent in parallel while block numbers increase, i.e. data of blocks which were popped and applied again is
+ *  stored after the data of the original blocks.
+ */
+class es_spool
+{
+public:
+   struct options
+   {
+      fc::path directory;
+      /// A new segment file is started when the current one reaches this size
+      uint64_t segment_size = 64 * 1024 * 1024;
+      /// The number of blocks whose data is kept after it has been stored in ES
+      uint32_t retain_blocks = 0;
+      /// The number of records appended between syncs to disk, records not synced yet may be lost in a crash
+      uint32_t sync_interval = 16;
+      /// Options of the shipper used to send the data, retries are not limited
+      es_bulk_shipper::options shipper;
+   };
+
+   es_spool( const std::string& base_url, const std::string& auth, const options& opts );
+   ~es_spool();
+
+   /// Appends the bulk lines of the given block, to be sent in the background
+   void append( uint32_t block_num, const std::vector<std::string>& bulk_lines );
+
+   /**
+    *  Sends the data of the given block and all later blocks again, as far as it is still in the spool
+    *  @return the first block whose data will be sent again, or 0 if nothing is left to send
+    */
+   uint32_t rewind( uint32_t block_num );
+
+   /// Stops sending, data which has not been stored in ES is sent after the spool is opened again
+   void close();
+
+   /// @return the number of the block whose data has been stored in ES most recently
+   uint32_t last_acknowledged_block()const;
+   /// @return the number of the block whose data has been appended most recently
+   uint32_t last_appended_block()const;
+   /// @return true if all data appended so far has been stored in ES
+   bool     drained()const;
+
+private:
+   struct position
+   {
+      uint32_t segment = 0;
+      uint64_t offset = 0;
+
+      bool operator<( const position& other )const
+      {
+         return segment < other.segment || ( segment == other.segment && offset < other.offset );
+      }
+      bool operator==( const position& other )const
+      {
+         return segment == other.segment && offset == other.offset;
+      }
+   };
+
+   struct segment_info
+   {
+      uint32_t number = 0;
+      uint64_t size = 0;
+      uint32_t first_block = 0;
+      uint32_t last_block = 0;
+   };
+
+   /// A request which was handed to the shipper, and the position up to which it covers the spool
+   struct sent_request
+   {
+      uint64_t number;
+      position end;
+      uint32_t last_block;
+   };
+
+   fc::path segment_file( uint32_t number )const;
+   /// Finds the segments and discards incomplete records at their ends, e.g. after a crash
+   void open_segments();
+   void load_cursor();
+   void save_cursor()const;
+   /// @return the position of the first record of the given block or a later one, requires the lock
+   position find_block( uint32_t block_num, uint32_t& found_block )const;
+   /// @return the position after the last record, requires the lock
+   position end_position()const;
+
+   /// Syncs the records written to the current segment to disk, requires the writer lock
+   void sync_writer();
+   /// Syncs and closes the current segment, requires the writer lock
+   void close_writer();
+
+   void run_drainer();
+   /// Reads records starting at @ref _read_position until @p end, up to the ES request size threshold
+   std::vector<std::string> read_records( const position& end, uint32_t& first_block, uint32_t& last_block );
+   /// Moves the cursor forward to what the shipper has acknowledged, and deletes segments no longer needed
+   void update_cursor();
+   void remove_old_segments();
+
+   const options _options;
+
+   mutable std::mutex      _mutex;
+   std::condition_variable _changed;
+
+   std::deque<segment_info> _segments;
+   uint32_t                 _last_appended_block = 0;
+
+   /// Serializes appending, so that the file is written and synced without holding @ref _mutex
+   std::mutex               _writer_mutex;
+   std::FILE*               _writer = nullptr;
+   uint32_t                 _writer_segment = 0;
+   uint32_t                 _unsynced_records = 0;
+
+   /// Everything before the cursor has been stored in ES
+   position _cursor;
+   uint32_t _last_acknowledged_block = 0;
+   /// Where the drainer reads next
+   position _read_position;
+   fc::optional<uint32_t> _rewind_to;
+   bool     _closing = false;
+
+   std::ifstream _reader;
+   uint32_t      _reader_segment = 0;
+   uint32_t      _last_sent_block = 0;
+   std::deque<sent_request> _sent;
+
+   std::unique_ptr<es_bulk_shipper> _shipper;
+   std::thread                      _drainer;
+};
+
+} } // end namespace graphene::utilities
@@ -16,6 +16,15 @@ foreach( HF ${HARDFORKS} )
   string( CONCAT HARDFORK_CONTENT ${HARDFORK_CONTENT} ${INCL} )
 endforeach( HF )
 
+# Lists all hardfork times, for code which needs to know whether a hardfork lies in a time range
+string( REGEX MATCHALL "#define HARDFORK_[A-Za-z0-9_]+_TIME[ \t]" HARDFORK_TIME_DEFINES "${HARDFORK_CONTENT}" )
+set( HARDFORK_TIMES "" )
+foreach( HF_DEFINE ${HARDFORK_TIME_DEFINES} )
+  string( REGEX REPLACE "#define (HARDFORK_[A-Za-z0-9_]+_TIME)[ \t]" "\\1" HF_TIME "${HF_DEFINE}" )
+  string( CONCAT HARDFORK_TIMES "${HARDFORK_TIMES}" " \\\n   ${HF_TIME}," )
+endforeach( HF_DEFINE )
+string( CONCAT HARDFORK_CONTENT "${HARDFORK_CONTENT}" "\n#define GRAPHENE_HARDFORK_TIMES${HARDFORK_TIMES}\n" )
+
 if( EXISTS ${HARDFORK_FILE} )
   file( READ ${HARDFORK_FILE} HFF )
 
@@ -214,6 +214,13 @@ std::shared_ptr<boost::program_options::variables_map> database_fixture_base::in
       fc::set_option( options, "min-blocks-to-keep", (uint32_t)3 );
       fc::set_option( options, "max-ops-per-acc-by-min-blocks", (uint64_t)5 );
    }
+   if (fixture.current_test_name == "history_store_test")
+   {
+      fc::set_option( options, "partial-operations", true );
+      fc::set_option( options, "max-ops-per-account", (uint64_t)2 );
+      fc::set_option( options, "min-blocks-to-keep", (uint32_t)0 );
+      fc::set_option( options, "history-store-dir", boost::filesystem::path( fixture.data_dir.path() / "history" ) );
+   }
    if (fixture.current_test_name == "get_account_history_operations")
    {
       fc::set_option( options, "max-ops-per-account", (uint64_t)75 );
@@ -405,6 +412,13 @@ std::shared_ptr<boost::program_options::variables_map> database_fixture_base::in
           || fixture.current_test_name == "track_votes_committee_disabled") {
       fixture.app.chain_database()->enable_standby_votes_tracking( false );
    }
+   // benchmarks measure the overhead of history plugins by running with and without them
+   const string with_history_suffix = "_with_history";
+   const auto& test_name = fixture.current_test_name;
+   const bool without_history_plugins = ( fixture.current_suite_name == "chain_benchmarks"
+         && ( test_name.size() < with_history_suffix.size()
+              || test_name.compare( test_name.size() - with_history_suffix.size(), string::npos,
+                                    with_history_suffix ) != 0 ) );
    // load ES or AH, but not both
    if(fixture.current_test_name == "elasticsearch_account_history" ||
          fixture.current_test_name == "elasticsearch_history_api") {
@@ -423,7 +437,7 @@ std::shared_ptr<boost::program_options::variables_map> database_fixture_base::in
       BOOST_TEST_MESSAGE( string("ES index prefix is ") + fixture.es_index_prefix );
       fc::set_option( options, "elasticsearch-index-prefix", fixture.es_index_prefix );
    }
-   else if( fixture.current_suite_name != "performance_tests" )
+   else if( fixture.current_suite_name != "performance_tests" && !without_history_plugins )
    {
       fixture.app.register_plugin<graphene::account_history::account_history_plugin>(true);
    }
@@ -449,6 +463,7 @@ std::shared_ptr<boost::program_options::variables_map> database_fixture_base::in
    if( fixture.current_test_name == "asset_in_collateral"
             || fixture.current_test_name == "htlc_database_api"
             || fixture.current_test_name == "liquidity_pool_apis_test"
+            || fixture.current_test_name == "asset_holders_count"
             || fixture.current_suite_name == "database_api_tests"
             || fixture.current_suite_name == "api_limit_tests" )
    {
@@ -464,10 +479,21 @@ std::shared_ptr<boost::program_options::variables_map> database_fixture_base::in
          fc::set_option( options, "api-limit-get-storage-info", uint32_t(6) );
    }
 
-   fc::set_option( options, "bucket-size", string("[15]") );
+   if( fixture.current_test_name == "market_history_roll_up" )
+      fc::set_option( options, "bucket-size", string("[15,60,300]") );
+   else if( fixture.current_test_name == "market_history_roll_up_after_idle_gap" )
+   {
+      fc::set_option( options, "bucket-size", string("[15,60,300]") );
+      fc::set_option( options, "history-per-size", uint32_t(10) );
+   }
+   else
+      fc::set_option( options, "bucket-size", string("[15]") );
 
-   fixture.app.register_plugin<graphene::market_history::market_history_plugin>(true);
-   fixture.app.register_plugin<graphene::grouped_orders::grouped_orders_plugin>(true);
+   if( !without_history_plugins )
+   {
+      fixture.app.register_plugin<graphene::market_history::market_history_plugin>(true);
+      fixture.app.register_plugin<graphene::grouped_orders::grouped_orders_plugin>(true);
+   }
 
    return sharable_options;
 }
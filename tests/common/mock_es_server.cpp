@@ -0,0 +1,148 @@
+/*
+ * Copyright (c) 2026 Contributors.
+ *
+ * The MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#include "mock_es_server.hpp"
+
+#include <boost/algorithm/string.hpp>
+
+namespace graphene { namespace utilities {
+
+mock_es_server::mock_es_server( uint32_t failures_to_return, std::chrono::milliseconds delay )
+   : _failures_left( failures_to_return ), _delay( delay ),
+     _acceptor( _io, boost::asio::ip::tcp::endpoint( boost::asio::ip::address_v4::loopback(), 0 ) )
+{
+   _accept_thread = std::thread( [this]() { accept_loop(); } );
+}
+
+mock_es_server::~mock_es_server()
+{
+   _stopping = true;
+   // unblock the accept call
+   boost::system::error_code ec;
+   boost::asio::ip::tcp::socket socket( _io );
+   socket.connect( _acceptor.local_endpoint(), ec );
+   _accept_thread.join();
+   for( auto& connection : _connections )
+      connection.join();
+}
+
+std::string mock_es_server::url()const
+{
+   return "http://127.0.0.1:" + std::to_string( _acceptor.local_endpoint().port() ) + "/";
+}
+
+std::vector<std::string> mock_es_server::received_lines()const
+{
+   std::lock_guard<std::mutex> lock( _mutex );
+   return _lines;
+}
+
+void mock_es_server::set_failures( uint32_t failures_to_return )
+{
+   std::lock_guard<std::mutex> lock( _mutex );
+   _failures_left = failures_to_return;
+}
+
+void mock_es_server::accept_loop()
+{
+   while( !_stopping )
+   {
+      auto socket = std::make_shared<boost::asio::ip::tcp::socket>( _io );
+      boost::system::error_code ec;
+      _acceptor.accept( *socket, ec );
+      if( ec || _stopping )
+         break;
+      _connections.emplace_back( [this,socket]() { serve( *socket ); } );
+   }
+}
+
+void mock_es_server::serve( boost::asio::ip::tcp::socket& socket )
+{
+   boost::asio::streambuf buffer;
+   boost::system::error_code ec;
+   while( true )
+   {
+      const size_t header_size = boost::asio::read_until( socket, buffer, "\r\n\r\n", ec );
+      if( ec )
+         return;
+      std::string header( boost::asio::buffers_begin( buffer.data() ),
+                          boost::asio::buffers_begin( buffer.data() ) + header_size );
+      buffer.consume( header_size );
+
+      size_t content_length = 0;
+      std::vector<std::string> header_lines;
+      boost::split( header_lines, header, boost::is_any_of( "\r\n" ), boost::token_compress_on );
+      for( const auto& line : header_lines )
+      {
+         if( boost::istarts_with( line, "content-length:" ) )
+            content_length = std::stoul( boost::trim_copy( line.substr( 15 ) ) );
+         else if( boost::istarts_with( line, "expect:" ) )
+            boost::asio::write( socket, boost::asio::buffer( std::string( "HTTP/1.1 100 Continue\r\n\r\n" ) ), ec );
+      }
+      if( buffer.size() < content_length )
+         boost::asio::read( socket, buffer, boost::asio::transfer_exactly( content_length - buffer.size() ), ec );
+      if( ec )
+         return;
+      std::string body( boost::asio::buffers_begin( buffer.data() ),
+                        boost::asio::buffers_begin( buffer.data() ) + content_length );
+      buffer.consume( content_length );
+
+      const uint32_t concurrent = ++_concurrent;
+      uint32_t max_concurrent = _max_concurrent.load();
+      while( concurrent > max_concurrent && !_max_concurrent.compare_exchange_weak( max_concurrent, concurrent ) )
+         ;
+      std::this_thread::sleep_for( _delay );
+      ++_requests;
+
+      bool fail = false;
+      {
+         std::lock_guard<std::mutex> lock( _mutex );
+         if( _failures_left > 0 )
+         {
+            --_failures_left;
+            fail = true;
+         }
+         else
+         {
+            std::vector<std::string> lines;
+            boost::split( lines, body, boost::is_any_of( "\n" ), boost::token_compress_on );
+            for( auto& line : lines )
+            {
+               if( !line.empty() )
+                  _lines.push_back( std::move(line) );
+            }
+         }
+      }
+      --_concurrent;
+
+      const std::string content = fail ? R"({"error":"unavailable"})" : R"({"errors":false,"items":[]})";
+      const std::string response = std::string( fail ? "HTTP/1.1 503 Service Unavailable" : "HTTP/1.1 200 OK" )
+            + "\r\nContent-Type: application/json\r\nContent-Length: " + std::to_string( content.size() )
+            + "\r\n\r\n" + content;
+      boost::asio::write( socket, boost::asio::buffer( response ), ec );
+      if( ec )
+         return;
+   }
+}
+
+} } // graphene::utilities
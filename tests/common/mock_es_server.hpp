@@ -0,0 +1,76 @@
+/*
+ * Copyright (c) 2026 Contributors.
+ *
+ * The MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#pragma once
+
+#include <boost/asio.hpp>
+
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace graphene { namespace utilities {
+
+/**
+ * A local HTTP endpoint which answers bulk requests like ES does, failing the first few of them
+ */
+class mock_es_server
+{
+public:
+   mock_es_server( uint32_t failures_to_return, std::chrono::milliseconds delay );
+   ~mock_es_server();
+
+   std::string url()const;
+   /// The lines of all bulk requests which succeeded, in the order they were received
+   std::vector<std::string> received_lines()const;
+   /// Makes the following requests fail, e.g. to simulate an outage
+   void set_failures( uint32_t failures_to_return );
+
+   uint32_t requests()const { return _requests.load(); }
+   uint32_t max_concurrent_requests()const { return _max_concurrent.load(); }
+
+private:
+   void accept_loop();
+   /// Serves the requests of a keep-alive connection until the client closes it
+   void serve( boost::asio::ip::tcp::socket& socket );
+
+   mutable std::mutex              _mutex;
+   std::vector<std::string>        _lines;
+   uint32_t                        _failures_left;
+   const std::chrono::milliseconds _delay;
+
+   std::atomic<uint32_t>           _requests { 0 };
+   std::atomic<uint32_t>           _concurrent { 0 };
+   std::atomic<uint32_t>           _max_concurrent { 0 };
+   std::atomic<bool>               _stopping { false };
+
+   boost::asio::io_service         _io;
+   boost::asio::ip::tcp::acceptor  _acceptor;
+   std::thread                     _accept_thread;
+   std::vector<std::thread>        _connections;
+};
+
+} } // graphene::utilities
@@ -0,0 +1,486 @@
+/*
+ * Copyright (c) 2026 Contributors.
+ *
+ * The MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <boost/test/unit_test.hpp>
+
+#include <graphene/chain/database.hpp>
+
+#include <graphene/chain/account_object.hpp>
+#include <graphene/chain/asset_object.hpp>
+#include <graphene/chain/committee_member_object.hpp>
+#include <graphene/chain/market_object.hpp>
+#include <graphene/chain/witness_object.hpp>
+
+#include <fc/io/json.hpp>
+#include <fc/variant_object.hpp>
+
+#include "../common/database_fixture.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+
+using namespace graphene::chain;
+using namespace graphene::chain::test;
+
+namespace {
+
+/// Size multiplier of the synthetic chains, taken from the GRAPHENE_BENCHMARK_SCALE environment variable
+uint32_t benchmark_scale()
+{
+   const char* scale = getenv( "GRAPHENE_BENCHMARK_SCALE" );
+   if( scale == nullptr )
+      return 1;
+   return std::max<uint32_t>( 1, std::stoul( scale ) );
+}
+
+/**
+ * Latencies of one measured action.  The report is a JSON object on a single line, written to standard output
+ * and appended to the file named by the GRAPHENE_BENCHMARK_OUTPUT environment variable if it is set, so that
+ * results of different builds can be compared by scripts.
+ */
+class benchmark_result
+{
+public:
+   using clock = std::chrono::steady_clock;
+
+   benchmark_result( std::string test, std::string name ) : _test( std::move(test) ), _name( std::move(name) ) {}
+
+   /// Runs @p action once and records how long it took, counting @p items processed items for the throughput
+   template<typename Action>
+   void measure( Action&& action, uint64_t items = 1 )
+   {
+      const auto start = clock::now();
+      action();
+      _samples.push_back( std::chrono::duration_cast<std::chrono::nanoseconds>( clock::now() - start ).count() );
+      _items += items;
+   }
+
+   void report()const
+   {
+      BOOST_REQUIRE( !_samples.empty() );
+      std::vector<int64_t> sorted( _samples );
+      std::sort( sorted.begin(), sorted.end() );
+      int64_t total_ns = 0;
+      for( const int64_t ns : sorted )
+         total_ns += ns;
+      const auto percentile_us = [&sorted]( double p ) {
+         return sorted[ std::min( sorted.size() - 1, size_t( p * sorted.size() ) ) ] / 1000.0;
+      };
+
+      fc::mutable_variant_object result;
+      result( "test", _test )
+            ( "name", _name )
+            ( "samples", uint64_t( sorted.size() ) )
+            ( "items", _items )
+            ( "total_ms", total_ns / 1000000.0 )
+            ( "items_per_second", total_ns > 0 ? _items * 1e9 / total_ns : 0.0 )
+            ( "p50_us", percentile_us( 0.5 ) )
+            ( "p90_us", percentile_us( 0.9 ) )
+            ( "p99_us", percentile_us( 0.99 ) )
+            ( "max_us", sorted.back() / 1000.0 );
+      const std::string line = fc::json::to_string( result );
+
+      std::cout << line << std::endl;
+      const char* output = getenv( "GRAPHENE_BENCHMARK_OUTPUT" );
+      if( output != nullptr )
+      {
+         std::ofstream file( output, std::ios::app );
+         file << line << "\n";
+      }
+   }
+
+private:
+   std::string          _test;
+   std::string          _name;
+   std::vector<int64_t> _samples;
+   uint64_t             _items = 0;
+};
+
+struct benchmark_fixture : database_fixture
+{
+   /// Transactions pushed before a block is generated
+   static constexpr uint32_t transactions_per_block = 200;
+
+   /// Pushes a single operation without checking signatures, nor asset supplies like PUSH_TX does
+   processed_transaction push( const operation& op )
+   {
+      trx.clear();
+      set_expiration( db, trx );
+      trx.operations.push_back( op );
+      return db.push_transaction( precomputable_transaction( trx ), ~0 );
+   }
+
+   /// Generates a block after every @ref transactions_per_block calls
+   void maybe_generate_block()
+   {
+      if( ++_pushed % transactions_per_block == 0 )
+         generate_block();
+   }
+
+   vector<account_id_type> create_accounts( const string& prefix, uint32_t count, share_type core_balance )
+   {
+      vector<account_id_type> result;
+      result.reserve( count );
+      transfer_operation funding;
+      funding.from = committee_account;
+      funding.amount = asset( core_balance );
+      for( uint32_t i = 0; i < count; ++i )
+      {
+         result.push_back( create_account( prefix + std::to_string( i ) ).get_id() );
+         funding.to = result.back();
+         push( funding );
+         maybe_generate_block();
+      }
+      generate_block();
+      return result;
+   }
+
+   asset_id_type create_issued_asset( const string& symbol, const vector<account_id_type>& holders,
+                                      share_type amount_each )
+   {
+      const asset_object& new_asset = create_user_issued_asset( symbol );
+      asset_issue_operation issue;
+      issue.issuer = new_asset.issuer;
+      issue.asset_to_issue = new_asset.amount( amount_each );
+      for( const auto& holder : holders )
+      {
+         issue.issue_to_account = holder;
+         push( issue );
+         maybe_generate_block();
+      }
+      generate_block();
+      return new_asset.get_id();
+   }
+
+   limit_order_create_operation make_order( account_id_type seller, const asset& amount, const asset& min_to_receive )
+   {
+      limit_order_create_operation order;
+      order.seller = seller;
+      order.amount_to_sell = amount;
+      order.min_to_receive = min_to_receive;
+      order.expiration = time_point_sec::maximum();
+      return order;
+   }
+
+   /// Generates a block, then measures popping it and pushing it again
+   void measure_block( benchmark_result& generated, benchmark_result& popped, benchmark_result& applied,
+                       uint64_t transactions )
+   {
+      signed_block block;
+      generated.measure( [&]() { block = generate_block(); }, transactions );
+      popped.measure( [&]() { db.pop_block(); }, transactions );
+      applied.measure( [&]() { PUSH_BLOCK( db, block, database::skip_transaction_signatures ); }, transactions );
+   }
+
+   /// Transfers and orders crossing a book, run with and without the history plugins
+   void run_history_workload()
+   {
+      const string test = current_test_name;
+      const uint32_t scale = benchmark_scale();
+      const auto accounts = create_accounts( "trader", 200, 1000000000 );
+      const asset_id_type token = create_issued_asset( "TOKEN", accounts, 1000000000 );
+
+      benchmark_result transfers( test, "transfer" );
+      benchmark_result orders( test, "limit_order_create_filled" );
+      benchmark_result generated( test, "generate_block" );
+      benchmark_result popped( test, "pop_block" );
+      benchmark_result applied( test, "push_block" );
+
+      transfer_operation xfer;
+      xfer.amount = asset( 10 );
+      for( uint32_t i = 0; i < 5000 * scale; ++i )
+      {
+         const account_id_type from = accounts[ i % accounts.size() ];
+         const account_id_type to = accounts[ ( i + 1 ) % accounts.size() ];
+         xfer.from = from;
+         xfer.to = to;
+         transfers.measure( [&]() { push( xfer ); } );
+         // Every other trader sells tokens to the previous one, which filled orders are recorded by the plugins
+         if( i % 2 == 0 )
+            orders.measure( [&]() { push( make_order( from, asset( 100, token ), asset( 1000 ) ) ); } );
+         else
+            orders.measure( [&]() { push( make_order( from, asset( 1000 ), asset( 100, token ) ) ); } );
+         if( i % ( transactions_per_block / 2 ) == transactions_per_block / 2 - 1 )
+            measure_block( generated, popped, applied, transactions_per_block );
+      }
+
+      transfers.report();
+      orders.report();
+      generated.report();
+      popped.report();
+      applied.report();
+   }
+
+private:
+   uint32_t _pushed = 0;
+};
+
+} // namespace
+
+BOOST_FIXTURE_TEST_SUITE( chain_benchmarks, benchmark_fixture )
+
+BOOST_AUTO_TEST_CASE( transfers )
+{ try {
+   const uint32_t scale = benchmark_scale();
+   const auto accounts = create_accounts( "xfer", 1000 * scale, 1000000000 );
+
+   benchmark_result pushed( "transfers", "push_transaction" );
+   benchmark_result generated( "transfers", "generate_block" );
+   benchmark_result popped( "transfers", "pop_block" );
+   benchmark_result applied( "transfers", "push_block" );
+
+   transfer_operation xfer;
+   xfer.amount = asset( 10 );
+   for( uint32_t i = 0; i < 20000 * scale; ++i )
+   {
+      xfer.from = accounts[ i % accounts.size() ];
+      xfer.to = accounts[ ( i + 1 ) % accounts.size() ];
+      pushed.measure( [&]() { push( xfer ); } );
+      if( i % transactions_per_block == transactions_per_block - 1 )
+         measure_block( generated, popped, applied, transactions_per_block );
+   }
+
+   pushed.report();
+   generated.report();
+   popped.report();
+   applied.report();
+} FC_LOG_AND_RETHROW() }
+
+BOOST_AUTO_TEST_CASE( limit_orders_deep_book )
+{ try {
+   const uint32_t scale = benchmark_scale();
+   const uint32_t depth = 5000 * scale;
+   const auto makers = create_accounts( "maker", 100, int64_t( 100000000 ) * scale );
+   const asset_id_type book = create_issued_asset( "BOOK", makers, int64_t( 1000000 ) * scale );
+
+   // Asks sell 100 BOOK for at least 100 CORE each, bids pay less than 100 CORE for one BOOK
+   benchmark_result resting( "limit_orders_deep_book", "limit_order_create_resting" );
+   vector<limit_order_id_type> asks;
+   asks.reserve( depth );
+   for( uint32_t i = 0; i < depth; ++i )
+   {
+      const account_id_type maker = makers[ i % makers.size() ];
+      resting.measure( [&]() {
+         const auto result = push( make_order( maker, asset( 100, book ), asset( 10000 + i ) ) );
+         asks.emplace_back( result.operation_results[0].get<object_id_type>() );
+      } );
+      maybe_generate_block();
+      resting.measure( [&]() { push( make_order( maker, asset( 10000 ), asset( 101 + i, book ) ) ); } );
+      maybe_generate_block();
+   }
+   generate_block();
+   BOOST_CHECK_EQUAL( db.get_index_type<limit_order_index>().indices().size(), 2u * depth );
+
+   // Each taker fills about 5 of the best bids
+   benchmark_result crossing( "limit_orders_deep_book", "limit_order_create_filled" );
+   benchmark_result cancelled( "limit_orders_deep_book", "limit_order_cancel" );
+   for( uint32_t i = 0; i < depth / 5; ++i )
+   {
+      const account_id_type taker = makers[ i % makers.size() ];
+      crossing.measure( [&]() { push( make_order( taker, asset( 500, book ), asset( 1 ) ) ); } );
+      maybe_generate_block();
+   }
+   generate_block();
+
+   // The takers only filled bids, cancel the asks from the far end of the book
+   limit_order_cancel_operation cancel;
+   for( uint32_t i = 0; i < depth / 5; ++i )
+   {
+      cancel.order = asks[ depth - 1 - i ];
+      cancel.fee_paying_account = makers[ ( depth - 1 - i ) % makers.size() ];
+      cancelled.measure( [&]() { push( cancel ); } );
+      maybe_generate_block();
+   }
+
+   resting.report();
+   crossing.report();
+   cancelled.report();
+} FC_LOG_AND_RETHROW() }
+
+BOOST_AUTO_TEST_CASE( margin_calls )
+{ try {
+   const uint32_t scale = benchmark_scale();
+   const uint32_t borrowers_count = 500 * scale;
+
+   ACTOR( feedproducer );
+   const asset_object& usd = create_bitasset( "USDBIT", feedproducer_id );
+   const asset_id_type usd_id = usd.get_id();
+   const asset_object& core = asset_id_type()( db );
+   update_feed_producers( usd, { feedproducer_id } );
+   price_feed feed;
+   feed.maintenance_collateral_ratio = 1750;
+   feed.maximum_short_squeeze_ratio = 1500;
+   feed.settlement_price = usd.amount( 1 ) / core.amount( 5 );
+   publish_feed( usd, feedproducer_id( db ), feed );
+
+   const auto borrowers = create_accounts( "borrower", borrowers_count, 1000 );
+
+   // Every borrower has a collateral ratio of 3 or more, and sells the debt for 11 to 14 CORE per USD
+   benchmark_result borrowed( "margin_calls", "call_order_update" );
+   for( uint32_t i = 0; i < borrowers_count; ++i )
+   {
+      call_order_update_operation borrow_op;
+      borrow_op.funding_account = borrowers[i];
+      borrow_op.delta_collateral = core.amount( 150 + i % 20 );
+      borrow_op.delta_debt = asset( 10, usd_id );
+      borrowed.measure( [&]() { push( borrow_op ); } );
+      push( make_order( borrowers[i], asset( 10, usd_id ), core.amount( 110 + i % 30 ) ) );
+      maybe_generate_block();
+   }
+   generate_block();
+
+   const auto& calls = db.get_index_type<call_order_index>().indices();
+   const size_t calls_before = calls.size();
+
+   // Halving the value of the collateral puts every position into margin call
+   asset_publish_feed_operation publish;
+   publish.publisher = feedproducer_id;
+   publish.asset_id = usd_id;
+   publish.feed = feed;
+   publish.feed.settlement_price = usd.amount( 1 ) / core.amount( 10 );
+   publish.feed.core_exchange_rate = publish.feed.settlement_price;
+
+   benchmark_result margin_called( "margin_calls", "asset_publish_feed_with_margin_calls" );
+   margin_called.measure( [&]() { push( publish ); } );
+   const size_t filled = calls_before - calls.size();
+   BOOST_CHECK_GT( filled, 0u );
+   BOOST_TEST_MESSAGE( "Margin calls filled: " + std::to_string( filled ) );
+
+   benchmark_result generated( "margin_calls", "generate_block" );
+   benchmark_result popped( "margin_calls", "pop_block" );
+   benchmark_result applied( "margin_calls", "push_block" );
+   measure_block( generated, popped, applied, filled );
+
+   borrowed.report();
+   margin_called.report();
+   generated.report();
+   popped.report();
+   applied.report();
+} FC_LOG_AND_RETHROW() }
+
+BOOST_AUTO_TEST_CASE( maintenance_tally )
+{ try {
+   const uint32_t scale = benchmark_scale();
+   const uint32_t witness_count = 100;
+   const uint32_t committee_count = 50;
+
+   vector<vote_id_type> witness_votes;
+   vector<vote_id_type> committee_votes;
+   for( uint32_t i = 0; i < witness_count; ++i )
+      witness_votes.push_back( create_witness( create_account( "witness" + std::to_string( i ) ) ).vote_id );
+   for( uint32_t i = 0; i < committee_count; ++i )
+      committee_votes.push_back(
+            create_committee_member( create_account( "committee" + std::to_string( i ) ) ).vote_id );
+   generate_block();
+
+   const auto voters = create_accounts( "voter", 5000 * scale, 100000 );
+   benchmark_result voted( "maintenance_tally", "account_update_votes" );
+   for( uint32_t i = 0; i < voters.size(); ++i )
+   {
+      account_update_operation update;
+      update.account = voters[i];
+      update.new_options = voters[i]( db ).options;
+      for( uint32_t k = 0; k < 10; ++k )
+         update.new_options->votes.insert( witness_votes[ ( i + k * 7 ) % witness_count ] );
+      for( uint32_t k = 0; k < 5; ++k )
+         update.new_options->votes.insert( committee_votes[ ( i + k * 3 ) % committee_count ] );
+      voted.measure( [&]() { push( update ); } );
+      maybe_generate_block();
+   }
+   generate_block();
+
+   benchmark_result maintenance( "maintenance_tally", "maintenance_block" );
+   for( uint32_t round = 0; round < 3; ++round )
+   {
+      const auto next_maintenance = db.get_dynamic_global_properties().next_maintenance_time;
+      maintenance.measure( [&]() { generate_blocks( next_maintenance ); }, voters.size() );
+      BOOST_CHECK( db.get_dynamic_global_properties().next_maintenance_time > next_maintenance );
+   }
+
+   voted.report();
+   maintenance.report();
+} FC_LOG_AND_RETHROW() }
+
+BOOST_AUTO_TEST_CASE( flush_and_open )
+{ try {
+   const uint32_t scale = benchmark_scale();
+   const auto accounts = create_accounts( "holder", 5000 * scale, 1000000 );
+   const asset_id_type token = create_issued_asset( "TOKEN", accounts, 1000000 );
+   for( uint32_t i = 0; i < accounts.size(); ++i )
+   {
+      push( make_order( accounts[i], asset( 100, token ), asset( 1000 + i ) ) );
+      maybe_generate_block();
+   }
+   generate_block();
+
+   const uint64_t objects = db.get_index_type<account_index>().indices().size()
+                          + db.get_index_type<account_balance_index>().indices().size()
+                          + db.get_index_type<limit_order_index>().indices().size();
+   benchmark_result flushed( "flush_and_open", "flush" );
+   benchmark_result flushed_incrementally( "flush_and_open", "flush_incremental" );
+   benchmark_result opened( "flush_and_open", "open" );
+   transfer_operation xfer;
+   xfer.amount = asset( 10 );
+   for( uint32_t round = 0; round < 3; ++round )
+   {
+      flushed.measure( [&]() { db.flush(); }, objects );
+
+      // A small part of the state changes between incremental flushes
+      for( uint32_t i = 0; i < 1000; ++i )
+      {
+         xfer.from = accounts[ i % accounts.size() ];
+         xfer.to = accounts[ ( i + round + 1 ) % accounts.size() ];
+         push( xfer );
+         maybe_generate_block();
+      }
+      generate_block();
+      flushed_incrementally.measure( [&]() { db.flush_incremental(); } );
+
+      opened.measure( [&]() {
+         database reopened;
+         reopened.object_database::open( db.get_data_dir() );
+         BOOST_CHECK_EQUAL( reopened.get_index_type<account_index>().indices().size(),
+                            db.get_index_type<account_index>().indices().size() );
+      }, objects );
+   }
+
+   flushed.report();
+   flushed_incrementally.report();
+   opened.report();
+} FC_LOG_AND_RETHROW() }
+
+BOOST_AUTO_TEST_CASE( history_plugins )
+{ try {
+   run_history_workload();
+} FC_LOG_AND_RETHROW() }
+
+BOOST_AUTO_TEST_CASE( history_plugins_with_history )
+{ try {
+   run_history_workload();
+} FC_LOG_AND_RETHROW() }
+
+BOOST_AUTO_TEST_SUITE_END()
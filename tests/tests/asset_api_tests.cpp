@@ -81,4 +81,45 @@ BOOST_AUTO_TEST_CASE( api_limit_get_asset_holders )
    BOOST_REQUIRE_EQUAL( holders.size(), 4u );
 }
 
+BOOST_AUTO_TEST_CASE( asset_holders_count )
+{ try {
+   graphene::app::asset_api asset_api(app);
+
+   const auto& counts = db.get_index_type< primary_index< account_balance_index > >()
+                           .get_secondary_index< graphene::api_helper_indexes::asset_holders_count_index >();
+   const auto scan_count = [this]( asset_id_type asset_id ) {
+      const auto& bal_idx = db.get_index_type< account_balance_index >().indices().get< by_asset_balance >();
+      return int64_t( boost::distance( bal_idx.equal_range( boost::make_tuple( asset_id ) ) ) ) - 1;
+   };
+
+   ACTORS( (dan)(bob)(alice) );
+   const asset_id_type usd_id = create_user_issued_asset( "USD" ).get_id();
+   issue_uia( dan_id, asset( 1000, usd_id ) );
+   issue_uia( bob_id, asset( 1000, usd_id ) );
+
+   transfer( account_id_type(), dan_id, asset(100) );
+   transfer( account_id_type(), alice_id, asset(200) );
+   generate_block();
+
+   BOOST_CHECK_EQUAL( counts.get_balance_count( usd_id ), 2 );
+   BOOST_CHECK_EQUAL( asset_api.get_asset_holders_count( "USD" ), scan_count( usd_id ) );
+   BOOST_CHECK_EQUAL( asset_api.get_asset_holders_count( "BTS" ), scan_count( asset_id_type() ) );
+
+   // Emptied balances are still counted, like when going through the balances
+   transfer( bob_id, dan_id, asset( 1000, usd_id ) );
+   issue_uia( alice_id, asset( 1, usd_id ) );
+   BOOST_CHECK_EQUAL( counts.get_balance_count( usd_id ), 3 );
+   BOOST_CHECK_EQUAL( asset_api.get_asset_holders_count( std::string( usd_id ) ),
+                      scan_count( usd_id ) );
+
+   // Counts are restored when changes are undone
+   db.clear_pending();
+   BOOST_CHECK_EQUAL( counts.get_balance_count( usd_id ), 2 );
+
+   const auto all_holders = asset_api.get_all_asset_holders();
+   BOOST_REQUIRE_EQUAL( all_holders.size(), db.get_index_type<asset_index>().indices().size() );
+   for( const auto& holders : all_holders )
+      BOOST_CHECK_EQUAL( holders.count, scan_count( holders.asset_id ) );
+} FC_LOG_AND_RETHROW() }
+
 BOOST_AUTO_TEST_SUITE_END()
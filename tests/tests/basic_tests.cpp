@@ -32,6 +32,8 @@
 
 #include <graphene/db/simple_index.hpp>
 
+#include <graphene/protocol/signature_key_cache.hpp>
+
 #include <fc/crypto/digest.hpp>
 #include <fc/crypto/hex.hpp>
 #include "../common/database_fixture.hpp"
@@ -641,6 +643,49 @@ BOOST_AUTO_TEST_CASE( merkle_root )
    BOOST_CHECK( block.calculate_merkle_root() == c(dO) );
 }
 
+BOOST_AUTO_TEST_CASE( signature_key_cache_test )
+{ try {
+   const chain_id_type chain_id = fc::sha256::hash( std::string( "signature_key_cache_test" ) );
+   auto key1 = generate_private_key( "1" );
+   auto key2 = generate_private_key( "2" );
+
+   signed_transaction trx;
+   trx.expiration = fc::time_point_sec( 1000 );
+   trx.sign( key1, chain_id );
+   trx.sign( key2, chain_id );
+
+   signature_key_cache cache( 32 );
+   const digest_type digest = trx.sig_digest( chain_id );
+   BOOST_CHECK( cache.recover( digest, trx.signatures[0] ) == public_key_type( key1.get_public_key() ) );
+   BOOST_CHECK_EQUAL( cache.size(), 1u );
+   // found in the cache
+   BOOST_CHECK( cache.recover( digest, trx.signatures[0] ) == public_key_type( key1.get_public_key() ) );
+   BOOST_CHECK_EQUAL( cache.size(), 1u );
+
+   // a transaction fills the cache with its keys
+   precomputable_transaction ptrx( trx );
+   const flat_set<public_key_type>& keys = ptrx.get_signature_keys( chain_id, cache );
+   BOOST_CHECK( keys == trx.get_signature_keys( chain_id ) );
+   BOOST_CHECK_EQUAL( cache.size(), 2u );
+
+   // the cache does not grow beyond its capacity
+   for( int i = 0; i < 100; ++i )
+   {
+      signed_transaction other;
+      other.expiration = fc::time_point_sec( 2000 + i );
+      other.sign( key1, chain_id );
+      BOOST_CHECK( cache.recover( other.sig_digest( chain_id ), other.signatures[0] )
+                   == public_key_type( key1.get_public_key() ) );
+   }
+   BOOST_CHECK_LE( cache.size(), cache.get_capacity() );
+
+   // a disabled cache recovers keys without storing them
+   cache.set_capacity( 0 );
+   BOOST_CHECK_EQUAL( cache.size(), 0u );
+   BOOST_CHECK( cache.recover( digest, trx.signatures[1] ) == public_key_type( key2.get_public_key() ) );
+   BOOST_CHECK_EQUAL( cache.size(), 0u );
+} FC_LOG_AND_RETHROW() }
+
 /**
  * Reproduces https://github.com/bitshares/bitshares-core/issues/888 and tests fix for it.
  */
@@ -41,6 +41,9 @@
 #include <fc/crypto/digest.hpp>
 #include <fc/io/fstream.hpp>
 
+#include <atomic>
+#include <thread>
+
 #include "../common/database_fixture.hpp"
 
 using namespace graphene::chain;
@@ -101,6 +104,9 @@ BOOST_AUTO_TEST_CASE( block_database_test )
          fetch = bdb.fetch_optional( b.id() );
          FC_ASSERT( fetch.valid() );
          FC_ASSERT( fetch->witness ==  b.witness );
+         auto packed = bdb.fetch_packed( b.id() );
+         FC_ASSERT( packed.valid() );
+         FC_ASSERT( *packed == fc::raw::pack( b ) );
       }
 
       for( uint32_t i = 1; i < 5; ++i )
@@ -133,6 +139,59 @@ BOOST_AUTO_TEST_CASE( block_database_test )
    }
 }
 
+BOOST_AUTO_TEST_CASE( block_database_concurrent_read_test )
+{
+   try {
+      fc::temp_directory data_dir( graphene::utilities::temp_directory_path() );
+
+      block_database bdb;
+      bdb.open( data_dir.path() );
+
+      const uint32_t num_blocks = 200;
+      std::vector<block_id_type> ids;
+      clearable_block b;
+      for( uint32_t i = 0; i < num_blocks; ++i )
+      {
+         if( i > 0 ) b.previous = b.id();
+         b.witness = witness_id_type(i+1);
+         b.clear();
+         ids.push_back( b.id() );
+         bdb.store( b.id(), b );
+      }
+      BOOST_CHECK_EQUAL( bdb.total_block_size(), fc::file_size( data_dir.path() / "blocks" ) );
+
+      std::atomic<uint32_t> failures { 0 };
+      std::vector<std::thread> readers;
+      for( uint32_t t = 0; t < 4; ++t )
+         readers.emplace_back( [&bdb,&ids,&failures,num_blocks,t]() {
+            for( uint32_t i = t; i < num_blocks; i += 2 )
+            {
+               auto blk = bdb.fetch_by_number( i+1 );
+               if( !blk.valid() || blk->witness != witness_id_type(i+1) || !bdb.contains( ids[i] )
+                     || bdb.fetch_block_id( i+1 ) != ids[i] )
+                  ++failures;
+            }
+         } );
+      for( auto& reader : readers )
+         reader.join();
+      BOOST_CHECK_EQUAL( failures.load(), 0u );
+
+      // removed blocks are no longer reported, reopening recovers the last valid entry
+      bdb.remove( ids.back() );
+      BOOST_CHECK( !bdb.contains( ids.back() ) );
+      bdb.close();
+      bdb.open( data_dir.path() );
+      auto last_id = bdb.last_id();
+      BOOST_REQUIRE( last_id.valid() );
+      BOOST_CHECK( *last_id == ids[num_blocks-2] );
+      BOOST_CHECK( !bdb.fetch_by_number( num_blocks ).valid() );
+
+   } catch (fc::exception& e) {
+      edump((e.to_detail_string()));
+      throw;
+   }
+}
+
 BOOST_AUTO_TEST_CASE( generate_empty_blocks )
 {
    try {
@@ -511,6 +570,40 @@ BOOST_AUTO_TEST_CASE( fork_db_tests )
      FC_ASSERT( head && head->data.block_num() == 2001, "", ("head",head->data.block_num()) );
   } FC_LOG_AND_RETHROW() 
 }
+BOOST_AUTO_TEST_CASE( shared_blocks )
+{
+   try {
+      fc::temp_directory data_dir1( graphene::utilities::temp_directory_path() );
+      fc::temp_directory data_dir2( graphene::utilities::temp_directory_path() );
+
+      database db1;
+      db1.open(data_dir1.path(), make_genesis, "TEST");
+      database db2;
+      db2.open(data_dir2.path(), make_genesis, "TEST");
+
+      auto init_account_priv_key  = fc::ecc::private_key::regenerate(fc::sha256::hash(string("null_key")) );
+
+      for( uint32_t i = 0; i < 5; ++i )
+      {
+         const uint32_t slot = ( i == 0 ) ? db1.get_slot_at_time( fc::time_point::now() ) : 1;
+         const auto b = std::make_shared<const signed_block>(
+               db1.generate_block( db1.get_slot_time(slot), db1.get_scheduled_witness(slot),
+                                   init_account_priv_key, database::skip_nothing ) );
+         db2.push_block( b );
+
+         // the fork database keeps the pushed block instead of a copy of it
+         BOOST_CHECK( b.use_count() > 1 );
+
+         const auto packed = db2.fetch_packed_block_by_id( b->id() );
+         BOOST_REQUIRE( packed.valid() );
+         BOOST_CHECK( *packed == fc::raw::pack( *b ) );
+         BOOST_CHECK( db2.fetch_block_by_id( b->id() )->id() == b->id() );
+      }
+
+      BOOST_CHECK( !db2.fetch_packed_block_by_id( block_id_type() ).valid() );
+   } FC_LOG_AND_RETHROW()
+}
+
 BOOST_AUTO_TEST_CASE( out_of_order_blocks )
 {
    try {
@@ -1385,6 +1478,206 @@ BOOST_FIXTURE_TEST_CASE( transaction_invalidated_in_cache, database_fixture )
    }
 }
 
+BOOST_FIXTURE_TEST_CASE( pending_transactions_reapplied, database_fixture )
+{
+   try
+   {
+      ACTORS( (alice)(bob)(carol)(dan) );
+      transfer( account_id_type(), alice_id, asset( 10000 ) );
+      transfer( account_id_type(), bob_id, asset( 10000 ) );
+      transfer( account_id_type(), carol_id, asset( 10000 ) );
+      transfer( account_id_type(), dan_id, asset( 10000 ) );
+      generate_block( database::skip_transaction_signatures );
+
+      fc::temp_directory data_dir2( graphene::utilities::temp_directory_path() );
+
+      database db2;
+      {
+         std::string genesis_json;
+         fc::read_file_contents( data_dir.path() / "genesis.json", genesis_json );
+         genesis_state_type genesis = fc::json::from_string( genesis_json ).as<genesis_state_type>( 50 );
+         genesis.initial_chain_id = fc::sha256::hash( genesis_json );
+         db2.open(data_dir2.path(), [&genesis] () { return genesis; }, "TEST");
+      }
+      while( db2.head_block_num() < db.head_block_num() )
+      {
+         optional< signed_block > b = db.fetch_block_by_number( db2.head_block_num()+1 );
+         db2.push_block(*b, database::skip_witness_signature
+                           |database::skip_transaction_signatures );
+      }
+
+      auto make_transfer = [&]( account_id_type from, const fc::ecc::private_key& key, account_id_type to,
+                                share_type amount ) -> signed_transaction
+      {
+         signed_transaction tx;
+         transfer_operation xfer_op;
+         xfer_op.from = from;
+         xfer_op.to = to;
+         xfer_op.amount = asset( amount );
+         tx.operations.push_back( xfer_op );
+         set_expiration( db, tx );
+         sign( tx, key );
+         return tx;
+      };
+
+      // Evaluations of pending transactions and of transactions in pushed blocks are counted
+      db.enable_evaluator_profiling( true );
+      const auto transfer_evaluations = [this]() {
+         const auto profile = db.get_evaluator_profiler()->get_profile();
+         for( const auto& op : profile.operations )
+         {
+            if( op.operation == "transfer_operation" )
+               return op.evaluate.count;
+         }
+         return uint64_t(0);
+      };
+
+      // Alice's transfer is pending in db, and a block from db2 contains an unrelated transfer from Carol
+      signed_transaction tx_alice = make_transfer( alice_id, alice_private_key, bob_id, 1000 );
+      signed_transaction tx_carol = make_transfer( carol_id, carol_private_key, dan_id, 2000 );
+      PUSH_TX( db, tx_alice );
+      PUSH_TX( db2, tx_carol );
+      BOOST_CHECK_EQUAL( db.get_balance( bob_id, asset_id_type() ).amount.value, 11000 );
+      auto evaluations = transfer_evaluations();
+
+      signed_block b = db2.generate_block( db2.get_slot_time(1), db2.get_scheduled_witness(1),
+                                           init_account_priv_key, database::skip_nothing );
+      PUSH_BLOCK( db, b );
+
+      // Only Carol's transfer was evaluated, Alice's was reapplied
+      BOOST_CHECK_EQUAL( transfer_evaluations(), evaluations + 1 );
+      BOOST_CHECK( db.is_known_transaction( tx_alice.id() ) );
+      BOOST_CHECK_EQUAL( db.get_balance( alice_id, asset_id_type() ).amount.value, 9000 );
+      BOOST_CHECK_EQUAL( db.get_balance( bob_id, asset_id_type() ).amount.value, 11000 );
+      BOOST_CHECK_EQUAL( db.get_balance( carol_id, asset_id_type() ).amount.value, 8000 );
+      BOOST_CHECK_EQUAL( db.get_balance( dan_id, asset_id_type() ).amount.value, 12000 );
+
+      // A block spending Alice's balance makes her pending transfer fail when evaluated again
+      signed_transaction tx_alice2 = make_transfer( alice_id, alice_private_key, dan_id, 9500 );
+      PUSH_TX( db2, tx_alice2 );
+      b = db2.generate_block( db2.get_slot_time(1), db2.get_scheduled_witness(1),
+                              init_account_priv_key, database::skip_nothing );
+      PUSH_BLOCK( db, b );
+
+      BOOST_CHECK( !db.is_known_transaction( tx_alice.id() ) );
+      BOOST_CHECK_EQUAL( db.get_balance( alice_id, asset_id_type() ).amount.value, 500 );
+      BOOST_CHECK_EQUAL( db.get_balance( bob_id, asset_id_type() ).amount.value, 10000 );
+      BOOST_CHECK_EQUAL( db.get_balance( dan_id, asset_id_type() ).amount.value, 21500 );
+
+      // A transfer reapplied from its recorded effects is evaluated again when a block is generated from it
+      signed_transaction tx_alice3 = make_transfer( alice_id, alice_private_key, bob_id, 100 );
+      PUSH_TX( db, tx_alice3 );
+      evaluations = transfer_evaluations();
+      b = db2.generate_block( db2.get_slot_time(1), db2.get_scheduled_witness(1),
+                              init_account_priv_key, database::skip_nothing );
+      PUSH_BLOCK( db, b );
+      BOOST_CHECK( db.is_known_transaction( tx_alice3.id() ) );
+      BOOST_CHECK_EQUAL( transfer_evaluations(), evaluations );
+
+      b = db.generate_block( db.get_slot_time(1), db.get_scheduled_witness(1),
+                             init_account_priv_key, database::skip_nothing );
+      BOOST_CHECK_EQUAL( b.transactions.size(), 1u );
+      // When the block was generated and when it was applied
+      BOOST_CHECK_EQUAL( transfer_evaluations(), evaluations + 2 );
+      BOOST_CHECK_EQUAL( db.get_balance( bob_id, asset_id_type() ).amount.value, 10100 );
+   }
+   catch (fc::exception& e)
+   {
+      edump((e.to_detail_string()));
+      throw;
+   }
+}
+
+BOOST_FIXTURE_TEST_CASE( authorities_prechecked_in_block, database_fixture )
+{
+   try
+   {
+      ACTORS( (alice)(bob)(carol) );
+      transfer( account_id_type(), alice_id, asset( 10000 ) );
+      transfer( account_id_type(), bob_id, asset( 10000 ) );
+      transfer( account_id_type(), carol_id, asset( 10000 ) );
+      generate_block( database::skip_transaction_signatures );
+
+      fc::temp_directory data_dir2( graphene::utilities::temp_directory_path() );
+
+      database db2;
+      {
+         std::string genesis_json;
+         fc::read_file_contents( data_dir.path() / "genesis.json", genesis_json );
+         genesis_state_type genesis = fc::json::from_string( genesis_json ).as<genesis_state_type>( 50 );
+         genesis.initial_chain_id = fc::sha256::hash( genesis_json );
+         db2.open(data_dir2.path(), [&genesis] () { return genesis; }, "TEST");
+      }
+      while( db2.head_block_num() < db.head_block_num() )
+      {
+         optional< signed_block > b = db.fetch_block_by_number( db2.head_block_num()+1 );
+         db2.push_block(*b, database::skip_witness_signature
+                           |database::skip_transaction_signatures );
+      }
+
+      auto make_transfer = [&]( account_id_type from, const fc::ecc::private_key& key, share_type amount )
+      {
+         signed_transaction tx;
+         transfer_operation xfer_op;
+         xfer_op.from = from;
+         xfer_op.to = account_id_type();
+         xfer_op.amount = asset( amount );
+         tx.operations.push_back( xfer_op );
+         set_expiration( db, tx );
+         sign( tx, key );
+         return tx;
+      };
+      auto make_key_update = [&]( const fc::ecc::private_key& key, const fc::ecc::private_key& new_key )
+      {
+         signed_transaction tx;
+         account_update_operation update_op;
+         update_op.account = alice_id;
+         update_op.active = authority( 1, public_key_type( new_key.get_public_key() ), 1 );
+         tx.operations.push_back( update_op );
+         set_expiration( db, tx );
+         sign( tx, key );
+         return tx;
+      };
+      auto generate_block2 = [&]( uint32_t skip ) {
+         return db2.generate_block( db2.get_slot_time(1), db2.get_scheduled_witness(1), init_account_priv_key,
+                                    skip );
+      };
+
+      // Independent transactions
+      PUSH_TX( db2, make_transfer( alice_id, alice_private_key, 100 ) );
+      PUSH_TX( db2, make_transfer( bob_id, bob_private_key, 200 ) );
+      PUSH_TX( db2, make_transfer( carol_id, carol_private_key, 300 ) );
+      PUSH_BLOCK( db, generate_block2( database::skip_nothing ) );
+      BOOST_CHECK_EQUAL( db.get_balance( alice_id, asset_id_type() ).amount.value, 9900 );
+      BOOST_CHECK_EQUAL( db.get_balance( bob_id, asset_id_type() ).amount.value, 9800 );
+      BOOST_CHECK_EQUAL( db.get_balance( carol_id, asset_id_type() ).amount.value, 9700 );
+
+      // A transaction signed with a key which is only authorized by an earlier transaction of the block
+      const fc::ecc::private_key alice_new_key = generate_private_key( "alice_new" );
+      PUSH_TX( db2, make_transfer( bob_id, bob_private_key, 200 ) );
+      PUSH_TX( db2, make_key_update( alice_private_key, alice_new_key ) );
+      PUSH_TX( db2, make_transfer( alice_id, alice_new_key, 100 ) );
+      PUSH_BLOCK( db, generate_block2( database::skip_nothing ) );
+      BOOST_CHECK_EQUAL( db.get_balance( alice_id, asset_id_type() ).amount.value, 9800 );
+      BOOST_CHECK( alice_id(db).active.key_auths.count( public_key_type( alice_new_key.get_public_key() ) ) == 1 );
+
+      // A transaction signed with a key which is no longer authorized by an earlier transaction of the block
+      PUSH_TX( db2, make_transfer( carol_id, carol_private_key, 300 ) );
+      PUSH_TX( db2, make_key_update( alice_new_key, alice_private_key ) );
+      PUSH_TX( db2, make_transfer( alice_id, alice_new_key, 100 ), database::skip_transaction_signatures );
+      signed_block bad_block = generate_block2( database::skip_transaction_signatures );
+      BOOST_CHECK_EQUAL( bad_block.transactions.size(), 3u );
+      GRAPHENE_REQUIRE_THROW( PUSH_BLOCK( db, bad_block ), fc::exception );
+      BOOST_CHECK_EQUAL( db.get_balance( alice_id, asset_id_type() ).amount.value, 9800 );
+      BOOST_CHECK_EQUAL( db.get_balance( carol_id, asset_id_type() ).amount.value, 9700 );
+   }
+   catch (fc::exception& e)
+   {
+      edump((e.to_detail_string()));
+      throw;
+   }
+}
+
 BOOST_AUTO_TEST_CASE( genesis_reserve_ids )
 {
    try
@@ -1949,4 +2242,37 @@ BOOST_FIXTURE_TEST_CASE( block_size_test, database_fixture )
    }
 }
 
+BOOST_FIXTURE_TEST_CASE( generate_block_from_pending_state, database_fixture )
+{ try {
+   ACTORS( (alice) );
+   generate_block();
+
+   db.enable_evaluator_profiling( true );
+   const auto transfer_evaluations = [this]() {
+      const auto profile = db.get_evaluator_profiler()->get_profile();
+      for( const auto& op : profile.operations )
+      {
+         if( op.operation == "transfer_operation" )
+            return op.evaluate.count;
+      }
+      return uint64_t(0);
+   };
+
+   // The pending transactions are checked as strictly as the block requires,
+   // so they are not evaluated again when the block is generated, only when it is applied
+   transfer( account_id_type(), alice_id, asset(1000) );
+   BOOST_CHECK_EQUAL( transfer_evaluations(), 1u );
+   signed_block b = generate_block();
+   BOOST_CHECK_EQUAL( b.transactions.size(), 1u );
+   BOOST_CHECK( b.transactions.front().operation_results.empty() );
+   BOOST_CHECK_EQUAL( transfer_evaluations(), 2u );
+   BOOST_CHECK_EQUAL( get_balance( alice_id, asset_id_type() ), 1000 );
+
+   // An unsigned transaction pushed without checking signatures is evaluated again and left out
+   transfer( account_id_type(), alice_id, asset(1000) );
+   b = generate_block( database::skip_nothing );
+   BOOST_CHECK( b.transactions.empty() );
+   BOOST_CHECK_EQUAL( get_balance( alice_id, asset_id_type() ), 1000 );
+} FC_LOG_AND_RETHROW() }
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -6269,4 +6269,69 @@ BOOST_AUTO_TEST_CASE(custom_auths) { try {
       FC_LOG_AND_RETHROW()
    }
 
+BOOST_AUTO_TEST_CASE(custom_auth_predicate_cache) { try {
+   generate_blocks(HARDFORK_BSIP_40_TIME);
+   generate_blocks(5);
+   db.modify(global_property_id_type()(db), [](global_property_object& gpo) {
+      gpo.parameters.extensions.value.custom_authority_options = custom_authority_options_type();
+   });
+   set_expiration(db, trx);
+   ACTORS((alice)(bob))
+   fund(alice, asset(1000*GRAPHENE_BLOCKCHAIN_PRECISION));
+
+   custom_authority_create_operation op;
+   op.account = alice.get_id();
+   op.auth.add_authority(bob.get_id(), 1);
+   op.auth.weight_threshold = 1;
+   op.enabled = true;
+   op.valid_to = db.head_block_time() + 1000;
+   op.operation_type = operation::tag<transfer_operation>::value;
+   op.restrictions = {restriction(member_index<transfer_operation>("amount"), restriction::func_attr,
+                                  vector<restriction>{restriction(member_index<asset>("amount"),
+                                                                  restriction::func_lt, int64_t(100))})};
+   trx.operations = {op};
+   sign(trx, alice_private_key);
+   PUSH_TX(db, trx);
+   generate_block();
+
+   // The predicate is built when the custom authority is created, not when it is used first
+   const auto& auth = *db.get_index_type<custom_authority_index>().indices().get<by_account_custom>().find(alice_id);
+   BOOST_CHECK(auth.is_predicate_cached());
+
+   transfer_operation top;
+   top.from = alice.get_id();
+   top.to = bob.get_id();
+   top.amount.amount = 99;
+   BOOST_CHECK(auth.get_predicate()(top).success);
+   top.amount.amount = 100;
+   BOOST_CHECK(!auth.get_predicate()(top).success);
+
+   // Copies of the object, e.g. in undo states, share the predicate
+   custom_authority_object copy = auth;
+   BOOST_CHECK(&copy.get_predicate() == &auth.get_predicate());
+
+   // The predicate is rebuilt when the restrictions are updated, and restored when the update is undone
+   custom_authority_update_operation uop;
+   uop.account = alice.get_id();
+   uop.authority_to_update = auth.get_id();
+   uop.restrictions_to_remove = {0};
+   trx.clear();
+   trx.operations = {uop};
+   sign(trx, alice_private_key);
+   PUSH_TX(db, trx);
+   generate_block();
+   BOOST_CHECK(auth.is_predicate_cached());
+   BOOST_CHECK(auth.get_predicate()(top).success);
+
+   db.pop_block();
+   BOOST_CHECK(auth.is_predicate_cached());
+   BOOST_CHECK(!auth.get_predicate()(top).success);
+
+   // Predicates which are not cached, e.g. after a restart, are all built at once
+   db.modify(auth, [](custom_authority_object& obj) { obj.clear_predicate_cache(); });
+   BOOST_CHECK(!auth.is_predicate_cached());
+   db.cache_custom_authority_predicates();
+   BOOST_CHECK(auth.is_predicate_cached());
+} FC_LOG_AND_RETHROW() }
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -25,6 +25,7 @@
 #include <boost/test/unit_test.hpp>
 
 #include <graphene/app/database_api.hpp>
+#include <graphene/app/util.hpp>
 #include <graphene/chain/hardfork.hpp>
 
 #include <fc/crypto/digest.hpp>
@@ -1090,6 +1091,124 @@ BOOST_AUTO_TEST_CASE( subscription_notification_test )
    } FC_LOG_AND_RETHROW()
 }
 
+BOOST_AUTO_TEST_CASE( subscription_shared_serialization_test )
+{ try {
+   const size_t num_sessions = 3;
+   vector< vector<variant> > received( num_sessions );
+   vector< std::unique_ptr<graphene::app::database_api> > db_apis;
+   vector<object_id_type> obj_ids;
+   obj_ids.push_back( db.get_dynamic_global_properties().id );
+   for( size_t i = 0; i < num_sessions; ++i )
+   {
+      db_apis.emplace_back( std::make_unique<graphene::app::database_api>( db ) );
+      db_apis.back()->set_subscribe_callback( [&received,i]( const variant& v ) { received[i].push_back( v ); },
+                                              false );
+      db_apis.back()->get_objects( obj_ids ); // subscribe to dynamic global properties
+   }
+
+   generate_block();
+   fc::usleep(fc::milliseconds(200)); // sleep a while to execute callback in another thread
+
+   // @return the dynamic global properties in the first notification of a session containing them
+   const auto find_dgpo = [&obj_ids]( const vector<variant>& notifications ) -> const variant_object* {
+      for( const auto& notification : notifications )
+         for( const auto& update : notification.get_array() )
+         {
+            if( !update.is_object() )
+               continue;
+            const auto itr = update.get_object().find( "id" );
+            if( itr != update.get_object().end() && itr->value().as<object_id_type>( 1 ) == obj_ids.front() )
+               return &update.get_object();
+         }
+      return nullptr;
+   };
+
+   const variant_object* first = find_dgpo( received[0] );
+   BOOST_REQUIRE( first != nullptr );
+   for( size_t i = 1; i < num_sessions; ++i )
+   {
+      const variant_object* other = find_dgpo( received[i] );
+      BOOST_REQUIRE( other != nullptr );
+      BOOST_CHECK_EQUAL( fc::json::to_string( *other ), fc::json::to_string( *first ) );
+      // Copies of a variant object share its entries, so all sessions got the object serialized once
+      BOOST_CHECK( &*other->begin() == &*first->begin() );
+   }
+} FC_LOG_AND_RETHROW() }
+
+BOOST_AUTO_TEST_CASE( subscription_queue_overflow_test )
+{ try {
+   ACTORS( (alice) );
+
+   graphene::app::application_options opt;
+   opt.enable_subscribe_to_all = true;
+   opt.subscription_queue_size = 1;
+
+   bool resync_required = false;
+   uint32_t notifications_after_resync = 0;
+   auto callback = [&]( const variant& v )
+   {
+      for( const auto& update : v.get_array() )
+      {
+         if( update.is_object() && update.get_object().contains( "resync_required" ) )
+            resync_required = true;
+         else if( resync_required )
+            ++notifications_after_resync;
+      }
+   };
+
+   graphene::app::database_api db_api( db, &opt );
+   db_api.set_subscribe_callback( callback, true );
+
+   // Every block comes with several notifications at once, which do not fit into the queue while the worker
+   // is busy with the first one, so some of them are dropped sooner or later
+   for( uint32_t i = 0; i < 100 && !resync_required; ++i )
+   {
+      transfer( account_id_type(), alice_id, asset(1) );
+      generate_block();
+      fc::usleep(fc::milliseconds(10)); // sleep a while to execute callback in another thread
+   }
+   BOOST_REQUIRE( resync_required );
+
+   // The session keeps getting notifications once it is told to resync
+   transfer( account_id_type(), alice_id, asset(1) );
+   generate_block();
+   fc::usleep(fc::milliseconds(200)); // sleep a while to execute callback in another thread
+   BOOST_CHECK_GT( notifications_after_resync, 0u );
+} FC_LOG_AND_RETHROW() }
+
+BOOST_AUTO_TEST_CASE( subscription_order_with_several_threads_test )
+{ try {
+   graphene::app::application_options opt;
+   opt.subscription_threads = 4;
+
+   // Each session is served by another worker thread
+   const size_t num_sessions = 4;
+   vector< vector<block_id_type> > received( num_sessions );
+   vector< std::unique_ptr<graphene::app::database_api> > db_apis;
+   for( size_t i = 0; i < num_sessions; ++i )
+   {
+      db_apis.emplace_back( std::make_unique<graphene::app::database_api>( db, &opt ) );
+      db_apis.back()->set_block_applied_callback( [&received,i]( const variant& block_id ) {
+         received[i].push_back( block_id.as<block_id_type>( 1 ) );
+      });
+   }
+
+   vector<block_id_type> expected;
+   for( uint32_t i = 0; i < 50; ++i )
+   {
+      generate_block();
+      expected.push_back( db.head_block_id() );
+   }
+   fc::usleep(fc::milliseconds(500)); // sleep a while to execute callback in another thread
+
+   for( size_t i = 0; i < num_sessions; ++i )
+   {
+      BOOST_REQUIRE_EQUAL( received[i].size(), expected.size() );
+      for( size_t j = 0; j < expected.size(); ++j )
+         BOOST_CHECK( received[i][j] == expected[j] );
+   }
+} FC_LOG_AND_RETHROW() }
+
 BOOST_AUTO_TEST_CASE( get_all_workers )
 { try {
    graphene::app::database_api db_api( db, &( app.get_options() ));
@@ -1340,6 +1459,92 @@ BOOST_AUTO_TEST_CASE(get_limit_orders_by_account)
 
 } FC_LOG_AND_RETHROW() }
 
+BOOST_AUTO_TEST_CASE(get_order_book_depth)
+{ try {
+   graphene::app::database_api db_api( db, &( app.get_options() ));
+   ACTORS((seller)(buyer));
+
+   const auto& bitcny = create_user_issued_asset("CNY");
+   const auto& core   = asset_id_type()(db);
+
+   transfer( committee_account, seller_id, asset(10000000) );
+   issue_uia( buyer_id, bitcny.amount(10000000) );
+
+   // The price levels kept by the index should always be the orders from the limit order index summed up
+   auto check_depth = [&]( size_t expected_bids, size_t expected_asks ) {
+      const auto depth = db_api.get_order_book_depth( "CNY", core.symbol, 50 );
+      const auto orders = db_api.get_limit_orders( "CNY", core.symbol, 50 );
+      vector<graphene::app::order_book_level> bids;
+      vector<graphene::app::order_book_level> asks;
+      for( size_t i = 0; i < orders.size(); )
+      {
+         const price level_price = orders[i].sell_price;
+         share_type for_sale;
+         share_type to_receive;
+         uint32_t count = 0;
+         for( ; i < orders.size() && orders[i].sell_price == level_price; ++i, ++count )
+         {
+            for_sale += orders[i].for_sale;
+            to_receive += orders[i].amount_to_receive().amount;
+         }
+         auto& levels = ( level_price.base.asset_id == bitcny.get_id() ? bids : asks );
+         levels.emplace_back( level_price, for_sale, to_receive, count, bitcny, core );
+      }
+      BOOST_REQUIRE_EQUAL( depth.bids.size(), expected_bids );
+      BOOST_REQUIRE_EQUAL( depth.asks.size(), expected_asks );
+      BOOST_REQUIRE_EQUAL( bids.size(), expected_bids );
+      BOOST_REQUIRE_EQUAL( asks.size(), expected_asks );
+      const auto check_level = []( const graphene::app::order_book_level& actual,
+                                   const graphene::app::order_book_level& expected ) {
+         BOOST_CHECK_EQUAL( actual.price, expected.price );
+         BOOST_CHECK_EQUAL( actual.base, expected.base );
+         BOOST_CHECK_EQUAL( actual.quote, expected.quote );
+         BOOST_CHECK_EQUAL( actual.order_count, expected.order_count );
+      };
+      for( size_t i = 0; i < expected_bids; ++i )
+         check_level( depth.bids[i], bids[i] );
+      for( size_t i = 0; i < expected_asks; ++i )
+         check_level( depth.asks[i], asks[i] );
+   };
+
+   check_depth( 0, 0 );
+
+   for( size_t i = 0; i < 5; ++i )
+   {
+      BOOST_CHECK( create_sell_order( seller, core.amount(1000), bitcny.amount(2500 + i * 10) ) );
+      BOOST_CHECK( create_sell_order( buyer, bitcny.amount(1000), core.amount(500 + i * 10) ) );
+   }
+   // Orders at the same price, also when given as a different fraction, are in the same level
+   BOOST_CHECK( create_sell_order( seller, core.amount(1000), bitcny.amount(2500) ) );
+   BOOST_CHECK( create_sell_order( seller, core.amount(2000), bitcny.amount(5000) ) );
+   BOOST_CHECK( create_sell_order( buyer, bitcny.amount(3000), core.amount(1500) ) );
+   check_depth( 5, 5 );
+   BOOST_CHECK_EQUAL( db_api.get_order_book_depth( "CNY", core.symbol, 50 ).asks.front().order_count, 3u );
+
+   generate_block();
+
+   // Partially fill the best ask level
+   BOOST_CHECK( !create_sell_order( buyer, bitcny.amount(1250), core.amount(500) ) );
+   check_depth( 5, 5 );
+
+   // Cancel the orders of the best bid level
+   // The two best bids come first
+   const auto best = db_api.get_limit_orders( "CNY", core.symbol, 2 );
+   BOOST_REQUIRE( best.size() >= 2u && best[0].sell_price == best[1].sell_price );
+   cancel_limit_order( best[0] );
+   check_depth( 5, 5 );
+   cancel_limit_order( best[1] );
+   check_depth( 4, 5 );
+
+   // Undo
+   generate_block();
+   db.pop_block();
+   check_depth( 5, 5 );
+
+   BOOST_CHECK_EQUAL( db_api.get_order_book_depth( "CNY", core.symbol, 2 ).bids.size(), 2u );
+
+} FC_LOG_AND_RETHROW() }
+
 BOOST_AUTO_TEST_CASE(get_account_limit_orders)
 { try {
    graphene::app::database_api db_api( db, &( app.get_options() ));
@@ -29,8 +29,13 @@
 #include <graphene/chain/account_object.hpp>
 #include <graphene/chain/proposal_object.hpp>
 
+#include <graphene/utilities/tempdir.hpp>
+
 #include <fc/crypto/digest.hpp>
 
+#include <algorithm>
+#include <numeric>
+
 #include "../common/database_fixture.hpp"
 
 using namespace graphene::chain;
@@ -138,6 +143,162 @@ BOOST_AUTO_TEST_CASE( merge_test )
    }
 }
 
+BOOST_AUTO_TEST_CASE( undo_arena_merge_test )
+{ try {
+   database db;
+   const auto& balance = db.create<account_balance_object>( []( account_balance_object& obj ){
+      obj.balance = 1;
+   });
+   const object_id_type balance_id = balance.id;
+
+   auto outer = db._undo_db.start_undo_session();
+   db.modify( balance, []( account_balance_object& obj ){ obj.balance = 2; } );
+   object_id_type created_id;
+   {
+      auto inner = db._undo_db.start_undo_session();
+      db.modify( balance, []( account_balance_object& obj ){ obj.balance = 3; } );
+      created_id = db.create<account_balance_object>( []( account_balance_object& obj ){
+         obj.balance = 4;
+      }).id;
+
+      auto stats = db._undo_db.get_memory_stats();
+      BOOST_REQUIRE_EQUAL( stats.size(), 2u );
+      BOOST_CHECK_EQUAL( stats.back().old_values, 1u );
+      BOOST_CHECK_EQUAL( stats.back().new_ids, 1u );
+      BOOST_CHECK_GE( stats.back().arena_used, sizeof(account_balance_object) );
+      inner.merge();
+   }
+
+   auto stats = db._undo_db.get_memory_stats();
+   BOOST_REQUIRE_EQUAL( stats.size(), 1u );
+   BOOST_CHECK_EQUAL( stats.back().old_values, 1u );
+   BOOST_CHECK_EQUAL( stats.back().new_ids, 1u );
+   BOOST_CHECK_GE( stats.back().arena_reserved, stats.back().arena_used );
+
+   outer.undo();
+   BOOST_CHECK_EQUAL( db.get<account_balance_object>( balance_id ).balance.value, 1 );
+   BOOST_CHECK( db.find_object( created_id ) == nullptr );
+} FC_CAPTURE_AND_RETHROW() }
+
+BOOST_AUTO_TEST_CASE( incremental_flush_test )
+{ try {
+   fc::temp_directory data_dir( graphene::utilities::temp_directory_path() );
+   const auto target_dir = data_dir.path() / "object_database";
+   account_balance_id_type id1;
+   account_balance_id_type id2;
+   account_balance_id_type id3;
+   {
+      database db1;
+      db1.object_database::open( data_dir.path() );
+      db1.set_max_delta_segments( 2 );
+      id1 = db1.create<account_balance_object>( []( account_balance_object& obj ){ obj.balance = 1; } ).get_id();
+      id2 = db1.create<account_balance_object>( []( account_balance_object& obj ){ obj.balance = 2; } ).get_id();
+      // nothing saved yet, so this is a full flush
+      db1.flush_incremental();
+      BOOST_CHECK( fc::exists( target_dir / "0" ) );
+      BOOST_CHECK( !fc::exists( target_dir / "delta-1" ) );
+
+      db1.modify( id1(db1), []( account_balance_object& obj ){ obj.balance = 10; } );
+      db1.remove( id2(db1) );
+      id3 = db1.create<account_balance_object>( []( account_balance_object& obj ){ obj.balance = 3; } ).get_id();
+      db1.flush_incremental();
+      BOOST_CHECK( fc::exists( target_dir / "delta-1" ) );
+
+      // the second delta segment triggers merging in the background
+      db1.modify( id3(db1), []( account_balance_object& obj ){ obj.balance = 30; } );
+      db1.flush_incremental();
+      db1.object_database::close();
+      BOOST_CHECK( fc::exists( target_dir / "compacted-2" ) );
+      BOOST_CHECK( !fc::exists( target_dir / "delta-1" ) );
+      BOOST_CHECK( !fc::exists( target_dir / "0" ) );
+
+      db1.modify( id1(db1), []( account_balance_object& obj ){ obj.balance = 100; } );
+      db1.flush_incremental();
+      BOOST_CHECK( fc::exists( target_dir / "delta-3" ) );
+   }
+
+   database db2;
+   db2.object_database::open( data_dir.path() );
+   BOOST_CHECK_EQUAL( id1(db2).balance.value, 100 );
+   BOOST_CHECK( db2.find( id2 ) == nullptr );
+   BOOST_CHECK_EQUAL( id3(db2).balance.value, 30 );
+   BOOST_CHECK( db2.get_index_type<account_balance_index>().get_next_id() == object_id_type( id3 ) + 1 );
+
+   // a full flush replaces all segments
+   db2.flush();
+   BOOST_CHECK( !fc::exists( target_dir / "compacted-2" ) );
+   BOOST_CHECK( !fc::exists( target_dir / "delta-3" ) );
+   database db3;
+   db3.object_database::open( data_dir.path() );
+   BOOST_CHECK_EQUAL( id1(db3).balance.value, 100 );
+   BOOST_CHECK( db3.find( id2 ) == nullptr );
+} FC_LOG_AND_RETHROW() }
+
+BOOST_AUTO_TEST_CASE( flush_interval_test )
+{ try {
+   const auto target_dir = db.get_data_dir() / "object_database";
+   // nothing saved yet, so this is a full flush, as soon as a block can not be undone anymore
+   db.set_flush_interval( 1 );
+   const uint32_t first_block_num = db.last_non_undoable_block_num();
+   while( db.last_non_undoable_block_num() == first_block_num )
+   {
+      BOOST_CHECK( !fc::exists( target_dir / "0" ) );
+      generate_block();
+   }
+   BOOST_CHECK( fc::exists( target_dir / "0" ) );
+
+   db.set_flush_interval( 3 );
+   const uint32_t flushed_block_num = db.last_non_undoable_block_num();
+   while( db.last_non_undoable_block_num() < flushed_block_num + 3 )
+   {
+      BOOST_CHECK( !fc::exists( target_dir / "delta-1" ) );
+      generate_block();
+   }
+   BOOST_CHECK( fc::exists( target_dir / "delta-1" ) );
+} FC_LOG_AND_RETHROW() }
+
+BOOST_AUTO_TEST_CASE( flush_excluding_undo_history_test )
+{ try {
+   fc::temp_directory data_dir( graphene::utilities::temp_directory_path() );
+   account_balance_id_type modified;
+   account_balance_id_type removed;
+   account_balance_id_type created;
+   {
+      database db1;
+      db1.object_database::open( data_dir.path() );
+      modified = db1.create<account_balance_object>( []( account_balance_object& obj ){ obj.balance = 1; } ).get_id();
+      removed = db1.create<account_balance_object>( []( account_balance_object& obj ){ obj.balance = 2; } ).get_id();
+      db1.flush_incremental();
+
+      db1._undo_db.enable();
+      {
+         auto session = db1._undo_db.start_undo_session();
+         db1.modify( modified(db1), []( account_balance_object& obj ){ obj.balance = 10; } );
+         db1.remove( removed(db1) );
+         created = db1.create<account_balance_object>( []( account_balance_object& obj ){ obj.balance = 3; } ).get_id();
+         session.commit();
+      }
+      // the changes in the undo state are left out, but still written by the next flush
+      db1.flush_incremental( true );
+      {
+         database db2;
+         db2.object_database::open( data_dir.path() );
+         BOOST_CHECK_EQUAL( modified(db2).balance.value, 1 );
+         BOOST_CHECK_EQUAL( removed(db2).balance.value, 2 );
+         BOOST_CHECK( db2.find( created ) == nullptr );
+         BOOST_CHECK( db2.get_index_type<account_balance_index>().get_next_id() == object_id_type( created ) );
+      }
+      db1.flush_incremental();
+   }
+
+   database db3;
+   db3.object_database::open( data_dir.path() );
+   BOOST_CHECK_EQUAL( modified(db3).balance.value, 10 );
+   BOOST_CHECK( db3.find( removed ) == nullptr );
+   BOOST_CHECK_EQUAL( created(db3).balance.value, 3 );
+   BOOST_CHECK( db3.get_index_type<account_balance_index>().get_next_id() == object_id_type( created ) + 1 );
+} FC_LOG_AND_RETHROW() }
+
 BOOST_AUTO_TEST_CASE( direct_index_test )
 { try {
    try {
@@ -311,4 +472,71 @@ BOOST_AUTO_TEST_CASE( required_approval_index_test ) // see https://github.com/b
 
 } FC_LOG_AND_RETHROW() }
 
+BOOST_AUTO_TEST_CASE( evaluator_profiling_test )
+{ try {
+   ACTORS( (alice) );
+   generate_block();
+
+   BOOST_CHECK( db.get_evaluator_profiler() == nullptr );
+   db.enable_evaluator_profiling( true );
+   const evaluator_profiler* profiler = db.get_evaluator_profiler();
+   BOOST_REQUIRE( profiler != nullptr );
+   BOOST_CHECK( profiler->get_profile().operations.empty() );
+
+   transfer( account_id_type(), alice_id, asset(1000) );
+   generate_block();
+
+   const auto find_operation = []( const evaluator_profile& profile, const string& name ) {
+      return std::find_if( profile.operations.begin(), profile.operations.end(),
+                           [&name]( const operation_profile& op ) { return op.operation == name; } );
+   };
+   const auto bucket_total = []( const latency_histogram& h ) {
+      return std::accumulate( h.buckets.begin(), h.buckets.end(), uint64_t(0) );
+   };
+
+   evaluator_profile profile = profiler->get_profile();
+   auto transfer_profile = find_operation( profile, "transfer_operation" );
+   BOOST_REQUIRE( transfer_profile != profile.operations.end() );
+   // Evaluated when pushed and when the block was applied, and when it was generated if pending state is rebuilt
+   BOOST_CHECK_GE( transfer_profile->evaluate.count, 2u );
+   BOOST_CHECK_EQUAL( transfer_profile->evaluate.count, transfer_profile->apply.count );
+   BOOST_CHECK_EQUAL( transfer_profile->evaluate.buckets.size(), latency_histogram::bucket_count );
+   BOOST_CHECK_EQUAL( bucket_total( transfer_profile->evaluate ), transfer_profile->evaluate.count );
+   BOOST_CHECK_LE( transfer_profile->evaluate.max_ns, transfer_profile->evaluate.total_ns );
+   BOOST_CHECK( find_operation( profile, "account_create_operation" ) == profile.operations.end() );
+
+   auto phase = std::find_if( profile.phases.begin(), profile.phases.end(),
+                              []( const block_phase_profile& p ) { return p.phase == "clear_expired_orders"; } );
+   BOOST_REQUIRE( phase != profile.phases.end() );
+   BOOST_CHECK_EQUAL( phase->duration.count, 1u );
+
+   generate_blocks( db.get_dynamic_global_properties().next_maintenance_time );
+   profile = profiler->get_profile();
+   phase = std::find_if( profile.phases.begin(), profile.phases.end(),
+                         []( const block_phase_profile& p ) { return p.phase == "perform_chain_maintenance"; } );
+   BOOST_REQUIRE( phase != profile.phases.end() );
+   BOOST_CHECK_EQUAL( phase->duration.count, 1u );
+
+   db.get_evaluator_profiler()->reset();
+   profile = profiler->get_profile();
+   BOOST_CHECK( profile.operations.empty() );
+   BOOST_CHECK( profile.phases.empty() );
+
+   BOOST_CHECK_EQUAL( latency_histogram::bucket_of( 0 ), 0u );
+   BOOST_CHECK_EQUAL( latency_histogram::bucket_of( 999 ), 0u );
+   BOOST_CHECK_EQUAL( latency_histogram::bucket_of( 1000 ), 1u );
+   BOOST_CHECK_EQUAL( latency_histogram::bucket_of( 3999 ), 2u );
+   BOOST_CHECK_EQUAL( latency_histogram::bucket_of( 4000 ), 3u );
+   BOOST_CHECK_EQUAL( latency_histogram::bucket_of( UINT64_MAX ), latency_histogram::bucket_count - 1 );
+
+   db.enable_evaluator_profiling( false );
+   BOOST_CHECK( db.get_evaluator_profiler() == nullptr );
+   transfer( account_id_type(), alice_id, asset(1000) );
+   generate_block();
+   // Still usable by callers which got it before profiling was disabled
+   BOOST_CHECK( profiler->get_profile().operations.empty() );
+   db.enable_evaluator_profiling( true );
+   BOOST_CHECK( db.get_evaluator_profiler() == profiler );
+} FC_LOG_AND_RETHROW() }
+
 BOOST_AUTO_TEST_SUITE_END()
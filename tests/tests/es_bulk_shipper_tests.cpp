@@ -0,0 +1,126 @@
+/*
+ * Copyright (c) 2026 Contributors.
+ *
+ * The MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <boost/test/unit_test.hpp>
+
+#include <graphene/utilities/elasticsearch.hpp>
+
+#include <fc/exception/exception.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <string>
+#include <vector>
+
+#include "../common/mock_es_server.hpp"
+
+using graphene::utilities::es_bulk_shipper;
+using graphene::utilities::mock_es_server;
+
+namespace {
+
+std::vector<std::string> make_payload( uint32_t n )
+{
+   return { R"({"index":{"_index":"test","_id":")" + std::to_string(n) + R"("}})",
+            R"({"n":)" + std::to_string(n) + "}" };
+}
+
+es_bulk_shipper::options fast_retries()
+{
+   es_bulk_shipper::options opts;
+   opts.initial_backoff = std::chrono::milliseconds( 10 );
+   opts.max_backoff = std::chrono::milliseconds( 50 );
+   return opts;
+}
+
+}
+
+BOOST_AUTO_TEST_SUITE( es_bulk_shipper_tests )
+
+BOOST_AUTO_TEST_CASE( payloads_are_sent_in_parallel )
+{ try {
+   mock_es_server server( 0, std::chrono::milliseconds( 50 ) );
+   const uint32_t num_payloads = 20;
+   {
+      auto opts = fast_retries();
+      opts.connections = 4;
+      opts.max_queued = 8;
+      es_bulk_shipper shipper( server.url(), "", opts );
+      for( uint32_t i = 1; i <= num_payloads; ++i )
+      {
+         BOOST_CHECK_EQUAL( shipper.enqueue( make_payload(i) ), i );
+         BOOST_CHECK_LE( shipper.pending(), opts.max_queued );
+      }
+      shipper.flush();
+      BOOST_CHECK_EQUAL( shipper.last_acknowledged(), num_payloads );
+      BOOST_CHECK_EQUAL( shipper.pending(), 0u );
+   }
+
+   BOOST_CHECK_EQUAL( server.requests(), num_payloads );
+   BOOST_CHECK_GT( server.max_concurrent_requests(), 1u );
+   auto lines = server.received_lines();
+   BOOST_REQUIRE_EQUAL( lines.size(), 2 * num_payloads );
+   for( uint32_t i = 1; i <= num_payloads; ++i )
+   {
+      const auto payload = make_payload(i);
+      BOOST_CHECK( std::find( lines.begin(), lines.end(), payload.back() ) != lines.end() );
+   }
+} FC_LOG_AND_RETHROW() }
+
+BOOST_AUTO_TEST_CASE( failed_requests_are_retried )
+{ try {
+   mock_es_server server( 3, std::chrono::milliseconds( 0 ) );
+   {
+      auto opts = fast_retries();
+      opts.connections = 1;
+      es_bulk_shipper shipper( server.url(), "", opts );
+      shipper.enqueue( make_payload(1) );
+      shipper.enqueue( make_payload(2) );
+      shipper.flush();
+      BOOST_CHECK_EQUAL( shipper.last_acknowledged(), 2u );
+   }
+   BOOST_CHECK_EQUAL( server.requests(), 5u );
+   const auto lines = server.received_lines();
+   BOOST_REQUIRE_EQUAL( lines.size(), 4u );
+   BOOST_CHECK_EQUAL( lines[1], make_payload(1).back() );
+   BOOST_CHECK_EQUAL( lines[3], make_payload(2).back() );
+} FC_LOG_AND_RETHROW() }
+
+BOOST_AUTO_TEST_CASE( shipper_gives_up_after_max_retries )
+{ try {
+   mock_es_server server( 100, std::chrono::milliseconds( 0 ) );
+   {
+      auto opts = fast_retries();
+      opts.connections = 2;
+      opts.max_retries = 2;
+      es_bulk_shipper shipper( server.url(), "", opts );
+      shipper.enqueue( make_payload(1) );
+      BOOST_CHECK_THROW( shipper.flush(), fc::exception );
+      BOOST_CHECK_EQUAL( shipper.last_acknowledged(), 0u );
+      BOOST_CHECK_THROW( shipper.enqueue( make_payload(2) ), fc::exception );
+   }
+   BOOST_CHECK_EQUAL( server.requests(), 3u );
+} FC_LOG_AND_RETHROW() }
+
+BOOST_AUTO_TEST_SUITE_END()
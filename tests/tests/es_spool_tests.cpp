@@ -0,0 +1,183 @@
+/*
+ * Copyright (c) 2026 Contributors.
+ *
+ * The MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <boost/test/unit_test.hpp>
+
+#include <graphene/utilities/es_spool.hpp>
+#include <graphene/utilities/tempdir.hpp>
+
+#include <fc/exception/exception.hpp>
+#include <fc/filesystem.hpp>
+
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "../common/mock_es_server.hpp"
+
+using graphene::utilities::es_spool;
+using graphene::utilities::mock_es_server;
+
+namespace {
+
+std::vector<std::string> make_lines( uint32_t block_num )
+{
+   return { R"({"index":{"_index":"test","_id":")" + std::to_string(block_num) + R"("}})",
+            R"({"block":)" + std::to_string(block_num) + "}" };
+}
+
+/// The lines the server should have received for the given blocks
+std::vector<std::string> expected_lines( uint32_t from, uint32_t to )
+{
+   std::vector<std::string> result;
+   for( uint32_t i = from; i <= to; ++i )
+   {
+      auto lines = make_lines(i);
+      result.insert( result.end(), lines.begin(), lines.end() );
+   }
+   return result;
+}
+
+es_spool::options spool_options( const fc::path& dir )
+{
+   es_spool::options opts;
+   opts.directory = dir;
+   // a few records per segment
+   opts.segment_size = 256;
+   // so that the order in which the server receives the data is known
+   opts.shipper.connections = 1;
+   opts.shipper.initial_backoff = std::chrono::milliseconds( 10 );
+   opts.shipper.max_backoff = std::chrono::milliseconds( 50 );
+   return opts;
+}
+
+bool wait_until_drained( const es_spool& spool )
+{
+   const auto give_up = std::chrono::steady_clock::now() + std::chrono::seconds( 10 );
+   while( !spool.drained() && std::chrono::steady_clock::now() < give_up )
+      std::this_thread::sleep_for( std::chrono::milliseconds( 10 ) );
+   return spool.drained();
+}
+
+size_t count_segments( const fc::path& dir )
+{
+   size_t result = 0;
+   for( fc::directory_iterator itr( dir ); itr != fc::directory_iterator(); ++itr )
+   {
+      if( (*itr).filename().string().compare( 0, 8, "segment-" ) == 0 )
+         ++result;
+   }
+   return result;
+}
+
+}
+
+BOOST_AUTO_TEST_SUITE( es_spool_tests )
+
+BOOST_AUTO_TEST_CASE( spool_is_sent_after_outage )
+{ try {
+   fc::temp_directory dir( graphene::utilities::temp_directory_path() );
+   mock_es_server server( 1000000, std::chrono::milliseconds( 0 ) );
+   es_spool spool( server.url(), "", spool_options( dir.path() ) );
+
+   // appending does not wait for ES
+   for( uint32_t i = 1; i <= 20; ++i )
+      spool.append( i, make_lines(i) );
+   BOOST_CHECK_EQUAL( spool.last_appended_block(), 20u );
+   BOOST_CHECK_EQUAL( spool.last_acknowledged_block(), 0u );
+   BOOST_CHECK( !spool.drained() );
+   BOOST_CHECK( server.received_lines().empty() );
+   BOOST_CHECK_GT( count_segments( dir.path() ), 1u );
+
+   server.set_failures( 0 );
+   BOOST_REQUIRE( wait_until_drained( spool ) );
+   BOOST_CHECK_EQUAL( spool.last_acknowledged_block(), 20u );
+   BOOST_CHECK( server.received_lines() == expected_lines( 1, 20 ) );
+   // segments which have been sent are removed
+   BOOST_CHECK_EQUAL( count_segments( dir.path() ), 1u );
+} FC_LOG_AND_RETHROW() }
+
+BOOST_AUTO_TEST_CASE( spool_resumes_after_restart )
+{ try {
+   fc::temp_directory dir( graphene::utilities::temp_directory_path() );
+   mock_es_server server( 1000000, std::chrono::milliseconds( 0 ) );
+   {
+      es_spool spool( server.url(), "", spool_options( dir.path() ) );
+      for( uint32_t i = 1; i <= 10; ++i )
+         spool.append( i, make_lines(i) );
+   }
+
+   server.set_failures( 0 );
+   {
+      es_spool spool( server.url(), "", spool_options( dir.path() ) );
+      BOOST_CHECK_EQUAL( spool.last_appended_block(), 10u );
+      BOOST_REQUIRE( wait_until_drained( spool ) );
+      BOOST_CHECK_EQUAL( spool.last_acknowledged_block(), 10u );
+   }
+   BOOST_CHECK( server.received_lines() == expected_lines( 1, 10 ) );
+
+   // the cursor has been saved, so nothing is sent twice
+   const auto requests = server.requests();
+   {
+      es_spool spool( server.url(), "", spool_options( dir.path() ) );
+      BOOST_CHECK( spool.drained() );
+      spool.append( 11, make_lines(11) );
+      BOOST_REQUIRE( wait_until_drained( spool ) );
+   }
+   BOOST_CHECK_EQUAL( server.requests(), requests + 1 );
+   BOOST_CHECK( server.received_lines() == expected_lines( 1, 11 ) );
+} FC_LOG_AND_RETHROW() }
+
+BOOST_AUTO_TEST_CASE( spool_reexports_retained_blocks )
+{ try {
+   fc::temp_directory dir( graphene::utilities::temp_directory_path() );
+   mock_es_server server( 0, std::chrono::milliseconds( 0 ) );
+   auto opts = spool_options( dir.path() );
+   opts.retain_blocks = 100;
+   es_spool spool( server.url(), "", opts );
+   for( uint32_t i = 1; i <= 10; ++i )
+      spool.append( i, make_lines(i) );
+   BOOST_REQUIRE( wait_until_drained( spool ) );
+   BOOST_CHECK_GT( count_segments( dir.path() ), 1u );
+
+   BOOST_CHECK_EQUAL( spool.rewind( 6 ), 6u );
+   // the rewind is done by the background thread
+   const auto give_up = std::chrono::steady_clock::now() + std::chrono::seconds( 10 );
+   while( server.received_lines().size() < expected_lines( 1, 15 ).size()
+          && std::chrono::steady_clock::now() < give_up )
+      std::this_thread::sleep_for( std::chrono::milliseconds( 10 ) );
+
+   auto expected = expected_lines( 1, 10 );
+   const auto resent = expected_lines( 6, 10 );
+   expected.insert( expected.end(), resent.begin(), resent.end() );
+   BOOST_CHECK( server.received_lines() == expected );
+   BOOST_CHECK( wait_until_drained( spool ) );
+   BOOST_CHECK_EQUAL( spool.last_acknowledged_block(), 10u );
+
+   // blocks which are not in the spool any more can not be sent again
+   BOOST_CHECK_EQUAL( spool.rewind( 11 ), 0u );
+} FC_LOG_AND_RETHROW() }
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -25,6 +25,8 @@
 #include <boost/test/unit_test.hpp>
 
 #include <graphene/app/api.hpp>
+#include <graphene/account_history/account_history_plugin.hpp>
+#include <graphene/account_history/history_store.hpp>
 
 #include <graphene/chain/hardfork.hpp>
 
@@ -920,6 +922,73 @@ BOOST_AUTO_TEST_CASE(min_blocks_to_keep_test) {
    }
 }
 
+BOOST_AUTO_TEST_CASE(history_store_test) {
+   try {
+      graphene::app::history_api hist_api(app);
+
+      // max-ops-per-account = 2
+      // min-blocks-to-keep = 0
+      // history removed from memory is moved to the history store once it is irreversible
+      create_bitasset("USA", account_id_type());
+      create_bitasset("USB", account_id_type());
+      create_bitasset("USC", account_id_type());
+      create_bitasset("USD", account_id_type());
+      create_bitasset("USE", account_id_type());
+      generate_block();
+      generate_blocks( 20 );
+
+      const auto& stats = account_id_type()(db).statistics(db);
+      BOOST_REQUIRE_EQUAL( stats.total_ops, 5u );
+      BOOST_CHECK_EQUAL( stats.removed_ops, 3u );
+
+      auto store = app.get_plugin<graphene::account_history::account_history_plugin>( "account_history" )
+                      ->get_history_store();
+      BOOST_REQUIRE( store );
+      BOOST_CHECK_EQUAL( store->last_sequence( account_id_type() ), 3u );
+
+      // All history is found in memory and on disk
+      vector<operation_history_object> histories = hist_api.get_account_history( "1.2.0",
+            operation_history_id_type(0), 10, operation_history_id_type(0) );
+      BOOST_REQUIRE_EQUAL( histories.size(), 5u );
+      for( size_t i = 1; i < histories.size(); ++i )
+         BOOST_CHECK( histories[i].id < histories[i-1].id );
+      for( const auto& h : histories )
+         BOOST_CHECK( h.op.is_type<asset_create_operation>() );
+
+      // Paging continues from memory to disk
+      vector<operation_history_object> page = hist_api.get_account_history( "1.2.0",
+            operation_history_id_type(0), 2, histories[1].id );
+      BOOST_REQUIRE_EQUAL( page.size(), 2u );
+      BOOST_CHECK( page[0].id == histories[1].id );
+      BOOST_CHECK( page[1].id == histories[2].id );
+
+      page = hist_api.get_account_history( "1.2.0", histories[4].id, 10, histories[2].id );
+      BOOST_REQUIRE_EQUAL( page.size(), 2u );
+      BOOST_CHECK( page[0].id == histories[2].id );
+      BOOST_CHECK( page[1].id == histories[3].id );
+
+      // By sequence number
+      page = hist_api.get_relative_account_history( "1.2.0", 0, 10, 0 );
+      BOOST_REQUIRE_EQUAL( page.size(), 5u );
+      for( size_t i = 0; i < page.size(); ++i )
+         BOOST_CHECK( page[i].id == histories[i].id );
+
+      page = hist_api.get_relative_account_history( "1.2.0", 2, 10, 3 );
+      BOOST_REQUIRE_EQUAL( page.size(), 2u );
+      BOOST_CHECK( page[0].id == histories[2].id );
+      BOOST_CHECK( page[1].id == histories[3].id );
+
+      // By operation type
+      page = hist_api.get_account_history_operations( "1.2.0", operation::tag<asset_create_operation>::value,
+            operation_history_id_type(), operation_history_id_type(), 10 );
+      BOOST_CHECK_EQUAL( page.size(), 5u );
+
+   } catch (fc::exception &e) {
+      edump((e.to_detail_string()));
+      throw;
+   }
+}
+
 BOOST_AUTO_TEST_CASE(get_account_history_operations) {
    try {
       graphene::app::history_api hist_api(app);
@@ -1155,4 +1224,204 @@ BOOST_AUTO_TEST_CASE(api_limit_get_account_history_by_operations) {
  }
 }
 
+BOOST_AUTO_TEST_CASE(binary_api_results) {
+ try {
+   graphene::app::history_api hist_api(app);
+   graphene::app::binary_api bin_api(app);
+
+   create_bitasset("USD", account_id_type());
+   const account_id_type dan_id = create_account("dan").get_id();
+   generate_block();
+   fc::usleep(fc::milliseconds(100));
+
+   // blocks
+   const uint32_t head_num = db.head_block_num();
+   auto blocks = fc::raw::unpack< vector<optional<signed_block>> >( bin_api.get_blocks( 1, head_num + 1 ) );
+   BOOST_REQUIRE_EQUAL( blocks.size(), head_num + 1 );
+   BOOST_REQUIRE( blocks[head_num - 1].valid() );
+   BOOST_CHECK( blocks[head_num - 1]->id() == db.head_block_id() );
+   BOOST_CHECK( !blocks[head_num].valid() );
+
+   // objects, including one which does not exist
+   vector<object_id_type> ids { dan_id, asset_id_type(), account_id_type(1000000) };
+   auto objects = fc::raw::unpack< vector<optional<vector<char>>> >( bin_api.get_objects( ids ) );
+   BOOST_REQUIRE_EQUAL( objects.size(), 3u );
+   BOOST_REQUIRE( objects[0].valid() );
+   BOOST_CHECK_EQUAL( fc::raw::unpack<account_object>( *objects[0] ).name, "dan" );
+   BOOST_REQUIRE( objects[1].valid() );
+   BOOST_CHECK_EQUAL( fc::raw::unpack<asset_object>( *objects[1] ).symbol, GRAPHENE_SYMBOL );
+   BOOST_CHECK( !objects[2].valid() );
+
+   // account history, same as from the history API
+   auto histories = hist_api.get_account_history("1.2.0", operation_history_id_type(), 100,
+                                                 operation_history_id_type());
+   BOOST_REQUIRE_EQUAL( histories.size(), 2u );
+   BOOST_CHECK( bin_api.get_account_history("1.2.0", operation_history_id_type(), 100,
+                                            operation_history_id_type()) == fc::raw::pack( histories ) );
+   GRAPHENE_CHECK_THROW( bin_api.get_account_history("1.2.0", operation_history_id_type(), 260,
+                                                     operation_history_id_type()), fc::exception );
+ }
+ catch (fc::exception &e) {
+   edump((e.to_detail_string()));
+   throw;
+ }
+}
+
+BOOST_AUTO_TEST_CASE(market_history_roll_up) {
+ try {
+   graphene::app::history_api hist_api(app);
+
+   ACTORS( (buyer)(seller) );
+
+   const auto& bitcny = create_user_issued_asset("CNY");
+   const auto& core   = asset_id_type()(db);
+
+   int64_t init_balance(10000000);
+   transfer( committee_account, seller_id, asset(init_balance) );
+   issue_uia( buyer_id, bitcny.amount(init_balance) );
+   generate_block();
+
+   const fc::time_point_sec start_time = db.head_block_time();
+
+   // Buckets of 60 and 300 seconds are rolled up from buckets of 15 seconds, so they must be the same as
+   // buckets aggregated from those
+   auto check_buckets = [&]( uint32_t bucket_seconds ) {
+      const auto fine = hist_api.get_market_history( "CNY", GRAPHENE_SYMBOL, 15,
+                                                     start_time, db.head_block_time() );
+      vector<bucket_object> expected;
+      for( const auto& b : fine )
+      {
+         fc::time_point_sec open( b.key.open.sec_since_epoch() / bucket_seconds * bucket_seconds );
+         if( expected.empty() || expected.back().key.open != open )
+         {
+            expected.push_back( b );
+            expected.back().key.seconds = bucket_seconds;
+            expected.back().key.open = open;
+            continue;
+         }
+         auto& e = expected.back();
+         e.base_volume += b.base_volume;
+         e.quote_volume += b.quote_volume;
+         e.close_base = b.close_base;
+         e.close_quote = b.close_quote;
+         if( e.high() < b.high() )
+         {
+            e.high_base = b.high_base;
+            e.high_quote = b.high_quote;
+         }
+         if( e.low() > b.low() )
+         {
+            e.low_base = b.low_base;
+            e.low_quote = b.low_quote;
+         }
+      }
+
+      const auto coarse = hist_api.get_market_history( "CNY", GRAPHENE_SYMBOL, bucket_seconds,
+                                                       fc::time_point_sec( start_time.sec_since_epoch()
+                                                                           / bucket_seconds * bucket_seconds ),
+                                                       db.head_block_time() );
+      BOOST_REQUIRE_EQUAL( coarse.size(), expected.size() );
+      for( size_t i = 0; i < coarse.size(); ++i )
+      {
+         const auto& c = coarse[i];
+         const auto& e = expected[i];
+         BOOST_CHECK( c.key.base == core.get_id() && c.key.quote == bitcny.get_id() );
+         BOOST_CHECK_EQUAL( c.key.seconds, bucket_seconds );
+         BOOST_CHECK( c.key.open == e.key.open );
+         BOOST_CHECK_EQUAL( c.base_volume.value, e.base_volume.value );
+         BOOST_CHECK_EQUAL( c.quote_volume.value, e.quote_volume.value );
+         BOOST_CHECK_EQUAL( c.open_base.value, e.open_base.value );
+         BOOST_CHECK_EQUAL( c.open_quote.value, e.open_quote.value );
+         BOOST_CHECK_EQUAL( c.close_base.value, e.close_base.value );
+         BOOST_CHECK_EQUAL( c.close_quote.value, e.close_quote.value );
+         BOOST_CHECK_EQUAL( c.high_base.value, e.high_base.value );
+         BOOST_CHECK_EQUAL( c.high_quote.value, e.high_quote.value );
+         BOOST_CHECK_EQUAL( c.low_base.value, e.low_base.value );
+         BOOST_CHECK_EQUAL( c.low_quote.value, e.low_quote.value );
+      }
+   };
+
+   const uint32_t gaps[] = { 7, 23, 41, 97, 130, 5, 290 };
+   for( size_t i = 0; i < 30; ++i )
+   {
+      const int64_t cny_amount = 200 + int64_t( (i * 37) % 11 ) * 10;
+      BOOST_CHECK( create_sell_order( seller, core.amount(100), bitcny.amount(cny_amount) ) );
+      BOOST_CHECK( !create_sell_order( buyer, bitcny.amount(cny_amount), core.amount(100) ) );
+      generate_blocks( db.head_block_time() + gaps[ i % 7 ] );
+
+      check_buckets( 60 );
+      check_buckets( 300 );
+   }
+
+   // Roll-ups are undone with the block
+   db.pop_block();
+   check_buckets( 60 );
+   check_buckets( 300 );
+
+   // All trades are in the coarse buckets, except the popped ones
+   const auto total = hist_api.get_market_history( "CNY", GRAPHENE_SYMBOL, 300,
+                                                   fc::time_point_sec(), db.head_block_time() );
+   int64_t total_volume = 0;
+   for( const auto& b : total )
+      total_volume += b.base_volume.value;
+   BOOST_CHECK_EQUAL( total_volume, 29 * 100 );
+ }
+ catch (fc::exception &e) {
+   edump((e.to_detail_string()));
+   throw;
+ }
+}
+
+BOOST_AUTO_TEST_CASE(market_history_roll_up_after_idle_gap) {
+ try {
+   graphene::app::history_api hist_api(app);
+
+   ACTORS( (buyer)(seller) );
+
+   const auto& bitcny = create_user_issued_asset("CNY");
+   const auto& core   = asset_id_type()(db);
+
+   int64_t init_balance(10000000);
+   transfer( committee_account, seller_id, asset(init_balance) );
+   issue_uia( buyer_id, bitcny.amount(init_balance) );
+   generate_block();
+
+   auto trade = [&]( int64_t core_amount ) {
+      BOOST_CHECK( create_sell_order( seller, core.amount(core_amount), bitcny.amount(200) ) );
+      BOOST_CHECK( !create_sell_order( buyer, bitcny.amount(200), core.amount(core_amount) ) );
+      generate_block();
+   };
+   auto total_volume = [&]( uint32_t bucket_seconds ) {
+      int64_t total = 0;
+      for( const auto& b : hist_api.get_market_history( "CNY", GRAPHENE_SYMBOL, bucket_seconds,
+                                                        fc::time_point_sec(), db.head_block_time() ) )
+         total += b.base_volume.value;
+      return total;
+   };
+
+   trade( 100 );
+
+   // Only 10 buckets of each size are kept, so the 60 second bucket of the first trade is out of range once
+   // the 15 second bucket is rolled up, while the 300 second bucket is not
+   generate_blocks( db.head_block_time() + 1000 );
+   trade( 50 );
+
+   BOOST_CHECK_EQUAL( total_volume( 15 ), 50 );
+   BOOST_CHECK_EQUAL( total_volume( 60 ), 0 );
+   BOOST_CHECK_EQUAL( total_volume( 300 ), 100 );
+
+   // The second trade reaches the 300 second buckets as usual, once its 60 second bucket is complete
+   generate_blocks( db.head_block_time() + 300 );
+   trade( 20 );
+   BOOST_CHECK_EQUAL( total_volume( 60 ), 50 );
+   generate_blocks( db.head_block_time() + 60 );
+   trade( 10 );
+   BOOST_CHECK_EQUAL( total_volume( 300 ), 150 );
+ }
+ catch (fc::exception &e) {
+   edump((e.to_detail_string()));
+   throw;
+ }
+}
+
 BOOST_AUTO_TEST_SUITE_END()
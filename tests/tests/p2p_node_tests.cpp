@@ -21,6 +21,8 @@
  * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
  * THE SOFTWARE.
  */
+#include <algorithm>
+#include <map>
 #include <memory>
 #include <thread>
 #include <iostream>
@@ -164,6 +166,48 @@ static void test_address_message( const graphene::net::message& msg, std::size_t
    BOOST_CHECK_EQUAL( addr_msg.addresses.size(), num_elements );
 }
 
+static graphene::protocol::signed_block create_block_with_transactions( size_t count )
+{
+   graphene::protocol::signed_block blk;
+   blk.timestamp = fc::time_point_sec( fc::time_point::now() );
+   for( size_t i = 0; i < count; ++i )
+   {
+      graphene::protocol::signed_transaction trx;
+      trx.expiration = blk.timestamp + ( i + 1 ); // to get different IDs
+      blk.transactions.push_back( graphene::protocol::processed_transaction( trx ) );
+   }
+   blk.transaction_merkle_root = blk.calculate_merkle_root();
+   return blk;
+}
+
+static std::vector<graphene::protocol::signed_block> create_chain_of_blocks( size_t count )
+{
+   std::vector<graphene::protocol::signed_block> blocks;
+   for( size_t i = 0; i < count; ++i )
+   {
+      graphene::protocol::signed_block blk;
+      blk.timestamp = fc::time_point_sec( 1 + i );
+      if( !blocks.empty() )
+         blk.previous = blocks.back().id();
+      blocks.push_back( blk );
+   }
+   return blocks;
+}
+
+static std::vector<graphene::net::item_hash_t> sync_items_requested( const test_peer& peer )
+{
+   std::vector<graphene::net::item_hash_t> result;
+   for( const auto& msg : peer.messages_received )
+   {
+      if( msg.msg_type.value() != graphene::net::fetch_items_message::type )
+         continue;
+      const auto req = msg.as<graphene::net::fetch_items_message>();
+      if( req.item_type == graphene::net::block_message_type )
+         result.insert( result.end(), req.items_to_fetch.begin(), req.items_to_fetch.end() );
+   }
+   return result;
+}
+
 class test_node_delegate : public graphene::net::node_delegate
 {
 private:
@@ -181,6 +225,10 @@ public:
    bool handle_block( const graphene::net::block_message& blk_msg, bool sync_mode,
          std::vector<fc::uint160_t>& contained_transaction_message_ids )
       { return false; }
+   fc::future<void> prepare_sync_block( const graphene::net::block_message& blk_msg )
+   {
+      return fc::future<void>( fc::promise<void>::create( true ) );
+   }
    void handle_transaction( const graphene::net::trx_message& trx_msg )
    {
       ilog( "${name} was asked to handle a transaction", ("name", node_name) );
@@ -246,6 +294,31 @@ public:
    }
 };
 
+/***
+ * A node delegate which prepares sync blocks only when told so, and records the blocks it handles
+ */
+class sync_test_node_delegate : public test_node_delegate
+{
+public:
+   using test_node_delegate::test_node_delegate;
+
+   bool handle_block( const graphene::net::block_message& blk_msg, bool sync_mode,
+         std::vector<fc::uint160_t>& contained_transaction_message_ids ) override
+   {
+      handled_blocks.push_back( blk_msg.block_id );
+      return true;
+   }
+   fc::future<void> prepare_sync_block( const graphene::net::block_message& blk_msg ) override
+   {
+      auto preparation = fc::promise<void>::create( "sync_test_node_delegate::prepare_sync_block" );
+      preparations[blk_msg.block_id] = preparation;
+      return fc::future<void>( preparation );
+   }
+
+   std::map<graphene::net::block_id_type, fc::promise<void>::ptr> preparations;
+   std::vector<graphene::net::block_id_type> handled_blocks;
+};
+
 class test_node : public graphene::net::node
 {
 public:
@@ -294,6 +367,33 @@ public:
       try { my->_p2p_network_connect_loop_done.cancel(); } catch( ... ) { }
    }
 
+   void start_fake_fetch_sync_items_loop()
+   {
+      this->my->get_thread()->async( [&]() {
+            my->_fetch_sync_items_loop_done
+                  = fc::async( [&]{ my->fetch_sync_items_loop(); }, "fetch_sync_items_loop" );
+         }).wait();
+   }
+
+   void stop_fake_fetch_sync_items_loop()
+   {
+      this->my->get_thread()->async( [&]() {
+            try { my->_fetch_sync_items_loop_done.cancel_and_wait(); } catch( ... ) { }
+         }).wait();
+   }
+
+   // simulate that we are syncing with the peer, which told us it has the blocks
+   void start_syncing_with_peer( std::shared_ptr<test_peer> peer_ptr,
+                                 const std::vector<graphene::net::item_hash_t>& block_ids )
+   {
+      this->my->get_thread()->async( [&]() {
+            my->move_peer_to_active_list( peer_ptr );
+            peer_ptr->we_need_sync_items_from_peer = true;
+            peer_ptr->ids_of_items_to_get.assign( block_ids.begin(), block_ids.end() );
+            my->trigger_fetch_sync_items_loop();
+         }).wait();
+   }
+
    void on_message( graphene::net::peer_connection_ptr originating_peer,
                     const graphene::net::message& received_message )
    {
@@ -1002,4 +1102,203 @@ BOOST_AUTO_TEST_CASE( advertising_all_test )
    test_closing_connection_message( msg2 );
 }
 
+/****
+ * Testing that a block is sent as a compact block to a peer that supports it
+ */
+BOOST_AUTO_TEST_CASE( compact_block_sent )
+{
+   // create a node (node1)
+   int node1_port = fc::network::get_available_port();
+   fc::temp_directory node1_dir( graphene::utilities::temp_directory_path() );
+   test_node node1( "Node1", node1_dir.path(), node1_port );
+   // simulate that node1 started to connect to the network and accepting connections
+   fake_network_connect_guard guard( node1 );
+
+   // a new peer (peer3) which supports compact blocks
+   std::pair<std::shared_ptr<test_delegate>, std::shared_ptr<test_peer>> peer3
+         = node1.create_test_peer( "1.2.3.4:5678" );
+   std::shared_ptr<test_peer> peer3_ptr = peer3.second;
+   peer3_ptr->their_state = test_peer::their_connection_state::connection_accepted;
+   peer3_ptr->supports_compact_blocks = true;
+
+   // node1 has received a block
+   graphene::protocol::signed_block blk = create_block_with_transactions( 2 );
+   graphene::net::message block_msg( ( graphene::net::block_message( blk ) ) );
+   node1.broadcast( block_msg );
+
+   // peer3 asks for the block
+   graphene::net::fetch_items_message req( graphene::net::block_message_type, { block_msg.id() } );
+   node1.on_message( peer3_ptr, req );
+
+   // node1 replies with the IDs of the transactions
+   BOOST_REQUIRE_EQUAL( peer3_ptr->messages_received.size(), 1U );
+   BOOST_REQUIRE( peer3_ptr->messages_received.back().msg_type.value()
+                  == graphene::net::compact_block_message::type );
+   const auto compact = peer3_ptr->messages_received.back().as<graphene::net::compact_block_message>();
+   BOOST_CHECK( compact.block_id == blk.id() );
+   BOOST_CHECK( compact.block_message_hash == block_msg.id() );
+   BOOST_REQUIRE_EQUAL( compact.transaction_ids.size(), 2U );
+   BOOST_CHECK( compact.transaction_ids[0] == blk.transactions[0].id() );
+   BOOST_CHECK( compact.transaction_ids[1] == blk.transactions[1].id() );
+
+   // peer3 asks for the second transaction
+   graphene::net::fetch_block_transactions_message req2( block_msg.id(), { 1 } );
+   node1.on_message( peer3_ptr, req2 );
+
+   BOOST_REQUIRE_EQUAL( peer3_ptr->messages_received.size(), 2U );
+   BOOST_REQUIRE( peer3_ptr->messages_received.back().msg_type.value()
+                  == graphene::net::block_transactions_message::type );
+   const auto trxs = peer3_ptr->messages_received.back().as<graphene::net::block_transactions_message>();
+   BOOST_CHECK( trxs.block_message_hash == block_msg.id() );
+   BOOST_REQUIRE_EQUAL( trxs.transactions.size(), 1U );
+   BOOST_CHECK( trxs.transactions[0].id() == blk.transactions[1].id() );
+}
+
+/****
+ * Testing that a block is rebuilt from a compact block and the transactions a node has
+ */
+BOOST_AUTO_TEST_CASE( compact_block_received )
+{
+   // create a node (node1)
+   int node1_port = fc::network::get_available_port();
+   fc::temp_directory node1_dir( graphene::utilities::temp_directory_path() );
+   test_node node1( "Node1", node1_dir.path(), node1_port );
+   // simulate that node1 started to connect to the network and accepting connections
+   fake_network_connect_guard guard( node1 );
+
+   std::pair<std::shared_ptr<test_delegate>, std::shared_ptr<test_peer>> peer3
+         = node1.create_test_peer( "1.2.3.4:5678" );
+   std::shared_ptr<test_peer> peer3_ptr = peer3.second;
+   peer3_ptr->their_state = test_peer::their_connection_state::connection_accepted;
+
+   // node1 has received the first transaction of the block, and asked peer3 for the block
+   graphene::protocol::signed_block blk = create_block_with_transactions( 2 );
+   graphene::net::message block_msg( ( graphene::net::block_message( blk ) ) );
+   node1.broadcast( graphene::net::trx_message( blk.transactions[0] ) );
+   const graphene::net::item_id block_item( graphene::net::block_message_type, block_msg.id() );
+   peer3_ptr->items_requested_from_peer[block_item] = fc::time_point::now();
+
+   // peer3 sends the compact block, node1 asks for the transaction it does not have
+   graphene::net::compact_block_message compact( blk, block_msg.id() );
+   node1.on_message( peer3_ptr, compact );
+
+   BOOST_REQUIRE_EQUAL( peer3_ptr->messages_received.size(), 1U );
+   BOOST_REQUIRE( peer3_ptr->messages_received.back().msg_type.value()
+                  == graphene::net::fetch_block_transactions_message::type );
+   const auto req = peer3_ptr->messages_received.back().as<graphene::net::fetch_block_transactions_message>();
+   BOOST_CHECK( req.block_message_hash == block_msg.id() );
+   BOOST_REQUIRE_EQUAL( req.transaction_indexes.size(), 1U );
+   BOOST_CHECK_EQUAL( req.transaction_indexes[0], 1U );
+
+   // peer3 sends it, node1 rebuilds the block and handles it as requested
+   graphene::net::block_transactions_message trxs( block_msg.id(), { blk.transactions[1] } );
+   node1.on_message( peer3_ptr, trxs );
+
+   BOOST_CHECK_EQUAL( peer3_ptr->messages_received.size(), 1U );
+   BOOST_CHECK( peer3_ptr->items_requested_from_peer.find( block_item ) == peer3_ptr->items_requested_from_peer.end() );
+   BOOST_CHECK( peer3_ptr->partial_compact_blocks.empty() );
+}
+
+/****
+ * Testing that more than one batch of sync blocks can be requested from a peer at a time
+ */
+BOOST_AUTO_TEST_CASE( sync_requests_pipelined )
+{
+   // create a node (node1) which requests batches of 2 blocks, up to 3 batches from a peer at a time
+   int node1_port = fc::network::get_available_port();
+   fc::temp_directory node1_dir( graphene::utilities::temp_directory_path() );
+   test_node node1( "Node1", node1_dir.path(), node1_port );
+   fake_network_connect_guard guard( node1 );
+   fc::mutable_variant_object params;
+   params["max_sync_blocks_per_peer"] = 2;
+   params["max_sync_requests_per_peer"] = 3;
+   node1.set_advanced_node_parameters( params );
+
+   // node1 is syncing with peer3, which has 8 blocks
+   std::pair<std::shared_ptr<test_delegate>, std::shared_ptr<test_peer>> peer3
+         = node1.create_test_peer( "1.2.3.4:5678" );
+   std::shared_ptr<test_peer> peer3_ptr = peer3.second;
+   peer3_ptr->their_state = test_peer::their_connection_state::connection_accepted;
+   const auto blocks = create_chain_of_blocks( 8 );
+   std::vector<graphene::net::item_hash_t> block_ids;
+   for( const auto& blk : blocks )
+      block_ids.push_back( blk.id() );
+
+   node1.start_fake_fetch_sync_items_loop();
+   node1.start_syncing_with_peer( peer3_ptr, block_ids );
+   fc::usleep( fc::milliseconds(200) );
+
+   // 3 batches are requested without waiting for the first one to arrive
+   BOOST_CHECK_EQUAL( peer3_ptr->messages_received.size(), 3U );
+   auto requested = sync_items_requested( *peer3_ptr );
+   BOOST_REQUIRE_EQUAL( requested.size(), 6U );
+   BOOST_CHECK( std::equal( requested.begin(), requested.end(), block_ids.begin() ) );
+
+   // the first block arrives, there is no room for another batch yet
+   node1.on_message( peer3_ptr, graphene::net::block_message( blocks[0] ) );
+   fc::usleep( fc::milliseconds(200) );
+   BOOST_CHECK_EQUAL( sync_items_requested( *peer3_ptr ).size(), 6U );
+
+   // the second block arrives, so the last batch is requested while 4 blocks are still outstanding
+   node1.on_message( peer3_ptr, graphene::net::block_message( blocks[1] ) );
+   fc::usleep( fc::milliseconds(200) );
+   requested = sync_items_requested( *peer3_ptr );
+   BOOST_REQUIRE_EQUAL( requested.size(), 8U );
+   BOOST_CHECK( std::equal( requested.begin(), requested.end(), block_ids.begin() ) );
+
+   node1.stop_fake_fetch_sync_items_loop();
+}
+
+/****
+ * Testing that sync blocks are handled in order, each only after it has been prepared
+ */
+BOOST_AUTO_TEST_CASE( sync_blocks_handled_when_prepared )
+{
+   int node1_port = fc::network::get_available_port();
+   fc::temp_directory node1_dir( graphene::utilities::temp_directory_path() );
+   test_node node1( "Node1", node1_dir.path(), node1_port );
+   fake_network_connect_guard guard( node1 );
+   auto delegate = std::make_shared<sync_test_node_delegate>( "Node1" );
+   node1.set_node_delegate( delegate );
+
+   // node1 is syncing with peer3, which has 2 blocks
+   std::pair<std::shared_ptr<test_delegate>, std::shared_ptr<test_peer>> peer3
+         = node1.create_test_peer( "1.2.3.4:5678" );
+   std::shared_ptr<test_peer> peer3_ptr = peer3.second;
+   peer3_ptr->their_state = test_peer::their_connection_state::connection_accepted;
+   const auto blocks = create_chain_of_blocks( 2 );
+   const graphene::net::block_id_type id1 = blocks[0].id();
+   const graphene::net::block_id_type id2 = blocks[1].id();
+
+   node1.start_fake_fetch_sync_items_loop();
+   node1.start_syncing_with_peer( peer3_ptr, { id1, id2 } );
+   fc::usleep( fc::milliseconds(200) );
+   BOOST_REQUIRE_EQUAL( sync_items_requested( *peer3_ptr ).size(), 2U );
+
+   // the second block arrives first, its preparation starts but it can not be handled yet
+   node1.on_message( peer3_ptr, graphene::net::block_message( blocks[1] ) );
+   fc::usleep( fc::milliseconds(200) );
+   BOOST_CHECK_EQUAL( delegate->preparations.count( id2 ), 1U );
+   BOOST_CHECK( delegate->handled_blocks.empty() );
+
+   // the first block arrives, it is not handled before it has been prepared
+   node1.on_message( peer3_ptr, graphene::net::block_message( blocks[0] ) );
+   fc::usleep( fc::milliseconds(200) );
+   BOOST_REQUIRE_EQUAL( delegate->preparations.count( id1 ), 1U );
+   BOOST_CHECK( delegate->handled_blocks.empty() );
+
+   delegate->preparations[id1]->set_value();
+   fc::usleep( fc::milliseconds(200) );
+   BOOST_REQUIRE_EQUAL( delegate->handled_blocks.size(), 1U );
+   BOOST_CHECK( delegate->handled_blocks[0] == id1 );
+
+   // the second block follows once it has been prepared too
+   delegate->preparations[id2]->set_value();
+   fc::usleep( fc::milliseconds(200) );
+   BOOST_REQUIRE_EQUAL( delegate->handled_blocks.size(), 2U );
+   BOOST_CHECK( delegate->handled_blocks[1] == id2 );
+
+   node1.stop_fake_fetch_sync_items_loop();
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -981,4 +981,77 @@ BOOST_AUTO_TEST_CASE( committee_votes_calculation )
    } FC_LOG_AND_RETHROW()
 }
 
+BOOST_AUTO_TEST_CASE( parallel_vote_tally )
+{ try {
+   generate_blocks( HARDFORK_CORE_2262_TIME );
+   generate_block();
+   set_expiration( db, trx );
+
+   ACTORS( (votee) );
+   upgrade_to_lifetime_member( votee_id );
+   const asset_id_type uia_id = create_user_issued_asset( "UIATEST" ).get_id();
+   const witness_id_type wit_id = create_witness( votee_id ).get_id();
+   const vote_id_type wit_vote = wit_id(db).vote_id;
+
+   // More voting accounts than one thread tallies, so that they are tallied in parallel
+   const size_t num_voters = 2500;
+   vector<account_id_type> voters;
+   vector<uint64_t> stakes;
+   uint64_t total_stake = 0;
+   for( size_t i = 0; i < num_voters; ++i )
+   {
+      account_create_operation create_op = make_account( "voter" + std::to_string(i) );
+      const account_id_type voter_id( db.get_index_type<account_index>().get_next_id() );
+
+      transfer_operation transfer_op;
+      transfer_op.from = account_id_type();
+      transfer_op.to = voter_id;
+      transfer_op.amount = asset( ( i % 7 + 1 ) * 1000 );
+
+      // Votes set on creation do not count after core-2103, since the account did not vote yet
+      account_update_operation update_op;
+      update_op.account = voter_id;
+      update_op.new_options = create_op.options;
+      update_op.new_options->votes.clear();
+      update_op.new_options->votes.insert( wit_vote );
+      update_op.new_options->num_witness = 1;
+      update_op.new_options->num_committee = 0;
+
+      // After core-2262, core in orders is voting stake, but liquid core is not
+      limit_order_create_operation order_op;
+      order_op.seller = voter_id;
+      order_op.amount_to_sell = transfer_op.amount;
+      order_op.min_to_receive = asset( 1, uia_id );
+      order_op.expiration = time_point_sec::maximum();
+
+      trx.operations.push_back( create_op );
+      trx.operations.push_back( transfer_op );
+      trx.operations.push_back( update_op );
+      trx.operations.push_back( order_op );
+      PUSH_TX( db, trx, ~0 );
+      trx.clear();
+
+      voters.push_back( voter_id );
+      stakes.push_back( transfer_op.amount.amount.value );
+      total_stake += transfer_op.amount.amount.value;
+
+      if( i % 200 == 199 )
+      {
+         generate_block();
+         set_expiration( db, trx );
+      }
+   }
+
+   generate_blocks( db.get_dynamic_global_properties().next_maintenance_time );
+
+   // The same as a serial tally
+   BOOST_CHECK_EQUAL( wit_id(db).total_votes, total_stake );
+   for( size_t i = 0; i < num_voters; ++i )
+   {
+      const account_statistics_object& stats = voters[i](db).statistics(db);
+      BOOST_CHECK_EQUAL( stats.vp_all, stakes[i] );
+      BOOST_CHECK_EQUAL( stats.vp_witness, stakes[i] );
+   }
+} FC_LOG_AND_RETHROW() }
+
 BOOST_AUTO_TEST_SUITE_END()